@@ -0,0 +1,387 @@
+// Benchmarks of the control loop and the code it calls.
+// Usage: vr-hr-joint-task-bench [--filter TEXT] [--list] [--sample-time MS] [--samples N]
+//                               [--json results.json] [--baseline baseline.json] [--tolerance 0.10]
+// With --baseline, exits with 1 if any benchmark's median is more than tolerance slower than in the baseline.
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "causal_latency.h"
+#include "coppeliasim_handler.h"
+#include "dnf_composer_handler.h"
+#include "event_log_writer.h"
+#include "gauss_stimulus_updater.h"
+#include "hand_kinematics.h"
+#include "misc.h"
+#include "parameter_sweep.h"
+#include "simulated_coppeliasim.h"
+#include "workspace.h"
+#include "workspace_stimulus.h"
+
+using namespace std::chrono_literals;
+using namespace dnf_composer::element;
+
+namespace
+{
+	constexpr double DELTA_T = 65;
+
+	struct Architecture
+	{
+		DnfArchitectureType type;
+		const char* name;
+	};
+
+	constexpr Architecture architectures[] = {
+		{ DnfArchitectureType::HAND_MOTION, "hand motion" },
+		{ DnfArchitectureType::ACTION_LIKELIHOOD, "action likelihood" },
+	};
+
+	// A hand reaching over the table, one position per call.
+	class Reach
+	{
+	private:
+		std::uint64_t sample = 0;
+	public:
+		Position next()
+		{
+			const double phase = static_cast<double>(++sample % 200) / 200.0;
+			return { 0.35 - 0.3 * phase, -0.2 + 0.4 * phase, 0.95 - 0.2 * phase };
+		}
+	};
+
+	std::shared_ptr<DnfComposerHandler> makeHeadlessHandler(DnfArchitectureType type, const DnfArchitectureOptions& options = {})
+	{
+		auto handler = std::make_shared<DnfComposerHandler>(type, DELTA_T,
+			DnfComposerHandlerParameters(false, SteppingMode::AS_FAST_AS_POSSIBLE, options));
+		handler->initSimulation();
+		return handler;
+	}
+
+	// Steps with the hand resting on an object until the field has decided.
+	void settleOnObject(DnfComposerHandler& handler, int object)
+	{
+		const Workspace& workspace = handler.getWorkspace();
+		HandKinematics hand;
+		hand.sequence = 1;
+		hand.position = workspace.getObject(object).position;
+		for (int step = 0; step < 200; ++step)
+		{
+			handler.setHandStimulus(hand, workspace.getAllObjects());
+			handler.setAvailableObjectsInTheWorkspace(workspace.getAllObjects());
+			handler.stepSimulation();
+		}
+	}
+
+	void addMiscBenchmarks(BenchmarkSuite& suite)
+	{
+		const Workspace workspace = Workspace::getDefault();
+		std::vector<Position> objects;
+		for (const WorkspaceObject& object : workspace.getObjects())
+			objects.push_back(object.position);
+
+		suite.add("misc/euclidean distance", [objects](std::uint64_t iterations) {
+			Reach reach;
+			for (std::uint64_t i = 0; i < iterations; ++i)
+				doNotOptimize(calculateEuclideanDistance(reach.next(), objects[0]));
+		});
+
+		suite.add("misc/action likelihood, scalar, per object", [objects](std::uint64_t iterations) {
+			Reach reach;
+			for (std::uint64_t i = 0; i < iterations; ++i)
+			{
+				const Position hand = reach.next();
+				for (const Position& object : objects)
+					doNotOptimize(calculateLikelihoodOfHumanAction(hand, 0.5, object, 0.8, 0.2));
+			}
+		});
+
+		for (const std::size_t numberOfObjects : { objects.size(), std::size_t{ 64 } })
+		{
+			PositionArrays arrays;
+			for (std::size_t i = 0; i < numberOfObjects; ++i)
+				arrays.push_back(objects[i % objects.size()]);
+			suite.add("misc/action likelihood, batch of " + std::to_string(numberOfObjects),
+				[arrays](std::uint64_t iterations) {
+					Reach reach;
+					std::vector<double> likelihoods(arrays.size());
+					for (std::uint64_t i = 0; i < iterations; ++i)
+					{
+						calculateLikelihoodsOfHumanAction(reach.next(), 0.5, arrays, 0.8, 0.2, likelihoods.data());
+						doNotOptimize(likelihoods.data());
+					}
+				});
+		}
+
+		suite.add("misc/hand kinematics update and estimate", [](std::uint64_t iterations) {
+			HandKinematicsEstimator estimator;
+			Reach reach;
+			auto time = std::chrono::steady_clock::time_point{};
+			for (std::uint64_t i = 0; i < iterations; ++i)
+			{
+				time += 10ms;
+				estimator.update(i + 1, time, reach.next());
+				doNotOptimize(estimator.estimateAt(time + 30ms));
+			}
+		});
+
+		suite.add("misc/workspace target object", [workspace](std::uint64_t iterations) {
+			const double fieldSize = workspace.getMaxSpatialDimension();
+			for (std::uint64_t i = 0; i < iterations; ++i)
+				doNotOptimize(workspace.getTargetObject(static_cast<double>(i % 1000) * fieldSize / 1000));
+		});
+	}
+
+	void addStimulusBenchmarks(BenchmarkSuite& suite)
+	{
+		const Workspace workspace = Workspace::getDefault();
+		const ElementSpatialDimensionParameters dimensions(workspace.getMaxSpatialDimension(), workspace.getSpatialStep());
+
+		const auto makeGaussStimulus = [dimensions] {
+			ElementFactory factory;
+			const auto stimulus = std::dynamic_pointer_cast<GaussStimulus>(factory.createElement(GAUSS_STIMULUS,
+				{ "hand position stimulus", dimensions }, { GaussStimulusParameters(3, 5, 25, false, false) }));
+			stimulus->init();
+			return stimulus;
+		};
+
+		suite.addWithSetup("stimulus/gauss amplitude", [makeGaussStimulus] {
+			return [stimulus = makeGaussStimulus()](std::uint64_t iterations) {
+				GaussStimulusUpdater updater(stimulus.get());
+				for (std::uint64_t i = 0; i < iterations; ++i)
+					updater.setAmplitude(i % 2 == 0 ? 5.0 : 2.5);
+			};
+		});
+
+		suite.addWithSetup("stimulus/gauss amplitude and position", [makeGaussStimulus, fieldSize = dimensions.x_max] {
+			return [stimulus = makeGaussStimulus(), fieldSize](std::uint64_t iterations) {
+				GaussStimulusUpdater updater(stimulus.get());
+				for (std::uint64_t i = 0; i < iterations; ++i)
+					updater.setAmplitudeAndPosition(5.0, static_cast<double>(i % 100) * fieldSize / 100);
+			};
+		});
+
+		suite.addWithSetup("stimulus/workspace amplitudes", [workspace, dimensions] {
+			const auto stimuli = std::make_shared<WorkspaceStimulus>(ElementCommonParameters{ "object stimuli", dimensions },
+				GaussStimulusParameters(3, 0, 0, false, false), workspace, 0.0);
+			stimuli->init();
+			return [stimuli](std::uint64_t iterations) {
+				std::vector<double> amplitudes(stimuli->getNumberOfObjects());
+				for (std::uint64_t i = 0; i < iterations; ++i)
+				{
+					amplitudes[i % amplitudes.size()] = i % 2 == 0 ? 5.0 : 0.0;
+					stimuli->setAmplitudes(amplitudes);
+				}
+			};
+		});
+
+		for (const Architecture& architecture : architectures)
+			suite.addWithSetup(std::string("stimulus/hand stimulus, ") + architecture.name, [type = architecture.type] {
+				return [handler = makeHeadlessHandler(type)](std::uint64_t iterations) {
+					const ObjectSet available = handler->getWorkspace().getAllObjects();
+					Reach reach;
+					HandKinematics hand;
+					hand.velocity = { -0.3, 0.4, -0.2 };
+					for (std::uint64_t i = 0; i < iterations; ++i)
+					{
+						hand.sequence = i + 1;
+						hand.position = reach.next();
+						handler->setHandStimulus(hand, available);
+					}
+				};
+			});
+	}
+
+	void addDnfBenchmarks(BenchmarkSuite& suite)
+	{
+		DnfArchitectureOptions engine;
+		engine.convolution = ConvolutionMethod::AUTOMATIC;
+
+		const auto makeSettledHandler = [](DnfArchitectureType type, const DnfArchitectureOptions& options) {
+			std::shared_ptr<DnfComposerHandler> handler = makeHeadlessHandler(type, options);
+			settleOnObject(*handler, 1);
+			return handler;
+		};
+
+		for (const Architecture& architecture : architectures)
+		{
+			const DnfArchitectureType type = architecture.type;
+			suite.addWithSetup(std::string("dnf/step, ") + architecture.name, [=] {
+				return [handler = makeSettledHandler(type, {})](std::uint64_t iterations) {
+					for (std::uint64_t i = 0; i < iterations; ++i)
+						handler->stepSimulation();
+				};
+			});
+
+			suite.addWithSetup(std::string("dnf/step, ") + architecture.name + ", convolution engine", [=] {
+				return [handler = makeSettledHandler(type, engine)](std::uint64_t iterations) {
+					for (std::uint64_t i = 0; i < iterations; ++i)
+						handler->stepSimulation();
+				};
+			});
+
+			suite.addWithSetup(std::string("dnf/target object, ") + architecture.name, [=] {
+				return [handler = makeSettledHandler(type, {})](std::uint64_t iterations) {
+					for (std::uint64_t i = 0; i < iterations; ++i)
+						doNotOptimize(handler->getTargetObject());
+				};
+			});
+		}
+	}
+
+	void addEventLogBenchmarks(BenchmarkSuite& suite)
+	{
+		// EventLogger is a process-wide facade that opens a session directory; its log() is a push to this writer.
+		suite.add("event log/push and write", [](std::uint64_t iterations) {
+			const std::string path = (std::filesystem::temp_directory_path() / "vr-hr-joint-task-bench-logs.txt").string();
+			EventLogWriter writer;
+			writer.open(path);
+			for (std::uint64_t i = 0; i < iterations; ++i)
+			{
+				// Retry a full queue, so that the writer thread's formatting and writing are timed too.
+				while (!writer.push({ LogLevel::ROBOT, LogEventId::ROBOT_TARGETING, static_cast<int>(i % 3) + 1,
+					std::chrono::system_clock::now(), {} }))
+					std::this_thread::yield();
+			}
+			writer.close();
+			std::filesystem::remove(path);
+		});
+	}
+
+	// The control thread's work for one pass, as in Experiment::handleSignalsBetweenDnfAndCoppeliasim() but without
+	// the wait for a change and the logging, against a simulated scene playing a reach in a loop.
+	class ControlLoop
+	{
+	private:
+		SimulatedCoppeliaSim scene;
+		std::shared_ptr<DnfComposerHandler> dnf;
+		CoppeliasimHandler coppeliasim;
+		HandKinematicsEstimator kinematics;
+		CausalLatencyTracer tracer;
+		OutgoingSignals outSignals;
+	public:
+		explicit ControlLoop(DnfArchitectureType type)
+			: scene(makeScript(type)), dnf(makeHeadlessHandler(type)),
+			coppeliasim(std::make_unique<SimulatedRemoteApiClient>(scene, SimulatedConnectionParameters(100us, 0us, 1)),
+				std::make_unique<SimulatedRemoteApiClient>(scene, SimulatedConnectionParameters(100us, 0us, 2)),
+				std::make_unique<SimulatedRemoteApiClient>(scene, SimulatedConnectionParameters(100us, 0us, 3)))
+		{
+			scene.addObject("RightController");
+			settleOnObject(*dnf, 2);
+			coppeliasim.init();
+			while (coppeliasim.getHandPoseSnapshot().sequence == 0 || !coppeliasim.getSignals().simStarted)
+				std::this_thread::sleep_for(1ms);
+		}
+
+		~ControlLoop()
+		{
+			scene.close();
+			coppeliasim.end();
+		}
+
+		void iterate()
+		{
+			const IncomingSignals inSignals = coppeliasim.getSignals();
+			const ObjectSignals objectSignals = decodeObjectSignals(inSignals);
+			const Snapshot<Pose> handPose = coppeliasim.getHandPoseSnapshot();
+			kinematics.update(handPose);
+			dnf->setHandStimulus(kinematics.estimateAt(dnf->getNextStepTime()), objectSignals.present);
+			tracer.onStimulusApplied(handPose.sequence, handPose.captureTime, dnf->getNumberOfSteps());
+			dnf->setAvailableObjectsInTheWorkspace(objectSignals.present);
+			const TargetDecision decision = dnf->getTargetDecision().value;
+			outSignals.targetObject = decision.targetObject;
+			coppeliasim.setSignals(outSignals, tracer.onDecision(outSignals.targetObject, decision.step));
+		}
+	private:
+		static SceneScript makeScript(DnfArchitectureType type)
+		{
+			SceneScript script = makeSceneScript(makeSyntheticReach(type, 1));
+			script.loop = true;
+			return script;
+		}
+	};
+
+	void addControlBenchmarks(BenchmarkSuite& suite)
+	{
+		for (const Architecture& architecture : architectures)
+			suite.addWithSetup(std::string("control/iteration, ") + architecture.name, [type = architecture.type] {
+				return [loop = std::make_shared<ControlLoop>(type)](std::uint64_t iterations) {
+					for (std::uint64_t i = 0; i < iterations; ++i)
+						loop->iterate();
+				};
+			});
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		BenchmarkParameters parameters;
+		std::string jsonPath;
+		std::string baselinePath;
+		double tolerance = 0.10;
+		bool list = false;
+		for (int i = 1; i < argc; ++i)
+		{
+			if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+				parameters.filter = argv[++i];
+			else if (std::strcmp(argv[i], "--sample-time") == 0 && i + 1 < argc)
+				parameters.sampleTime = std::chrono::milliseconds(std::stoul(argv[++i]));
+			else if (std::strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+				parameters.samples = std::stoul(argv[++i]);
+			else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+				jsonPath = argv[++i];
+			else if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+				baselinePath = argv[++i];
+			else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+				tolerance = std::stod(argv[++i]);
+			else if (std::strcmp(argv[i], "--list") == 0)
+				list = true;
+			else
+				throw std::runtime_error(std::string("Unknown argument ") + argv[i] + ".");
+		}
+
+		BenchmarkSuite suite;
+		addMiscBenchmarks(suite);
+		addStimulusBenchmarks(suite);
+		addDnfBenchmarks(suite);
+		addEventLogBenchmarks(suite);
+		addControlBenchmarks(suite);
+
+		if (list)
+		{
+			for (const std::string& name : suite.getNames())
+				std::cout << name << std::endl;
+			return 0;
+		}
+
+		const std::vector<BenchmarkResult> results = suite.run(parameters);
+		std::cout << "\n" << formatBenchmarkTable(results);
+
+		if (!jsonPath.empty() && !writeBenchmarkJson(jsonPath, results))
+			throw std::runtime_error("Cannot write " + jsonPath + ".");
+
+		if (!baselinePath.empty())
+		{
+			const auto comparisons = compareWithBaseline(results, readBenchmarkJson(baselinePath), tolerance);
+			std::cout << "\nAgainst " << baselinePath << " (tolerance " << 100 * tolerance << "%)\n"
+				<< formatComparisonTable(comparisons);
+			for (const BenchmarkComparison& comparison : comparisons)
+				if (comparison.regression)
+					return 1;
+		}
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 2;
+	}
+	return 0;
+}
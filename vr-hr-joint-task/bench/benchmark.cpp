@@ -0,0 +1,236 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include <nlohmann/json.hpp>
+
+#include "metrics.h"
+
+namespace
+{
+	constexpr int JSON_VERSION = 1;
+
+	using Clock = std::chrono::steady_clock;
+
+	double timeBatch(const BenchmarkSuite::Body& body, std::uint64_t iterations)
+	{
+		const auto start = Clock::now();
+		body(iterations);
+		const auto end = Clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count();
+	}
+
+	std::string getCompiler()
+	{
+#if defined(__clang__)
+		return "clang " __clang_version__;
+#elif defined(__GNUC__)
+		return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+		return "msvc " + std::to_string(_MSC_VER);
+#else
+		return "unknown";
+#endif
+	}
+
+	std::string getDate()
+	{
+		const std::time_t now = std::time(nullptr);
+		std::stringstream ss;
+		ss << std::put_time(std::localtime(&now), "%Y-%m-%dT%H:%M:%S");
+		return ss.str();
+	}
+}
+
+void BenchmarkSuite::add(std::string name, Body body)
+{
+	addWithSetup(std::move(name), [body = std::move(body)] { return body; });
+}
+
+void BenchmarkSuite::addWithSetup(std::string name, Setup setup)
+{
+	benchmarks.emplace_back(std::move(name), std::move(setup));
+}
+
+std::vector<std::string> BenchmarkSuite::getNames() const
+{
+	std::vector<std::string> names;
+	for (const auto& [name, setup] : benchmarks)
+		names.push_back(name);
+	return names;
+}
+
+std::vector<BenchmarkResult> BenchmarkSuite::run(const BenchmarkParameters& parameters) const
+{
+	std::vector<BenchmarkResult> results;
+	for (const auto& [name, setup] : benchmarks)
+	{
+		if (name.find(parameters.filter) == std::string::npos)
+			continue;
+		results.push_back(measure(name, setup(), parameters));
+		std::cout << name << ": " << results.back().medianNs << " ns" << std::endl;
+	}
+	return results;
+}
+
+BenchmarkResult BenchmarkSuite::measure(const std::string& name, const Body& body, const BenchmarkParameters& parameters)
+{
+	const double sampleTimeNs = std::chrono::duration<double, std::nano>(parameters.sampleTime).count();
+
+	// Calibration doubles as the warm-up.
+	std::uint64_t iterations = 1;
+	for (double elapsed = timeBatch(body, iterations); elapsed < sampleTimeNs; elapsed = timeBatch(body, iterations))
+	{
+		const double scale = elapsed > 0 ? std::clamp(sampleTimeNs / elapsed, 1.25, 10.0) : 10.0;
+		iterations = static_cast<std::uint64_t>(std::ceil(static_cast<double>(iterations) * scale));
+	}
+
+	std::vector<double> perOperation;
+	perOperation.reserve(parameters.samples);
+	for (std::size_t sample = 0; sample < std::max<std::size_t>(parameters.samples, 1); ++sample)
+		perOperation.push_back(timeBatch(body, iterations) / static_cast<double>(iterations));
+
+	BenchmarkResult result;
+	result.name = name;
+	result.iterations = iterations;
+	result.samples = perOperation.size();
+	result.meanNs = std::accumulate(perOperation.begin(), perOperation.end(), 0.0) / static_cast<double>(perOperation.size());
+	double squares = 0;
+	for (const double value : perOperation)
+		squares += (value - result.meanNs) * (value - result.meanNs);
+	result.stddevNs = std::sqrt(squares / static_cast<double>(perOperation.size()));
+	std::sort(perOperation.begin(), perOperation.end());
+	result.minNs = perOperation.front();
+	result.medianNs = perOperation[perOperation.size() / 2];
+	return result;
+}
+
+std::string toBenchmarkJson(const std::vector<BenchmarkResult>& results)
+{
+	nlohmann::ordered_json json;
+	json["version"] = JSON_VERSION;
+	json["context"] = {
+		{ "date", getDate() },
+		{ "compiler", getCompiler() },
+#ifdef NDEBUG
+		{ "build_type", "release" },
+#else
+		{ "build_type", "debug" },
+#endif
+		{ "metrics", HR_VR_PROJ_METRICS != 0 },
+		{ "hardware_threads", std::thread::hardware_concurrency() },
+	};
+	json["benchmarks"] = nlohmann::ordered_json::array();
+	for (const BenchmarkResult& result : results)
+		json["benchmarks"].push_back({
+			{ "name", result.name },
+			{ "median_ns", result.medianNs },
+			{ "mean_ns", result.meanNs },
+			{ "min_ns", result.minNs },
+			{ "stddev_ns", result.stddevNs },
+			{ "iterations", result.iterations },
+			{ "samples", result.samples },
+		});
+	return json.dump(2);
+}
+
+bool writeBenchmarkJson(const std::string& path, const std::vector<BenchmarkResult>& results)
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+	file << toBenchmarkJson(results) << '\n';
+	return static_cast<bool>(file);
+}
+
+std::vector<BenchmarkResult> readBenchmarkJson(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file)
+		throw std::runtime_error("Cannot open benchmark results " + path + ".");
+
+	std::vector<BenchmarkResult> results;
+	try
+	{
+		const nlohmann::json json = nlohmann::json::parse(file);
+		if (json.at("version").get<int>() != JSON_VERSION)
+			throw std::runtime_error("Unsupported benchmark results version in " + path + ".");
+		for (const nlohmann::json& entry : json.at("benchmarks"))
+		{
+			BenchmarkResult result;
+			result.name = entry.at("name").get<std::string>();
+			result.medianNs = entry.at("median_ns").get<double>();
+			result.meanNs = entry.value("mean_ns", result.medianNs);
+			result.minNs = entry.value("min_ns", result.medianNs);
+			result.stddevNs = entry.value("stddev_ns", 0.0);
+			result.iterations = entry.value("iterations", std::uint64_t{ 0 });
+			result.samples = entry.value("samples", std::size_t{ 0 });
+			results.push_back(std::move(result));
+		}
+	}
+	catch (const nlohmann::json::exception& exception)
+	{
+		throw std::runtime_error("Invalid benchmark results " + path + ": " + exception.what());
+	}
+	return results;
+}
+
+std::vector<BenchmarkComparison> compareWithBaseline(const std::vector<BenchmarkResult>& results,
+	const std::vector<BenchmarkResult>& baseline, double tolerance)
+{
+	std::unordered_map<std::string, double> baselineNs;
+	for (const BenchmarkResult& result : baseline)
+		baselineNs[result.name] = result.medianNs;
+
+	std::vector<BenchmarkComparison> comparisons;
+	for (const BenchmarkResult& result : results)
+	{
+		const auto it = baselineNs.find(result.name);
+		if (it == baselineNs.end() || it->second <= 0)
+			continue;
+		BenchmarkComparison comparison;
+		comparison.name = result.name;
+		comparison.baselineNs = it->second;
+		comparison.currentNs = result.medianNs;
+		comparison.change = result.medianNs / it->second - 1;
+		comparison.regression = comparison.change > tolerance;
+		comparisons.push_back(comparison);
+	}
+	return comparisons;
+}
+
+std::string formatBenchmarkTable(const std::vector<BenchmarkResult>& results)
+{
+	std::stringstream ss;
+	ss << std::left << std::setw(44) << "benchmark" << std::right
+		<< std::setw(14) << "median (ns)" << std::setw(14) << "mean (ns)" << std::setw(14) << "stddev (ns)" << "\n";
+	ss << std::fixed << std::setprecision(1);
+	for (const BenchmarkResult& result : results)
+		ss << std::left << std::setw(44) << result.name << std::right
+			<< std::setw(14) << result.medianNs << std::setw(14) << result.meanNs << std::setw(14) << result.stddevNs << "\n";
+	return ss.str();
+}
+
+std::string formatComparisonTable(const std::vector<BenchmarkComparison>& comparisons)
+{
+	std::stringstream ss;
+	ss << std::left << std::setw(44) << "benchmark" << std::right
+		<< std::setw(14) << "baseline (ns)" << std::setw(14) << "current (ns)" << std::setw(10) << "change" << "\n";
+	ss << std::fixed << std::setprecision(1);
+	for (const BenchmarkComparison& comparison : comparisons)
+		ss << std::left << std::setw(44) << comparison.name << std::right
+			<< std::setw(14) << comparison.baselineNs << std::setw(14) << comparison.currentNs
+			<< std::setw(9) << std::showpos << 100 * comparison.change << std::noshowpos << "%"
+			<< (comparison.regression ? "  REGRESSION" : "") << "\n";
+	return ss.str();
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from optimising away a value a benchmark computes.
+template<typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static const volatile void* sink;
+	sink = &value;
+#endif
+}
+
+struct BenchmarkResult
+{
+	std::string name;
+	// Operations timed per sample.
+	std::uint64_t iterations = 0;
+	std::size_t samples = 0;
+	// Per operation.
+	double medianNs = 0;
+	double meanNs = 0;
+	double minNs = 0;
+	double stddevNs = 0;
+};
+
+struct BenchmarkParameters
+{
+	// Time spent on each sample; the iteration count is doubled until one batch takes this long.
+	std::chrono::milliseconds sampleTime;
+	std::size_t samples;
+	// Only the benchmarks whose name contains this run.
+	std::string filter;
+
+	BenchmarkParameters(std::chrono::milliseconds sampleTime = std::chrono::milliseconds(20), std::size_t samples = 15,
+		std::string filter = {})
+		: sampleTime(sampleTime), samples(samples), filter(std::move(filter))
+	{}
+};
+
+// A named set of benchmarks. A benchmark body runs its operation the given number of times, so the loop
+// overhead is the body's own and the timer is read once per sample.
+// A setup builds the body and whatever it works on right before the benchmark runs, and it is all destroyed
+// right after, so one benchmark's threads or buffers do not weigh on the next.
+class BenchmarkSuite
+{
+public:
+	using Body = std::function<void(std::uint64_t iterations)>;
+	using Setup = std::function<Body()>;
+private:
+	std::vector<std::pair<std::string, Setup>> benchmarks;
+public:
+	void add(std::string name, Body body);
+	void addWithSetup(std::string name, Setup setup);
+	std::vector<std::string> getNames() const;
+	std::vector<BenchmarkResult> run(const BenchmarkParameters& parameters) const;
+private:
+	static BenchmarkResult measure(const std::string& name, const Body& body, const BenchmarkParameters& parameters);
+};
+
+// One benchmark against the same benchmark in the baseline.
+struct BenchmarkComparison
+{
+	std::string name;
+	double baselineNs = 0;
+	double currentNs = 0;
+	// currentNs / baselineNs - 1, positive when slower.
+	double change = 0;
+	bool regression = false;
+};
+
+// Results as JSON, median per operation first, with the context they were measured in.
+std::string toBenchmarkJson(const std::vector<BenchmarkResult>& results);
+bool writeBenchmarkJson(const std::string& path, const std::vector<BenchmarkResult>& results);
+// Throws std::runtime_error if the file cannot be read or is not a benchmark result file.
+std::vector<BenchmarkResult> readBenchmarkJson(const std::string& path);
+
+// Medians compared by name; a benchmark more than tolerance slower than its baseline is a regression.
+// Benchmarks missing from either side are left out.
+std::vector<BenchmarkComparison> compareWithBaseline(const std::vector<BenchmarkResult>& results,
+	const std::vector<BenchmarkResult>& baseline, double tolerance);
+
+std::string formatBenchmarkTable(const std::vector<BenchmarkResult>& results);
+std::string formatComparisonTable(const std::vector<BenchmarkComparison>& comparisons);
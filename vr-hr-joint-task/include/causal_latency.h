@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "metrics.h"
+
+// Pose sample behind a target decision change, and when each stage of the path handled it.
+// Travels with the outgoing signals to the thread that writes them, so it is trivially copyable.
+struct DecisionCause
+{
+	// Sequence number of the hand pose sample, 0 when the decision has no traced cause.
+	std::uint64_t sampleSequence = 0;
+	std::chrono::steady_clock::time_point sampleTime;
+	// When its stimulus was applied, and the DNF steps completed then: step stimulusStep + 1 first reads it.
+	std::chrono::steady_clock::time_point stimulusTime;
+	std::uint64_t stimulusStep = 0;
+	// When the decision was taken, and the DNF steps completed then.
+	std::chrono::steady_clock::time_point decisionTime;
+	std::uint64_t decisionStep = 0;
+	int previousTargetObject = 0;
+	int targetObject = 0;
+
+	bool isValid() const { return sampleSequence != 0; }
+};
+
+// A decision change whose target write reached the simulator.
+struct DecisionLatency
+{
+	DecisionCause cause;
+	std::chrono::steady_clock::time_point writeTime;
+};
+
+// Causal latency from a hand pose sample to the target object write it leads to.
+// The control thread reports every new sample it applies and every decision it takes. A decision change
+// is attributed to the newest sample applied before the last DNF step the decision saw began, the newest
+// sample that can have shaped the field; the writing thread reports when the change reached the simulator.
+// Constant cost per call: a fixed ring of recent samples, wait-free histograms and a preallocated list of changes.
+class CausalLatencyTracer
+{
+public:
+	static constexpr std::size_t SAMPLE_HISTORY = 64;
+private:
+	struct AppliedSample
+	{
+		std::uint64_t sequence;
+		std::chrono::steady_clock::time_point sampleTime;
+		std::chrono::steady_clock::time_point stimulusTime;
+		std::uint64_t stimulusStep;
+	};
+
+	// Control thread.
+	std::array<AppliedSample, SAMPLE_HISTORY> samples;
+	std::size_t numberOfSamples;
+	std::uint64_t lastSampleSequence;
+	int lastTargetObject;
+
+	// Writing thread.
+	LatencyHistogram sampleToStimulus;
+	LatencyHistogram stimulusToDecision;
+	LatencyHistogram decisionToWrite;
+	LatencyHistogram total;
+	std::vector<DecisionLatency> changes;
+	std::atomic<std::uint64_t> changesDropped;
+public:
+	// Keeps the first maxChanges decision changes for writeCsv(), the histograms take every one.
+	explicit CausalLatencyTracer(std::size_t maxChanges = 4096);
+
+	// Control thread: the stimulus of a pose sample was applied with dnfStep steps completed.
+	// Repeated samples (same sequence) are ignored.
+	void onStimulusApplied(std::uint64_t sampleSequence, std::chrono::steady_clock::time_point sampleTime,
+		std::uint64_t dnfStep, std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+	// Control thread: decision taken with dnfStep steps completed. Returns its cause if the target changed.
+	DecisionCause onDecision(int targetObject, std::uint64_t dnfStep,
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+	// Writing thread: the target of a decision change reached the simulator.
+	void onTargetWritten(const DecisionCause& cause, std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+	std::uint64_t getNumberOfChanges() const { return total.getCount(); }
+	const LatencyHistogram& getTotal() const { return total; }
+	// Once the writing thread has stopped.
+	std::string getReport() const;
+	bool writeCsv(const std::string& path) const;
+};
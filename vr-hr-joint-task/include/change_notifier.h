@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <semaphore>
+
+// Wakes a single waiting consumer when any producer has published something new.
+// notify() never blocks; repeated notifications before the consumer wakes collapse into one.
+class ChangeNotifier
+{
+private:
+	std::atomic<bool> pending;
+	std::binary_semaphore semaphore;
+public:
+	ChangeNotifier()
+		: pending(false), semaphore(0)
+	{}
+
+	void notify()
+	{
+		if (!pending.exchange(true, std::memory_order_acq_rel))
+			semaphore.release();
+	}
+
+	// Returns false if maxPeriod elapsed without a notification.
+	template<typename Rep, typename Period>
+	bool waitFor(const std::chrono::duration<Rep, Period>& maxPeriod)
+	{
+		if (!semaphore.try_acquire_for(maxPeriod))
+			return false;
+		pending.store(false, std::memory_order_release);
+		return true;
+	}
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+enum class ConvolutionMethod
+{
+	// Direct or FFT, whichever the cost model expects to be cheaper for the field and kernel size.
+	AUTOMATIC,
+	DIRECT,
+	FFT,
+};
+
+// In-place radix-2 complex FFT of one size: twiddle factors and bit-reversal table computed once.
+// Plans are immutable, get() hands out one shared plan per size.
+class FftPlan
+{
+private:
+	std::size_t size;
+	std::vector<std::complex<double>> twiddles;
+	std::vector<std::size_t> bitReversed;
+public:
+	// size must be a power of two.
+	explicit FftPlan(std::size_t size);
+
+	void forward(std::complex<double>* data) const;
+	// Unscaled, divide by getSize() to invert forward().
+	void inverse(std::complex<double>* data) const;
+
+	std::size_t getSize() const { return size; }
+
+	static std::shared_ptr<const FftPlan> get(std::size_t size);
+	static std::size_t getNumberOfCachedPlans();
+private:
+	void transform(std::complex<double>* data, bool inverse) const;
+};
+
+// Non-circular "same" convolution of a fixed-size field with a fixed, centred kernel (odd number of taps),
+// output[i] = sum_k kernel[k] * input[i + radius - k], zero outside the field.
+// Direct convolution costs fieldSize * kernelSize, FFT convolution a few passes over the next power of two
+// of fieldSize + kernelSize - 1; the kernel spectrum and the scratch buffers are computed once, so a call
+// allocates nothing. Not thread-safe, one engine per kernel element.
+class ConvolutionEngine
+{
+private:
+	std::size_t fieldSize;
+	std::size_t radius;
+	ConvolutionMethod method;
+	std::vector<double> kernel;
+	std::vector<double> padded;
+	std::shared_ptr<const FftPlan> plan;
+	std::vector<std::complex<double>> kernelSpectrum;
+	std::vector<std::complex<double>> spectrum;
+public:
+	ConvolutionEngine(std::size_t fieldSize, std::vector<double> kernel, ConvolutionMethod method = ConvolutionMethod::AUTOMATIC);
+
+	void convolve(const double* input, double* output);
+	void convolve(const std::vector<double>& input, std::vector<double>& output) { convolve(input.data(), output.data()); }
+
+	// Never AUTOMATIC, the method picked at construction.
+	ConvolutionMethod getMethod() const { return method; }
+	std::size_t getFieldSize() const { return fieldSize; }
+	std::size_t getKernelSize() const { return kernel.size(); }
+
+	static ConvolutionMethod chooseMethod(std::size_t fieldSize, std::size_t kernelSize);
+	static std::size_t getFftSize(std::size_t fieldSize, std::size_t kernelSize);
+private:
+	void convolveDirect(const double* input, double* output);
+	void convolveFft(const double* input, double* output);
+};
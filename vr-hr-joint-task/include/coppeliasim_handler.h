@@ -1,13 +1,32 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <thread>
-#include <client.h>
+#include <vector>
 
+#include "causal_latency.h"
+#include "change_notifier.h"
+#include "metrics.h"
 #include "misc.h"
+#include "polling_schedule.h"
+#include "pose_telemetry.h"
+#include "remote_api_client.h"
+#include "remote_api_executor.h"
+#include "shared_scene_state.h"
+#include "snapshot_publisher.h"
+#include "thread_activity.h"
+#include "workspace.h"
 
 
 struct HumanHand
 {
+	static constexpr const char* POLLING_TARGET = "handPose";
+
 	int objectHandle;
 	Pose pose;
 
@@ -39,6 +58,8 @@ struct IncomingSignals
 	static constexpr const char* HUMAN_PLACE_OBJ3 = "humanPlaceObj3";
 	static constexpr const char* CAN_RESTART = "canBeRestarted";
 	static constexpr const char* RESTART = "restart";
+	// Objects the scene publishes flags for; workspaces with more cannot be driven by it.
+	static constexpr std::size_t NUMBER_OF_OBJECTS = 3;
 
 	bool simStarted;
 	bool object1;
@@ -83,8 +104,35 @@ struct IncomingSignals
 		, canRestart(false)
 		, restart(false)
 	{}
+
+	bool operator==(const IncomingSignals&) const = default;
+};
+
+// All IncomingSignals flags packed by the scene into a single integer signal,
+// so that one snapshot costs one round trip and every flag is sampled at the same instant.
+// Wire layout (version 1): bit i holds the i-th flag in IncomingSignals declaration order
+// (simStarted = bit 0 ... restart = bit 19), bits 24-30 hold the layout version.
+// Scenes that do not publish it read as 0 (no version) and fall back to per-signal reads.
+struct IncomingSignalsSnapshot
+{
+	static constexpr const char* SIGNAL = "signalSnapshot";
+	static constexpr int VERSION = 1;
+	static constexpr int VERSION_SHIFT = 24;
+	static constexpr int VERSION_MASK = 0x7F;
+	static constexpr int NUMBER_OF_FLAGS = 20;
+
+	static int pack(const IncomingSignals& signals);
+	static bool unpack(int packed, IncomingSignals& signals);
 };
 
+// Reads one IncomingSignals snapshot, using the packed signal when the scene publishes a known layout version.
+IncomingSignals readIncomingSignals(const RemoteApiClient& client);
+// The same as an awaitable; without the packed signal, all the per-signal reads are in flight together.
+Task<IncomingSignals> readSnapshot(AsyncRemoteApiClient& client);
+
+// The per-object flags of the scene as one bit per object; bits past IncomingSignals::NUMBER_OF_OBJECTS stay clear.
+ObjectSignals decodeObjectSignals(const IncomingSignals& signals);
+
 struct OutgoingSignals
 {
 	static constexpr const char* START_SIM = "startSim";
@@ -97,37 +145,214 @@ struct OutgoingSignals
 		: startSim(false)
 		, targetObject(0)
 	{}
+
+	bool operator==(const OutgoingSignals&) const = default;
+};
+
+// Outgoing signals with the cause of the target decision they carry, for causal latency tracing.
+struct TracedOutgoingSignals
+{
+	OutgoingSignals signals;
+	DecisionCause cause;
+};
+
+// Hand pose at every opportunity; grasp, place and approach flags at 100 Hz, raised to 500 Hz for 3 s once the
+// robot starts approaching; object presence at 20 Hz; simStarted, canRestart and restart at 2 Hz, restart
+// raised to 50 Hz for 5 s once the scene can be restarted.
+PollingScheduleParameters makeDefaultPollingSchedule();
+
+struct CoppeliasimHandlerParameters
+{
+	// Unchanged outgoing signals are re-sent this often, zero disables the refresh.
+	std::chrono::milliseconds keepAlivePeriod;
+	// After a change, wait this long for further changes before writing them together.
+	std::chrono::microseconds coalescingWindow;
+	// Pipelined connection only: reads of the signals and of the hand pose each kept in flight,
+	// spread evenly over a round trip.
+	std::size_t readsInFlight;
+	// Between connection attempts.
+	ConnectionBackoff connectionBackoff;
+	// Shared memory only: how often the region is checked for new samples and outgoing changes.
+	std::chrono::microseconds sharedScenePollPeriod;
+	// Remote API only: how often each incoming flag and the hand pose are read. With the packed snapshot,
+	// one read covers every flag, and it is due as soon as any flag is.
+	PollingScheduleParameters pollingSchedule;
+	// Pipelined connection only: see RemoteApiExecutor; zero, the default, never busy-waits.
+	std::chrono::microseconds executorSpinThreshold;
+
+	CoppeliasimHandlerParameters(std::chrono::milliseconds keepAlivePeriod = std::chrono::milliseconds(500),
+		std::chrono::microseconds coalescingWindow = std::chrono::microseconds(1000),
+		std::size_t readsInFlight = 2,
+		const ConnectionBackoff& connectionBackoff = ConnectionBackoff(),
+		std::chrono::microseconds sharedScenePollPeriod = std::chrono::microseconds(50),
+		const PollingScheduleParameters& pollingSchedule = makeDefaultPollingSchedule(),
+		std::chrono::microseconds executorSpinThreshold = std::chrono::microseconds(0))
+		: keepAlivePeriod(keepAlivePeriod), coalescingWindow(coalescingWindow),
+		readsInFlight(readsInFlight), connectionBackoff(connectionBackoff),
+		sharedScenePollPeriod(sharedScenePollPeriod), pollingSchedule(pollingSchedule),
+		executorSpinThreshold(executorSpinThreshold)
+	{}
+};
+
+// How the handler talks to CoppeliaSim.
+enum class CoppeliasimTransport
+{
+	// Three blocking remote API connections, one thread each.
+	REMOTE_API_THREADS,
+	// Every call pipelined over one remote API connection.
+	PIPELINED,
+	// A shared memory region mapped by a simulator plugin on the same host (SharedSceneState::DEFAULT_NAME).
+	// No CoppeliaSim plugin serves it yet, so only tests use it and the executable does not offer it.
+	SHARED_MEMORY
 };
 
+struct OutgoingSignalsStatistics
+{
+	std::uint64_t writesSent;
+	std::uint64_t writesSuppressed;
+};
+
+// Three blocking connections, one thread each; or every call pipelined over one connection by coroutines
+// on a single executor thread; or, with the simulator on the same host, a shared memory region polled by
+// one thread.
 class CoppeliasimHandler
 {
 private:
-	coppeliasim_cpp::CoppeliaSimClient incomingSignalsClient;
-	coppeliasim_cpp::CoppeliaSimClient outgoingSignalsClient;
-	coppeliasim_cpp::CoppeliaSimClient handClient;
+	// Writes of one pass of the outgoing signals.
+	struct SignalWrites
+	{
+		OutgoingSignals signals;
+		std::vector<std::pair<std::string, int>> writes;
+		// The traced target decision change these writes carry, if any.
+		std::optional<DecisionCause> tracedCause;
+	};
+
+	CoppeliasimHandlerParameters parameters;
+	std::unique_ptr<RemoteApiClient> incomingSignalsClient;
+	std::unique_ptr<RemoteApiClient> outgoingSignalsClient;
+	std::unique_ptr<RemoteApiClient> handClient;
 	std::thread incomingSignalsThread;
 	std::thread outgoingSignalsThread;
 	std::thread handThread;
-	IncomingSignals incomingSignals;
-	OutgoingSignals outgoingSignals;
+	// Pipelined connection.
+	std::unique_ptr<RemoteApiExecutor> executor;
+	std::unique_ptr<AsyncRemoteApiClient> asyncClient;
+	std::unique_ptr<RemoteApiExecutor::Event> outgoingSignalsEvent;
+	std::unique_ptr<RemoteApiExecutor::Event> stopEvent;
+	std::thread executorThread;
+	// Shared memory.
+	std::unique_ptr<SharedSceneClient> sharedScene;
+	std::thread sharedSceneThread;
+	std::atomic<bool> stopRequested;
+	// The transport gave up for good, see hasFailed().
+	std::atomic<bool> failed;
+	// Incoming flags first, in packed snapshot order, so the index of a flag is its bit; then the hand.
+	PollingSchedule pollingSchedule;
+	std::vector<std::size_t> flagTargets;
+	std::size_t handTarget;
+	// The hand is read on its own thread with three blocking connections.
+	mutable std::mutex pollingScheduleMutex;
+	// Every flag as last read, for the flags that are not due.
+	IncomingSignals polledSignals;
+	// Whether the connected scene publishes the packed snapshot; unknown until it has started. Detected once
+	// per connection.
+	std::optional<bool> packedSignals;
+	SnapshotPublisher<IncomingSignals> incomingSignals;
+	SnapshotPublisher<TracedOutgoingSignals> outgoingSignals;
+	SnapshotPublisher<Pose> handPose;
 	HumanHand hand;
+	ChangeNotifier outgoingSignalsChanged;
+	ChangeNotifier* incomingChangeNotifier;
+	CausalLatencyTracer* causalLatencyTracer;
+	PoseTelemetryWriter* handPoseTelemetry;
+	// Last value acknowledged by the simulator for each outgoing signal.
+	std::optional<bool> sentStartSim;
+	std::optional<int> sentTargetObject;
+	std::chrono::steady_clock::time_point lastRefreshTime;
+	std::atomic<std::uint64_t> writesSent;
+	std::atomic<std::uint64_t> writesSuppressed;
+	ThreadActivity incomingSignalsActivity;
+	ThreadActivity outgoingSignalsActivity;
+	ThreadActivity handActivity;
+	ThreadActivity sharedSceneActivity;
 public:
-	CoppeliasimHandler();
+	CoppeliasimHandler(const CoppeliasimHandlerParameters& parameters = CoppeliasimHandlerParameters());
+	CoppeliasimHandler(std::unique_ptr<RemoteApiClient> incomingSignalsClient,
+		std::unique_ptr<RemoteApiClient> outgoingSignalsClient,
+		std::unique_ptr<RemoteApiClient> handClient,
+		const CoppeliasimHandlerParameters& parameters = CoppeliasimHandlerParameters());
+	explicit CoppeliasimHandler(std::unique_ptr<PipelinedConnection> connection,
+		const CoppeliasimHandlerParameters& parameters = CoppeliasimHandlerParameters());
+	explicit CoppeliasimHandler(std::unique_ptr<SharedSceneClient> sharedScene,
+		const CoppeliasimHandlerParameters& parameters = CoppeliasimHandlerParameters());
 	~CoppeliasimHandler();
 
 	void init();
-	void setSignals(const OutgoingSignals& signals);
+	// Notified whenever new incoming signals or a new hand pose are published.
+	void setChangeNotifier(ChangeNotifier* notifier);
+	// Told when a traced target decision change has been written.
+	void setCausalLatencyTracer(CausalLatencyTracer* tracer);
+	// Records every hand pose sample on the thread that receives it; set before init().
+	void setHandPoseTelemetry(PoseTelemetryWriter* telemetry);
+	// cause: the decision change the target object comes from, if traced.
+	void setSignals(const OutgoingSignals& signals, const DecisionCause& cause = {});
 	IncomingSignals getSignals() const;
+	Snapshot<IncomingSignals> getSignalsSnapshot() const;
 	Pose getHandPose() const;
+	Snapshot<Pose> getHandPoseSnapshot() const;
 	void end();
 
 	bool isConnected() const;
-	void resetSignals() const;
+	// The connection cannot be made, e.g. the shared scene has another layout; it was logged and will not be retried.
+	bool hasFailed() const { return failed.load(std::memory_order_relaxed); }
+	std::vector<const ThreadActivity*> getThreadActivities() const;
+	OutgoingSignalsStatistics getOutgoingSignalsStatistics() const;
 private:
 	void incomingSignalsLoop();
+	// Zeroes every signal of the scene. With blocking connections, on the incoming signals thread before the
+	// outgoing one starts; the pipelined connection resets before it spawns its writer.
+	void resetSignals() const;
 	void outgoingSignalsLoop();
 	void readHandPosition();
 	void readSignals();
-	void writeSignals() const;
+	void onIndividualSignalsRead(const IncomingSignals& signals);
+	void writeSignals();
+	// Of a request/response read.
+	void publishSignals(const IncomingSignals& signals, std::chrono::steady_clock::time_point requestTime,
+		std::chrono::steady_clock::time_point responseTime);
+	void publishHandPose(const Pose& pose, std::chrono::steady_clock::time_point requestTime,
+		std::chrono::steady_clock::time_point responseTime);
+	void publishSignals(const IncomingSignals& signals, std::chrono::steady_clock::time_point captureTime);
+	void publishHandPose(const Pose& pose, std::chrono::steady_clock::time_point captureTime);
+	// The writes due now, taken as acknowledged.
+	SignalWrites planWrites();
+	void onWritesAcknowledged(const SignalWrites& writes);
+	// Returns true if the value is to be written.
+	template<typename T>
+	bool planWrite(const char* name, T value, std::optional<T>& sentValue, bool refresh, SignalWrites& writes);
+
+	bool isRunningPipelined() const;
+	Task<void> runPipelined();
+	Task<void> readSignalsPipelined();
+	Task<void> readHandPosePipelined();
+	Task<void> writeSignalsPipelined();
+
+	// Calls connect until it succeeds, waiting longer after each failure; false once stopped or failed.
+	bool connectWithBackoff(const std::function<bool()>& connect);
+	void sharedSceneLoop();
+	bool connectSharedScene();
+	void setupPollingSchedule();
+	// Flags due at time, by priority.
+	std::vector<std::size_t> getDueFlags(std::chrono::steady_clock::time_point time) const;
+	std::chrono::steady_clock::time_point getNextFlagReadTime(std::chrono::steady_clock::time_point time) const;
+	// Of the signals read, flags were sent at time.
+	void onFlagsRead(const IncomingSignals& signals, const std::vector<std::size_t>& flags,
+		std::chrono::steady_clock::time_point time);
+	std::chrono::steady_clock::duration getHandReadPeriod(std::chrono::steady_clock::time_point time) const;
+	void onHandRead(std::chrono::steady_clock::time_point time);
 	void printSignals() const;
 };
+
+// The handler for a CoppeliaSim on this host over the given transport.
+CoppeliasimHandler makeCoppeliasimHandler(CoppeliasimTransport transport,
+	const CoppeliasimHandlerParameters& parameters = CoppeliasimHandlerParameters());
@@ -1,13 +1,61 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
+
 #include <elements/element_factory.h>
 
+#include "convolution_engine.h"
+#include "workspace.h"
+
+class WorkspaceStimulus;
+
 enum class DnfArchitectureType
 {
 	HAND_MOTION,
 	ACTION_LIKELIHOOD,
 };
 
-std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureHandMotion(const std::string& id, const double& deltaT);
+// Elements the control loop touches every tick, resolved once when the architecture is built.
+// Non-owning, valid for as long as the simulation that owns the elements.
+struct DnfArchitectureHandles
+{
+	dnf_composer::element::NeuralField* ael = nullptr;
+	// "object stimuli", one Gaussian per workspace object.
+	WorkspaceStimulus* objectStimuli = nullptr;
+	// HAND_MOTION: "hand position stimulus".
+	dnf_composer::element::GaussStimulus* handPositionStimulus = nullptr;
+	// ACTION_LIKELIHOOD: "hand position stimuli", one Gaussian per workspace object.
+	WorkspaceStimulus* handLikelihoodStimuli = nullptr;
+};
+
+struct DnfArchitecture
+{
+	std::shared_ptr<dnf_composer::Simulation> simulation;
+	DnfArchitectureHandles handles;
+};
+
+struct DnfArchitectureOptions
+{
+	// Seeds every NormalNoise element so runs are reproducible; without it the library's random noise is used.
+	std::optional<std::uint64_t> noiseSeed;
+	// Replaces the hand-tuned "ael -> ael" kernel, for parameter sweeps.
+	std::optional<dnf_composer::element::LateralInteractionsParameters> aelLateralInteractions;
+	// How the kernels convolve; without it the library's own GaussKernel and LateralInteractions are used.
+	std::optional<ConvolutionMethod> convolution;
+	// Objects on the table and the field dimensions.
+	Workspace workspace;
+
+	DnfArchitectureOptions(std::optional<std::uint64_t> noiseSeed = std::nullopt,
+		std::optional<dnf_composer::element::LateralInteractionsParameters> aelLateralInteractions = std::nullopt,
+		std::optional<ConvolutionMethod> convolution = ConvolutionMethod::AUTOMATIC,
+		const Workspace& workspace = Workspace::getDefault())
+		: noiseSeed(noiseSeed), aelLateralInteractions(aelLateralInteractions), convolution(convolution), workspace(workspace)
+	{}
+};
+
+DnfArchitecture getDynamicNeuralFieldArchitectureHandMotion(const std::string& id, const double& deltaT,
+	const DnfArchitectureOptions& options = {});
 
-std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureActionLikelihood(const std::string& id, const double& deltaT);
\ No newline at end of file
+DnfArchitecture getDynamicNeuralFieldArchitectureActionLikelihood(const std::string& id, const double& deltaT,
+	const DnfArchitectureOptions& options = {});
\ No newline at end of file
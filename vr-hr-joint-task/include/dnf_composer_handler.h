@@ -1,44 +1,140 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <thread>
 
 #include <application/application.h>
 #include <simulation/simulation.h>
 #include <user_interface/plot_window.h>
 
+#include "change_notifier.h"
 #include "dnf_architecture.h"
+#include "fixed_step_runner.h"
+#include "fused_dnf_architecture.h"
+#include "gauss_stimulus_updater.h"
+#include "hand_kinematics.h"
+#include "metrics.h"
 #include "misc.h"
+#include "snapshot_publisher.h"
+#include "target_decision.h"
+#include "workspace.h"
+#include "workspace_stimulus.h"
+
+// What steps the fields.
+enum class DnfBackend
+{
+	// The dnf_composer simulation, which the plot windows draw.
+	ELEMENT_GRAPH,
+	// FusedDnfArchitecture: the same fields without the element graph, headless only.
+	FUSED,
+};
+
+struct DnfComposerHandlerParameters
+{
+	// Attach the plot windows; without them the simulation runs headless.
+	bool userInterface;
+	// REAL_TIME ties every step to deltaT of wall-clock time, so the field time constants keep their meaning
+	// whatever the plot windows cost; AS_FAST_AS_POSSIBLE is for offline runs.
+	SteppingMode steppingMode;
+	// Noise seed (for sessions that must be replayed bit for bit) and kernel overrides.
+	DnfArchitectureOptions architectureOptions;
+	// Late steps run back to back to catch up, at most this many; see FixedStepRunner.
+	int maxCatchUpSteps;
+	DnfBackend backend;
+
+	DnfComposerHandlerParameters(bool userInterface = true, SteppingMode steppingMode = SteppingMode::REAL_TIME,
+		const DnfArchitectureOptions& architectureOptions = {}, int maxCatchUpSteps = 2,
+		DnfBackend backend = DnfBackend::ELEMENT_GRAPH)
+		: userInterface(userInterface), steppingMode(steppingMode), architectureOptions(architectureOptions),
+		maxCatchUpSteps(maxCatchUpSteps), backend(backend)
+	{}
+};
+
+// Stimulus inputs as set by the control thread, applied to the elements by the thread that steps the fields.
+struct HandPositionInput
+{
+	double amplitude;
+	double position;
+};
+
+using HandLikelihoodInput = std::array<double, Workspace::MAX_OBJECTS>;
 
 class DnfComposerHandler
 {
 private:
 	DnfArchitectureType dnf;
+	double deltaT;
+	// ELEMENT_GRAPH: the simulation and its elements; FUSED: the fused fields, with no simulation.
 	std::shared_ptr<dnf_composer::Simulation> simulation;
+	DnfArchitectureHandles handles;
+	std::unique_ptr<FusedDnfArchitecture<>> fused;
+	// Written by the const per-tick setters, read before every step.
+	mutable SnapshotPublisher<HandPositionInput> handPositionInput;
+	mutable SnapshotPublisher<HandLikelihoodInput> handLikelihoodInput;
+	mutable SnapshotPublisher<ObjectSet> availableObjectsInput;
+	// On the thread that steps the fields: the input sequences applied so far, the hand stimulus profile cache and
+	// one likelihood per workspace object, reused every step.
+	std::uint64_t appliedHandPosition;
+	std::uint64_t appliedHandLikelihoods;
+	std::uint64_t appliedAvailableObjects;
+	GaussStimulusUpdater handPositionStimulus;
+	std::vector<double> handLikelihoods;
+	PositionArrays objectPositions;
 	std::shared_ptr<dnf_composer::Application> application;
-	std::thread simulationThread;
+	DnfArchitectureOptions architectureOptions;
+	FixedStepRunner runner;
+	TargetDecisionTracker targetDecision;
+	std::jthread simulationThread;
+	ChangeNotifier* stepNotifier;
 public:
-	DnfComposerHandler(DnfArchitectureType dnf, double deltaT);
+	DnfComposerHandler(DnfArchitectureType dnf, double deltaT,
+		const DnfComposerHandlerParameters& parameters = DnfComposerHandlerParameters());
 	~DnfComposerHandler();
 
 	void init();
-	void run() const;
+	// Notified after every simulation step.
+	void setChangeNotifier(ChangeNotifier* notifier);
+	void run(const std::stop_token& stopToken);
+	// Headless runs stop right away, with the user interface attached this waits for the window to close.
 	void end();
 
-	void setHandStimulus(const Position& position, 
-		bool object1,
-		bool object2,
-		bool object3) const;
+	// Manual stepping on the calling thread, for headless handlers that were not init()ed (replay, tests).
+	void initSimulation();
+	void stepSimulation();
+	void closeSimulation();
+
+	bool isHeadless() const { return application == nullptr; }
+	std::uint64_t getNumberOfSteps() const { return runner.getNumberOfSteps(); }
+	// Steps, missed deadlines and lateness of the simulation thread.
+	std::string getSteppingReport() const { return runner.getReport("DNF"); }
+	// When the stimuli set now are first read by a step.
+	std::chrono::steady_clock::time_point getNextStepTime() const { return runner.getNextStepTime(); }
+	DnfArchitectureType getArchitectureType() const { return dnf; }
+	DnfBackend getBackend() const { return fused ? DnfBackend::FUSED : DnfBackend::ELEMENT_GRAPH; }
+	double getDeltaT() const { return deltaT; }
+	std::optional<std::uint64_t> getNoiseSeed() const { return architectureOptions.noiseSeed; }
+	const Workspace& getWorkspace() const { return architectureOptions.workspace; }
+
+	// hand is the hand state at the time of the step that reads the stimulus, see getNextStepTime().
+	// The stimuli are published to the thread that steps the fields, which applies them before its next step.
+	void setHandStimulus(const HandKinematics& hand, const ObjectSet& availableObjects) const;
+	// As of the last step, O(1) from any thread.
 	int getTargetObject() const;
-	void setAvailableObjectsInTheWorkspace(bool object1, bool object2, bool object3) const;
+	Snapshot<TargetDecision> getTargetDecision() const;
+	std::vector<double> getActionExecutionActivation() const;
+	void setAvailableObjectsInTheWorkspace(const ObjectSet& availableObjects) const;
 private:
-	void setHandStimulusDependingOnHumanActionLikelihood(const Position& position, 
-		bool object1, 
-		bool object2, 
-		bool object3) const;
+	void setHandStimulusDependingOnHumanActionLikelihood(const HandKinematics& hand, const ObjectSet& availableObjects) const;
 	void setHandStimulusDependingOnHumanHandPosition(const Position& position) const;
 	static double calculateHandDistanceToObjects(const Position& position);
 	static double calculateHandProximityToObjects(double distance);
-	static double normalizeHandPosition(double handPositionY);
 	void setupUserInterface() const;
+	// On the thread that steps the fields.
+	void applyStimulusInputs();
+	double getActionExecutionCentroid() const;
+	void resetTargetDecision();
+	void updateTargetDecision();
 };
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <optional>
+
+#include <elements/element_factory.h>
+
+#include "convolution_engine.h"
+
+// GaussKernel and LateralInteractions that keep the library's kernel but convolve through a ConvolutionEngine,
+// so wide fields and wide kernels switch to FFT convolution. The kernel is taken from the element once init()
+// has built it; circular kernels fall back to the library's own step().
+class EngineGaussKernel : public dnf_composer::element::GaussKernel
+{
+private:
+	ConvolutionMethod method;
+	std::optional<ConvolutionEngine> engine;
+public:
+	EngineGaussKernel(const dnf_composer::element::ElementCommonParameters& elementCommonParameters,
+		const dnf_composer::element::GaussKernelParameters& parameters, ConvolutionMethod method = ConvolutionMethod::AUTOMATIC);
+
+	void init() override;
+	void step(double t, double deltaT) override;
+	std::shared_ptr<dnf_composer::element::Element> clone() const override;
+
+	const std::optional<ConvolutionEngine>& getEngine() const { return engine; }
+};
+
+class EngineLateralInteractions : public dnf_composer::element::LateralInteractions
+{
+private:
+	ConvolutionMethod method;
+	std::optional<ConvolutionEngine> engine;
+public:
+	EngineLateralInteractions(const dnf_composer::element::ElementCommonParameters& elementCommonParameters,
+		const dnf_composer::element::LateralInteractionsParameters& parameters, ConvolutionMethod method = ConvolutionMethod::AUTOMATIC);
+
+	void init() override;
+	void step(double t, double deltaT) override;
+	std::shared_ptr<dnf_composer::element::Element> clone() const override;
+
+	const std::optional<ConvolutionEngine>& getEngine() const { return engine; }
+};
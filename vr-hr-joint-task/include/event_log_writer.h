@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "change_notifier.h"
+#include "mpsc_queue.h"
+
+enum class LogLevel
+{
+    CONTROL,
+    ROBOT,
+    HUMAN,
+};
+
+enum class LogEventId : std::uint16_t
+{
+	MESSAGE,
+	CONNECTED_WITH_COPPELIASIM,
+	SIMULATION_STARTED,
+	ROBOT_GRASPING,
+	ROBOT_PLACING,
+	ROBOT_TARGETING,
+	HUMAN_GRASPING,
+	HUMAN_PLACING,
+};
+
+// Formatting is deferred to the writer thread; only MESSAGE events carry text.
+struct LogEvent
+{
+	LogLevel level = LogLevel::CONTROL;
+	LogEventId id = LogEventId::MESSAGE;
+	int objectId = 0;
+	std::chrono::system_clock::time_point timestamp;
+	std::string message;
+};
+
+struct EventLogWriterParameters
+{
+	std::size_t queueCapacity;
+	// A batch is written and flushed once it holds this many bytes...
+	std::size_t groupCommitBytes;
+	// ...or once its oldest event has waited this long.
+	std::chrono::milliseconds groupCommitPeriod;
+
+	EventLogWriterParameters(std::size_t queueCapacity = 8192,
+		std::size_t groupCommitBytes = 64 * 1024,
+		std::chrono::milliseconds groupCommitPeriod = std::chrono::milliseconds(100))
+		: queueCapacity(queueCapacity), groupCommitBytes(groupCommitBytes), groupCommitPeriod(groupCommitPeriod)
+	{}
+};
+
+// Text event log written by a background thread.
+// push() is lock-free and never blocks: when the queue is full the event is dropped and counted.
+class EventLogWriter
+{
+public:
+	static constexpr std::chrono::milliseconds SIGNAL_POLL_PERIOD{ 100 };
+private:
+	EventLogWriterParameters parameters;
+	MpscQueue<LogEvent> events;
+	ChangeNotifier eventsPushed;
+	std::ofstream file;
+	std::jthread writerThread;
+	// Writer thread state.
+	std::string batch;
+	std::chrono::steady_clock::time_point batchStart;
+	std::time_t cachedSecond;
+	std::string cachedDatePrefix;
+	// Crash flush handshake with the writer thread.
+	std::atomic<bool> crashFlushRequested;
+	std::atomic<bool> crashFlushDone;
+	// Touched by signal handlers, so they must stay lock-free; polled by the writer thread.
+	std::atomic<bool> running;
+	std::atomic<int> pendingSignal;
+	std::atomic<std::uint64_t> logged;
+	std::atomic<std::uint64_t> dropped;
+	std::atomic<std::uint64_t> commits;
+public:
+	explicit EventLogWriter(const EventLogWriterParameters& parameters = {});
+	~EventLogWriter();
+
+	bool open(const std::string& path);
+	bool push(LogEvent&& event);
+	// Writes every pending event and closes the file.
+	void close();
+	// Commits every pending event from any thread, for the terminate handler. Not async-signal-safe.
+	void flushOnCrash();
+	// Async-signal-safe: only records the signal. The writer thread commits every pending event at its next
+	// wakeup, at most SIGNAL_POLL_PERIOD later, then raises the signal again with its default action.
+	// Returns false if no writer thread runs.
+	bool requestFlushOnSignal(int signal);
+
+	bool isOpen() const { return file.is_open(); }
+	std::uint64_t getNumberOfLogged() const { return logged.load(std::memory_order_relaxed); }
+	std::uint64_t getNumberOfDropped() const { return dropped.load(std::memory_order_relaxed); }
+	std::uint64_t getNumberOfCommits() const { return commits.load(std::memory_order_relaxed); }
+private:
+	void writeLoop(const std::stop_token& stopToken);
+	void drain();
+	void commit();
+	void raisePendingSignal();
+	void format(const LogEvent& event);
+	const std::string& getDatePrefix(std::chrono::system_clock::time_point timestamp);
+};
@@ -1,23 +1,32 @@
 #pragma once
 
-#include <fstream>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
 
-enum class LogLevel
-{
-    CONTROL,
-    ROBOT,
-    HUMAN,
-};
+#include "misc.h"
+#include "event_log_writer.h"
+#include "metrics.h"
+#include "pose_telemetry.h"
 
 class EventLogger
 {
-    static std::ofstream logFile;
-    static std::ofstream humanHandPoseFile;
+    static EventLogWriter logWriter;
+    static PoseTelemetryWriter humanHandPoseStream;
+    static MetricsReporter metricsReporter;
     static std::string sessionDirectory;
 public:
     static void initialize();
+    // Both overloads only queue the event, the writer thread formats and writes it.
+    static void log(LogLevel level, LogEventId event, int objectId = 0);
     static void log(LogLevel level, const std::string& message);
-    static void logHumanHandPose(const std::string& message);
+    // The binary hand pose stream, nullptr unless initialize() opened it. Samples are recorded on the thread that
+    // receives them, see CoppeliasimHandler::setHandPoseTelemetry().
+    static PoseTelemetryWriter* getHumanHandPoseStream();
     static void finalize();
+
+    static const std::string& getSessionDirectory() { return sessionDirectory; }
+private:
+    static void installCrashHandlers();
+    static void flushOnCrash();
 };
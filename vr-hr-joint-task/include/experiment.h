@@ -1,17 +1,29 @@
 #pragma once
 
+#include <chrono>
+
+#include "causal_latency.h"
 #include "dnf_architecture.h"
 #include "dnf_composer_handler.h"
 #include "coppeliasim_handler.h"
 #include "event_logger.h"
+#include "hand_kinematics.h"
+#include "session_trace.h"
 
 struct ExperimentParameters
 {
 	DnfArchitectureType dnf;
 	double deltaT;
+	// Longest the control loop sleeps when neither CoppeliaSim nor the DNF publish anything new.
+	std::chrono::milliseconds maxControlPeriod;
+	DnfComposerHandlerParameters dnfParameters;
+	CoppeliasimTransport transport;
 
-	ExperimentParameters(DnfArchitectureType dnf, double deltaT)
-	: dnf(dnf), deltaT(deltaT)
+	ExperimentParameters(DnfArchitectureType dnf, double deltaT,
+		std::chrono::milliseconds maxControlPeriod = std::chrono::milliseconds(20),
+		const DnfComposerHandlerParameters& dnfParameters = DnfComposerHandlerParameters(),
+		CoppeliasimTransport transport = CoppeliasimTransport::REMOTE_API_THREADS)
+	: dnf(dnf), deltaT(deltaT), maxControlPeriod(maxControlPeriod), dnfParameters(dnfParameters), transport(transport)
 	{}
 };
 
@@ -19,35 +31,13 @@ struct LogMsgs
 {
     int lastTargetObject = -1;
 	bool prevSimStarted = false;
-    bool prevRobotGraspObj1 = false;
-    bool prevRobotGraspObj2 = false;
-    bool prevRobotGraspObj3 = false;
-    bool prevHumanGraspObj1 = false;
-    bool prevHumanGraspObj2 = false;
-    bool prevHumanGraspObj3 = false;
-    bool prevRobotPlaceObj1 = false;
-    bool prevRobotPlaceObj2 = false;
-    bool prevRobotPlaceObj3 = false;
-    bool prevHumanPlaceObj1 = false;
-    bool prevHumanPlaceObj2 = false;
-    bool prevHumanPlaceObj3 = false;
+	ObjectSignals prevObjectSignals;
 
     void clear()
 	{
         lastTargetObject = -1;
 		prevSimStarted = false;
-        prevRobotGraspObj1 = false;
-        prevRobotGraspObj2 = false;
-        prevRobotGraspObj3 = false;
-        prevHumanGraspObj1 = false;
-        prevHumanGraspObj2 = false;
-        prevHumanGraspObj3 = false;
-        prevRobotPlaceObj1 = false;
-        prevRobotPlaceObj2 = false;
-        prevRobotPlaceObj3 = false;
-        prevHumanPlaceObj1 = false;
-        prevHumanPlaceObj2 = false;
-        prevHumanPlaceObj3 = false;
+		prevObjectSignals = {};
     }
 };
 
@@ -57,9 +47,21 @@ private:
 	DnfComposerHandler dnfComposerHandler;
 	CoppeliasimHandler coppeliasimHandler;
 	std::thread experimentThread;
+	ChangeNotifier controlNotifier;
+	std::chrono::milliseconds maxControlPeriod;
+	ThreadActivity controlActivity;
+	SessionRecorder sessionRecorder;
+	CausalLatencyTracer causalLatencyTracer;
+	DecisionCause decisionCause;
 	IncomingSignals inSignals;
+	ObjectSignals objectSignals;
 	OutgoingSignals outSignals;
 	Pose handPose;
+	Snapshot<Pose> handPoseSnapshot;
+	HandKinematicsEstimator handKinematics;
+	// DNF step time the current pass's stimuli are estimated for.
+	std::chrono::steady_clock::time_point stimulusTime;
+	std::uint64_t lastHandPoseSequence;
 	LogMsgs logMsgs;
 public:
 	Experiment(const ExperimentParameters& parameters);
@@ -79,7 +81,7 @@ private:
 	void sendTargetObjectToRobot();
 	void interpretAndLogSystemState();
 
+	void logRuntimeStatistics() const;
 	void keepAliveWhileTaskIsRunning() const;
 	bool areObjectsPresent() const;
-	bool areAllObjectsPresent() const;
 };
\ No newline at end of file
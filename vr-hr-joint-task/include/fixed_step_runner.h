@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <stop_token>
+#include <string>
+
+#include "metrics.h"
+
+enum class SteppingMode
+{
+	// Step k starts at start + k * period of wall-clock time, so the simulated time tracks the wall clock.
+	REAL_TIME,
+	// Simulated time only: steps back to back, as fast as the CPU allows (replay, sweeps, tests).
+	AS_FAST_AS_POSSIBLE,
+};
+
+// Calls a step function on a fixed period until stopped.
+// In real time, steps are due on absolute deadlines (clock_nanosleep with TIMER_ABSTIME where available),
+// so sleep overshoot does not accumulate. A step that starts after its deadline is a missed deadline;
+// the steps that fall behind are run back to back to catch up, but never more than maxCatchUpSteps of them:
+// beyond that the runner skips the deadlines it cannot make and the simulated time falls behind instead.
+// Lateness (start of a step minus its deadline) is kept in a histogram.
+class FixedStepRunner
+{
+private:
+	std::chrono::nanoseconds period;
+	SteppingMode mode;
+	int maxCatchUpSteps;
+	std::atomic<std::uint64_t> steps;
+	std::atomic<std::uint64_t> missedDeadlines;
+	std::atomic<std::uint64_t> skippedSteps;
+	LatencyHistogram lateness;
+	// Steady-clock nanoseconds of the next step, 0 when not running in real time.
+	std::atomic<std::int64_t> nextStepTimeNs;
+public:
+	FixedStepRunner(std::chrono::nanoseconds period, SteppingMode mode, int maxCatchUpSteps = 2);
+
+	// Runs until a stop is requested or step() returns false.
+	void run(const std::stop_token& stopToken, const std::function<bool()>& step);
+
+	std::uint64_t getNumberOfSteps() const { return steps.load(std::memory_order_relaxed); }
+	std::chrono::nanoseconds getPeriod() const { return period; }
+	SteppingMode getMode() const { return mode; }
+	int getMaxCatchUpSteps() const { return maxCatchUpSteps; }
+	// When the next step is due; now when steps run back to back or the runner is not running.
+	std::chrono::steady_clock::time_point getNextStepTime() const;
+
+	// Real-time accounting, all zero in AS_FAST_AS_POSSIBLE.
+	std::uint64_t getNumberOfMissedDeadlines() const { return missedDeadlines.load(std::memory_order_relaxed); }
+	// Deadlines given up on by the bounded catch-up; the simulated time lags the wall clock by as many periods.
+	std::uint64_t getNumberOfSkippedSteps() const { return skippedSteps.load(std::memory_order_relaxed); }
+	const LatencyHistogram& getLateness() const { return lateness; }
+	std::string getReport(const std::string& name) const;
+
+	// Sleeps until an absolute steady-clock time.
+	static void sleepUntil(std::chrono::steady_clock::time_point time);
+};
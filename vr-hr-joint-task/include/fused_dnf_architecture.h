@@ -0,0 +1,403 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "dnf_architecture.h"
+#include "seeded_normal_noise.h"
+
+// Both architectures are static graphs of four fields with fixed kernels, so they can be stepped without the
+// element graph: every array has a compile-time size, kernels are sampled once, and one pass per field sums its
+// inputs, applies the Euler step and the sigmoid. No virtual calls and no allocation per step.
+// Mirrors getDynamicNeuralFieldArchitectureHandMotion/ActionLikelihood element by element;
+// tests/test_fused_dnf_architecture.cpp checks the two against each other.
+
+// Kernels are sampled per position offset and cut off at CUT_OFF_FACTOR sigmas, as the library does.
+inline constexpr int FUSED_KERNEL_CUT_OFF_FACTOR = 5;
+
+// Non-circular "same" convolution with a symmetric precomputed kernel, plus a global term.
+template<std::size_t Size>
+class FusedKernel
+{
+public:
+	static constexpr std::size_t MAX_RADIUS = Size - 1;
+private:
+	alignas(64) std::array<double, 2 * MAX_RADIUS + 1> taps{};
+	// Input surrounded by MAX_RADIUS zeros on each side, so the inner loop needs no bounds checks.
+	alignas(64) std::array<double, Size + 2 * MAX_RADIUS> padded{};
+	std::size_t radius = 0;
+	double amplitudeGlobal = 0;
+public:
+	FusedKernel() = default;
+
+	static FusedKernel gauss(double sigma, double amplitude)
+	{
+		FusedKernel kernel;
+		kernel.radius = getRadius(sigma);
+		for (std::size_t k = 0; k <= 2 * kernel.radius; ++k)
+			kernel.taps[k] = amplitude * gaussian(static_cast<double>(k) - static_cast<double>(kernel.radius), sigma);
+		return kernel;
+	}
+
+	static FusedKernel lateralInteractions(const dnf_composer::element::LateralInteractionsParameters& parameters)
+	{
+		FusedKernel kernel;
+		kernel.radius = getRadius(std::max(parameters.sigmaExc, parameters.sigmaInh));
+		for (std::size_t k = 0; k <= 2 * kernel.radius; ++k)
+		{
+			const double x = static_cast<double>(k) - static_cast<double>(kernel.radius);
+			kernel.taps[k] = parameters.amplitudeExc * gaussian(x, parameters.sigmaExc)
+				- parameters.amplitudeInh * gaussian(x, parameters.sigmaInh);
+		}
+		kernel.amplitudeGlobal = parameters.amplitudeGlobal;
+		return kernel;
+	}
+
+	void apply(const std::array<double, Size>& input, std::array<double, Size>& output)
+	{
+		double sum = 0;
+		for (std::size_t i = 0; i < Size; ++i)
+		{
+			padded[MAX_RADIUS + i] = input[i];
+			sum += input[i];
+		}
+		output.fill(amplitudeGlobal * sum);
+		// One tap at a time over every output sample: a fixed-length, unit-stride inner loop the compiler vectorises.
+		const double* base = padded.data() + MAX_RADIUS + radius;
+		for (std::size_t k = 0; k <= 2 * radius; ++k)
+		{
+			const double tap = taps[k];
+			const double* shifted = base - k;
+			for (std::size_t i = 0; i < Size; ++i)
+				output[i] += tap * shifted[i];
+		}
+	}
+
+	std::size_t getRadius() const { return radius; }
+	double getTap(int offset) const { return taps[radius + offset]; }
+	double getAmplitudeGlobal() const { return amplitudeGlobal; }
+private:
+	static double gaussian(double x, double sigma)
+	{
+		return std::exp(-0.5 * x * x / (sigma * sigma));
+	}
+
+	static std::size_t getRadius(double sigma)
+	{
+		const auto radius = static_cast<std::size_t>(std::ceil(sigma * FUSED_KERNEL_CUT_OFF_FACTOR));
+		return std::min(radius, MAX_RADIUS);
+	}
+};
+
+template<std::size_t Size>
+struct FusedField
+{
+	double tau = 100;
+	double restingLevel = -5;
+	double xShift = 0;
+	double steepness = 4;
+	alignas(64) std::array<double, Size> activation{};
+	alignas(64) std::array<double, Size> output{};
+
+	void init()
+	{
+		activation.fill(restingLevel);
+		for (std::size_t i = 0; i < Size; ++i)
+			output[i] = sigmoid(activation[i]);
+	}
+
+	// Sums the inputs, Euler step and sigmoid in a single pass.
+	template<typename... Inputs>
+	void step(double deltaT, const Inputs&... inputs)
+	{
+		const double rate = deltaT / tau;
+		for (std::size_t i = 0; i < Size; ++i)
+		{
+			const double input = (inputs[i] + ...);
+			activation[i] += rate * (-activation[i] + restingLevel + input);
+			output[i] = sigmoid(activation[i]);
+		}
+	}
+
+	double sigmoid(double value) const
+	{
+		return 1.0 / (1.0 + std::exp(-steepness * (value - xShift)));
+	}
+};
+
+// Draws the same stream as a SeededNormalNoise of the same seed, so a seeded fused run follows a seeded simulation.
+template<std::size_t Size>
+class FusedNoise
+{
+private:
+	std::uint64_t seed;
+	double amplitude;
+	std::mt19937_64 engine;
+	std::normal_distribution<double> distribution;
+public:
+	alignas(64) std::array<double, Size> output{};
+
+	FusedNoise(std::uint64_t seed = 0, double amplitude = 0)
+		: seed(seed), amplitude(amplitude), engine(seed)
+	{}
+
+	void init()
+	{
+		engine.seed(seed);
+		distribution.reset();
+		output.fill(0);
+	}
+
+	void step(double deltaT)
+	{
+		const double scale = amplitude / std::sqrt(deltaT);
+		for (double& value : output)
+			value = scale * distribution(engine);
+	}
+};
+
+enum class FusedDnfLayer
+{
+	AOL,
+	ASL,
+	ORL,
+	AEL,
+};
+
+// The workspace of the options must have fields of Size samples; its objects get one stimulus profile each.
+// Not thread-safe: set the stimuli between steps, from the thread that steps.
+template<std::size_t Size = 100>
+class FusedDnfArchitecture
+{
+public:
+	static constexpr std::size_t SIZE = Size;
+private:
+	DnfArchitectureType type;
+	double deltaT;
+	double dX;
+	std::size_t numberOfObjects;
+
+	FusedField<Size> aol, asl, orl, ael;
+
+	FusedKernel<Size> aolAolKernel, aslAslKernel, aolAslKernel, orlOrlKernel, orlAslKernel, aslAelKernel, aelAelKernel, orlAelKernel;
+	// Kernel outputs of the previous step; each element of the library reads what the others produced last.
+	alignas(64) std::array<double, Size> aolAol{}, aslAsl{}, aolAsl{}, orlOrl{}, orlAsl{}, aslAel{}, aelAel{}, orlAel{};
+
+	FusedNoise<Size> aolNoise, aslNoise, orlNoise, aelNoise;
+
+	// Unit-amplitude object profiles, shared by the object and the hand likelihood stimuli.
+	std::vector<std::array<double, Size>> objectProfiles;
+	std::vector<double> objectAmplitudes;
+	std::vector<double> handLikelihoodAmplitudes;
+	double handPositionSigma;
+	double handPositionAmplitude;
+	double handPositionPosition;
+	// Sum of the stimuli into each layer, refreshed when a stimulus changes rather than every step.
+	alignas(64) std::array<double, Size> aolStimuli{};
+	alignas(64) std::array<double, Size> orlStimuli{};
+public:
+	FusedDnfArchitecture(DnfArchitectureType type, double deltaT, const DnfArchitectureOptions& options = {})
+		: type(type), deltaT(deltaT), dX(options.workspace.getSpatialStep()),
+		numberOfObjects(options.workspace.getNumberOfObjects())
+	{
+		using namespace dnf_composer::element;
+		constexpr double tau = 100;
+		constexpr double noiseAmplitude = 0.001;
+		constexpr double stimulusSigma = 3;
+		constexpr double stimulusAmplitude = 5;
+		constexpr bool circularity = false;
+		constexpr bool normalization = false;
+
+		// The library samples x_max / d_x positions per field.
+		const auto samples = static_cast<std::size_t>(options.workspace.getMaxSpatialDimension() / dX);
+		if (samples != Size)
+			throw std::runtime_error("The fused fields have " + std::to_string(Size) + " samples, the workspace fields have "
+				+ std::to_string(samples) + ".");
+
+		const bool handMotion = type == DnfArchitectureType::HAND_MOTION;
+		for (FusedField<Size>* field : { &aol, &asl, &orl, &ael })
+			*field = FusedField<Size>{ tau };
+		if (!handMotion)
+			ael.tau = tau + 20;
+
+		aolAolKernel = FusedKernel<Size>::gauss(1, 1.5);
+		aslAslKernel = FusedKernel<Size>::lateralInteractions(handMotion
+			? LateralInteractionsParameters{ 1, 2, 0.5, 1.5, -0.1, circularity, normalization }
+			: LateralInteractionsParameters{ 3.3, 5.626, 3.375, 5.03, -0.515, circularity, normalization });
+		aolAslKernel = FusedKernel<Size>::gauss(2.4, 0.755);
+		orlOrlKernel = FusedKernel<Size>::gauss(1, 2);
+		orlAslKernel = FusedKernel<Size>::gauss(1.9, 0.7);
+		aslAelKernel = FusedKernel<Size>::gauss(1, -1.5);
+		aelAelKernel = FusedKernel<Size>::lateralInteractions(options.aelLateralInteractions.value_or(
+			LateralInteractionsParameters{ 4.75, handMotion ? 8.143 : 8.37, 3.375, 5.677, -2.5, circularity, normalization }));
+		orlAelKernel = FusedKernel<Size>::gauss(2, 1.5);
+
+		// Unseeded runs still get independent noise per layer.
+		std::random_device randomDevice;
+		const auto seedFor = [&](const char* name) {
+			return options.noiseSeed ? SeededNormalNoise::deriveSeed(*options.noiseSeed, name)
+				: (static_cast<std::uint64_t>(randomDevice()) << 32) | randomDevice();
+		};
+		aolNoise = FusedNoise<Size>(seedFor("normal noise aol"), noiseAmplitude);
+		aslNoise = FusedNoise<Size>(seedFor("normal noise asl"), noiseAmplitude);
+		orlNoise = FusedNoise<Size>(seedFor("normal noise orl"), noiseAmplitude);
+		aelNoise = FusedNoise<Size>(seedFor("normal noise ael"), noiseAmplitude);
+
+		objectProfiles.resize(numberOfObjects);
+		for (std::size_t i = 0; i < numberOfObjects; ++i)
+			evaluateStimulus(objectProfiles[i], stimulusSigma, options.workspace.getObjects()[i].fieldPosition, 1);
+		objectAmplitudes.assign(numberOfObjects, stimulusAmplitude);
+		handLikelihoodAmplitudes.assign(numberOfObjects, 0);
+		handPositionSigma = stimulusSigma + 1;
+		handPositionAmplitude = 0;
+		handPositionPosition = 0;
+		updateAolStimuli();
+		updateOrlStimuli();
+	}
+
+	void init()
+	{
+		for (FusedField<Size>* field : { &aol, &asl, &orl, &ael })
+			field->init();
+		for (std::array<double, Size>* output : { &aolAol, &aslAsl, &aolAsl, &orlOrl, &orlAsl, &aslAel, &aelAel, &orlAel })
+			output->fill(0);
+		for (FusedNoise<Size>* noise : { &aolNoise, &aslNoise, &orlNoise, &aelNoise })
+			noise->init();
+	}
+
+	void step()
+	{
+		// Fields first, from last step's kernel and noise outputs, then the kernels and the noise from the new outputs:
+		// the order the library steps the elements in.
+		aol.step(deltaT, aolStimuli, aolAol, aolNoise.output);
+		asl.step(deltaT, aslAsl, aolAsl, orlAsl, aslNoise.output);
+		orl.step(deltaT, orlStimuli, orlOrl, orlNoise.output);
+		ael.step(deltaT, aslAel, aelAel, orlAel, aelNoise.output);
+
+		aolAolKernel.apply(aol.output, aolAol);
+		aolAslKernel.apply(aol.output, aolAsl);
+		aslAslKernel.apply(asl.output, aslAsl);
+		orlOrlKernel.apply(orl.output, orlOrl);
+		orlAslKernel.apply(orl.output, orlAsl);
+		aslAelKernel.apply(asl.output, aslAel);
+		aelAelKernel.apply(ael.output, aelAel);
+		orlAelKernel.apply(orl.output, orlAel);
+
+		for (FusedNoise<Size>* noise : { &aolNoise, &aslNoise, &orlNoise, &aelNoise })
+			noise->step(deltaT);
+	}
+
+	// Index i is object i+1, as DnfArchitectureHandles::objectStimuli.
+	void setObjectStimulusAmplitude(std::size_t index, double amplitude)
+	{
+		objectAmplitudes.at(index) = amplitude;
+		updateOrlStimuli();
+	}
+
+	// amplitude for the objects in the set, 0 for the others, as WorkspaceStimulus::setAmplitudes().
+	void setObjectStimulusAmplitudes(const ObjectSet& objects, double amplitude)
+	{
+		for (std::size_t i = 0; i < numberOfObjects; ++i)
+			objectAmplitudes[i] = objects.test(i) ? amplitude : 0;
+		updateOrlStimuli();
+	}
+
+	// HAND_MOTION only.
+	void setHandPositionStimulus(double amplitude, double position)
+	{
+		if (type != DnfArchitectureType::HAND_MOTION)
+			throw std::logic_error("The action likelihood architecture has no hand position stimulus.");
+		handPositionAmplitude = amplitude;
+		handPositionPosition = position;
+		updateAolStimuli();
+	}
+
+	// ACTION_LIKELIHOOD only. Index i is object i+1, as DnfArchitectureHandles::handLikelihoodStimuli.
+	void setHandLikelihoodStimulusAmplitude(std::size_t index, double amplitude)
+	{
+		if (type != DnfArchitectureType::ACTION_LIKELIHOOD)
+			throw std::logic_error("The hand motion architecture has no hand likelihood stimuli.");
+		handLikelihoodAmplitudes.at(index) = amplitude;
+		updateAolStimuli();
+	}
+
+	// ACTION_LIKELIHOOD only. One amplitude per object.
+	void setHandLikelihoodStimulusAmplitudes(const std::vector<double>& amplitudes)
+	{
+		if (type != DnfArchitectureType::ACTION_LIKELIHOOD)
+			throw std::logic_error("The hand motion architecture has no hand likelihood stimuli.");
+		std::copy_n(amplitudes.begin(), std::min(amplitudes.size(), numberOfObjects), handLikelihoodAmplitudes.begin());
+		updateAolStimuli();
+	}
+
+	const FusedField<Size>& getLayer(FusedDnfLayer layer) const
+	{
+		switch (layer)
+		{
+		case FusedDnfLayer::AOL: return aol;
+		case FusedDnfLayer::ASL: return asl;
+		case FusedDnfLayer::ORL: return orl;
+		case FusedDnfLayer::AEL: return ael;
+		}
+		return ael;
+	}
+
+	// Output-weighted mean position of the action execution samples above 0, in field units; -1 without a peak.
+	double getCentroid() const
+	{
+		double weightedSum = 0;
+		double sum = 0;
+		for (std::size_t i = 0; i < Size; ++i)
+		{
+			if (ael.activation[i] <= 0)
+				continue;
+			weightedSum += static_cast<double>(i) * ael.output[i];
+			sum += ael.output[i];
+		}
+		return sum > 0 ? weightedSum / sum * dX : -1;
+	}
+
+	DnfArchitectureType getArchitectureType() const { return type; }
+	double getDeltaT() const { return deltaT; }
+	double getSpatialStep() const { return dX; }
+	std::size_t getNumberOfObjects() const { return numberOfObjects; }
+private:
+	void evaluateStimulus(std::array<double, Size>& output, double sigma, double position, double amplitude) const
+	{
+		for (std::size_t i = 0; i < Size; ++i)
+		{
+			const double x = static_cast<double>(i) * dX - position;
+			output[i] = amplitude * std::exp(-0.5 * x * x / (sigma * sigma));
+		}
+	}
+
+	void updateAolStimuli()
+	{
+		if (type == DnfArchitectureType::HAND_MOTION)
+		{
+			evaluateStimulus(aolStimuli, handPositionSigma, handPositionPosition, handPositionAmplitude);
+			return;
+		}
+		aolStimuli.fill(0);
+		for (std::size_t j = 0; j < numberOfObjects; ++j)
+			for (std::size_t i = 0; i < Size; ++i)
+				aolStimuli[i] += handLikelihoodAmplitudes[j] * objectProfiles[j][i];
+	}
+
+	void updateOrlStimuli()
+	{
+		orlStimuli.fill(0);
+		for (std::size_t j = 0; j < numberOfObjects; ++j)
+			for (std::size_t i = 0; i < Size; ++i)
+				orlStimuli[i] += objectAmplitudes[j] * objectProfiles[j][i];
+	}
+};
+
+extern template class FusedKernel<100>;
+extern template class FusedDnfArchitecture<100>;
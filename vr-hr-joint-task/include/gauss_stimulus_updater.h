@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <elements/element_factory.h>
+
+// Applies per-tick updates to a GaussStimulus without re-evaluating the Gaussian when only the amplitude changes.
+// A position change sets the element parameters, which evaluates the Gaussian once, and the unit-amplitude profile
+// is derived from that output; an amplitude change rescales it straight into the element output and an identical
+// update does not touch the element at all. At amplitude 0 the output carries no shape, the profile is derived at
+// the next nonzero amplitude instead.
+// Relies on GaussStimulus computing its output only when its parameters are set, not on every step.
+// The element keeps the parameters of the last profile evaluation, which it renders again when initialised; after
+// an amplitude-only update its getParameters().amplitude lags until the next position change.
+// Writes the element output, so call it on the thread that steps the simulation.
+class GaussStimulusUpdater
+{
+private:
+	dnf_composer::element::GaussStimulus* stimulus;
+	dnf_composer::element::GaussStimulusParameters parameters;
+	// Empty while the last evaluation was at amplitude 0.
+	std::vector<double> unitProfile;
+	std::uint64_t profileEvaluations;
+	std::uint64_t rescales;
+	std::uint64_t skips;
+public:
+	explicit GaussStimulusUpdater(dnf_composer::element::GaussStimulus* stimulus = nullptr);
+
+	void setAmplitude(double amplitude);
+	void setAmplitudeAndPosition(double amplitude, double position);
+
+	double getAmplitude() const { return parameters.amplitude; }
+	std::uint64_t getNumberOfProfileEvaluations() const { return profileEvaluations; }
+	std::uint64_t getNumberOfRescales() const { return rescales; }
+	std::uint64_t getNumberOfSkips() const { return skips; }
+private:
+	void evaluateProfile(double position, double amplitude);
+	void rescale(double amplitude);
+};
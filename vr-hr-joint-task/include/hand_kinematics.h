@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "misc.h"
+#include "snapshot_publisher.h"
+
+struct HandKinematicsParameters
+{
+	// Pose samples kept for interpolation.
+	std::size_t capacity;
+	// Time constants of the first-order filters on the finite-difference velocity and acceleration.
+	std::chrono::duration<double> velocityTimeConstant;
+	std::chrono::duration<double> accelerationTimeConstant;
+	// Estimates past the newest sample extrapolate at most this far.
+	std::chrono::duration<double> maxExtrapolation;
+
+	HandKinematicsParameters(std::size_t capacity = 32,
+		std::chrono::duration<double> velocityTimeConstant = std::chrono::milliseconds(40),
+		std::chrono::duration<double> accelerationTimeConstant = std::chrono::milliseconds(80),
+		std::chrono::duration<double> maxExtrapolation = std::chrono::milliseconds(100))
+		: capacity(capacity), velocityTimeConstant(velocityTimeConstant),
+		accelerationTimeConstant(accelerationTimeConstant), maxExtrapolation(maxExtrapolation)
+	{}
+};
+
+// Hand state at one instant. velocity (m/s) and acceleration (m/s^2) are per axis.
+struct HandKinematics
+{
+	// Newest pose sample the state is based on, 0 before the first one.
+	std::uint64_t sequence = 0;
+	std::chrono::steady_clock::time_point time;
+	Position position{ 0, 0, 0 };
+	Position velocity{ 0, 0, 0 };
+	Position acceleration{ 0, 0, 0 };
+
+	bool isValid() const { return sequence != 0; }
+	double getSpeed() const { return calculateEuclideanDistance(velocity, { 0, 0, 0 }); }
+};
+
+// Hand kinematics from source-timestamped pose samples. Velocity and acceleration are computed once per new
+// sample and kept with it in a fixed-capacity ring, so estimates at any time between the oldest sample and
+// shortly after the newest one are an interpolation or a bounded extrapolation, with no allocation.
+// Not thread-safe: one estimator per consumer thread.
+class HandKinematicsEstimator
+{
+private:
+	HandKinematicsParameters parameters;
+	std::vector<HandKinematics> samples;
+	// Index of the newest sample.
+	std::size_t newest;
+	std::size_t numberOfSamples;
+public:
+	explicit HandKinematicsEstimator(const HandKinematicsParameters& parameters = {});
+
+	// Adds a sample; returns false, and ignores it, if it is not newer than the newest one (or has sequence 0).
+	bool update(std::uint64_t sequence, std::chrono::steady_clock::time_point time, const Position& position);
+	bool update(const Snapshot<Pose>& pose) { return update(pose.sequence, pose.captureTime, pose.value.position); }
+	void clear();
+
+	// State at the newest sample.
+	const HandKinematics& getLatest() const;
+	// State at time: interpolated between the samples around it, extrapolated from the newest one after it,
+	// the oldest sample before it. Invalid before the first sample.
+	HandKinematics estimateAt(std::chrono::steady_clock::time_point time) const;
+
+	std::size_t getNumberOfSamples() const { return numberOfSamples; }
+	const HandKinematicsParameters& getParameters() const { return parameters; }
+private:
+	const HandKinematics& getSample(std::size_t age) const;
+};
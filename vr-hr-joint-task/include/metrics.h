@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Set to 0 (CMake option HR_VR_PROJ_ENABLE_METRICS=OFF) to compile every METRICS_* probe out.
+#ifndef HR_VR_PROJ_METRICS
+#define HR_VR_PROJ_METRICS 1
+#endif
+
+// Log-linear latency histogram in nanoseconds, in the spirit of HdrHistogram.
+// Every power of two is split into 16 buckets, so a reported value is within 1/16 of the recorded one.
+// record() is wait-free: a few relaxed atomic increments, no locks and no allocation.
+class LatencyHistogram
+{
+public:
+	static constexpr int SUB_BUCKET_BITS = 5;
+	static constexpr std::uint64_t SUB_BUCKET_COUNT = 1ull << SUB_BUCKET_BITS;
+	static constexpr std::uint64_t HALF_SUB_BUCKET_COUNT = SUB_BUCKET_COUNT / 2;
+	static constexpr std::size_t NUMBER_OF_BUCKETS = SUB_BUCKET_COUNT + (64 - SUB_BUCKET_BITS) * HALF_SUB_BUCKET_COUNT;
+private:
+	std::array<std::atomic<std::uint64_t>, NUMBER_OF_BUCKETS> buckets;
+	std::atomic<std::uint64_t> count;
+	std::atomic<std::uint64_t> sum;
+	std::atomic<std::uint64_t> max;
+public:
+	LatencyHistogram();
+
+	void record(std::chrono::nanoseconds latency);
+
+	std::uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+	std::chrono::nanoseconds getMean() const;
+	std::chrono::nanoseconds getMax() const { return std::chrono::nanoseconds(max.load(std::memory_order_relaxed)); }
+	// Highest value equivalent to the recorded one at the given percentile (0-100).
+	std::chrono::nanoseconds getPercentile(double percentile) const;
+
+	static std::size_t getBucketIndex(std::uint64_t value);
+	static std::uint64_t getBucketUpperBound(std::size_t index);
+};
+
+class Counter
+{
+private:
+	std::atomic<std::uint64_t> value;
+public:
+	Counter() : value(0) {}
+
+	void add(std::uint64_t amount = 1) { value.fetch_add(amount, std::memory_order_relaxed); }
+	std::uint64_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+class Gauge
+{
+private:
+	std::atomic<double> value;
+public:
+	Gauge() : value(0.0) {}
+
+	void set(double newValue) { value.store(newValue, std::memory_order_relaxed); }
+	double get() const { return value.load(std::memory_order_relaxed); }
+};
+
+// Named metrics. Lookups lock, so probes resolve their metric once and keep the reference,
+// which stays valid for the lifetime of the registry.
+class MetricsRegistry
+{
+private:
+	mutable std::mutex mutex;
+	std::map<std::string, std::unique_ptr<LatencyHistogram>> histograms;
+	std::map<std::string, std::unique_ptr<Counter>> counters;
+	std::map<std::string, std::unique_ptr<Gauge>> gauges;
+	std::chrono::steady_clock::time_point creationTime;
+public:
+	MetricsRegistry();
+
+	static MetricsRegistry& global();
+
+	LatencyHistogram& getHistogram(const std::string& name);
+	Counter& getCounter(const std::string& name);
+	Gauge& getGauge(const std::string& name);
+
+	std::string getSnapshot() const;
+};
+
+// Records the lifetime of the enclosing scope.
+class ScopedTimer
+{
+private:
+	LatencyHistogram& histogram;
+	std::chrono::steady_clock::time_point start;
+public:
+	explicit ScopedTimer(LatencyHistogram& histogram)
+		: histogram(histogram), start(std::chrono::steady_clock::now())
+	{}
+
+	~ScopedTimer()
+	{
+		histogram.record(std::chrono::steady_clock::now() - start);
+	}
+
+	ScopedTimer(const ScopedTimer&) = delete;
+	ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+// Rewrites a registry snapshot to a file periodically and once more on stop().
+class MetricsReporter
+{
+private:
+	MetricsRegistry& registry;
+	std::string path;
+	std::jthread reporterThread;
+public:
+	explicit MetricsReporter(MetricsRegistry& registry = MetricsRegistry::global());
+	~MetricsReporter();
+
+	void start(const std::string& path, std::chrono::milliseconds period);
+	void stop();
+	bool dump() const;
+};
+
+#define METRICS_CONCATENATE_(a, b) a##b
+#define METRICS_CONCATENATE(a, b) METRICS_CONCATENATE_(a, b)
+
+#if HR_VR_PROJ_METRICS
+#define METRICS_SCOPED_TIMER(name) \
+	static LatencyHistogram& METRICS_CONCATENATE(metricsHistogram, __LINE__) = MetricsRegistry::global().getHistogram(name); \
+	const ScopedTimer METRICS_CONCATENATE(metricsTimer, __LINE__)(METRICS_CONCATENATE(metricsHistogram, __LINE__))
+#define METRICS_RECORD(name, latency) \
+	do { static LatencyHistogram& histogram = MetricsRegistry::global().getHistogram(name); histogram.record(latency); } while (false)
+#define METRICS_ADD(name, amount) \
+	do { static Counter& counter = MetricsRegistry::global().getCounter(name); counter.add(amount); } while (false)
+#define METRICS_SET(name, value) \
+	do { static Gauge& gauge = MetricsRegistry::global().getGauge(name); gauge.set(value); } while (false)
+#else
+#define METRICS_SCOPED_TIMER(name) static_cast<void>(0)
+#define METRICS_RECORD(name, latency) static_cast<void>(0)
+#define METRICS_ADD(name, amount) static_cast<void>(0)
+#define METRICS_SET(name, value) static_cast<void>(0)
+#endif
@@ -3,6 +3,7 @@
 #include <cmath>
 #include <numbers>
 #include <chrono>
+#include <vector>
 
 struct Position
 {
@@ -12,6 +13,8 @@ struct Position
 	Position(double x, double y, double z)
 		: x(x), y(y), z(z)
 	{}
+
+	bool operator==(const Position&) const = default;
 };
 
 struct Orientation
@@ -22,6 +25,8 @@ struct Orientation
 	Orientation()
 		: alpha(0), beta(0), gamma(0)
 	{}
+
+	bool operator==(const Orientation&) const = default;
 };
 
 struct Pose
@@ -33,10 +38,32 @@ struct Pose
 	Pose(const Position& position, const Orientation& orientation)
 		: position(position), orientation(orientation)
 	{}
+
+	bool operator==(const Pose&) const = default;
+};
+
+// Positions as a structure of arrays, for the batch functions.
+struct PositionArrays
+{
+	std::vector<double> x, y, z;
+
+	PositionArrays() = default;
+	explicit PositionArrays(const std::vector<Position>& positions);
+
+	std::size_t size() const { return x.size(); }
+	void push_back(const Position& position);
 };
 
 double calculateEuclideanDistance(const Position& a, const Position& b);
 
 double calculateVelocity(const Position& a, const Position& b, double time);
 
-double calculateLikelihoodOfHumanAction(const Position& handPos, const Position& handPosPrev, const Position& componentPos, double deltaTime, double tau, double sigma);
\ No newline at end of file
+double calculateLikelihoodOfHumanAction(const Position& handPos, const Position& handPosPrev, const Position& componentPos, double deltaTime, double tau, double sigma);
+
+// Same likelihood for a hand speed that is already known.
+double calculateLikelihoodOfHumanAction(const Position& handPos, double handSpeed, const Position& componentPos, double tau, double sigma);
+
+// The likelihood for every component at once, likelihoods[i] for component i (likelihoods holds components.size()).
+// The Gaussian constants are computed once and the loops run over contiguous arrays, so the compiler vectorises them.
+void calculateLikelihoodsOfHumanAction(const Position& handPos, double handSpeed, const PositionArrays& components,
+	double tau, double sigma, double* likelihoods);
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Bounded multi-producer, single-consumer queue over preallocated cells.
+// Producers claim a cell with one compare-and-swap and never block: when the queue is full tryPush() fails.
+// Each cell carries its own sequence number, so a slow producer only delays the consumer, never the other producers.
+template<typename T>
+class MpscQueue
+{
+private:
+	struct Cell
+	{
+		std::atomic<std::size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	std::size_t mask;
+	alignas(64) std::atomic<std::size_t> enqueuePosition;
+	alignas(64) std::size_t dequeuePosition;
+public:
+	// Capacity is rounded up to a power of two.
+	explicit MpscQueue(std::size_t minimumCapacity)
+		: mask(roundUpToPowerOfTwo(minimumCapacity) - 1), enqueuePosition(0), dequeuePosition(0)
+	{
+		cells = std::make_unique<Cell[]>(mask + 1);
+		for (std::size_t i = 0; i <= mask; ++i)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	bool tryPush(T&& value)
+	{
+		std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		Cell* cell;
+		while (true)
+		{
+			cell = &cells[position & mask];
+			const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+			if (difference == 0)
+			{
+				if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (difference < 0)
+				return false;
+			else
+				position = enqueuePosition.load(std::memory_order_relaxed);
+		}
+		cell->value = std::move(value);
+		cell->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side only.
+	bool tryPop(T& value)
+	{
+		Cell& cell = cells[dequeuePosition & mask];
+		if (cell.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+			return false;
+		value = std::move(cell.value);
+		cell.sequence.store(dequeuePosition + mask + 1, std::memory_order_release);
+		++dequeuePosition;
+		return true;
+	}
+
+	std::size_t getCapacity() const { return mask + 1; }
+private:
+	static std::size_t roundUpToPowerOfTwo(std::size_t value)
+	{
+		std::size_t power = 1;
+		while (power < value)
+			power <<= 1;
+		return power;
+	}
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dnf_architecture.h"
+#include "session_replay.h"
+#include "session_trace.h"
+
+// Cartesian grid over the "ael -> ael" lateral interaction constants.
+struct LateralInteractionsGrid
+{
+	std::vector<double> sigmaExc;
+	std::vector<double> amplitudeExc;
+	std::vector<double> sigmaInh;
+	std::vector<double> amplitudeInh;
+	std::vector<double> amplitudeGlobal;
+
+	std::vector<dnf_composer::element::LateralInteractionsParameters> getCandidates() const;
+};
+
+struct SyntheticReachParameters
+{
+	double deltaT;
+	std::chrono::milliseconds controlPeriod;
+	std::chrono::milliseconds reachDuration;
+	// The hand rests over the object this long before the grasp is signalled.
+	std::chrono::milliseconds holdDuration;
+
+	SyntheticReachParameters(double deltaT = 65,
+		std::chrono::milliseconds controlPeriod = std::chrono::milliseconds(20),
+		std::chrono::milliseconds reachDuration = std::chrono::milliseconds(1500),
+		std::chrono::milliseconds holdDuration = std::chrono::milliseconds(1000))
+		: deltaT(deltaT), controlPeriod(controlPeriod), reachDuration(reachDuration), holdDuration(holdDuration)
+	{}
+};
+
+// Minimum-jerk reach from the resting hand position to object 1, 2 or 3, all objects present,
+// ending with the grasp of that object.
+SessionTrace makeSyntheticReach(DnfArchitectureType architecture, int humanObject, const SyntheticReachParameters& parameters = {});
+
+// Splits a recorded session into one trace per human grasp, each starting after the previous grasp,
+// with DNF step indices rebased to the start of the reach.
+std::vector<SessionTrace> splitIntoReaches(const SessionTrace& session);
+
+// Object whose human grasp signal rises first, 0 if none.
+int getGraspedObject(const SessionTrace& reach);
+
+struct TrialScore
+{
+	// The robot settled on a present object other than the one the human grasped.
+	bool correct = false;
+	// Time from the start of the reach until the target object stopped changing.
+	std::chrono::duration<double> decisionLatency{ 0 };
+};
+
+TrialScore scoreTrial(const SessionTrace& reach, const SessionReplayResult& replay);
+
+struct SweepResult
+{
+	dnf_composer::element::LateralInteractionsParameters parameters;
+	std::size_t trials = 0;
+	std::size_t correct = 0;
+	std::chrono::duration<double> meanDecisionLatency{ 0 };
+	std::chrono::duration<double> maxDecisionLatency{ 0 };
+
+	double getAccuracy() const { return trials > 0 ? static_cast<double>(correct) / trials : 0.0; }
+};
+
+// Replays every reach against every candidate, one independent simulation per pair, on a work-stealing pool.
+// Noise is seeded, so results do not depend on the number of threads.
+std::vector<SweepResult> runParameterSweep(const std::vector<dnf_composer::element::LateralInteractionsParameters>& candidates,
+	const std::vector<SessionTrace>& reaches, std::size_t numberOfThreads = 0, std::uint64_t noiseSeed = 1);
+
+// Best accuracy first, then lowest mean latency.
+std::string formatSweepTable(std::vector<SweepResult> results);
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A signal or pose read on its own schedule.
+struct PollingTarget
+{
+	std::string name;
+	// Reads per second; 0 reads at every opportunity. A value has to hold for longer than the period
+	// for every one of its edges to be seen.
+	double frequency;
+	// Of targets due together, lower is read first.
+	int priority;
+
+	PollingTarget(std::string name = "", double frequency = 0, int priority = 0)
+		: name(std::move(name)), frequency(frequency), priority(priority)
+	{}
+};
+
+// Reads targets at a higher rate for a while after a trigger rises from 0, around the transitions
+// that tend to follow it.
+struct PollingBoost
+{
+	std::string trigger;
+	std::vector<std::string> targets;
+	double frequency;
+	std::chrono::milliseconds duration;
+
+	PollingBoost(std::string trigger = "", std::vector<std::string> targets = {}, double frequency = 0,
+		std::chrono::milliseconds duration = std::chrono::milliseconds(0))
+		: trigger(std::move(trigger)), targets(std::move(targets)), frequency(frequency), duration(duration)
+	{}
+};
+
+// Targets left out read at every opportunity.
+struct PollingScheduleParameters
+{
+	std::vector<PollingTarget> targets;
+	std::vector<PollingBoost> boosts;
+
+	PollingScheduleParameters(std::vector<PollingTarget> targets = {}, std::vector<PollingBoost> boosts = {})
+		: targets(std::move(targets)), boosts(std::move(boosts))
+	{}
+};
+
+// Decides which targets are due for a read. Not thread-safe; targets are referred to by the index add() returns.
+class PollingSchedule
+{
+public:
+	using Clock = std::chrono::steady_clock;
+private:
+	struct Entry
+	{
+		PollingTarget target;
+		std::optional<Clock::time_point> lastRead;
+		int lastValue;
+		double boostedFrequency;
+		Clock::time_point boostedUntil;
+	};
+
+	struct Boost
+	{
+		std::size_t trigger;
+		std::vector<std::size_t> targets;
+		double frequency;
+		std::chrono::milliseconds duration;
+	};
+
+	std::vector<Entry> entries;
+	std::unordered_map<std::string, std::size_t> indices;
+	std::vector<Boost> boosts;
+public:
+	std::size_t add(const PollingTarget& target);
+	// Throws if the trigger or a target has not been added.
+	void addBoost(const PollingBoost& boost);
+	std::optional<std::size_t> find(const std::string& name) const;
+	const PollingTarget& getTarget(std::size_t index) const { return entries[index].target; }
+
+	// Time between reads at time, boosts included; zero at every opportunity.
+	Clock::duration getPeriod(std::size_t index, Clock::time_point time) const;
+	bool isDue(std::size_t index, Clock::time_point time) const;
+	// Those of candidates that are due at time, by priority.
+	std::vector<std::size_t> getDue(const std::vector<std::size_t>& candidates, Clock::time_point time) const;
+	// The earliest time one of candidates is due; time if one already is.
+	Clock::time_point getNextDueTime(const std::vector<std::size_t>& candidates, Clock::time_point time) const;
+
+	// A read of the target was sent at time and returned value; a rise from 0 starts the boosts it triggers.
+	void onRead(std::size_t index, int value, Clock::time_point time);
+};
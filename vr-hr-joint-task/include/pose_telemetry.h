@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+#include "misc.h"
+#include "record_stream_writer.h"
+
+// Binary hand pose stream.
+// File layout (version 1, little endian): one PoseTelemetryHeader followed by PoseTelemetryRecords.
+// Record timestamps are steady-clock nanoseconds; the header anchors them to the system clock.
+struct PoseTelemetryHeader
+{
+	static constexpr char MAGIC[8] = { 'H', 'A', 'N', 'D', 'P', 'O', 'S', 'E' };
+	static constexpr std::uint32_t VERSION = 1;
+
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t recordSize;
+	std::int64_t steadyClockAnchorNs;
+	std::int64_t systemClockAnchorNs;
+};
+static_assert(sizeof(PoseTelemetryHeader) == 32, "header layout is part of the file format");
+
+struct PoseTelemetryRecord
+{
+	std::uint64_t sequence;
+	std::int64_t timestampNs;
+	double x, y, z;
+	double alpha, beta, gamma;
+};
+static_assert(sizeof(PoseTelemetryRecord) == 64, "record layout is part of the file format");
+
+// Records hand poses from the thread that receives them and writes them to disk from a background thread.
+// record() never allocates or blocks; when the ring is full the new record is dropped and counted,
+// and the gap shows up in the sequence numbers of the file. Single producer, see RecordStreamWriter.
+class PoseTelemetryWriter
+{
+private:
+	RecordStreamWriter<PoseTelemetryRecord> stream;
+public:
+	explicit PoseTelemetryWriter(std::size_t ringCapacity = 4096);
+
+	bool open(const std::string& path);
+	void record(std::uint64_t sequence, std::chrono::steady_clock::time_point timestamp, const Pose& pose);
+	// Samples overwritten before they could be recorded.
+	void countDropped(std::uint64_t count) { stream.countDropped(count); }
+	// Writes every pending record and closes the file.
+	void close() { stream.close(); }
+
+	bool isOpen() const { return stream.isOpen(); }
+	std::uint64_t getNumberOfRecorded() const { return stream.getNumberOfRecorded(); }
+	std::uint64_t getNumberOfDropped() const { return stream.getNumberOfDropped(); }
+};
+
+// Converts a binary pose stream to CSV, returns false if the input is not a pose stream.
+bool convertPoseTelemetryToCsv(std::istream& input, std::ostream& output);
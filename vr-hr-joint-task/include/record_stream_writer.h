@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include "spsc_ring_buffer.h"
+
+// Append-only binary file of fixed-size records, written by a background thread.
+// record() never allocates or blocks; when the ring is full the new record is dropped and counted.
+// Single producer: record() must always be called from the same thread.
+template<typename Record>
+class RecordStreamWriter
+{
+	static_assert(std::is_trivially_copyable_v<Record>, "records are written byte for byte");
+private:
+	static constexpr std::chrono::milliseconds DRAIN_PERIOD{ 10 };
+	static constexpr std::chrono::milliseconds FLUSH_PERIOD{ 500 };
+
+	SpscRingBuffer<Record> ring;
+	std::ofstream file;
+	std::jthread writerThread;
+	std::atomic<std::uint64_t> recorded;
+	std::atomic<std::uint64_t> dropped;
+public:
+	explicit RecordStreamWriter(std::size_t ringCapacity)
+		: ring(ringCapacity), recorded(0), dropped(0)
+	{}
+
+	~RecordStreamWriter()
+	{
+		close();
+	}
+
+	// Truncates the file and writes the header before any record.
+	template<typename Header>
+	bool open(const std::string& path, const Header& header)
+	{
+		static_assert(std::is_trivially_copyable_v<Header>, "headers are written byte for byte");
+		file.open(path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+		if (!file.is_open())
+			return false;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		writerThread = std::jthread([this](const std::stop_token& stopToken) { writeLoop(stopToken); });
+		return true;
+	}
+
+	bool record(const Record& record)
+	{
+		if (!ring.tryPush(record))
+		{
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		recorded.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// Records lost before they reached record(), e.g. overwritten at their source.
+	void countDropped(std::uint64_t count)
+	{
+		dropped.fetch_add(count, std::memory_order_relaxed);
+	}
+
+	// Writes every pending record and closes the file.
+	void close()
+	{
+		if (writerThread.joinable())
+		{
+			writerThread.request_stop();
+			writerThread.join();
+		}
+		if (file.is_open())
+			file.close();
+	}
+
+	bool isOpen() const { return file.is_open(); }
+	std::uint64_t getNumberOfRecorded() const { return recorded.load(std::memory_order_relaxed); }
+	std::uint64_t getNumberOfDropped() const { return dropped.load(std::memory_order_relaxed); }
+private:
+	void writeLoop(const std::stop_token& stopToken)
+	{
+		auto lastFlush = std::chrono::steady_clock::now();
+		while (!stopToken.stop_requested())
+		{
+			drain();
+			const auto now = std::chrono::steady_clock::now();
+			if (now - lastFlush >= FLUSH_PERIOD)
+			{
+				file.flush();
+				lastFlush = now;
+			}
+			std::this_thread::sleep_for(DRAIN_PERIOD);
+		}
+		drain();
+		file.flush();
+	}
+
+	void drain()
+	{
+		Record record;
+		while (ring.tryPop(record))
+			file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+	}
+};
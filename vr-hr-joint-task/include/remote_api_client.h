@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <client.h>
+
+#include "misc.h"
+
+// The calls of the remote API subset, for requests and per-call statistics.
+enum class RemoteApiCall
+{
+	START_SIMULATION,
+	STOP_SIMULATION,
+	GET_INTEGER_SIGNAL,
+	SET_INTEGER_SIGNAL,
+	GET_OBJECT_HANDLE,
+	GET_OBJECT_POSE,
+};
+
+// Subset of the CoppeliaSim remote API used by the handler.
+// Kept abstract so the I/O path can be exercised without a running simulator.
+class RemoteApiClient
+{
+public:
+	virtual ~RemoteApiClient() = default;
+
+	virtual bool initialize() = 0;
+	virtual bool isConnected() const = 0;
+	virtual void startSimulation() const = 0;
+	virtual void stopSimulation() const = 0;
+
+	virtual int getIntegerSignal(const std::string& signalName) const = 0;
+	virtual void setIntegerSignal(const std::string& signalName, int signalValue) const = 0;
+
+	virtual int getObjectHandle(const std::string& objectName) const = 0;
+	virtual Pose getObjectPose(int objectHandle) const = 0;
+};
+
+class CoppeliaSimRemoteApiClient : public RemoteApiClient
+{
+private:
+	coppeliasim_cpp::CoppeliaSimClient client;
+public:
+	CoppeliaSimRemoteApiClient(const std::string& ip, int port);
+
+	bool initialize() override;
+	bool isConnected() const override;
+	void startSimulation() const override;
+	void stopSimulation() const override;
+
+	int getIntegerSignal(const std::string& signalName) const override;
+	void setIntegerSignal(const std::string& signalName, int signalValue) const override;
+
+	int getObjectHandle(const std::string& objectName) const override;
+	Pose getObjectPose(int objectHandle) const override;
+};
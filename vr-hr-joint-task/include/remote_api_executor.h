@@ -0,0 +1,270 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "misc.h"
+#include "remote_api_client.h"
+#include "task.h"
+#include "thread_activity.h"
+
+struct RemoteApiRequest
+{
+	RemoteApiCall call;
+	// Signal or object name.
+	std::string name;
+	// Signal value to set, or object handle to read.
+	int value;
+
+	RemoteApiRequest(RemoteApiCall call, std::string name = {}, int value = 0)
+		: call(call), name(std::move(name)), value(value)
+	{}
+};
+
+struct RemoteApiResponse
+{
+	// Signal value or object handle.
+	int value = 0;
+	Pose pose;
+};
+
+// Runs one request on a blocking client.
+RemoteApiResponse execute(const RemoteApiClient& client, const RemoteApiRequest& request);
+
+// A connection that takes new requests while earlier ones are outstanding and answers them in the order
+// they were sent. Driven by a single executor thread; only isConnected() and the wakeup are thread-safe.
+class PipelinedConnection
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using Completion = std::pair<std::uint64_t, RemoteApiResponse>;
+
+	virtual ~PipelinedConnection() = default;
+
+	// One connection attempt.
+	virtual bool connect() = 0;
+	virtual bool isConnected() const = 0;
+	virtual void send(std::uint64_t id, const RemoteApiRequest& request) = 0;
+	// Appends the responses that have arrived since the last call.
+	virtual void receive(std::vector<Completion>& responses) = 0;
+	// When the next outstanding response arrives, for connections that know; the others call the wakeup.
+	virtual std::optional<Clock::time_point> getNextResponseTime() const { return std::nullopt; }
+	virtual void setWakeup(std::function<void()> wakeup) {}
+};
+
+// A blocking client behind the pipelined interface. Requests queue up and run one at a time on a worker
+// thread, so the executor never blocks but requests do not overlap on the wire; the legacy remote API
+// can do no better.
+class SerialRemoteApiConnection : public PipelinedConnection
+{
+private:
+	std::unique_ptr<RemoteApiClient> client;
+	std::mutex mutex;
+	std::condition_variable requestQueued;
+	std::deque<std::pair<std::uint64_t, RemoteApiRequest>> requests;
+	std::vector<Completion> completed;
+	std::function<void()> wakeup;
+	bool stopping;
+	std::thread worker;
+public:
+	explicit SerialRemoteApiConnection(std::unique_ptr<RemoteApiClient> client);
+	~SerialRemoteApiConnection() override;
+
+	bool connect() override;
+	bool isConnected() const override;
+	void send(std::uint64_t id, const RemoteApiRequest& request) override;
+	void receive(std::vector<Completion>& responses) override;
+	void setWakeup(std::function<void()> wakeup) override;
+private:
+	void serve();
+};
+
+struct ConnectionBackoff
+{
+	// Wait between failed connection attempts, doubled after each one up to maxDelay.
+	std::chrono::milliseconds initialDelay;
+	std::chrono::milliseconds maxDelay;
+
+	ConnectionBackoff(std::chrono::milliseconds initialDelay = std::chrono::milliseconds(10),
+		std::chrono::milliseconds maxDelay = std::chrono::milliseconds(1000))
+		: initialDelay(initialDelay), maxDelay(maxDelay)
+	{}
+};
+
+// Single-threaded event loop running coroutines over one pipelined connection. Requests are sent as soon
+// as they are made, so a coroutine can have many outstanding and await them later; timers, events and
+// responses resume the coroutines waiting on them. Everything but Event::notify() and wake() is called
+// from the thread running run(), or before it starts.
+class RemoteApiExecutor
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// An outstanding request; awaiting it gives its response. Dropping it abandons the response.
+	class Request
+	{
+	private:
+		RemoteApiExecutor* executor;
+		std::uint64_t id;
+		Clock::time_point sendTime;
+	public:
+		Request(RemoteApiExecutor& executor, std::uint64_t id, Clock::time_point sendTime)
+			: executor(&executor), id(id), sendTime(sendTime)
+		{}
+		Request(Request&& other) noexcept
+			: executor(std::exchange(other.executor, nullptr)), id(other.id), sendTime(other.sendTime)
+		{}
+		Request& operator=(Request&& other) noexcept;
+		~Request();
+
+		Clock::time_point getSendTime() const { return sendTime; }
+
+		bool await_ready() const;
+		void await_suspend(std::coroutine_handle<> awaiting) const;
+		RemoteApiResponse await_resume();
+	};
+
+	// Set from any thread; a coroutine waits for it, with a timeout.
+	class Event
+	{
+	private:
+		RemoteApiExecutor& executor;
+		std::atomic<bool> set;
+	public:
+		explicit Event(RemoteApiExecutor& executor) : executor(executor), set(false) {}
+
+		void notify();
+		// Consumes the notification.
+		bool reset() { return set.exchange(false, std::memory_order_acquire); }
+
+		class Wait
+		{
+		private:
+			Event& event;
+			Clock::time_point deadline;
+			bool notified;
+		public:
+			Wait(Event& event, Clock::time_point deadline) : event(event), deadline(deadline), notified(false) {}
+
+			bool await_ready();
+			void await_suspend(std::coroutine_handle<> awaiting);
+			// True if notified, false on timeout.
+			bool await_resume() const { return notified; }
+
+			friend class RemoteApiExecutor;
+		};
+
+		Wait waitFor(Clock::duration timeout) { return { *this, Clock::now() + timeout }; }
+	};
+
+	class Sleep
+	{
+	private:
+		RemoteApiExecutor& executor;
+		Clock::time_point until;
+	public:
+		Sleep(RemoteApiExecutor& executor, Clock::time_point until) : executor(executor), until(until) {}
+
+		bool await_ready() const { return Clock::now() >= until; }
+		void await_suspend(std::coroutine_handle<> awaiting) const;
+		void await_resume() const {}
+	};
+private:
+	struct PendingRequest
+	{
+		std::optional<RemoteApiResponse> response;
+		std::coroutine_handle<> awaiting;
+	};
+	struct EventWaiter
+	{
+		Event::Wait* wait;
+		std::coroutine_handle<> awaiting;
+	};
+
+	std::unique_ptr<PipelinedConnection> connection;
+	std::vector<Task<void>> tasks;
+	std::deque<std::coroutine_handle<>> ready;
+	std::unordered_map<std::uint64_t, PendingRequest> pending;
+	std::uint64_t nextRequestId;
+	std::multimap<Clock::time_point, std::coroutine_handle<>> timers;
+	std::vector<EventWaiter> eventWaiters;
+	std::vector<PipelinedConnection::Completion> responses;
+	std::mutex wakeMutex;
+	std::condition_variable wakeCondition;
+	std::atomic<bool> woken;
+	// The last stretch before a deadline that is busy-waited rather than slept; zero sleeps all the way.
+	std::chrono::microseconds spinThreshold;
+	std::atomic<std::uint64_t> requestsSent;
+	ThreadActivity activity;
+public:
+	// spinThreshold trades a core for wakeups closer to the deadlines, for benchmarks against sub-millisecond
+	// round trips; sleep granularity is coarser than that.
+	explicit RemoteApiExecutor(std::unique_ptr<PipelinedConnection> connection, std::string name = "Remote API executor",
+		std::chrono::microseconds spinThreshold = std::chrono::microseconds(0));
+
+	~RemoteApiExecutor();
+
+	RemoteApiExecutor(const RemoteApiExecutor&) = delete;
+	RemoteApiExecutor& operator=(const RemoteApiExecutor&) = delete;
+
+	PipelinedConnection& getConnection() { return *connection; }
+	const PipelinedConnection& getConnection() const { return *connection; }
+
+	// Runs the task on the loop from the next iteration.
+	void spawn(Task<void> task);
+	// Until every spawned task has finished; rethrows what a task threw.
+	void run();
+	// From any thread.
+	void wake();
+
+	Request submit(const RemoteApiRequest& request);
+	Sleep sleepFor(Clock::duration duration) { return { *this, Clock::now() + duration }; }
+	Sleep sleepUntil(Clock::time_point time) { return { *this, time }; }
+
+	std::uint64_t getNumberOfRequests() const { return requestsSent.load(std::memory_order_relaxed); }
+	std::size_t getNumberOfOutstandingRequests() const { return pending.size(); }
+	const ThreadActivity& getActivity() const { return activity; }
+private:
+	// Moves whatever is due to the ready queue, returns whether anything is.
+	bool collectReady(Clock::time_point now);
+	void waitForWork(Clock::time_point now);
+};
+
+// The calls of the handler as awaitable operations on an executor. Calls are sent when made, so calls
+// started together are pipelined on the connection. readSnapshot() is with the signals it reads.
+class AsyncRemoteApiClient
+{
+private:
+	RemoteApiExecutor& executor;
+	ConnectionBackoff backoff;
+public:
+	explicit AsyncRemoteApiClient(RemoteApiExecutor& executor, const ConnectionBackoff& backoff = ConnectionBackoff())
+		: executor(executor), backoff(backoff)
+	{}
+
+	// Retries with exponential backoff until connected; false if stopRequested is set first.
+	Task<bool> connect(const std::atomic<bool>& stopRequested);
+	Task<void> startSimulation();
+	Task<void> stopSimulation();
+	Task<int> getObjectHandle(std::string objectName);
+	// The response holds the value.
+	RemoteApiExecutor::Request getIntegerSignal(std::string signalName);
+	// The response holds the pose.
+	RemoteApiExecutor::Request readPose(int objectHandle);
+	// All writes in flight together; completes once every one is acknowledged.
+	Task<void> writeSignals(std::vector<std::pair<std::string, int>> signals);
+};
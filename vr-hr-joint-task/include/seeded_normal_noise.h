@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include <elements/element_factory.h>
+
+// NormalNoise drawing from its own fixed-seed generator instead of the library's shared one,
+// so two runs fed the same inputs produce bit-identical fields (same build, same standard library).
+// init() rewinds the generator, every run of the simulation replays the same noise.
+class SeededNormalNoise : public dnf_composer::element::NormalNoise
+{
+private:
+	std::uint64_t seed;
+	std::mt19937_64 engine;
+	std::normal_distribution<double> distribution;
+public:
+	SeededNormalNoise(const dnf_composer::element::ElementCommonParameters& elementCommonParameters,
+		const dnf_composer::element::NormalNoiseParameters& parameters, std::uint64_t seed);
+
+	void init() override;
+	void step(double t, double deltaT) override;
+	std::shared_ptr<dnf_composer::element::Element> clone() const override;
+
+	std::uint64_t getSeed() const { return seed; }
+
+	// Per-element seed, derived from the architecture seed and the element name (FNV-1a),
+	// so adding an element does not change the noise of the others.
+	static std::uint64_t deriveSeed(std::uint64_t seed, const std::string& elementName);
+};
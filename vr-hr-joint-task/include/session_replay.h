@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "session_trace.h"
+
+struct SessionReplayResult
+{
+	std::uint64_t steps = 0;
+	// Target decision after each replayed control pass.
+	std::vector<int> targetObjects;
+	// Passes whose decision differs from the recorded one.
+	std::uint64_t targetMismatches = 0;
+	// Action execution layer activation after the last step.
+	std::vector<double> finalActivation;
+	std::chrono::duration<double> simulatedTime{ 0 };
+	std::chrono::duration<double> wallTime{ 0 };
+
+	double getSimulatedSecondsPerWallSecond() const
+	{
+		return wallTime.count() > 0 ? simulatedTime.count() / wallTime.count() : 0.0;
+	}
+};
+
+// Feeds a recorded session to a headless DnfComposerHandler on the calling thread, as fast as the CPU allows.
+// Each control pass is applied after the number of DNF steps it was recorded at, in the order the live
+// control loop applied it. The trace's noise seed is used unless options give one; with a seed, replays are bit-identical.
+SessionReplayResult replaySession(const SessionTrace& trace, DnfArchitectureOptions options = {});
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "coppeliasim_handler.h"
+#include "dnf_architecture.h"
+#include "misc.h"
+#include "record_stream_writer.h"
+#include "snapshot_publisher.h"
+
+// Binary trace of everything the control loop fed to the fields and decided, one record per control pass.
+// File layout (version 2, little endian): one SessionTraceHeader followed by SessionTraceRecords.
+struct SessionTraceHeader
+{
+	static constexpr char MAGIC[8] = { 'V', 'R', 'H', 'R', 'T', 'R', 'C', 'E' };
+	// Version 1 traces stamped records with the capture time of the hand pose rather than the DNF step time,
+	// and replay differently; they are refused.
+	static constexpr std::uint32_t VERSION = 2;
+
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t recordSize;
+	std::uint32_t architecture;
+	std::uint32_t hasNoiseSeed;
+	std::uint64_t noiseSeed;
+	double deltaT;
+	std::int64_t steadyClockAnchorNs;
+};
+static_assert(sizeof(SessionTraceHeader) == 48, "header layout is part of the file format");
+
+struct SessionTraceRecord
+{
+	// DNF steps completed when the pass applied its inputs; replay applies them after as many steps.
+	std::uint64_t dnfStep;
+	// Time of the DNF step the pass estimated the hand state for.
+	std::int64_t timestampNs;
+	std::uint64_t handPoseSequence;
+	std::int64_t handPoseTimestampNs;
+	double x, y, z;
+	double alpha, beta, gamma;
+	// IncomingSignalsSnapshot::pack() of the signals the pass saw.
+	std::int32_t incomingSignals;
+	std::int32_t targetObject;
+};
+static_assert(sizeof(SessionTraceRecord) == 88, "record layout is part of the file format");
+
+struct SessionTrace
+{
+	SessionTraceHeader header;
+	std::vector<SessionTraceRecord> records;
+
+	DnfArchitectureType getArchitectureType() const { return static_cast<DnfArchitectureType>(header.architecture); }
+	std::optional<std::uint64_t> getNoiseSeed() const;
+};
+
+// Records control passes without blocking the control thread, see RecordStreamWriter.
+class SessionRecorder
+{
+private:
+	RecordStreamWriter<SessionTraceRecord> stream;
+public:
+	explicit SessionRecorder(std::size_t ringCapacity = 4096);
+
+	bool open(const std::string& path, DnfArchitectureType architecture, double deltaT, std::optional<std::uint64_t> noiseSeed);
+	void record(std::uint64_t dnfStep, std::chrono::steady_clock::time_point timestamp,
+		const Snapshot<Pose>& handPose, const IncomingSignals& incomingSignals, int targetObject);
+	void close() { stream.close(); }
+
+	bool isOpen() const { return stream.isOpen(); }
+	std::uint64_t getNumberOfRecorded() const { return stream.getNumberOfRecorded(); }
+	std::uint64_t getNumberOfDropped() const { return stream.getNumberOfDropped(); }
+};
+
+// Throws std::runtime_error if the input is not a session trace.
+SessionTrace readSessionTrace(std::istream& input);
+SessionTrace readSessionTrace(const std::string& path);
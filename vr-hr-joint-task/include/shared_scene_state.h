@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "misc.h"
+#include "snapshot_publisher.h"
+
+struct SharedOutgoingSignals
+{
+	std::int32_t startSim;
+	std::int32_t targetObject;
+};
+
+// What a co-located simulator and the controller exchange through shared memory instead of remote API
+// calls. Every field has a fixed size, so a simulator plugin built on its own can map it. Layout version 2;
+// any change to a field bumps VERSION, and a region with another version or size is refused.
+// Capture times are steady clock times, which the processes of a host share.
+struct SharedSceneState
+{
+	static constexpr std::uint32_t MAGIC = 0x56524854;
+	static constexpr std::uint32_t VERSION = 2;
+	// The region the controller maps unless told otherwise.
+	static constexpr const char* DEFAULT_NAME = "vr-hr-joint-task-scene";
+
+	// Stored last by the simulator side, once the rest is laid out.
+	std::atomic<std::uint32_t> magic;
+	std::uint32_t version;
+	std::uint32_t size;
+	// Cleared by the simulator side when it goes away.
+	std::atomic<std::uint32_t> open;
+	// Steady clock time of the simulator's last step, in nanoseconds. A simulator that crashed cannot clear open,
+	// it stops updating this instead.
+	std::atomic<std::int64_t> heartbeat;
+
+	// Written by the simulator: IncomingSignalsSnapshot::pack() of its signals, and the hand.
+	SnapshotPublisher<std::int32_t> incomingSignals;
+	SnapshotPublisher<Pose> handPose;
+	// Written by the controller.
+	SnapshotPublisher<SharedOutgoingSignals> outgoingSignals;
+
+	SharedSceneState() : magic(0), version(VERSION), size(sizeof(SharedSceneState)), open(0), heartbeat(0) {}
+};
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free && std::atomic<std::uint64_t>::is_always_lock_free
+	&& std::atomic<std::int64_t>::is_always_lock_free,
+	"atomics in shared memory must be lock-free");
+static_assert(std::is_standard_layout_v<SharedSceneState>, "the shared scene state is mapped by other processes");
+
+// A named shared memory region mapped into this process; the creator removes the name when it goes away.
+class SharedMemoryRegion
+{
+private:
+	std::string name;
+	void* address;
+	std::size_t size;
+	bool owner;
+#ifdef _WIN32
+	void* mapping;
+#endif
+public:
+	// Replaces any region left under the name.
+	static std::unique_ptr<SharedMemoryRegion> create(const std::string& name, std::size_t size);
+	// Null if there is no region under the name.
+	static std::unique_ptr<SharedMemoryRegion> open(const std::string& name);
+
+	~SharedMemoryRegion();
+	SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+	SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+	void* getAddress() const { return address; }
+	std::size_t getSize() const { return size; }
+private:
+	SharedMemoryRegion(std::string name, bool owner);
+};
+
+// Simulator side: creates the region and lays out the state in it.
+class SharedSceneServer
+{
+private:
+	std::unique_ptr<SharedMemoryRegion> region;
+	SharedSceneState* state;
+public:
+	explicit SharedSceneServer(const std::string& name);
+	~SharedSceneServer();
+
+	SharedSceneState& getState() { return *state; }
+	// Every step, or at least more often than the clients' liveness timeout.
+	void beat();
+	// Clients read as disconnected from then on.
+	void close() { state->open.store(0, std::memory_order_release); }
+};
+
+// Controller side: maps the region the simulator created.
+class SharedSceneClient
+{
+private:
+	std::string name;
+	std::chrono::steady_clock::duration livenessTimeout;
+	std::unique_ptr<SharedMemoryRegion> region;
+	// Regions of simulators that went away; other threads may still be reading them.
+	std::vector<std::unique_ptr<SharedMemoryRegion>> retiredRegions;
+	std::atomic<SharedSceneState*> state;
+public:
+	// The simulator is taken as gone once its heartbeat is older than livenessTimeout.
+	explicit SharedSceneClient(std::string name,
+		std::chrono::steady_clock::duration livenessTimeout = std::chrono::milliseconds(500));
+
+	// One attempt; false while the simulator has not created the region, or left one behind that it no longer
+	// steps. Throws if the region has another layout. Once the mapped simulator goes away, maps the region of
+	// the one that replaced it; the client keeps every region it mapped.
+	bool connect();
+	bool isConnected() const;
+	// Once connected.
+	SharedSceneState& getState() { return *state.load(std::memory_order_acquire); }
+private:
+	bool isAlive(const SharedSceneState& candidate) const;
+};
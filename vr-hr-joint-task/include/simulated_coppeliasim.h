@@ -0,0 +1,258 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "metrics.h"
+#include "misc.h"
+#include "remote_api_client.h"
+#include "remote_api_executor.h"
+#include "session_trace.h"
+#include "shared_scene_state.h"
+
+// Pose of an object at a time since the simulation started.
+struct PoseKeyframe
+{
+	std::chrono::nanoseconds time;
+	Pose pose;
+};
+
+// Value a signal takes at a time since the simulation started.
+struct SignalKeyframe
+{
+	std::chrono::nanoseconds time;
+	std::string signal;
+	int value;
+};
+
+// What a scene does once the simulation starts: object trajectories, linearly interpolated between keyframes
+// and held after the last one, and signal timelines. A scripted signal holds the value of its last keyframe and
+// is re-asserted on every request, as a scene script sets it every simulation step; a write from a client
+// lasts until the next request.
+struct SceneScript
+{
+	// By object name.
+	std::unordered_map<std::string, std::vector<PoseKeyframe>> trajectories;
+	std::vector<SignalKeyframe> signals;
+	// Plays again from the start once the last keyframe of the script has played.
+	bool loop = false;
+
+	std::chrono::nanoseconds getDuration() const;
+};
+
+// The hand of a recorded (or synthetic) session and its incoming signals, as the packed signal snapshot,
+// at the times they were sampled.
+SceneScript makeSceneScript(const SessionTrace& trace, const std::string& handObjectName = "RightController");
+
+struct SimulatedConnectionParameters
+{
+	// Every call takes this long, and the request is served halfway through, once the scene gets to it.
+	std::chrono::nanoseconds roundTripTime;
+	// Plus a uniformly distributed delay in [0, jitter].
+	std::chrono::nanoseconds jitter;
+	std::uint64_t seed;
+
+	SimulatedConnectionParameters(std::chrono::nanoseconds roundTripTime = std::chrono::microseconds(200),
+		std::chrono::nanoseconds jitter = std::chrono::nanoseconds(0), std::uint64_t seed = 1)
+		: roundTripTime(roundTripTime), jitter(jitter), seed(seed)
+	{}
+};
+
+// In-process stand-in for a CoppeliaSim scene behind the remote API, so the I/O path can be exercised and
+// load-tested without a simulator. Connections are SimulatedRemoteApiClients or SimulatedPipelinedConnections;
+// the scene plays its script
+// from the first startSimulation() call and records the throughput and per-call latency of every connection.
+class SimulatedCoppeliaSim
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	static constexpr std::size_t NUMBER_OF_CALLS = 6;
+private:
+	mutable std::mutex mutex;
+	SceneScript script;
+	std::chrono::nanoseconds scriptDuration;
+	std::unordered_map<std::string, int> signals;
+	std::unordered_map<std::string, int> handles;
+	std::unordered_map<int, Pose> poses;
+	// Scripted objects, by handle.
+	std::unordered_map<int, const std::vector<PoseKeyframe>*> trajectories;
+	// Value of every signal the timeline has set so far in this pass of the script.
+	std::unordered_map<std::string, int> scriptedSignals;
+	// Every value served to the reads of the signals being recorded, in the order served.
+	std::unordered_map<std::string, std::vector<int>> servedValues;
+	std::size_t nextSignalKeyframe;
+	std::chrono::nanoseconds lastScriptTime;
+	bool running;
+	Clock::time_point startTime;
+	std::chrono::nanoseconds serviceTime;
+	Clock::time_point busyUntil;
+	std::atomic<bool> open;
+	// Recorded by the connections.
+	std::array<LatencyHistogram, NUMBER_OF_CALLS> latencies;
+	std::atomic<std::int64_t> firstRequestNs;
+	std::atomic<std::int64_t> lastRequestNs;
+public:
+	explicit SimulatedCoppeliaSim(SceneScript script = {});
+
+	SimulatedCoppeliaSim(const SimulatedCoppeliaSim&) = delete;
+	SimulatedCoppeliaSim& operator=(const SimulatedCoppeliaSim&) = delete;
+
+	// Scene side. Returns the handle of the object, scripted if the script has a trajectory under its name.
+	int addObject(const std::string& name, const Pose& pose = {});
+	void setSignal(const std::string& name, int value);
+	int getSignal(const std::string& name) const;
+	// Starts the script as if the simulation had started at time.
+	void start(Clock::time_point time = Clock::now());
+	void stop();
+	bool isRunning() const;
+	// Every connection reads as disconnected from then on.
+	void close() { open.store(false, std::memory_order_relaxed); }
+	bool isOpen() const { return open.load(std::memory_order_relaxed); }
+	// Requests from every connection are served one at a time, each taking serviceTime, as CoppeliaSim serves
+	// the remote API from its main loop. Zero, the default, serves any number at once.
+	void setServiceTime(std::chrono::nanoseconds serviceTime);
+	// Records the values served to every read of the signal from then on.
+	void recordServedValues(const std::string& name);
+	std::vector<int> getServedValues(const std::string& name) const;
+
+	// When a request arriving at time has been served, after the ones that arrived before it.
+	Clock::time_point reserveService(Clock::time_point arrival);
+	// Server side of the calls, served at time.
+	int serveGetIntegerSignal(const std::string& name, Clock::time_point time);
+	void serveSetIntegerSignal(const std::string& name, int value, Clock::time_point time);
+	int serveGetObjectHandle(const std::string& name) const;
+	Pose serveGetObjectPose(int handle, Clock::time_point time);
+	// A call that took latency as seen by the client, ending at end.
+	void recordCall(RemoteApiCall call, Clock::duration latency, Clock::time_point end);
+
+	std::uint64_t getNumberOfRequests() const;
+	// Requests per second from the first to the last one.
+	double getRequestRate() const;
+	const LatencyHistogram& getLatency(RemoteApiCall call) const { return latencies[static_cast<std::size_t>(call)]; }
+	std::string getReport() const;
+private:
+	// Applies the signal keyframes due at time and returns the script time; called with the lock held.
+	std::chrono::nanoseconds advanceScript(Clock::time_point time);
+	static Pose samplePose(const std::vector<PoseKeyframe>& trajectory, std::chrono::nanoseconds time);
+};
+
+// One connection to a SimulatedCoppeliaSim, with its own latency and jitter. Like a remote API client,
+// a connection is used by one thread at a time.
+class SimulatedRemoteApiClient : public RemoteApiClient
+{
+private:
+	SimulatedCoppeliaSim& scene;
+	SimulatedConnectionParameters parameters;
+	mutable std::mt19937_64 random;
+	std::atomic<bool> connected;
+public:
+	explicit SimulatedRemoteApiClient(SimulatedCoppeliaSim& scene,
+		const SimulatedConnectionParameters& parameters = SimulatedConnectionParameters());
+
+	bool initialize() override;
+	bool isConnected() const override;
+	void startSimulation() const override;
+	void stopSimulation() const override;
+
+	int getIntegerSignal(const std::string& signalName) const override;
+	void setIntegerSignal(const std::string& signalName, int signalValue) const override;
+
+	int getObjectHandle(const std::string& objectName) const override;
+	Pose getObjectPose(int objectHandle) const override;
+
+	void disconnect() { connected.store(false, std::memory_order_relaxed); }
+private:
+	// Waits half a round trip, serves the request, waits the other half and records the call.
+	template<typename Request>
+	auto roundTrip(RemoteApiCall call, Request&& request) const;
+	static void waitFor(std::chrono::nanoseconds duration);
+};
+
+// One pipelined connection to a SimulatedCoppeliaSim: requests overlap on the wire, each is served half its
+// round trip after it was sent, and responses come back in send order, so one that is held up by jitter
+// holds up the ones behind it.
+class SimulatedPipelinedConnection : public PipelinedConnection
+{
+private:
+	struct InFlight
+	{
+		std::uint64_t id;
+		RemoteApiRequest request;
+		Clock::time_point sendTime;
+		Clock::time_point serveTime;
+		Clock::time_point responseTime;
+		RemoteApiResponse response;
+	};
+
+	SimulatedCoppeliaSim& scene;
+	SimulatedConnectionParameters parameters;
+	std::mt19937_64 random;
+	std::atomic<bool> connected;
+	std::deque<InFlight> inFlight;
+	// Requests before this one have been served.
+	std::size_t served;
+public:
+	explicit SimulatedPipelinedConnection(SimulatedCoppeliaSim& scene,
+		const SimulatedConnectionParameters& parameters = SimulatedConnectionParameters());
+
+	bool connect() override;
+	bool isConnected() const override;
+	void send(std::uint64_t id, const RemoteApiRequest& request) override;
+	void receive(std::vector<Completion>& responses) override;
+	// The next request to serve or response to deliver, whichever comes first.
+	std::optional<Clock::time_point> getNextResponseTime() const override;
+
+	void disconnect() { connected.store(false, std::memory_order_relaxed); }
+private:
+	RemoteApiResponse serve(const RemoteApiRequest& request, Clock::time_point time);
+};
+
+struct SimulatedSharedSceneParameters
+{
+	// How often the scene publishes its signals and the hand, and picks up outgoing signals: its step.
+	std::chrono::nanoseconds stepPeriod;
+	std::string handObjectName;
+
+	SimulatedSharedSceneParameters(std::chrono::nanoseconds stepPeriod = std::chrono::milliseconds(1),
+		std::string handObjectName = "RightController")
+		: stepPeriod(stepPeriod), handObjectName(std::move(handObjectName))
+	{}
+};
+
+// What a simulator plugin does on the scene's side of a shared scene region: every step, the packed signal
+// snapshot and the hand pose are published with the step time, and changed outgoing signals are applied.
+class SimulatedSharedSceneServer
+{
+private:
+	SimulatedCoppeliaSim& scene;
+	SimulatedSharedSceneParameters parameters;
+	SharedSceneServer server;
+	std::atomic<bool> stopping;
+	std::atomic<std::uint64_t> steps;
+	std::thread thread;
+public:
+	SimulatedSharedSceneServer(SimulatedCoppeliaSim& scene, const std::string& name,
+		const SimulatedSharedSceneParameters& parameters = SimulatedSharedSceneParameters());
+	~SimulatedSharedSceneServer();
+
+	SimulatedSharedSceneServer(const SimulatedSharedSceneServer&) = delete;
+	SimulatedSharedSceneServer& operator=(const SimulatedSharedSceneServer&) = delete;
+
+	// Stops stepping; clients read as disconnected from then on.
+	void close();
+	// Stops stepping but leaves the region open, as a simulator that crashed would.
+	void hang();
+	std::uint64_t getNumberOfSteps() const { return steps.load(std::memory_order_relaxed); }
+private:
+	void run();
+};
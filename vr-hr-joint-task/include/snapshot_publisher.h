@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+template<typename T>
+struct Snapshot
+{
+	T value;
+	// Number of publications so far, 0 until the first one.
+	std::uint64_t sequence;
+	std::chrono::steady_clock::time_point captureTime;
+
+	Snapshot()
+		: value(), sequence(0), captureTime()
+	{}
+};
+
+// Single-writer, multi-reader seqlock.
+// The writer never blocks; a reader retries only if a publication overlapped its copy.
+// The payload is stored in atomic words so concurrent copies are well defined.
+template<typename T>
+class SnapshotPublisher
+{
+	static_assert(std::is_trivially_copyable_v<T>, "snapshots are copied word by word");
+private:
+	struct Record
+	{
+		T value;
+		std::chrono::steady_clock::time_point captureTime;
+	};
+
+	static constexpr std::size_t NUMBER_OF_WORDS = (sizeof(Record) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+	// Odd while a publication is in progress, sequence = version / 2.
+	std::atomic<std::uint64_t> version;
+	std::array<std::atomic<std::uint64_t>, NUMBER_OF_WORDS> words;
+public:
+	SnapshotPublisher()
+		: version(0)
+	{
+		publishWords(Record{ T(), std::chrono::steady_clock::time_point() });
+		version.store(0, std::memory_order_release);
+	}
+
+	SnapshotPublisher(const SnapshotPublisher&) = delete;
+	SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+	void publish(const T& value, std::chrono::steady_clock::time_point captureTime = std::chrono::steady_clock::now())
+	{
+		const std::uint64_t current = version.load(std::memory_order_relaxed);
+		version.store(current + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		publishWords(Record{ value, captureTime });
+		version.store(current + 2, std::memory_order_release);
+	}
+
+	Snapshot<T> read() const
+	{
+		std::array<std::uint64_t, NUMBER_OF_WORDS> copy;
+		std::uint64_t before, after;
+		do
+		{
+			before = version.load(std::memory_order_acquire);
+			for (std::size_t i = 0; i < NUMBER_OF_WORDS; ++i)
+				copy[i] = words[i].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = version.load(std::memory_order_relaxed);
+		} while (before != after || (before & 1) != 0);
+
+		Record record;
+		std::memcpy(static_cast<void*>(&record), copy.data(), sizeof(Record));
+
+		Snapshot<T> snapshot;
+		snapshot.value = record.value;
+		snapshot.sequence = before / 2;
+		snapshot.captureTime = record.captureTime;
+		return snapshot;
+	}
+
+	std::uint64_t getSequence() const
+	{
+		return version.load(std::memory_order_acquire) / 2;
+	}
+private:
+	void publishWords(const Record& record)
+	{
+		std::array<std::uint64_t, NUMBER_OF_WORDS> copy{};
+		std::memcpy(copy.data(), &record, sizeof(Record));
+		for (std::size_t i = 0; i < NUMBER_OF_WORDS; ++i)
+			words[i].store(copy[i], std::memory_order_relaxed);
+	}
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded single-producer, single-consumer queue over preallocated storage.
+// tryPush() never allocates or blocks: when the ring is full the new item is rejected.
+template<typename T>
+class SpscRingBuffer
+{
+private:
+	std::vector<T> buffer;
+	std::size_t mask;
+	alignas(64) std::atomic<std::size_t> head;
+	alignas(64) std::atomic<std::size_t> tail;
+public:
+	// Capacity is rounded up to a power of two.
+	explicit SpscRingBuffer(std::size_t minimumCapacity)
+		: buffer(roundUpToPowerOfTwo(minimumCapacity)), mask(buffer.size() - 1), head(0), tail(0)
+	{}
+
+	SpscRingBuffer(const SpscRingBuffer&) = delete;
+	SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+	bool tryPush(const T& item)
+	{
+		const std::size_t currentHead = head.load(std::memory_order_relaxed);
+		if (currentHead - tail.load(std::memory_order_acquire) == buffer.size())
+			return false;
+		buffer[currentHead & mask] = item;
+		head.store(currentHead + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool tryPop(T& item)
+	{
+		const std::size_t currentTail = tail.load(std::memory_order_relaxed);
+		if (currentTail == head.load(std::memory_order_acquire))
+			return false;
+		item = buffer[currentTail & mask];
+		tail.store(currentTail + 1, std::memory_order_release);
+		return true;
+	}
+
+	std::size_t getCapacity() const { return buffer.size(); }
+	bool isEmpty() const { return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire); }
+private:
+	static std::size_t roundUpToPowerOfTwo(std::size_t value)
+	{
+		std::size_t power = 1;
+		while (power < value)
+			power <<= 1;
+		return power;
+	}
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+#include "snapshot_publisher.h"
+#include "workspace.h"
+
+// The target object the action execution field settles on, as of one DNF step.
+struct TargetDecision
+{
+	// Whether the field holds a peak; without one there is no target.
+	bool peak;
+	// Of the peak along the field, negative without one.
+	double centroid;
+	// 1-based, 0 without a peak.
+	int targetObject;
+	// Steps completed when it was taken.
+	std::uint64_t step;
+	// Consecutive steps that have decided on targetObject, this one included.
+	std::uint64_t stableSteps;
+	// Steps completed when targetObject last changed.
+	std::uint64_t changeStep;
+
+	TargetDecision()
+		: peak(false), centroid(-1), targetObject(0), step(0), stableSteps(0), changeStep(0)
+	{}
+};
+
+// Takes the decision once per step on the thread that steps the fields, and publishes it for the control
+// thread, which reads it in O(1) and never touches field buffers that are being written.
+class TargetDecisionTracker
+{
+private:
+	const Workspace& workspace;
+	// Owned by the stepping thread.
+	TargetDecision decision;
+	SnapshotPublisher<TargetDecision> published;
+public:
+	explicit TargetDecisionTracker(const Workspace& workspace);
+
+	TargetDecisionTracker(const TargetDecisionTracker&) = delete;
+	TargetDecisionTracker& operator=(const TargetDecisionTracker&) = delete;
+
+	// Once the fields are initialised, before the first step.
+	void reset(double centroid);
+	// After every step.
+	void update(double centroid);
+
+	Snapshot<TargetDecision> read() const { return published.read(); }
+private:
+	void decide(double centroid);
+};
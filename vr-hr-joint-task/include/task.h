@@ -0,0 +1,105 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+// Shared part of the Task promises: the awaiting coroutine is resumed by symmetric transfer when the task
+// finishes, so long chains of tasks do not grow the stack, and an exception is kept to be rethrown to it.
+struct TaskPromiseBase
+{
+	std::coroutine_handle<> continuation;
+	std::exception_ptr exception;
+
+	struct FinalAwaiter
+	{
+		bool await_ready() const noexcept { return false; }
+
+		template<typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) const noexcept
+		{
+			const std::coroutine_handle<> continuation = finished.promise().continuation;
+			return continuation ? continuation : std::noop_coroutine();
+		}
+
+		void await_resume() const noexcept {}
+	};
+
+	std::suspend_always initial_suspend() const noexcept { return {}; }
+	FinalAwaiter final_suspend() const noexcept { return {}; }
+	void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase
+{
+	std::optional<T> value;
+
+	void return_value(T result) { value = std::move(result); }
+	T takeResult()
+	{
+		if (exception)
+			std::rethrow_exception(exception);
+		return std::move(*value);
+	}
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase
+{
+	void return_void() const noexcept {}
+	void takeResult() const
+	{
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+};
+
+// Lazily started coroutine: it runs when awaited, or when an executor resumes its handle, and owns its frame.
+template<typename T = void>
+class Task
+{
+public:
+	struct promise_type : TaskPromise<T>
+	{
+		Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+	};
+private:
+	std::coroutine_handle<promise_type> handle;
+public:
+	Task() = default;
+	explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+	Task(Task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+	Task& operator=(Task&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (handle)
+				handle.destroy();
+			handle = std::exchange(other.handle, {});
+		}
+		return *this;
+	}
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+	~Task()
+	{
+		if (handle)
+			handle.destroy();
+	}
+
+	bool await_ready() const noexcept { return false; }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+	{
+		handle.promise().continuation = awaiting;
+		return handle;
+	}
+	T await_resume() { return handle.promise().takeResult(); }
+
+	// For executors running the task at the top level.
+	std::coroutine_handle<> getHandle() const { return handle; }
+	bool isDone() const { return !handle || handle.done(); }
+	// Rethrows what the finished task threw.
+	T getResult() { return handle.promise().takeResult(); }
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Wakeup count and CPU time of one worker thread.
+// start() and finish() must be called from the thread being measured.
+class ThreadActivity
+{
+private:
+	std::string name;
+	std::atomic<std::uint64_t> wakeups;
+	std::chrono::steady_clock::time_point startTime;
+	std::chrono::steady_clock::time_point finishTime;
+	std::chrono::nanoseconds startCpuTime;
+	std::chrono::nanoseconds finishCpuTime;
+public:
+	explicit ThreadActivity(std::string name);
+
+	void start();
+	void wakeup() { wakeups.fetch_add(1, std::memory_order_relaxed); }
+	void finish();
+
+	std::chrono::nanoseconds getCpuTime() const { return finishCpuTime - startCpuTime; }
+	std::chrono::nanoseconds getWallTime() const { return finishTime - startTime; }
+	double getWakeupsPerSecond() const;
+	std::string getReport() const;
+private:
+	static std::chrono::nanoseconds getCurrentThreadCpuTime();
+};
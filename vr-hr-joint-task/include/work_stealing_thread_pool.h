@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of workers, each with its own task deque.
+// A worker pops its newest task first (cache-warm), an idle worker steals the oldest task of another,
+// so long and short tasks balance out without a shared queue becoming the bottleneck.
+class WorkStealingThreadPool
+{
+private:
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::jthread> threads;
+	std::mutex idleMutex;
+	std::condition_variable idle;
+	std::condition_variable finished;
+	std::atomic<std::size_t> pending;
+	std::atomic<std::size_t> nextWorker;
+	std::atomic<std::uint64_t> steals;
+	std::exception_ptr firstError;
+	bool stopping;
+public:
+	// 0 uses every hardware thread.
+	explicit WorkStealingThreadPool(std::size_t numberOfThreads = 0);
+	~WorkStealingThreadPool();
+
+	WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+	WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+	// Tasks submitted from a worker go to that worker's deque, others are spread round-robin.
+	void submit(std::function<void()> task);
+	// Blocks until every submitted task, including tasks they submitted, has run,
+	// then rethrows the first exception a task threw, if any.
+	void wait();
+
+	std::size_t getNumberOfThreads() const { return threads.size(); }
+	std::uint64_t getNumberOfSteals() const { return steals.load(std::memory_order_relaxed); }
+private:
+	void waitForTasks();
+	void workerLoop(std::size_t index);
+	bool tryRunTask(std::size_t index);
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <bit>
+#include <bitset>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "misc.h"
+
+// Bit i is object i+1, as numbered in the scene signals and the target object.
+using ObjectSet = std::bitset<64>;
+
+// Calls function(object) for every object in the set, lowest first, one step per set bit.
+template<typename Function>
+void forEachObject(const ObjectSet& objects, Function&& function)
+{
+	for (std::uint64_t bits = objects.to_ullong(); bits != 0; bits &= bits - 1)
+		function(std::countr_zero(bits) + 1);
+}
+
+// Per-object flags of the scene, one bit per object.
+struct ObjectSignals
+{
+	ObjectSet present;
+	ObjectSet robotGrasp;
+	ObjectSet robotPlace;
+	ObjectSet humanGrasp;
+	ObjectSet humanPlace;
+
+	bool operator==(const ObjectSignals&) const = default;
+};
+
+struct WorkspaceObject
+{
+	std::string name;
+	// On the table, in scene coordinates (m).
+	Position position;
+	// Centre of the object along the spatial dimension of the fields.
+	double fieldPosition;
+
+	WorkspaceObject(std::string name = {}, const Position& position = { 0, 0, 0 }, double fieldPosition = 0)
+		: name(std::move(name)), position(position), fieldPosition(fieldPosition)
+	{}
+};
+
+// The objects on the table and where each one lives in the fields. Loaded from JSON:
+// {
+//   "field": { "x_max": 50, "d_x": 0.5 },
+//   "table": { "y_min": -0.25, "y_max": 0.25 },
+//   "objects": [ { "name": "object1", "position": [0.0, 0.125, 0.716], "field_position": 37.5 }, ... ]
+// }
+// "field" and "table" are optional (defaults above); "field_position" defaults to the object's y mapped from
+// the table's y range onto the field, as the hand position is.
+class Workspace
+{
+public:
+	static constexpr std::size_t MAX_OBJECTS = ObjectSet().size();
+private:
+	std::vector<WorkspaceObject> objects;
+	int xMax;
+	double dX;
+	double tableYMin;
+	double tableYMax;
+	// Object indices ordered by field position, for the nearest-object search of getTargetObject().
+	std::vector<int> byFieldPosition;
+public:
+	explicit Workspace(std::vector<WorkspaceObject> objects, int xMax = 50, double dX = 0.5,
+		double tableYMin = -0.25, double tableYMax = 0.25);
+
+	// The three objects of the joint task scene.
+	static Workspace getDefault();
+	static Workspace parse(std::istream& stream);
+	static Workspace load(const std::string& path);
+
+	std::size_t getNumberOfObjects() const { return objects.size(); }
+	// object is 1-based.
+	const WorkspaceObject& getObject(int object) const { return objects.at(object - 1); }
+	const std::vector<WorkspaceObject>& getObjects() const { return objects; }
+	ObjectSet getAllObjects() const;
+	int getMaxSpatialDimension() const { return xMax; }
+	double getSpatialStep() const { return dX; }
+
+	// Scene y coordinate to the field's spatial dimension.
+	double getFieldPosition(double y) const;
+	// Object whose field position is closest to the centroid, going round the field (ties go to the lowest object);
+	// 0 when the centroid is negative (no decision). O(log n) in the number of objects.
+	int getTargetObject(double centroid) const;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+#include <elements/element_factory.h>
+
+#include "workspace.h"
+
+// One Gaussian per workspace object summed into a single stimulus element, so the field it feeds sums one input
+// however many objects there are. Each object's unit profile is evaluated once by the GaussStimulus formula;
+// an amplitude update adds the change of the objects whose amplitude changed, O(size) per changed object.
+// Profiles are evaluated in init(), amplitudes set before it take effect then.
+// The element's own parameters keep amplitude 0 and are not used after init().
+// The setters write the element output, so call them on the thread that steps the simulation.
+class WorkspaceStimulus : public dnf_composer::element::GaussStimulus
+{
+private:
+	std::vector<double> fieldPositions;
+	std::vector<double> amplitudes;
+	// Unit profile of object i at [i * size, (i + 1) * size).
+	std::vector<double> unitProfiles;
+	// The amplitudes the output currently sums.
+	std::vector<double> appliedAmplitudes;
+	// GaussStimulus::setParameters() re-initialises the element, which comes back here while the profiles are
+	// being evaluated.
+	bool evaluatingProfiles;
+public:
+	WorkspaceStimulus(const dnf_composer::element::ElementCommonParameters& elementCommonParameters,
+		const dnf_composer::element::GaussStimulusParameters& parameters, const Workspace& workspace, double amplitude);
+
+	void init() override;
+	void step(double t, double deltaT) override;
+	std::shared_ptr<dnf_composer::element::Element> clone() const override;
+
+	// index is 0-based (object index + 1 is the object number).
+	void setAmplitude(std::size_t index, double amplitude);
+	// One amplitude per object.
+	void setAmplitudes(const std::vector<double>& newAmplitudes);
+	// amplitude for the objects in the set, 0 for the others.
+	void setAmplitudes(const ObjectSet& objects, double amplitude);
+
+	std::size_t getNumberOfObjects() const { return amplitudes.size(); }
+	double getAmplitude(std::size_t index) const { return amplitudes.at(index); }
+private:
+	void evaluateProfiles();
+	void resetOutput();
+	void updateOutput();
+};
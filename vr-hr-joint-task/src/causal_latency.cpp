@@ -0,0 +1,114 @@
+#include "causal_latency.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	double toMilliseconds(std::chrono::steady_clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	void reportStage(std::stringstream& ss, const char* name, const LatencyHistogram& histogram)
+	{
+		ss << "\n  " << name << ": p50 = " << toMilliseconds(histogram.getPercentile(50))
+			<< " ms, p90 = " << toMilliseconds(histogram.getPercentile(90))
+			<< " ms, p99 = " << toMilliseconds(histogram.getPercentile(99))
+			<< " ms, max = " << toMilliseconds(histogram.getMax()) << " ms";
+	}
+}
+
+CausalLatencyTracer::CausalLatencyTracer(std::size_t maxChanges)
+	: samples(), numberOfSamples(0), lastSampleSequence(0), lastTargetObject(0), changesDropped(0)
+{
+	changes.reserve(maxChanges);
+}
+
+void CausalLatencyTracer::onStimulusApplied(std::uint64_t sampleSequence, std::chrono::steady_clock::time_point sampleTime,
+	std::uint64_t dnfStep, std::chrono::steady_clock::time_point now)
+{
+	if (sampleSequence == 0 || sampleSequence == lastSampleSequence)
+		return;
+	lastSampleSequence = sampleSequence;
+	samples[numberOfSamples % SAMPLE_HISTORY] = { sampleSequence, sampleTime, now, dnfStep };
+	++numberOfSamples;
+}
+
+DecisionCause CausalLatencyTracer::onDecision(int targetObject, std::uint64_t dnfStep, std::chrono::steady_clock::time_point now)
+{
+	if (targetObject == lastTargetObject)
+		return {};
+	DecisionCause cause;
+	cause.previousTargetObject = lastTargetObject;
+	cause.targetObject = targetObject;
+	cause.decisionTime = now;
+	cause.decisionStep = dnfStep;
+	lastTargetObject = targetObject;
+
+	// The last step the decision saw is step dnfStep, it read the stimuli applied with fewer steps completed.
+	const std::size_t available = std::min(numberOfSamples, SAMPLE_HISTORY);
+	for (std::size_t age = 1; age <= available; ++age)
+	{
+		const AppliedSample& sample = samples[(numberOfSamples - age) % SAMPLE_HISTORY];
+		if (sample.stimulusStep >= dnfStep)
+			continue;
+		cause.sampleSequence = sample.sequence;
+		cause.sampleTime = sample.sampleTime;
+		cause.stimulusTime = sample.stimulusTime;
+		cause.stimulusStep = sample.stimulusStep;
+		break;
+	}
+	return cause;
+}
+
+void CausalLatencyTracer::onTargetWritten(const DecisionCause& cause, std::chrono::steady_clock::time_point now)
+{
+	if (!cause.isValid())
+		return;
+	sampleToStimulus.record(cause.stimulusTime - cause.sampleTime);
+	stimulusToDecision.record(cause.decisionTime - cause.stimulusTime);
+	decisionToWrite.record(now - cause.decisionTime);
+	total.record(now - cause.sampleTime);
+	METRICS_RECORD("hand sample to target write", now - cause.sampleTime);
+	if (changes.size() < changes.capacity())
+		changes.push_back({ cause, now });
+	else
+		changesDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::string CausalLatencyTracer::getReport() const
+{
+	std::stringstream ss;
+	ss << "Hand sample to target write, " << total.getCount() << " decision changes";
+	if (total.getCount() == 0)
+		return ss.str();
+	reportStage(ss, "total", total);
+	reportStage(ss, "sample to stimulus", sampleToStimulus);
+	reportStage(ss, "stimulus to decision", stimulusToDecision);
+	reportStage(ss, "decision to write", decisionToWrite);
+	if (const std::uint64_t dropped = changesDropped.load(std::memory_order_relaxed))
+		ss << "\n  " << dropped << " changes not kept for the CSV";
+	return ss.str();
+}
+
+bool CausalLatencyTracer::writeCsv(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+	file << "sample_sequence,previous_target,target,stimulus_step,decision_step,"
+		"sample_to_stimulus_ms,stimulus_to_decision_ms,decision_to_write_ms,total_ms\n";
+	for (const DecisionLatency& change : changes)
+	{
+		const DecisionCause& cause = change.cause;
+		file << cause.sampleSequence << ',' << cause.previousTargetObject << ',' << cause.targetObject << ','
+			<< cause.stimulusStep << ',' << cause.decisionStep << ','
+			<< toMilliseconds(cause.stimulusTime - cause.sampleTime) << ','
+			<< toMilliseconds(cause.decisionTime - cause.stimulusTime) << ','
+			<< toMilliseconds(change.writeTime - cause.decisionTime) << ','
+			<< toMilliseconds(change.writeTime - cause.sampleTime) << '\n';
+	}
+	return static_cast<bool>(file);
+}
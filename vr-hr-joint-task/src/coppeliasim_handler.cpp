@@ -1,13 +1,277 @@
 #include "coppeliasim_handler.h"
 
-CoppeliasimHandler::CoppeliasimHandler()
-	: incomingSignalsClient("127.0.0.1", 19999),
-	outgoingSignalsClient("127.0.0.1", 19998),
-	handClient("127.0.0.1", 19995)
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+	struct IncomingSignalFlag
+	{
+		const char* name;
+		bool IncomingSignals::* flag;
+	};
+
+	// Order defines the bit positions of the packed snapshot, do not reorder.
+	constexpr IncomingSignalFlag incomingSignalFlags[IncomingSignalsSnapshot::NUMBER_OF_FLAGS] = {
+		{ IncomingSignals::SIM_STARTED, &IncomingSignals::simStarted },
+		{ IncomingSignals::OBJECT1_EXISTS, &IncomingSignals::object1 },
+		{ IncomingSignals::OBJECT2_EXISTS, &IncomingSignals::object2 },
+		{ IncomingSignals::OBJECT3_EXISTS, &IncomingSignals::object3 },
+		{ IncomingSignals::ROBOT_APPROACH, &IncomingSignals::robotApproaching },
+		{ IncomingSignals::ROBOT_GRASP, &IncomingSignals::robotGrasping },
+		{ IncomingSignals::ROBOT_GRASP_OBJ1, &IncomingSignals::robotGraspObj1 },
+		{ IncomingSignals::ROBOT_GRASP_OBJ2, &IncomingSignals::robotGraspObj2 },
+		{ IncomingSignals::ROBOT_GRASP_OBJ3, &IncomingSignals::robotGraspObj3 },
+		{ IncomingSignals::ROBOT_PLACE_OBJ1, &IncomingSignals::robotPlaceObj1 },
+		{ IncomingSignals::ROBOT_PLACE_OBJ2, &IncomingSignals::robotPlaceObj2 },
+		{ IncomingSignals::ROBOT_PLACE_OBJ3, &IncomingSignals::robotPlaceObj3 },
+		{ IncomingSignals::HUMAN_GRASP_OBJ1, &IncomingSignals::humanGraspObj1 },
+		{ IncomingSignals::HUMAN_GRASP_OBJ2, &IncomingSignals::humanGraspObj2 },
+		{ IncomingSignals::HUMAN_GRASP_OBJ3, &IncomingSignals::humanGraspObj3 },
+		{ IncomingSignals::HUMAN_PLACE_OBJ1, &IncomingSignals::humanPlaceObj1 },
+		{ IncomingSignals::HUMAN_PLACE_OBJ2, &IncomingSignals::humanPlaceObj2 },
+		{ IncomingSignals::HUMAN_PLACE_OBJ3, &IncomingSignals::humanPlaceObj3 },
+		{ IncomingSignals::CAN_RESTART, &IncomingSignals::canRestart },
+		{ IncomingSignals::RESTART, &IncomingSignals::restart },
+	};
+
+	// Outgoing signals, the packed snapshot and every incoming flag, as a fresh session starts with.
+	std::vector<std::pair<std::string, int>> getResetWrites()
+	{
+		std::vector<std::pair<std::string, int>> writes = { { OutgoingSignals::START_SIM, 0 },
+			{ OutgoingSignals::TARGET_OBJECT, 0 }, { IncomingSignalsSnapshot::SIGNAL, 0 } };
+		for (const auto& [name, flag] : incomingSignalFlags)
+			writes.emplace_back(name, 0);
+		return writes;
+	}
+
+	std::vector<std::size_t> getAllFlags()
+	{
+		std::vector<std::size_t> flags(IncomingSignalsSnapshot::NUMBER_OF_FLAGS);
+		for (std::size_t i = 0; i < flags.size(); ++i)
+			flags[i] = i;
+		return flags;
+	}
+
+	// Reads the given flags into signals, all in flight together.
+	Task<void> readIncomingSignalFlags(AsyncRemoteApiClient& client, const std::vector<std::size_t>& flags,
+		IncomingSignals& signals)
+	{
+		std::vector<RemoteApiExecutor::Request> reads;
+		reads.reserve(flags.size());
+		for (const std::size_t flag : flags)
+			reads.push_back(client.getIntegerSignal(incomingSignalFlags[flag].name));
+
+		for (std::size_t i = 0; i < flags.size(); ++i)
+		{
+			RemoteApiExecutor::Request& read = reads[i];
+			signals.*incomingSignalFlags[flags[i]].flag = (co_await read).value;
+		}
+	}
+
+	// Keeps inFlight reads outstanding and hands the responses over in order. Sends are spread over the
+	// smoothed round trip, so the samples stay evenly spaced rather than arriving in bursts, and are at least
+	// minimumPeriod(now) apart.
+	template<typename Issue, typename Consume, typename Running, typename MinimumPeriod>
+	Task<void> keepReading(RemoteApiExecutor& executor, std::size_t inFlight, Issue issue, Consume consume, Running running,
+		MinimumPeriod minimumPeriod)
+	{
+		inFlight = std::max<std::size_t>(inFlight, 1);
+		std::deque<RemoteApiExecutor::Request> reads;
+		RemoteApiExecutor::Clock::duration roundTrip(0);
+		while (running())
+		{
+			if (reads.size() < inFlight)
+			{
+				if (!reads.empty())
+					co_await executor.sleepUntil(reads.back().getSendTime()
+						+ std::max(roundTrip / static_cast<int>(inFlight), minimumPeriod(RemoteApiExecutor::Clock::now())));
+				reads.push_back(issue());
+				continue;
+			}
+
+			RemoteApiExecutor::Request read = std::move(reads.front());
+			reads.pop_front();
+			const RemoteApiResponse response = co_await read;
+			const auto responseTime = RemoteApiExecutor::Clock::now();
+			const auto sample = responseTime - read.getSendTime();
+			roundTrip = roundTrip.count() == 0 ? sample : (7 * roundTrip + sample) / 8;
+			co_await consume(response, read.getSendTime(), responseTime);
+		}
+	}
+}
+
+int IncomingSignalsSnapshot::pack(const IncomingSignals& signals)
+{
+	int packed = VERSION << VERSION_SHIFT;
+	for (int i = 0; i < NUMBER_OF_FLAGS; ++i)
+		if (signals.*incomingSignalFlags[i].flag)
+			packed |= 1 << i;
+	return packed;
+}
+
+bool IncomingSignalsSnapshot::unpack(int packed, IncomingSignals& signals)
 {
-	incomingSignalsClient.setLogMode(coppeliasim_cpp::LogMode::NO_LOGS);
-	outgoingSignalsClient.setLogMode(coppeliasim_cpp::LogMode::NO_LOGS);
-	handClient.setLogMode(coppeliasim_cpp::LogMode::NO_LOGS);
+	const int version = (packed >> VERSION_SHIFT) & VERSION_MASK;
+	if (version != VERSION)
+		return false;
+
+	for (int i = 0; i < NUMBER_OF_FLAGS; ++i)
+		signals.*incomingSignalFlags[i].flag = (packed >> i) & 1;
+	return true;
+}
+
+Task<IncomingSignals> readSnapshot(AsyncRemoteApiClient& client)
+{
+	const RemoteApiResponse snapshot = co_await client.getIntegerSignal(IncomingSignalsSnapshot::SIGNAL);
+	IncomingSignals signals;
+	if (!IncomingSignalsSnapshot::unpack(snapshot.value, signals))
+		co_await readIncomingSignalFlags(client, getAllFlags(), signals);
+	co_return signals;
+}
+
+IncomingSignals readIncomingSignals(const RemoteApiClient& client)
+{
+	IncomingSignals signals;
+	if (IncomingSignalsSnapshot::unpack(client.getIntegerSignal(IncomingSignalsSnapshot::SIGNAL), signals))
+		return signals;
+
+	// Older scenes only publish the individual signals.
+	for (const auto& [name, flag] : incomingSignalFlags)
+		signals.*flag = client.getIntegerSignal(name);
+	return signals;
+}
+
+PollingScheduleParameters makeDefaultPollingSchedule()
+{
+	PollingScheduleParameters parameters;
+	parameters.targets.emplace_back(HumanHand::POLLING_TARGET, 0, 0);
+	const std::vector<std::string> robotFlags = { IncomingSignals::ROBOT_GRASP,
+		IncomingSignals::ROBOT_GRASP_OBJ1, IncomingSignals::ROBOT_GRASP_OBJ2, IncomingSignals::ROBOT_GRASP_OBJ3,
+		IncomingSignals::ROBOT_PLACE_OBJ1, IncomingSignals::ROBOT_PLACE_OBJ2, IncomingSignals::ROBOT_PLACE_OBJ3 };
+	for (const char* name : { IncomingSignals::ROBOT_APPROACH,
+		IncomingSignals::HUMAN_GRASP_OBJ1, IncomingSignals::HUMAN_GRASP_OBJ2, IncomingSignals::HUMAN_GRASP_OBJ3,
+		IncomingSignals::HUMAN_PLACE_OBJ1, IncomingSignals::HUMAN_PLACE_OBJ2, IncomingSignals::HUMAN_PLACE_OBJ3 })
+		parameters.targets.emplace_back(name, 100, 1);
+	for (const std::string& name : robotFlags)
+		parameters.targets.emplace_back(name, 100, 1);
+	for (const char* name : { IncomingSignals::OBJECT1_EXISTS, IncomingSignals::OBJECT2_EXISTS, IncomingSignals::OBJECT3_EXISTS })
+		parameters.targets.emplace_back(name, 20, 2);
+	for (const char* name : { IncomingSignals::SIM_STARTED, IncomingSignals::CAN_RESTART, IncomingSignals::RESTART })
+		parameters.targets.emplace_back(name, 2, 3);
+
+	parameters.boosts.emplace_back(IncomingSignals::ROBOT_APPROACH, robotFlags, 500, std::chrono::milliseconds(3000));
+	parameters.boosts.emplace_back(IncomingSignals::CAN_RESTART, std::vector<std::string>{ IncomingSignals::RESTART },
+		50, std::chrono::milliseconds(5000));
+	return parameters;
+}
+
+ObjectSignals decodeObjectSignals(const IncomingSignals& signals)
+{
+	ObjectSignals objects;
+	const bool present[] = { signals.object1, signals.object2, signals.object3 };
+	const bool robotGrasp[] = { signals.robotGraspObj1, signals.robotGraspObj2, signals.robotGraspObj3 };
+	const bool robotPlace[] = { signals.robotPlaceObj1, signals.robotPlaceObj2, signals.robotPlaceObj3 };
+	const bool humanGrasp[] = { signals.humanGraspObj1, signals.humanGraspObj2, signals.humanGraspObj3 };
+	const bool humanPlace[] = { signals.humanPlaceObj1, signals.humanPlaceObj2, signals.humanPlaceObj3 };
+	static_assert(std::size(present) == IncomingSignals::NUMBER_OF_OBJECTS);
+	for (std::size_t i = 0; i < std::size(present); ++i)
+	{
+		objects.present[i] = present[i];
+		objects.robotGrasp[i] = robotGrasp[i];
+		objects.robotPlace[i] = robotPlace[i];
+		objects.humanGrasp[i] = humanGrasp[i];
+		objects.humanPlace[i] = humanPlace[i];
+	}
+	return objects;
+}
+
+CoppeliasimHandler makeCoppeliasimHandler(CoppeliasimTransport transport, const CoppeliasimHandlerParameters& parameters)
+{
+	switch (transport)
+	{
+	case CoppeliasimTransport::PIPELINED:
+		return CoppeliasimHandler(std::make_unique<SerialRemoteApiConnection>(
+			std::make_unique<CoppeliaSimRemoteApiClient>("127.0.0.1", 19999)), parameters);
+	case CoppeliasimTransport::SHARED_MEMORY:
+		return CoppeliasimHandler(std::make_unique<SharedSceneClient>(SharedSceneState::DEFAULT_NAME), parameters);
+	case CoppeliasimTransport::REMOTE_API_THREADS:
+		break;
+	}
+	return CoppeliasimHandler(parameters);
+}
+
+CoppeliasimHandler::CoppeliasimHandler(const CoppeliasimHandlerParameters& parameters)
+	: CoppeliasimHandler(std::make_unique<CoppeliaSimRemoteApiClient>("127.0.0.1", 19999),
+		std::make_unique<CoppeliaSimRemoteApiClient>("127.0.0.1", 19998),
+		std::make_unique<CoppeliaSimRemoteApiClient>("127.0.0.1", 19995),
+		parameters)
+{}
+
+CoppeliasimHandler::CoppeliasimHandler(std::unique_ptr<RemoteApiClient> incomingSignalsClient,
+	std::unique_ptr<RemoteApiClient> outgoingSignalsClient,
+	std::unique_ptr<RemoteApiClient> handClient,
+	const CoppeliasimHandlerParameters& parameters)
+	: parameters(parameters),
+	incomingSignalsClient(std::move(incomingSignalsClient)),
+	outgoingSignalsClient(std::move(outgoingSignalsClient)),
+	handClient(std::move(handClient)),
+	stopRequested(false),
+	failed(false),
+	incomingChangeNotifier(nullptr),
+	causalLatencyTracer(nullptr),
+	handPoseTelemetry(nullptr),
+	writesSent(0),
+	writesSuppressed(0),
+	incomingSignalsActivity("Incoming signals"),
+	outgoingSignalsActivity("Outgoing signals"),
+	handActivity("Hand pose"),
+	sharedSceneActivity("Shared scene")
+{
+	setupPollingSchedule();
+}
+
+CoppeliasimHandler::CoppeliasimHandler(std::unique_ptr<PipelinedConnection> connection,
+	const CoppeliasimHandlerParameters& parameters)
+	: parameters(parameters),
+	executor(std::make_unique<RemoteApiExecutor>(std::move(connection), "CoppeliaSim I/O", parameters.executorSpinThreshold)),
+	asyncClient(std::make_unique<AsyncRemoteApiClient>(*executor, parameters.connectionBackoff)),
+	outgoingSignalsEvent(std::make_unique<RemoteApiExecutor::Event>(*executor)),
+	stopEvent(std::make_unique<RemoteApiExecutor::Event>(*executor)),
+	stopRequested(false),
+	failed(false),
+	incomingChangeNotifier(nullptr),
+	causalLatencyTracer(nullptr),
+	handPoseTelemetry(nullptr),
+	writesSent(0),
+	writesSuppressed(0),
+	incomingSignalsActivity("Incoming signals"),
+	outgoingSignalsActivity("Outgoing signals"),
+	handActivity("Hand pose"),
+	sharedSceneActivity("Shared scene")
+{
+	setupPollingSchedule();
+}
+
+CoppeliasimHandler::CoppeliasimHandler(std::unique_ptr<SharedSceneClient> sharedScene,
+	const CoppeliasimHandlerParameters& parameters)
+	: parameters(parameters),
+	sharedScene(std::move(sharedScene)),
+	stopRequested(false),
+	failed(false),
+	incomingChangeNotifier(nullptr),
+	causalLatencyTracer(nullptr),
+	handPoseTelemetry(nullptr),
+	writesSent(0),
+	writesSuppressed(0),
+	incomingSignalsActivity("Incoming signals"),
+	outgoingSignalsActivity("Outgoing signals"),
+	handActivity("Hand pose"),
+	sharedSceneActivity("Shared scene")
+{
+	setupPollingSchedule();
 }
 
 CoppeliasimHandler::~CoppeliasimHandler()
@@ -17,147 +281,562 @@ CoppeliasimHandler::~CoppeliasimHandler()
 
 void CoppeliasimHandler::init()
 {
+	if (executor)
+	{
+		executor->spawn(runPipelined());
+		executorThread = std::thread(&RemoteApiExecutor::run, executor.get());
+		return;
+	}
+	if (sharedScene)
+	{
+		sharedSceneThread = std::thread(&CoppeliasimHandler::sharedSceneLoop, this);
+		return;
+	}
+	// The incoming signals thread starts the outgoing one once the signals are reset.
 	incomingSignalsThread = std::thread(&CoppeliasimHandler::incomingSignalsLoop, this);
-	outgoingSignalsThread = std::thread(&CoppeliasimHandler::outgoingSignalsLoop, this);
 	handThread = std::thread(&CoppeliasimHandler::readHandPosition, this);
 }
 
 
+void CoppeliasimHandler::setChangeNotifier(ChangeNotifier* notifier)
+{
+	incomingChangeNotifier = notifier;
+}
+
 void CoppeliasimHandler::incomingSignalsLoop()
 {
-	
-	while (!incomingSignalsClient.initialize());
+	if (!connectWithBackoff([this] { return incomingSignalsClient->initialize(); }))
+		return;
 
-	incomingSignalsClient.startSimulation();
+	incomingSignalsClient->startSimulation();
+	packedSignals.reset();
 
+	// Before the writer starts, so a reset never lands after a value the writer records as sent.
 	resetSignals();
+	outgoingSignalsThread = std::thread(&CoppeliasimHandler::outgoingSignalsLoop, this);
 
+	incomingSignalsActivity.start();
 	while (isConnected())
 	{
+		incomingSignalsActivity.wakeup();
 		readSignals();
 		//printSignals();
+		std::this_thread::sleep_until(getNextFlagReadTime(std::chrono::steady_clock::now()));
 	}
+	incomingSignalsActivity.finish();
 }
 
 void CoppeliasimHandler::outgoingSignalsLoop()
 {
-	while (!outgoingSignalsClient.initialize());
+	if (!connectWithBackoff([this] { return outgoingSignalsClient->initialize(); }))
+		return;
 
-	while (outgoingSignalsClient.isConnected())
+	// Without a keep-alive we still wake up now and then to notice a lost connection.
+	const std::chrono::milliseconds maxPeriod = parameters.keepAlivePeriod.count() > 0
+		? parameters.keepAlivePeriod : std::chrono::milliseconds(1000);
+
+	outgoingSignalsActivity.start();
+	while (outgoingSignalsClient->isConnected())
 	{
+		outgoingSignalsActivity.wakeup();
 		writeSignals();
+		if (outgoingSignalsChanged.waitFor(maxPeriod) && parameters.coalescingWindow.count() > 0)
+			std::this_thread::sleep_for(parameters.coalescingWindow);
 	}
+	outgoingSignalsActivity.finish();
 }
 
 
-void CoppeliasimHandler::setSignals(const OutgoingSignals& signals)
+void CoppeliasimHandler::setCausalLatencyTracer(CausalLatencyTracer* tracer)
 {
-	outgoingSignals = signals;
+	causalLatencyTracer = tracer;
+}
+
+void CoppeliasimHandler::setHandPoseTelemetry(PoseTelemetryWriter* telemetry)
+{
+	handPoseTelemetry = telemetry;
+}
+
+void CoppeliasimHandler::setSignals(const OutgoingSignals& signals, const DecisionCause& cause)
+{
+	// Single writer, so the published value is our own last write.
+	TracedOutgoingSignals traced{ signals, cause };
+	if (outgoingSignals.getSequence() != 0)
+	{
+		const TracedOutgoingSignals pending = outgoingSignals.read().value;
+		// A cause holds for as long as its target does; the writer may not have seen it yet.
+		if (!cause.isValid() && pending.cause.isValid() && pending.cause.targetObject == signals.targetObject)
+			traced.cause = pending.cause;
+		if (pending.signals == signals && pending.cause.sampleSequence == traced.cause.sampleSequence)
+			return;
+	}
+	outgoingSignals.publish(traced);
+	if (outgoingSignalsEvent)
+		outgoingSignalsEvent->notify();
+	else
+		outgoingSignalsChanged.notify();
 }
 
 
 IncomingSignals CoppeliasimHandler::getSignals() const
 {
-	return incomingSignals;
+	return incomingSignals.read().value;
+}
+
+Snapshot<IncomingSignals> CoppeliasimHandler::getSignalsSnapshot() const
+{
+	return incomingSignals.read();
 }
 
 void CoppeliasimHandler::readHandPosition()
 {
-	while (!handClient.initialize());
+	if (!connectWithBackoff([this] { return handClient->initialize(); }))
+		return;
 
-	hand.objectHandle = handClient.getObjectHandle("RightController");
+	hand.objectHandle = handClient->getObjectHandle("RightController");
 
-    while (handClient.isConnected())
+	handActivity.start();
+    while (handClient->isConnected())
     {
-        coppeliasim_cpp::Pose pos = handClient.getObjectPose(hand.objectHandle);
-		hand.pose = { {pos.position.x,
-			pos.position.y,
-			pos.position.z},
-			{pos.orientation.alpha,
-			pos.orientation.beta,
-			pos.orientation.gamma}
-		};
+		handActivity.wakeup();
+		const auto requestTime = std::chrono::steady_clock::now();
+		const Pose pose = handClient->getObjectPose(hand.objectHandle);
+		publishHandPose(pose, requestTime, std::chrono::steady_clock::now());
+		onHandRead(requestTime);
+		std::this_thread::sleep_until(requestTime + getHandReadPeriod(requestTime));
     }
+	handActivity.finish();
+}
+
+void CoppeliasimHandler::publishHandPose(const Pose& pose, std::chrono::steady_clock::time_point requestTime,
+	std::chrono::steady_clock::time_point responseTime)
+{
+	METRICS_RECORD("pose read", responseTime - requestTime);
+	// The pose is sampled somewhere within the round trip, take its midpoint.
+	publishHandPose(pose, requestTime + (responseTime - requestTime) / 2);
+}
+
+void CoppeliasimHandler::publishHandPose(const Pose& pose, std::chrono::steady_clock::time_point captureTime)
+{
+	handPose.publish(pose, captureTime);
+	if (handPoseTelemetry)
+		handPoseTelemetry->record(handPose.getSequence(), captureTime, pose);
+	if (pose != hand.pose && incomingChangeNotifier)
+		incomingChangeNotifier->notify();
+	hand.pose = pose;
 }
 
 
 Pose CoppeliasimHandler::getHandPose() const
 {
-	return hand.pose;
+	return handPose.read().value;
+}
+
+Snapshot<Pose> CoppeliasimHandler::getHandPoseSnapshot() const
+{
+	return handPose.read();
 }
 
 
 void CoppeliasimHandler::end()
 {
+	if (executor)
+	{
+		stopRequested.store(true, std::memory_order_relaxed);
+		stopEvent->notify();
+		outgoingSignalsEvent->notify();
+		if (executorThread.joinable())
+			executorThread.join();
+		return;
+	}
+	if (sharedScene)
+	{
+		stopRequested.store(true, std::memory_order_relaxed);
+		if (sharedSceneThread.joinable())
+			sharedSceneThread.join();
+		return;
+	}
+
+	stopRequested.store(true, std::memory_order_relaxed);
 	if (isConnected())
-		incomingSignalsClient.stopSimulation();
-	incomingSignalsThread.join();
-	outgoingSignalsThread.join();
-	handThread.join();
+		incomingSignalsClient->stopSimulation();
+	// The incoming signals thread starts the outgoing one, join it first.
+	if (incomingSignalsThread.joinable())
+		incomingSignalsThread.join();
+	if (outgoingSignalsThread.joinable())
+		outgoingSignalsThread.join();
+	if (handThread.joinable())
+		handThread.join();
+}
+
+std::vector<const ThreadActivity*> CoppeliasimHandler::getThreadActivities() const
+{
+	if (executor)
+		return { &executor->getActivity() };
+	if (sharedScene)
+		return { &sharedSceneActivity };
+	return { &incomingSignalsActivity, &outgoingSignalsActivity, &handActivity };
 }
 
 bool CoppeliasimHandler::isConnected() const
 {
-	return incomingSignalsClient.isConnected();
+	if (executor)
+		return executor->getConnection().isConnected();
+	if (sharedScene)
+		return !failed.load(std::memory_order_relaxed) && sharedScene->isConnected();
+	return incomingSignalsClient->isConnected();
 }
 
 void CoppeliasimHandler::readSignals()
 {
-	incomingSignals.simStarted = incomingSignalsClient.getIntegerSignal(IncomingSignals::SIM_STARTED);
-	incomingSignals.object1 = incomingSignalsClient.getIntegerSignal(IncomingSignals::OBJECT1_EXISTS);
-	incomingSignals.object2 = incomingSignalsClient.getIntegerSignal(IncomingSignals::OBJECT2_EXISTS);
-	incomingSignals.object3 = incomingSignalsClient.getIntegerSignal(IncomingSignals::OBJECT3_EXISTS);
-	incomingSignals.robotApproaching = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_APPROACH);
-	incomingSignals.robotGrasping = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_GRASP);
+	const auto requestTime = std::chrono::steady_clock::now();
+	std::vector<std::size_t> flags = getDueFlags(requestTime);
+	if (flags.empty())
+		return;
+
+	IncomingSignals signals;
+	if (packedSignals.value_or(true)
+		&& IncomingSignalsSnapshot::unpack(incomingSignalsClient->getIntegerSignal(IncomingSignalsSnapshot::SIGNAL), signals))
+	{
+		packedSignals = true;
+		flags = getAllFlags();
+	}
+	else
+	{
+		// Older scenes only publish the individual signals, read those that are due.
+		signals = polledSignals;
+		for (const std::size_t flag : flags)
+			signals.*incomingSignalFlags[flag].flag = incomingSignalsClient->getIntegerSignal(incomingSignalFlags[flag].name);
+		onIndividualSignalsRead(signals);
+	}
+	onFlagsRead(signals, flags, requestTime);
+	publishSignals(signals, requestTime, std::chrono::steady_clock::now());
+}
+
+void CoppeliasimHandler::onIndividualSignalsRead(const IncomingSignals& signals)
+{
+	// The reset clears the snapshot along with the flags, so it may be missing until the scene has stepped;
+	// a scene that sets flags without it is an older one, not worth asking again.
+	if (!packedSignals.has_value() && signals != IncomingSignals())
+		packedSignals = false;
+}
+
+void CoppeliasimHandler::publishSignals(const IncomingSignals& signals, std::chrono::steady_clock::time_point requestTime,
+	std::chrono::steady_clock::time_point responseTime)
+{
+	METRICS_RECORD("signal read", responseTime - requestTime);
+	publishSignals(signals, requestTime + (responseTime - requestTime) / 2);
+}
+
+void CoppeliasimHandler::publishSignals(const IncomingSignals& signals, std::chrono::steady_clock::time_point captureTime)
+{
+	const bool changed = signals != incomingSignals.read().value;
+	incomingSignals.publish(signals, captureTime);
+	if (changed && incomingChangeNotifier)
+		incomingChangeNotifier->notify();
+}
+
+void CoppeliasimHandler::writeSignals()
+{
+	METRICS_SCOPED_TIMER("signal write");
+	const SignalWrites writes = planWrites();
+	for (const auto& [name, value] : writes.writes)
+		outgoingSignalsClient->setIntegerSignal(name, value);
+	onWritesAcknowledged(writes);
+}
+
+CoppeliasimHandler::SignalWrites CoppeliasimHandler::planWrites()
+{
+	// Only the latest value is written, intermediate values of a burst are dropped.
+	const TracedOutgoingSignals traced = outgoingSignals.read().value;
+	const OutgoingSignals& signals = traced.signals;
+
+	const auto now = std::chrono::steady_clock::now();
+	const bool refresh = parameters.keepAlivePeriod.count() > 0
+		&& now - lastRefreshTime >= parameters.keepAlivePeriod;
+	if (refresh)
+		lastRefreshTime = now;
+
+	SignalWrites writes;
+	writes.signals = signals;
+	planWrite(OutgoingSignals::START_SIM, signals.startSim, sentStartSim, refresh, writes);
+	const bool targetChanged = sentTargetObject != signals.targetObject;
+	if (planWrite(OutgoingSignals::TARGET_OBJECT, signals.targetObject, sentTargetObject, refresh, writes)
+		&& targetChanged && causalLatencyTracer && traced.cause.targetObject == signals.targetObject)
+		writes.tracedCause = traced.cause;
+	return writes;
+}
+
+void CoppeliasimHandler::onWritesAcknowledged(const SignalWrites& writes)
+{
+	if (writes.tracedCause)
+		causalLatencyTracer->onTargetWritten(*writes.tracedCause);
+}
+
+template<typename T>
+bool CoppeliasimHandler::planWrite(const char* name, T value, std::optional<T>& sentValue, bool refresh, SignalWrites& writes)
+{
+	if (!refresh && sentValue == value)
+	{
+		writesSuppressed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	writes.writes.emplace_back(name, static_cast<int>(value));
+	sentValue = value;
+	writesSent.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+bool CoppeliasimHandler::isRunningPipelined() const
+{
+	return !stopRequested.load(std::memory_order_relaxed) && executor->getConnection().isConnected();
+}
+
+Task<void> CoppeliasimHandler::runPipelined()
+{
+	const bool connected = co_await asyncClient->connect(stopRequested);
+	if (!connected)
+		co_return;
+	co_await asyncClient->startSimulation();
+	packedSignals.reset();
+	co_await asyncClient->writeSignals(getResetWrites());
+	hand.objectHandle = co_await asyncClient->getObjectHandle("RightController");
+
+	executor->spawn(readSignalsPipelined());
+	executor->spawn(readHandPosePipelined());
+	executor->spawn(writeSignalsPipelined());
+
+	while (isRunningPipelined())
+		co_await stopEvent->waitFor(std::chrono::seconds(1));
+	if (executor->getConnection().isConnected())
+		co_await asyncClient->stopSimulation();
+}
+
+Task<void> CoppeliasimHandler::readSignalsPipelined()
+{
+	using Clock = RemoteApiExecutor::Clock;
+	while (isRunningPipelined())
+	{
+		Clock::time_point requestTime = Clock::now();
+		std::vector<std::size_t> flags = getDueFlags(requestTime);
+		if (flags.empty())
+		{
+			co_await executor->sleepUntil(getNextFlagReadTime(requestTime));
+			continue;
+		}
+
+		IncomingSignals signals;
+		bool unpacked = false;
+		if (packedSignals.value_or(true))
+		{
+			const RemoteApiResponse snapshot = co_await asyncClient->getIntegerSignal(IncomingSignalsSnapshot::SIGNAL);
+			unpacked = IncomingSignalsSnapshot::unpack(snapshot.value, signals);
+		}
+		if (unpacked)
+		{
+			packedSignals = true;
+			flags = getAllFlags();
+		}
+		else
+		{
+			// Older scenes only publish the individual signals, read those that are due.
+			requestTime = Clock::now();
+			signals = polledSignals;
+			co_await readIncomingSignalFlags(*asyncClient, flags, signals);
+			onIndividualSignalsRead(signals);
+		}
+		onFlagsRead(signals, flags, requestTime);
+		publishSignals(signals, requestTime, Clock::now());
+	}
+}
+
+Task<void> CoppeliasimHandler::readHandPosePipelined()
+{
+	using Clock = RemoteApiExecutor::Clock;
+	co_await keepReading(*executor, parameters.readsInFlight,
+		[this] { return asyncClient->readPose(hand.objectHandle); },
+		[this](RemoteApiResponse response, Clock::time_point requestTime, Clock::time_point responseTime) -> Task<void> {
+			publishHandPose(response.pose, requestTime, responseTime);
+			onHandRead(requestTime);
+			co_return;
+		},
+		[this] { return isRunningPipelined(); },
+		[this](Clock::time_point now) { return getHandReadPeriod(now); });
+}
+
+Task<void> CoppeliasimHandler::writeSignalsPipelined()
+{
+	// Without a keep-alive we still wake up now and then to notice a lost connection.
+	const std::chrono::milliseconds maxPeriod = parameters.keepAlivePeriod.count() > 0
+		? parameters.keepAlivePeriod : std::chrono::milliseconds(1000);
+
+	while (isRunningPipelined())
+	{
+		{
+			METRICS_SCOPED_TIMER("signal write");
+			const SignalWrites writes = planWrites();
+			co_await asyncClient->writeSignals(writes.writes);
+			onWritesAcknowledged(writes);
+		}
+		const bool changed = co_await outgoingSignalsEvent->waitFor(maxPeriod);
+		if (changed && parameters.coalescingWindow.count() > 0)
+			co_await executor->sleepFor(parameters.coalescingWindow);
+	}
+}
 
-	incomingSignals.robotGraspObj1 = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ1);
-	incomingSignals.robotGraspObj2 = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ2);
-	incomingSignals.robotGraspObj3 = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ3);
-	incomingSignals.robotPlaceObj1 = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ1);
-	incomingSignals.robotPlaceObj2 = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ2);
-	incomingSignals.robotPlaceObj3 = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ3);
-	incomingSignals.humanGraspObj1 = incomingSignalsClient.getIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ1);
-	incomingSignals.humanGraspObj2 = incomingSignalsClient.getIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ2);
-	incomingSignals.humanGraspObj3 = incomingSignalsClient.getIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ3);
-	incomingSignals.humanPlaceObj1 = incomingSignalsClient.getIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ1);
-	incomingSignals.humanPlaceObj2 = incomingSignalsClient.getIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ2);
-	incomingSignals.humanPlaceObj3 = incomingSignalsClient.getIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ3);
-	incomingSignals.canRestart = incomingSignalsClient.getIntegerSignal(IncomingSignals::CAN_RESTART);
-	incomingSignals.restart = incomingSignalsClient.getIntegerSignal(IncomingSignals::RESTART);
+void CoppeliasimHandler::sharedSceneLoop()
+{
+	if (!connectSharedScene())
+		return;
+	SharedSceneState& state = sharedScene->getState();
+
+	// Sequence numbers start at zero, before anything is published.
+	std::uint64_t signalsSequence = 0;
+	std::uint64_t poseSequence = 0;
+	std::optional<std::uint64_t> outgoingSequence;
+	// Without a keep-alive we still look at the outgoing signals now and then.
+	const std::chrono::milliseconds maxPeriod = parameters.keepAlivePeriod.count() > 0
+		? parameters.keepAlivePeriod : std::chrono::milliseconds(1000);
+	auto lastWriteTime = std::chrono::steady_clock::now();
+
+	sharedSceneActivity.start();
+	while (!stopRequested.load(std::memory_order_relaxed) && sharedScene->isConnected())
+	{
+		bool idle = true;
+		if (state.incomingSignals.getSequence() != signalsSequence)
+		{
+			const Snapshot<std::int32_t> packed = state.incomingSignals.read();
+			IncomingSignals signals;
+			if (IncomingSignalsSnapshot::unpack(packed.value, signals))
+				publishSignals(signals, packed.captureTime);
+			signalsSequence = packed.sequence;
+			idle = false;
+		}
+		if (state.handPose.getSequence() != poseSequence)
+		{
+			const Snapshot<Pose> pose = state.handPose.read();
+			// The simulator overwrites samples we were too late to read.
+			if (handPoseTelemetry && poseSequence != 0 && pose.sequence > poseSequence + 1)
+				handPoseTelemetry->countDropped(pose.sequence - poseSequence - 1);
+			publishHandPose(pose.value, pose.captureTime);
+			poseSequence = pose.sequence;
+			idle = false;
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		if (outgoingSequence != outgoingSignals.getSequence() || now - lastWriteTime >= maxPeriod)
+		{
+			outgoingSequence = outgoingSignals.getSequence();
+			lastWriteTime = now;
+			const SignalWrites writes = planWrites();
+			if (!writes.writes.empty())
+			{
+				state.outgoingSignals.publish({ writes.signals.startSim, writes.signals.targetObject });
+				onWritesAcknowledged(writes);
+			}
+			idle = false;
+		}
+
+		if (idle)
+			std::this_thread::sleep_for(parameters.sharedScenePollPeriod);
+		else
+			sharedSceneActivity.wakeup();
+	}
+	sharedSceneActivity.finish();
+}
+
+bool CoppeliasimHandler::connectWithBackoff(const std::function<bool()>& connect)
+{
+	std::chrono::milliseconds delay = parameters.connectionBackoff.initialDelay;
+	while (!stopRequested.load(std::memory_order_relaxed) && !failed.load(std::memory_order_relaxed))
+	{
+		if (connect())
+			return true;
+		std::this_thread::sleep_for(delay);
+		delay = std::min(delay * 2, parameters.connectionBackoff.maxDelay);
+	}
+	return false;
+}
+
+bool CoppeliasimHandler::connectSharedScene()
+{
+	// The region only exists while the simulator runs, so there is no simulation to start.
+	return connectWithBackoff([this] {
+		try
+		{
+			return sharedScene->connect();
+		}
+		catch (const std::exception& e)
+		{
+			// A region of another layout will not change by retrying.
+			std::cerr << "Could not connect to the shared scene: " << e.what() << std::endl;
+			failed.store(true, std::memory_order_relaxed);
+			return false;
+		}
+	});
+}
+
+void CoppeliasimHandler::setupPollingSchedule()
+{
+	const std::vector<PollingTarget>& targets = parameters.pollingSchedule.targets;
+	const auto targetOf = [&](const std::string& name) {
+		const auto target = std::find_if(targets.begin(), targets.end(),
+			[&](const PollingTarget& candidate) { return candidate.name == name; });
+		return target == targets.end() ? PollingTarget(name) : *target;
+	};
+	for (const auto& [name, flag] : incomingSignalFlags)
+		flagTargets.push_back(pollingSchedule.add(targetOf(name)));
+	handTarget = pollingSchedule.add(targetOf(HumanHand::POLLING_TARGET));
+
+	for (const PollingTarget& target : targets)
+		if (!pollingSchedule.find(target.name))
+			throw std::runtime_error("Polling target " + target.name + " is not an incoming signal or the hand pose.");
+	for (const PollingBoost& boost : parameters.pollingSchedule.boosts)
+		pollingSchedule.addBoost(boost);
+}
+
+std::vector<std::size_t> CoppeliasimHandler::getDueFlags(std::chrono::steady_clock::time_point time) const
+{
+	std::lock_guard lock(pollingScheduleMutex);
+	return pollingSchedule.getDue(flagTargets, time);
+}
+
+std::chrono::steady_clock::time_point CoppeliasimHandler::getNextFlagReadTime(std::chrono::steady_clock::time_point time) const
+{
+	std::lock_guard lock(pollingScheduleMutex);
+	return pollingSchedule.getNextDueTime(flagTargets, time);
+}
+
+void CoppeliasimHandler::onFlagsRead(const IncomingSignals& signals, const std::vector<std::size_t>& flags,
+	std::chrono::steady_clock::time_point time)
+{
+	polledSignals = signals;
+	std::lock_guard lock(pollingScheduleMutex);
+	for (const std::size_t flag : flags)
+		pollingSchedule.onRead(flagTargets[flag], signals.*incomingSignalFlags[flag].flag, time);
+}
+
+std::chrono::steady_clock::duration CoppeliasimHandler::getHandReadPeriod(std::chrono::steady_clock::time_point time) const
+{
+	std::lock_guard lock(pollingScheduleMutex);
+	return pollingSchedule.getPeriod(handTarget, time);
+}
+
+void CoppeliasimHandler::onHandRead(std::chrono::steady_clock::time_point time)
+{
+	std::lock_guard lock(pollingScheduleMutex);
+	pollingSchedule.onRead(handTarget, 0, time);
 }
 
-void CoppeliasimHandler::writeSignals() const
+OutgoingSignalsStatistics CoppeliasimHandler::getOutgoingSignalsStatistics() const
 {
-	outgoingSignalsClient.setIntegerSignal(OutgoingSignals::START_SIM, outgoingSignals.startSim);
-	outgoingSignalsClient.setIntegerSignal(OutgoingSignals::TARGET_OBJECT, outgoingSignals.targetObject);
+	return { writesSent.load(std::memory_order_relaxed), writesSuppressed.load(std::memory_order_relaxed) };
 }
 
 void CoppeliasimHandler::resetSignals() const
 {
-	incomingSignalsClient.setIntegerSignal(OutgoingSignals::START_SIM, 0);
-	incomingSignalsClient.setIntegerSignal(OutgoingSignals::TARGET_OBJECT, 0);
-
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::SIM_STARTED, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::OBJECT1_EXISTS, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::OBJECT2_EXISTS, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::OBJECT3_EXISTS, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_APPROACH, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_GRASP, 0);
-
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ1, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ2, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ3, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ1, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ2, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ3, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ1, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ2, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ3, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ1, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ2, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ3, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::CAN_RESTART, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::RESTART, 0);
+	for (const auto& [name, value] : getResetWrites())
+		incomingSignalsClient->setIntegerSignal(name, value);
 }
 
 void CoppeliasimHandler::printSignals() const
@@ -1,15 +1,62 @@
 
 #include "dnf_architecture.h"
 
+#include <stdexcept>
 
+#include "engine_convolution_kernels.h"
+#include "seeded_normal_noise.h"
+#include "workspace_stimulus.h"
 
-std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureHandMotion(const std::string& id, const double& deltaT)
+namespace
+{
+	template<typename ElementType>
+	ElementType* getHandle(const std::shared_ptr<dnf_composer::element::Element>& element)
+	{
+		const auto handle = dynamic_cast<ElementType*>(element.get());
+		if (!handle)
+			throw std::runtime_error("Element '" + element->getUniqueName() + "' does not have the expected type.");
+		return handle;
+	}
+
+	std::shared_ptr<dnf_composer::element::Element> createNormalNoise(dnf_composer::element::ElementFactory& factory,
+		const std::string& name, const dnf_composer::element::ElementSpatialDimensionParameters& dimensionParameters,
+		const dnf_composer::element::NormalNoiseParameters& parameters, const DnfArchitectureOptions& options)
+	{
+		if (!options.noiseSeed)
+			return factory.createElement(dnf_composer::element::NORMAL_NOISE, { name, dimensionParameters }, parameters);
+		return std::make_shared<SeededNormalNoise>(dnf_composer::element::ElementCommonParameters{ name, dimensionParameters },
+			parameters, SeededNormalNoise::deriveSeed(*options.noiseSeed, name));
+	}
+
+	std::shared_ptr<dnf_composer::element::Element> createGaussKernel(dnf_composer::element::ElementFactory& factory,
+		const std::string& name, const dnf_composer::element::ElementSpatialDimensionParameters& dimensionParameters,
+		const dnf_composer::element::GaussKernelParameters& parameters, const DnfArchitectureOptions& options)
+	{
+		if (!options.convolution)
+			return factory.createElement(dnf_composer::element::GAUSS_KERNEL, { name, dimensionParameters }, parameters);
+		return std::make_shared<EngineGaussKernel>(dnf_composer::element::ElementCommonParameters{ name, dimensionParameters },
+			parameters, *options.convolution);
+	}
+
+	std::shared_ptr<dnf_composer::element::Element> createLateralInteractions(dnf_composer::element::ElementFactory& factory,
+		const std::string& name, const dnf_composer::element::ElementSpatialDimensionParameters& dimensionParameters,
+		const dnf_composer::element::LateralInteractionsParameters& parameters, const DnfArchitectureOptions& options)
+	{
+		if (!options.convolution)
+			return factory.createElement(dnf_composer::element::LATERAL_INTERACTIONS, { name, dimensionParameters }, parameters);
+		return std::make_shared<EngineLateralInteractions>(dnf_composer::element::ElementCommonParameters{ name, dimensionParameters },
+			parameters, *options.convolution);
+	}
+}
+
+DnfArchitecture getDynamicNeuralFieldArchitectureHandMotion(const std::string& id, const double& deltaT, const DnfArchitectureOptions& options)
 {
 	using namespace dnf_composer;
 	auto simulation = std::make_shared<Simulation>(id, deltaT, 0, 0);
+	DnfArchitectureHandles handles;
 
 	element::ElementFactory factory;
-	element::ElementSpatialDimensionParameters dim_params{ 50, 0.5 };
+	element::ElementSpatialDimensionParameters dim_params{ options.workspace.getMaxSpatialDimension(), options.workspace.getSpatialStep() };
 	constexpr bool circularity = false;
 	constexpr bool normalization = false;
 	constexpr double tau = 100;
@@ -24,6 +71,7 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureHandM
 	element::GaussStimulusParameters hand_position_gsp = { stimulus_sigma + 1, 0, 0, circularity, normalization };
 	const auto hand_position_stimulus = factory.createElement(element::GAUSS_STIMULUS, { "hand position stimulus", dim_params }, { hand_position_gsp });
 	simulation->addElement(hand_position_stimulus);
+	handles.handPositionStimulus = getHandle<element::GaussStimulus>(hand_position_stimulus);
 
 	const element::SigmoidFunction aol_af = { x_shift, steepness };
 	element::NeuralFieldParameters aol_params = { tau, resting_level, aol_af };
@@ -31,11 +79,11 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureHandM
 	simulation->addElement(aol);
 
 	element::GaussKernelParameters aol_aol_k_params = { 1, 1.5, circularity, normalization };
-	const auto aol_aol_k = factory.createElement(element::GAUSS_KERNEL, { "aol -> aol", dim_params }, { aol_aol_k_params });
+	const auto aol_aol_k = createGaussKernel(factory, "aol -> aol", dim_params, aol_aol_k_params, options);
 	simulation->addElement(aol_aol_k);
 
 	const element::NormalNoiseParameters aol_nn_params = { noise_amplitude };
-	const auto aol_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise aol", dim_params }, aol_nn_params);
+	const auto aol_nn = createNormalNoise(factory, "normal noise aol", dim_params, aol_nn_params, options);
 	simulation->addElement(aol_nn);
 
 	simulation->createInteraction("aol", "output", "aol -> aol");
@@ -50,15 +98,15 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureHandM
 	simulation->addElement(asl);
 
 	element::LateralInteractionsParameters asl_asl_k_params = { 1, 2, 0.5, 1.5, -0.1, circularity, normalization };
-	const auto asl_asl_k = factory.createElement(element::LATERAL_INTERACTIONS, { "asl -> asl", dim_params }, { asl_asl_k_params });
+	const auto asl_asl_k = createLateralInteractions(factory, "asl -> asl", dim_params, asl_asl_k_params, options);
 	simulation->addElement(asl_asl_k);
 
 	element::GaussKernelParameters aol_asl_k_params = { 2.4, 0.755, circularity, normalization };
-	const auto aol_asl_k = factory.createElement(element::GAUSS_KERNEL, { "aol -> asl", dim_params }, { aol_asl_k_params });
+	const auto aol_asl_k = createGaussKernel(factory, "aol -> asl", dim_params, aol_asl_k_params, options);
 	simulation->addElement(aol_asl_k);
 
 	const element::NormalNoiseParameters asl_nn_params = { noise_amplitude };
-	const auto asl_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise asl", dim_params }, asl_nn_params);
+	const auto asl_nn = createNormalNoise(factory, "normal noise asl", dim_params, asl_nn_params, options);
 	simulation->addElement(asl_nn);
 
 	simulation->createInteraction("asl", "output", "asl -> asl");
@@ -69,17 +117,12 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureHandM
 	simulation->createInteraction("aol -> asl", "output", "asl");
 
 	// Object memory layer
-	element::GaussStimulusParameters orl_gsp = { stimulus_sigma, stimulus_amplitude, 12.5, circularity, normalization };
-	const auto orl_stimulus_1 = factory.createElement(element::GAUSS_STIMULUS, { "object stimulus 3", dim_params }, { orl_gsp });
-	simulation->addElement(orl_stimulus_1);
-
-	orl_gsp = { stimulus_sigma, stimulus_amplitude, 25, circularity, normalization };
-	const auto orl_stimulus_2 = factory.createElement(element::GAUSS_STIMULUS, { "object stimulus 2", dim_params }, { orl_gsp });
-	simulation->addElement(orl_stimulus_2);
-
-	orl_gsp = { stimulus_sigma, stimulus_amplitude, 37.5, circularity, normalization };
-	const auto orl_stimulus_3 = factory.createElement(element::GAUSS_STIMULUS, { "object stimulus 1", dim_params }, { orl_gsp });
-	simulation->addElement(orl_stimulus_3);
+	// One Gaussian per workspace object, summed into a single stimulus.
+	const element::GaussStimulusParameters orl_gsp = { stimulus_sigma, 0, 0, circularity, normalization };
+	const auto orl_stimuli = std::make_shared<WorkspaceStimulus>(element::ElementCommonParameters{ "object stimuli", dim_params },
+		orl_gsp, options.workspace, stimulus_amplitude);
+	simulation->addElement(orl_stimuli);
+	handles.objectStimuli = orl_stimuli.get();
 
 	element::SigmoidFunction orl_af = { x_shift, steepness };
 	element::NeuralFieldParameters orl_params = { tau, resting_level, orl_af };
@@ -87,15 +130,15 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureHandM
 	simulation->addElement(orl);
 
 	element::GaussKernelParameters orl_orl_k_params = { 1, 2, circularity, normalization };
-	const auto orl_orl_k = factory.createElement(element::GAUSS_KERNEL, { "orl -> orl", dim_params }, { orl_orl_k_params });
+	const auto orl_orl_k = createGaussKernel(factory, "orl -> orl", dim_params, orl_orl_k_params, options);
 	simulation->addElement(orl_orl_k);
 
 	element::GaussKernelParameters orl_asl_k_params = { 1.9, 0.7, circularity, normalization };
-	const auto orl_asl_k = factory.createElement(element::GAUSS_KERNEL, { "orl -> asl", dim_params }, { orl_asl_k_params });
+	const auto orl_asl_k = createGaussKernel(factory, "orl -> asl", dim_params, orl_asl_k_params, options);
 	simulation->addElement(orl_asl_k);
 
 	element::NormalNoiseParameters orl_nn_params = { noise_amplitude };
-	const auto orl_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise orl", dim_params }, orl_nn_params);
+	const auto orl_nn = createNormalNoise(factory, "normal noise orl", dim_params, orl_nn_params, options);
 	simulation->addElement(orl_nn);
 
 	simulation->createInteraction("orl", "output", "orl -> asl");
@@ -103,31 +146,31 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureHandM
 	simulation->createInteraction("orl", "output", "orl -> orl");
 	simulation->createInteraction("orl -> orl", "output", "orl");
 	simulation->createInteraction("normal noise orl", "output", "orl");
-	simulation->createInteraction("object stimulus 1", "output", "orl");
-	simulation->createInteraction("object stimulus 2", "output", "orl");
-	simulation->createInteraction("object stimulus 3", "output", "orl");
+	simulation->createInteraction("object stimuli", "output", "orl");
 
 	// Action execution layer
 	element::SigmoidFunction ael_af = { x_shift, steepness };
 	element::NeuralFieldParameters ael_params = { tau, resting_level, ael_af };
 	const auto ael = factory.createElement(element::NEURAL_FIELD, { "ael", dim_params }, { ael_params });
 	simulation->addElement(ael);
+	handles.ael = getHandle<element::NeuralField>(ael);
 
 	element::GaussKernelParameters asl_ael_k_params = { 1, -1.5, circularity, normalization };
-	const auto asl_ael_k = factory.createElement(element::GAUSS_KERNEL, { "asl -> ael", dim_params }, { asl_ael_k_params });
+	const auto asl_ael_k = createGaussKernel(factory, "asl -> ael", dim_params, asl_ael_k_params, options);
 	simulation->addElement(asl_ael_k);
 
 	// deltaT = 10 Aexc=8.37, Ainh=5.677, Sinh=3.375, Sexc=4.75, Sself=-2.5
-	element::LateralInteractionsParameters ael_ael_k_params = { 4.75, 8.143, 3.375, 5.677, -2.5, circularity, normalization };
-	const auto ael_ael_k = factory.createElement(element::LATERAL_INTERACTIONS, { "ael -> ael", dim_params }, { ael_ael_k_params });
+	const element::LateralInteractionsParameters ael_ael_k_params = options.aelLateralInteractions.value_or(
+		element::LateralInteractionsParameters{ 4.75, 8.143, 3.375, 5.677, -2.5, circularity, normalization });
+	const auto ael_ael_k = createLateralInteractions(factory, "ael -> ael", dim_params, ael_ael_k_params, options);
 	simulation->addElement(ael_ael_k);
 
 	element::GaussKernelParameters orl_ael_k_params = { 2, 1.5, circularity, normalization };
-	const auto orl_ael_k = factory.createElement(element::GAUSS_KERNEL, { "orl -> ael", dim_params }, { orl_ael_k_params });
+	const auto orl_ael_k = createGaussKernel(factory, "orl -> ael", dim_params, orl_ael_k_params, options);
 	simulation->addElement(orl_ael_k);
 
 	element::NormalNoiseParameters ael_nn_params = { noise_amplitude };
-	const auto ael_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise ael", dim_params }, ael_nn_params);
+	const auto ael_nn = createNormalNoise(factory, "normal noise ael", dim_params, ael_nn_params, options);
 	simulation->addElement(ael_nn);
 
 	simulation->createInteraction("ael", "output", "ael -> ael");
@@ -138,16 +181,17 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureHandM
 	simulation->createInteraction("orl -> ael", "output", "ael");
 	simulation->createInteraction("orl", "output", "orl -> ael");
 
-	return simulation;
+	return { simulation, handles };
 }
 
-std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureActionLikelihood(const std::string& id, const double& deltaT)
+DnfArchitecture getDynamicNeuralFieldArchitectureActionLikelihood(const std::string& id, const double& deltaT, const DnfArchitectureOptions& options)
 {
 	using namespace dnf_composer;
 	auto simulation = std::make_shared<Simulation>(id, deltaT, 0, 0);
+	DnfArchitectureHandles handles;
 
 	element::ElementFactory factory;
-	element::ElementSpatialDimensionParameters dim_params{ 50, 0.5 };
+	element::ElementSpatialDimensionParameters dim_params{ options.workspace.getMaxSpatialDimension(), options.workspace.getSpatialStep() };
 	constexpr bool circularity = false;
 	constexpr bool normalization = false;
 	constexpr double tau = 100;
@@ -159,17 +203,12 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureActio
 	constexpr double noise_amplitude = 0.001;
 
 	// Action observation layer
-	element::GaussStimulusParameters hand_position_gsp = { stimulus_sigma, 0, 12.5, circularity, normalization };
-	const auto hand_position_stimulus_3 = factory.createElement(element::GAUSS_STIMULUS, { "hand position stimulus 3", dim_params }, { hand_position_gsp });
-	simulation->addElement(hand_position_stimulus_3);
-
-	hand_position_gsp = { stimulus_sigma, 0, 25, circularity, normalization };
-	const auto hand_position_stimulus_2 = factory.createElement(element::GAUSS_STIMULUS, { "hand position stimulus 2", dim_params }, { hand_position_gsp });
-	simulation->addElement(hand_position_stimulus_2);
-
-	hand_position_gsp = { stimulus_sigma, 0, 37.5, circularity, normalization };
-	const auto hand_position_stimulus_1 = factory.createElement(element::GAUSS_STIMULUS, { "hand position stimulus 1", dim_params }, { hand_position_gsp });
-	simulation->addElement(hand_position_stimulus_1);
+	// One Gaussian per workspace object, weighted by the likelihood that the hand is reaching for it.
+	const element::GaussStimulusParameters hand_position_gsp = { stimulus_sigma, 0, 0, circularity, normalization };
+	const auto hand_position_stimuli = std::make_shared<WorkspaceStimulus>(element::ElementCommonParameters{ "hand position stimuli", dim_params },
+		hand_position_gsp, options.workspace, 0);
+	simulation->addElement(hand_position_stimuli);
+	handles.handLikelihoodStimuli = hand_position_stimuli.get();
 
 	const element::SigmoidFunction aol_af = { x_shift, steepness };
 	element::NeuralFieldParameters aol_params = { tau, resting_level, aol_af };
@@ -177,19 +216,17 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureActio
 	simulation->addElement(aol);
 
 	element::GaussKernelParameters aol_aol_k_params = { 1, 1.5, circularity, normalization };
-	const auto aol_aol_k = factory.createElement(element::GAUSS_KERNEL, { "aol -> aol", dim_params }, { aol_aol_k_params });
+	const auto aol_aol_k = createGaussKernel(factory, "aol -> aol", dim_params, aol_aol_k_params, options);
 	simulation->addElement(aol_aol_k);
 
 	const element::NormalNoiseParameters aol_nn_params = { noise_amplitude };
-	const auto aol_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise aol", dim_params }, aol_nn_params);
+	const auto aol_nn = createNormalNoise(factory, "normal noise aol", dim_params, aol_nn_params, options);
 	simulation->addElement(aol_nn);
 
 	simulation->createInteraction("aol", "output", "aol -> aol");
 	simulation->createInteraction("aol -> aol", "output", "aol");
 	simulation->createInteraction("normal noise aol", "output", "aol");
-	simulation->createInteraction("hand position stimulus 3", "output", "aol");
-	simulation->createInteraction("hand position stimulus 2", "output", "aol");
-	simulation->createInteraction("hand position stimulus 1", "output", "aol");
+	simulation->createInteraction("hand position stimuli", "output", "aol");
 
 	// Action simulation layer
 	const element::SigmoidFunction asl_af = { x_shift, steepness };
@@ -198,15 +235,15 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureActio
 	simulation->addElement(asl);
 
 	element::LateralInteractionsParameters asl_asl_k_params = { 3.3, 5.626, 3.375, 5.03, -0.515, circularity, normalization };
-	const auto asl_asl_k = factory.createElement(element::LATERAL_INTERACTIONS, { "asl -> asl", dim_params }, { asl_asl_k_params });
+	const auto asl_asl_k = createLateralInteractions(factory, "asl -> asl", dim_params, asl_asl_k_params, options);
 	simulation->addElement(asl_asl_k);
 
 	element::GaussKernelParameters aol_asl_k_params = { 2.4, 0.755, circularity, normalization };
-	const auto aol_asl_k = factory.createElement(element::GAUSS_KERNEL, { "aol -> asl", dim_params }, { aol_asl_k_params });
+	const auto aol_asl_k = createGaussKernel(factory, "aol -> asl", dim_params, aol_asl_k_params, options);
 	simulation->addElement(aol_asl_k);
 
 	const element::NormalNoiseParameters asl_nn_params = { noise_amplitude };
-	const auto asl_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise asl", dim_params }, asl_nn_params);
+	const auto asl_nn = createNormalNoise(factory, "normal noise asl", dim_params, asl_nn_params, options);
 	simulation->addElement(asl_nn);
 
 	simulation->createInteraction("asl", "output", "asl -> asl");
@@ -217,17 +254,12 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureActio
 	simulation->createInteraction("aol -> asl", "output", "asl");
 
 	// Object memory layer
-	element::GaussStimulusParameters orl_gsp = { stimulus_sigma, stimulus_amplitude, 12.5, circularity, normalization };
-	const auto orl_stimulus_1 = factory.createElement(element::GAUSS_STIMULUS, { "object stimulus 3", dim_params }, { orl_gsp });
-	simulation->addElement(orl_stimulus_1);
-
-	orl_gsp = { stimulus_sigma, stimulus_amplitude, 25, circularity, normalization };
-	const auto orl_stimulus_2 = factory.createElement(element::GAUSS_STIMULUS, { "object stimulus 2", dim_params }, { orl_gsp });
-	simulation->addElement(orl_stimulus_2);
-
-	orl_gsp = { stimulus_sigma, stimulus_amplitude, 37.5, circularity, normalization };
-	const auto orl_stimulus_3 = factory.createElement(element::GAUSS_STIMULUS, { "object stimulus 1", dim_params }, { orl_gsp });
-	simulation->addElement(orl_stimulus_3);
+	// One Gaussian per workspace object, summed into a single stimulus.
+	const element::GaussStimulusParameters orl_gsp = { stimulus_sigma, 0, 0, circularity, normalization };
+	const auto orl_stimuli = std::make_shared<WorkspaceStimulus>(element::ElementCommonParameters{ "object stimuli", dim_params },
+		orl_gsp, options.workspace, stimulus_amplitude);
+	simulation->addElement(orl_stimuli);
+	handles.objectStimuli = orl_stimuli.get();
 
 	element::SigmoidFunction orl_af = { x_shift, steepness };
 	element::NeuralFieldParameters orl_params = { tau, resting_level, orl_af };
@@ -235,15 +267,15 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureActio
 	simulation->addElement(orl);
 
 	element::GaussKernelParameters orl_orl_k_params = { 1, 2, circularity, normalization };
-	const auto orl_orl_k = factory.createElement(element::GAUSS_KERNEL, { "orl -> orl", dim_params }, { orl_orl_k_params });
+	const auto orl_orl_k = createGaussKernel(factory, "orl -> orl", dim_params, orl_orl_k_params, options);
 	simulation->addElement(orl_orl_k);
 
 	element::GaussKernelParameters orl_asl_k_params = { 1.9, 0.7, circularity, normalization };
-	const auto orl_asl_k = factory.createElement(element::GAUSS_KERNEL, { "orl -> asl", dim_params }, { orl_asl_k_params });
+	const auto orl_asl_k = createGaussKernel(factory, "orl -> asl", dim_params, orl_asl_k_params, options);
 	simulation->addElement(orl_asl_k);
 
 	element::NormalNoiseParameters orl_nn_params = { noise_amplitude };
-	const auto orl_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise orl", dim_params }, orl_nn_params);
+	const auto orl_nn = createNormalNoise(factory, "normal noise orl", dim_params, orl_nn_params, options);
 	simulation->addElement(orl_nn);
 
 	simulation->createInteraction("orl", "output", "orl -> asl");
@@ -251,30 +283,30 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureActio
 	simulation->createInteraction("orl", "output", "orl -> orl");
 	simulation->createInteraction("orl -> orl", "output", "orl");
 	simulation->createInteraction("normal noise orl", "output", "orl");
-	simulation->createInteraction("object stimulus 1", "output", "orl");
-	simulation->createInteraction("object stimulus 2", "output", "orl");
-	simulation->createInteraction("object stimulus 3", "output", "orl");
+	simulation->createInteraction("object stimuli", "output", "orl");
 
 	// Action execution layer
 	element::SigmoidFunction ael_af = { x_shift, steepness };
 	element::NeuralFieldParameters ael_params = { tau+20, resting_level, ael_af };
 	const auto ael = factory.createElement(element::NEURAL_FIELD, { "ael", dim_params }, { ael_params });
 	simulation->addElement(ael);
+	handles.ael = getHandle<element::NeuralField>(ael);
 
 	element::GaussKernelParameters asl_ael_k_params = { 1, -1.5, circularity, normalization };
-	const auto asl_ael_k = factory.createElement(element::GAUSS_KERNEL, { "asl -> ael", dim_params }, { asl_ael_k_params });
+	const auto asl_ael_k = createGaussKernel(factory, "asl -> ael", dim_params, asl_ael_k_params, options);
 	simulation->addElement(asl_ael_k);
 
-	element::LateralInteractionsParameters ael_ael_k_params = { 4.75, 8.37, 3.375, 5.677, -2.5, circularity, normalization };
-	const auto ael_ael_k = factory.createElement(element::LATERAL_INTERACTIONS, { "ael -> ael", dim_params }, { ael_ael_k_params });
+	const element::LateralInteractionsParameters ael_ael_k_params = options.aelLateralInteractions.value_or(
+		element::LateralInteractionsParameters{ 4.75, 8.37, 3.375, 5.677, -2.5, circularity, normalization });
+	const auto ael_ael_k = createLateralInteractions(factory, "ael -> ael", dim_params, ael_ael_k_params, options);
 	simulation->addElement(ael_ael_k);
 
 	element::GaussKernelParameters orl_ael_k_params = { 2, 1.5, circularity, normalization };
-	const auto orl_ael_k = factory.createElement(element::GAUSS_KERNEL, { "orl -> ael", dim_params }, { orl_ael_k_params });
+	const auto orl_ael_k = createGaussKernel(factory, "orl -> ael", dim_params, orl_ael_k_params, options);
 	simulation->addElement(orl_ael_k);
 
 	element::NormalNoiseParameters ael_nn_params = { noise_amplitude };
-	const auto ael_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise ael", dim_params }, ael_nn_params);
+	const auto ael_nn = createNormalNoise(factory, "normal noise ael", dim_params, ael_nn_params, options);
 	simulation->addElement(ael_nn);
 
 	simulation->createInteraction("ael", "output", "ael -> ael");
@@ -285,5 +317,5 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureActio
 	simulation->createInteraction("orl -> ael", "output", "ael");
 	simulation->createInteraction("orl", "output", "orl -> ael");
 
-	return simulation;
+	return { simulation, handles };
 }
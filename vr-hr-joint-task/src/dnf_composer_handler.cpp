@@ -1,19 +1,46 @@
 #include "dnf_composer_handler.h"
 
-DnfComposerHandler::DnfComposerHandler(DnfArchitectureType dnf, double deltaT)
-	: dnf(dnf)
+DnfComposerHandler::DnfComposerHandler(DnfArchitectureType dnf, double deltaT, const DnfComposerHandlerParameters& parameters)
+	: dnf(dnf),
+	deltaT(deltaT),
+	appliedHandPosition(0),
+	appliedHandLikelihoods(0),
+	appliedAvailableObjects(0),
+	architectureOptions(parameters.architectureOptions),
+	runner(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double, std::milli>(deltaT)),
+		parameters.steppingMode, parameters.maxCatchUpSteps),
+	targetDecision(architectureOptions.workspace),
+	stepNotifier(nullptr)
 {
+	handLikelihoods.resize(architectureOptions.workspace.getNumberOfObjects());
+	for (const WorkspaceObject& object : architectureOptions.workspace.getObjects())
+		objectPositions.push_back(object.position);
+	if (parameters.backend == DnfBackend::FUSED)
+	{
+		if (parameters.userInterface)
+			throw std::runtime_error("The fused backend has no plot windows, run it headless.");
+		fused = std::make_unique<FusedDnfArchitecture<>>(dnf, deltaT, architectureOptions);
+		return;
+	}
+
+	DnfArchitecture architecture;
 	switch (dnf)
 	{
 	case DnfArchitectureType::HAND_MOTION:
-		simulation = getDynamicNeuralFieldArchitectureHandMotion("dnf arch", deltaT);
+		architecture = getDynamicNeuralFieldArchitectureHandMotion("dnf arch", deltaT, architectureOptions);
 		break;
 	case DnfArchitectureType::ACTION_LIKELIHOOD:
-		simulation = getDynamicNeuralFieldArchitectureActionLikelihood("dnf arch", deltaT);
+		architecture = getDynamicNeuralFieldArchitectureActionLikelihood("dnf arch", deltaT, architectureOptions);
 		break;
 	}
-	application = std::make_shared<dnf_composer::Application>(simulation);
-	setupUserInterface();
+	simulation = architecture.simulation;
+	handles = architecture.handles;
+	handPositionStimulus = GaussStimulusUpdater(handles.handPositionStimulus);
+	if (parameters.userInterface)
+	{
+		application = std::make_shared<dnf_composer::Application>(simulation);
+		setupUserInterface();
+	}
 }
 
 DnfComposerHandler::~DnfComposerHandler()
@@ -23,153 +50,194 @@ DnfComposerHandler::~DnfComposerHandler()
 
 void DnfComposerHandler::init()
 {
-	simulationThread = std::thread(&DnfComposerHandler::run, this);
+	simulationThread = std::jthread([this](const std::stop_token& stopToken) { run(stopToken); });
 }
 
-void DnfComposerHandler::run() const
+void DnfComposerHandler::setChangeNotifier(ChangeNotifier* notifier)
 {
-	application->init();
-	bool userRequestedExit = false;
-	while (!userRequestedExit)
+	stepNotifier = notifier;
+}
+
+void DnfComposerHandler::run(const std::stop_token& stopToken)
+{
+	if (isHeadless())
 	{
-		application->step();
-		userRequestedExit = application->getCloseUI();
+		initSimulation();
+		runner.run(stopToken, [this] {
+			stepSimulation();
+			return true;
+		});
+		closeSimulation();
+		return;
 	}
+
+	// The application steps the simulation and renders the plot windows.
+	application->init();
+	resetTargetDecision();
+	runner.run(stopToken, [this] {
+		applyStimulusInputs();
+		{
+			METRICS_SCOPED_TIMER("dnf step");
+			application->step();
+		}
+		updateTargetDecision();
+		if (stepNotifier)
+			stepNotifier->notify();
+		return !application->getCloseUI();
+	});
 	application->close();
 }
 
 void DnfComposerHandler::end()
 {
+	if (!simulationThread.joinable())
+		return;
+	if (isHeadless())
+		simulationThread.request_stop();
 	simulationThread.join();
 }
 
-void DnfComposerHandler::setHandStimulus(const Position& position, bool object1, bool object2, bool object3) const
+void DnfComposerHandler::initSimulation()
+{
+	if (fused)
+		fused->init();
+	else
+		simulation->init();
+	resetTargetDecision();
+}
+
+void DnfComposerHandler::stepSimulation()
+{
+	applyStimulusInputs();
+	{
+		METRICS_SCOPED_TIMER("dnf step");
+		if (fused)
+			fused->step();
+		else
+			simulation->step();
+	}
+	updateTargetDecision();
+	if (stepNotifier)
+		stepNotifier->notify();
+}
+
+void DnfComposerHandler::closeSimulation()
+{
+	if (simulation)
+		simulation->close();
+}
+
+void DnfComposerHandler::setHandStimulus(const HandKinematics& hand, const ObjectSet& availableObjects) const
 {
 	switch (dnf)
 	{
 	case DnfArchitectureType::HAND_MOTION:
-		setHandStimulusDependingOnHumanHandPosition(position);
+		setHandStimulusDependingOnHumanHandPosition(hand.position);
 		break;
 	case DnfArchitectureType::ACTION_LIKELIHOOD:
-		setHandStimulusDependingOnHumanActionLikelihood(position, object1, object2, object3);
+		setHandStimulusDependingOnHumanActionLikelihood(hand, availableObjects);
 		break;
 	}
 }
 
 int DnfComposerHandler::getTargetObject() const
 {
-	const auto ael = std::dynamic_pointer_cast<dnf_composer::element::NeuralField>(simulation->getElement("ael"));
-	const double centroid = ael->getCentroid();
-	if (centroid < 0)
-		return 0;
-
-	const int size = ael->getMaxSpatialDimension();
-
-	// Function to calculate the circular distance between two points
-	auto circularDistance = [size](double point1, double point2) -> double {
-		const double directDistance = std::abs(point1 - point2);
-		const double circularDistance = size - directDistance;
-		return std::min(directDistance, circularDistance);
-		};
-
-	// Calculate distances to the three points
-	double distanceToObject1 = circularDistance(centroid, 37.5);
-	double distanceToObject2 = circularDistance(centroid, 25);
-	double distanceToObject3 = circularDistance(centroid, 12.5);
-
-	// Determine the closest target and return the corresponding value
-	const double minDistance = std::min({ distanceToObject1, distanceToObject2, distanceToObject3 });
-
-	if (minDistance == distanceToObject1)
-		return 1;
-	if (minDistance == distanceToObject2)
-		return 2;
-	if (minDistance == distanceToObject3)
-		return 3;
-	return 0;
+	return targetDecision.read().value.targetObject;
 }
 
-void DnfComposerHandler::setAvailableObjectsInTheWorkspace(bool object1, bool object2, bool object3) const
+Snapshot<TargetDecision> DnfComposerHandler::getTargetDecision() const
 {
-	auto orl_stimulus = std::dynamic_pointer_cast<dnf_composer::element::GaussStimulus>(simulation->getElement("object stimulus 1"));
-	auto orl_stimulus_parameters = orl_stimulus->getParameters();
-	double amplitude = object1 ? 1 : 0;
-	dnf_composer::element::GaussStimulusParameters new_params = { orl_stimulus_parameters.sigma, 5*amplitude, orl_stimulus_parameters.position, false, false };
-	orl_stimulus->setParameters(new_params);
-
-	orl_stimulus = std::dynamic_pointer_cast<dnf_composer::element::GaussStimulus>(simulation->getElement("object stimulus 2"));
-	orl_stimulus_parameters = orl_stimulus->getParameters();
-	amplitude = object2 ? 1 : 0;
-	new_params = { orl_stimulus_parameters.sigma, 5*amplitude, orl_stimulus_parameters.position, false, false };
-	orl_stimulus->setParameters(new_params);
-
-	orl_stimulus = std::dynamic_pointer_cast<dnf_composer::element::GaussStimulus>(simulation->getElement("object stimulus 3"));
-	orl_stimulus_parameters = orl_stimulus->getParameters();
-	amplitude = object3 ? 1 : 0;
-	new_params = { orl_stimulus_parameters.sigma, 5*amplitude, orl_stimulus_parameters.position, false, false };
-	orl_stimulus->setParameters(new_params);
+	return targetDecision.read();
 }
 
-void DnfComposerHandler::setHandStimulusDependingOnHumanActionLikelihood(const Position& position, bool object1, bool object2, bool object3) const
+void DnfComposerHandler::applyStimulusInputs()
 {
-	static Position handPrevious = position;
-	static const Position objPosition1 = { 0.000,  0.125, 0.716 };
-	static const Position objPosition2 = { 0.000,  0.000, 0.716 };
-	static const Position objPosition3 = { 0.000, -0.125, 0.716 };
-	static constexpr double tau = 0.1;
-	static constexpr double sigma = 0.05;
-	static constexpr double scalar = 5;
-
-	using Clock = std::chrono::high_resolution_clock;
-	auto lastTime = Clock::now();
-
-	const auto currentTime = Clock::now();
-	const std::chrono::duration<double> elapsed = currentTime - lastTime;
-	const double deltaTime = elapsed.count();
+	// Only the inputs published since the last step, each element is left alone until its input is first set.
+	if (handPositionInput.getSequence() != appliedHandPosition)
+	{
+		const Snapshot<HandPositionInput> input = handPositionInput.read();
+		if (fused)
+			fused->setHandPositionStimulus(input.value.amplitude, input.value.position);
+		else
+			handPositionStimulus.setAmplitudeAndPosition(input.value.amplitude, input.value.position);
+		appliedHandPosition = input.sequence;
+	}
+	if (handLikelihoodInput.getSequence() != appliedHandLikelihoods)
+	{
+		const Snapshot<HandLikelihoodInput> input = handLikelihoodInput.read();
+		std::copy_n(input.value.begin(), handLikelihoods.size(), handLikelihoods.begin());
+		if (fused)
+			fused->setHandLikelihoodStimulusAmplitudes(handLikelihoods);
+		else
+			handles.handLikelihoodStimuli->setAmplitudes(handLikelihoods);
+		appliedHandLikelihoods = input.sequence;
+	}
+	if (availableObjectsInput.getSequence() != appliedAvailableObjects)
+	{
+		const Snapshot<ObjectSet> input = availableObjectsInput.read();
+		if (fused)
+			fused->setObjectStimulusAmplitudes(input.value, 5);
+		else
+			handles.objectStimuli->setAmplitudes(input.value, 5);
+		appliedAvailableObjects = input.sequence;
+	}
+}
 
-	// Check if elapsed time is too small
-	if (deltaTime < std::numeric_limits<double>::epsilon())
-		return;
+double DnfComposerHandler::getActionExecutionCentroid() const
+{
+	return fused ? fused->getCentroid() : handles.ael->getCentroid();
+}
 
-	double likelihood_1 = calculateLikelihoodOfHumanAction(position, handPrevious, objPosition1, deltaTime, tau, sigma);
-	double likelihood_2 = calculateLikelihoodOfHumanAction(position, handPrevious, objPosition2, deltaTime, tau, sigma);
-	double likelihood_3 = calculateLikelihoodOfHumanAction(position, handPrevious, objPosition3, deltaTime, tau, sigma);
+void DnfComposerHandler::resetTargetDecision()
+{
+	targetDecision.reset(getActionExecutionCentroid());
+}
 
-	if (!object1)
-		likelihood_1 = 0.0;
-	if (!object2)
-		likelihood_2 = 0.0;
-	if (!object3)
-		likelihood_3 = 0.0;
+void DnfComposerHandler::updateTargetDecision()
+{
+	METRICS_SCOPED_TIMER("target decision");
+	targetDecision.update(getActionExecutionCentroid());
+}
 
+std::vector<double> DnfComposerHandler::getActionExecutionActivation() const
+{
+	if (fused)
+	{
+		const auto& activation = fused->getLayer(FusedDnfLayer::AEL).activation;
+		return { activation.begin(), activation.end() };
+	}
+	return *handles.ael->getComponentPtr("activation");
+}
 
-	const auto aol_stimulus_1 = std::dynamic_pointer_cast<dnf_composer::element::GaussStimulus>(simulation->getElement("hand position stimulus 1"));
-	const dnf_composer::element::GaussStimulusParameters new_params{ aol_stimulus_1->getParameters().sigma, scalar * likelihood_1, aol_stimulus_1->getParameters().position, false, false };
-	aol_stimulus_1->setParameters(new_params);
+void DnfComposerHandler::setAvailableObjectsInTheWorkspace(const ObjectSet& availableObjects) const
+{
+	availableObjectsInput.publish(availableObjects);
+}
 
-	const auto aol_stimulus_2 = std::dynamic_pointer_cast<dnf_composer::element::GaussStimulus>(simulation->getElement("hand position stimulus 2"));
-	const dnf_composer::element::GaussStimulusParameters new_params_2{ aol_stimulus_2->getParameters().sigma, scalar * likelihood_2, aol_stimulus_2->getParameters().position, false, false };
-	aol_stimulus_2->setParameters(new_params_2);
+void DnfComposerHandler::setHandStimulusDependingOnHumanActionLikelihood(const HandKinematics& hand, const ObjectSet& availableObjects) const
+{
+	static constexpr double tau = 0.1;
+	static constexpr double sigma = 0.05;
+	static constexpr double scalar = 5;
 
-	const auto aol_stimulus_3 = std::dynamic_pointer_cast<dnf_composer::element::GaussStimulus>(simulation->getElement("hand position stimulus 3"));
-	const dnf_composer::element::GaussStimulusParameters new_params_3{ aol_stimulus_3->getParameters().sigma, scalar * likelihood_3, aol_stimulus_3->getParameters().position, false, false };
-	aol_stimulus_3->setParameters(new_params_3);
+	// No pose sample yet.
+	if (!hand.isValid())
+		return;
 
-	handPrevious = position;
-	lastTime = currentTime;
+	HandLikelihoodInput likelihoods{};
+	calculateLikelihoodsOfHumanAction(hand.position, hand.getSpeed(), objectPositions, tau, sigma, likelihoods.data());
+	for (std::size_t i = 0; i < objectPositions.size(); ++i)
+		likelihoods[i] = availableObjects.test(i) ? scalar * likelihoods[i] : 0.0;
+	handLikelihoodInput.publish(likelihoods);
 }
 
 void DnfComposerHandler::setHandStimulusDependingOnHumanHandPosition(const Position& position) const
 {
-	const auto aol_stimulus =
-		std::dynamic_pointer_cast<dnf_composer::element::GaussStimulus>(simulation->getElement("hand position stimulus"));
-
 	const double proximity = calculateHandProximityToObjects(
 		calculateHandDistanceToObjects(position));
-	const double y = normalizeHandPosition(position.y);
+	const double y = architectureOptions.workspace.getFieldPosition(position.y);
 
-	const dnf_composer::element::GaussStimulusParameters new_params{ aol_stimulus->getParameters().sigma, proximity, y, false, false };
-	aol_stimulus->setParameters(new_params);
+	handPositionInput.publish({ proximity, y });
 }
 
 double DnfComposerHandler::calculateHandDistanceToObjects(const Position& position)
@@ -193,25 +261,11 @@ double DnfComposerHandler::calculateHandProximityToObjects(double distance)
 	return 1.0 / distance;
 }
 
-double DnfComposerHandler::normalizeHandPosition(double handPositionY)
-{
-	// Define the min and max of the table in Y dimension
-	static constexpr double yMin = -0.25;
-	static constexpr double yMax = 0.25;
-	// Define the min and max of the scale
-	static constexpr double scaleMin = 0;
-	static constexpr double scaleMax = 50;
-
-	// Normalize posY to the 0-50 scale
-	const double normalizedScale = scaleMin + (scaleMax - scaleMin) * (handPositionY - yMin) / (yMax - yMin);
-
-	return normalizedScale;
-}
-
 void DnfComposerHandler::setupUserInterface() const
 {
 	using namespace dnf_composer;
-	element::ElementSpatialDimensionParameters dim_params{ 50, 0.5 };
+	element::ElementSpatialDimensionParameters dim_params{ architectureOptions.workspace.getMaxSpatialDimension(),
+		architectureOptions.workspace.getSpatialStep() };
 
 	// Create User Interface windows
 	//application->activateUserInterfaceWindow(user_interface::SIMULATION_WINDOW);
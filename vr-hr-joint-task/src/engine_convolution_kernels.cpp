@@ -0,0 +1,81 @@
+#include "engine_convolution_kernels.h"
+
+#include <numeric>
+
+namespace
+{
+	// Sums the element's inputs and convolves them into its output, plus amplitudeGlobal times the input sum.
+	void convolveInput(dnf_composer::element::Element& element, ConvolutionEngine& engine, double amplitudeGlobal)
+	{
+		element.updateInput();
+		const std::vector<double>& input = *element.getComponentPtr("input");
+		std::vector<double>& output = *element.getComponentPtr("output");
+		engine.convolve(input, output);
+		if (amplitudeGlobal == 0)
+			return;
+		const double global = amplitudeGlobal * std::accumulate(input.begin(), input.end(), 0.0);
+		for (double& value : output)
+			value += global;
+	}
+
+	std::optional<ConvolutionEngine> makeEngine(dnf_composer::element::Element& element, bool circular, ConvolutionMethod method)
+	{
+		if (circular)
+			return std::nullopt;
+		// The library sizes the input of a non-circular kernel to the field.
+		element.getComponentPtr("input")->resize(element.getSize());
+		return ConvolutionEngine(element.getSize(), *element.getComponentPtr("kernel"), method);
+	}
+}
+
+EngineGaussKernel::EngineGaussKernel(const dnf_composer::element::ElementCommonParameters& elementCommonParameters,
+	const dnf_composer::element::GaussKernelParameters& parameters, ConvolutionMethod method)
+	: GaussKernel(elementCommonParameters, parameters), method(method)
+{}
+
+void EngineGaussKernel::init()
+{
+	GaussKernel::init();
+	engine = makeEngine(*this, getParameters().circular, method);
+}
+
+void EngineGaussKernel::step(double t, double deltaT)
+{
+	if (!engine)
+	{
+		GaussKernel::step(t, deltaT);
+		return;
+	}
+	convolveInput(*this, *engine, 0);
+}
+
+std::shared_ptr<dnf_composer::element::Element> EngineGaussKernel::clone() const
+{
+	return std::make_shared<EngineGaussKernel>(*this);
+}
+
+EngineLateralInteractions::EngineLateralInteractions(const dnf_composer::element::ElementCommonParameters& elementCommonParameters,
+	const dnf_composer::element::LateralInteractionsParameters& parameters, ConvolutionMethod method)
+	: LateralInteractions(elementCommonParameters, parameters), method(method)
+{}
+
+void EngineLateralInteractions::init()
+{
+	LateralInteractions::init();
+	engine = makeEngine(*this, getParameters().circular, method);
+}
+
+void EngineLateralInteractions::step(double t, double deltaT)
+{
+	if (!engine)
+	{
+		LateralInteractions::step(t, deltaT);
+		return;
+	}
+	convolveInput(*this, *engine, getParameters().amplitudeGlobal);
+}
+
+std::shared_ptr<dnf_composer::element::Element> EngineLateralInteractions::clone() const
+{
+	return std::make_shared<EngineLateralInteractions>(*this);
+}
@@ -0,0 +1,213 @@
+#include "event_log_writer.h"
+
+#include <algorithm>
+#include <csignal>
+
+namespace
+{
+	constexpr std::chrono::milliseconds CRASH_FLUSH_TIMEOUT{ 500 };
+
+	const char* toString(LogLevel level)
+	{
+		switch (level)
+		{
+		case LogLevel::CONTROL: return "CONTROL";
+		case LogLevel::ROBOT: return "ROBOT";
+		case LogLevel::HUMAN: return "HUMAN";
+		}
+		return "";
+	}
+
+	std::tm toLocalTime(std::time_t time)
+	{
+		std::tm local{};
+#ifdef _WIN32
+		localtime_s(&local, &time);
+#else
+		localtime_r(&time, &local);
+#endif
+		return local;
+	}
+}
+
+EventLogWriter::EventLogWriter(const EventLogWriterParameters& parameters)
+	: parameters(parameters), events(parameters.queueCapacity), cachedSecond(-1),
+	crashFlushRequested(false), crashFlushDone(false), running(false), pendingSignal(0),
+	logged(0), dropped(0), commits(0)
+{
+	static_assert(std::atomic<bool>::is_always_lock_free && std::atomic<int>::is_always_lock_free,
+		"signal handlers may only touch lock-free atomics");
+	batch.reserve(parameters.groupCommitBytes + 256);
+}
+
+EventLogWriter::~EventLogWriter()
+{
+	close();
+}
+
+bool EventLogWriter::open(const std::string& path)
+{
+	file.open(path, std::ofstream::out | std::ofstream::app);
+	if (!file.is_open())
+		return false;
+
+	writerThread = std::jthread([this](const std::stop_token& stopToken) { writeLoop(stopToken); });
+	running.store(true);
+	return true;
+}
+
+bool EventLogWriter::push(LogEvent&& event)
+{
+	if (!events.tryPush(std::move(event)))
+	{
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	logged.fetch_add(1, std::memory_order_relaxed);
+	eventsPushed.notify();
+	return true;
+}
+
+void EventLogWriter::close()
+{
+	running.store(false);
+	if (writerThread.joinable())
+	{
+		writerThread.request_stop();
+		eventsPushed.notify();
+		writerThread.join();
+	}
+	if (file.is_open())
+		file.close();
+}
+
+void EventLogWriter::flushOnCrash()
+{
+	if (!writerThread.joinable())
+		return;
+
+	// The writer thread itself crashed, nobody else may touch the batch.
+	if (std::this_thread::get_id() == writerThread.get_id())
+	{
+		drain();
+		commit();
+		return;
+	}
+
+	crashFlushDone.store(false);
+	crashFlushRequested.store(true);
+	eventsPushed.notify();
+	const auto deadline = std::chrono::steady_clock::now() + CRASH_FLUSH_TIMEOUT;
+	while (!crashFlushDone.load() && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+bool EventLogWriter::requestFlushOnSignal(int signal)
+{
+	if (!running.load())
+		return false;
+	pendingSignal.store(signal);
+	return true;
+}
+
+void EventLogWriter::writeLoop(const std::stop_token& stopToken)
+{
+	while (!stopToken.stop_requested())
+	{
+		// Sleep until the oldest batched event is due, or until something new arrives.
+		// A signal handler cannot wake us, so the wait is also bounded by the signal poll period.
+		std::chrono::steady_clock::duration timeout = parameters.groupCommitPeriod;
+		if (!batch.empty())
+			timeout = std::max(std::chrono::steady_clock::duration::zero(),
+				batchStart + parameters.groupCommitPeriod - std::chrono::steady_clock::now());
+		eventsPushed.waitFor(std::min<std::chrono::steady_clock::duration>(timeout, SIGNAL_POLL_PERIOD));
+
+		drain();
+		if (pendingSignal.load())
+		{
+			commit();
+			raisePendingSignal();
+		}
+		else if (crashFlushRequested.load())
+		{
+			commit();
+			crashFlushRequested.store(false);
+			crashFlushDone.store(true);
+		}
+		else if (!batch.empty() && std::chrono::steady_clock::now() - batchStart >= parameters.groupCommitPeriod)
+			commit();
+	}
+	drain();
+	commit();
+	// A signal that came in while closing is raised once everything is written.
+	raisePendingSignal();
+}
+
+void EventLogWriter::raisePendingSignal()
+{
+	if (const int signal = pendingSignal.exchange(0))
+	{
+		std::signal(signal, SIG_DFL);
+		std::raise(signal);
+	}
+}
+
+void EventLogWriter::drain()
+{
+	LogEvent event;
+	while (events.tryPop(event))
+	{
+		if (batch.empty())
+			batchStart = std::chrono::steady_clock::now();
+		format(event);
+		if (batch.size() >= parameters.groupCommitBytes)
+			commit();
+	}
+}
+
+void EventLogWriter::commit()
+{
+	if (batch.empty())
+		return;
+	file.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+	file.flush();
+	batch.clear();
+	commits.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EventLogWriter::format(const LogEvent& event)
+{
+	batch += getDatePrefix(event.timestamp);
+	batch += ' ';
+	batch += toString(event.level);
+	batch += ' ';
+
+	const std::string object = std::to_string(event.objectId);
+	switch (event.id)
+	{
+	case LogEventId::MESSAGE: batch += event.message; break;
+	case LogEventId::CONNECTED_WITH_COPPELIASIM: batch += "Connected with CoppeliaSim."; break;
+	case LogEventId::SIMULATION_STARTED: batch += "Simulation has started."; break;
+	case LogEventId::ROBOT_GRASPING: batch += "Robot is grasping object " + object + "."; break;
+	case LogEventId::ROBOT_PLACING: batch += "Robot is placing object " + object + "."; break;
+	case LogEventId::ROBOT_TARGETING: batch += "Robot will target object " + object + "."; break;
+	case LogEventId::HUMAN_GRASPING: batch += "Human is grasping object " + object + "."; break;
+	case LogEventId::HUMAN_PLACING: batch += "Human is placing object " + object + "."; break;
+	}
+	batch += '\n';
+}
+
+const std::string& EventLogWriter::getDatePrefix(std::chrono::system_clock::time_point timestamp)
+{
+	// Consecutive events mostly fall in the same second, so the formatted date is reused until it changes.
+	const std::time_t second = std::chrono::system_clock::to_time_t(timestamp);
+	if (second != cachedSecond)
+	{
+		const std::tm local = toLocalTime(second);
+		char buffer[32];
+		const std::size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+		cachedDatePrefix.assign(buffer, length);
+		cachedSecond = second;
+	}
+	return cachedDatePrefix;
+}
@@ -1,9 +1,23 @@
 #include "event_logger.h"
 
-std::ofstream EventLogger::logFile;
-std::ofstream EventLogger::humanHandPoseFile;
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+
+EventLogWriter EventLogger::logWriter;
+PoseTelemetryWriter EventLogger::humanHandPoseStream;
+MetricsReporter EventLogger::metricsReporter;
 std::string EventLogger::sessionDirectory;
 
+namespace
+{
+    std::atomic<bool> crashed{ false };
+    std::terminate_handler previousTerminateHandler = nullptr;
+    constexpr std::chrono::seconds metricsReportPeriod{ 10 };
+    // Only the asynchronous stop requests: after SIGSEGV, SIGABRT and the like nothing is safe to run.
+    constexpr int stopSignals[] = { SIGINT, SIGTERM };
+}
+
 void EventLogger::initialize()
 {
     const auto now = std::chrono::system_clock::now();
@@ -14,54 +28,78 @@ void EventLogger::initialize()
 
     std::filesystem::create_directories(sessionDirectory);
 
-    logFile.open(sessionDirectory + "/logs.txt", std::ofstream::out | std::ofstream::app);
-    humanHandPoseFile.open(sessionDirectory + "/logs_human.txt", std::ofstream::out | std::ofstream::app);
+    logWriter.open(sessionDirectory + "/logs.txt");
+    humanHandPoseStream.open(sessionDirectory + "/logs_human.bin");
+#if HR_VR_PROJ_METRICS
+    metricsReporter.start(sessionDirectory + "/metrics.txt", metricsReportPeriod);
+#endif
+    installCrashHandlers();
 
     log(LogLevel::CONTROL, "Session started at " + ss.str());
 }
 
-void EventLogger::log(LogLevel level, const std::string& msg)
+void EventLogger::log(LogLevel level, LogEventId event, int objectId)
 {
-	if (!logFile.is_open()) return;
-
-	const auto now = std::chrono::system_clock::now();
-	const std::time_t now_time = std::chrono::system_clock::to_time_t(now);
-
-	std::stringstream timeSS, logSS;
-	timeSS << std::put_time(std::localtime(&now_time), "%Y-%m-%d %H:%M:%S");
-	std::string levelStr;
-	switch (level) {
-	case LogLevel::CONTROL: levelStr = "CONTROL"; break;
-	case LogLevel::ROBOT: levelStr = "ROBOT"; break;
-	case LogLevel::HUMAN: levelStr = "HUMAN"; break;
-	}
-
-	logSS << timeSS.str() << " " << levelStr << " " << msg << std::endl;
+	if (!logWriter.isOpen()) return;
 
-	logFile << logSS.str();
-	logFile.flush(); // Ensure that each message is immediately written to the file
+	logWriter.push({ level, event, objectId, std::chrono::system_clock::now(), {} });
 }
 
-void EventLogger::logHumanHandPose(const std::string& msg)
+void EventLogger::log(LogLevel level, const std::string& msg)
 {
-	if (!humanHandPoseFile.is_open()) return;
+	if (!logWriter.isOpen()) return;
 
-	const auto now = std::chrono::system_clock::now();
-	const std::time_t now_time = std::chrono::system_clock::to_time_t(now);
+	logWriter.push({ level, LogEventId::MESSAGE, 0, std::chrono::system_clock::now(), msg });
+}
 
-	std::stringstream timeSS;
-	timeSS << std::put_time(std::localtime(&now_time), "%Y-%m-%d %H:%M:%S");
+PoseTelemetryWriter* EventLogger::getHumanHandPoseStream()
+{
+	return humanHandPoseStream.isOpen() ? &humanHandPoseStream : nullptr;
+}
 
-	const std::string logMsg = timeSS.str() + " " + msg + "\n";
+void EventLogger::finalize()
+{
+	metricsReporter.stop();
+	if (humanHandPoseStream.isOpen())
+	{
+		humanHandPoseStream.close();
+		log(LogLevel::CONTROL, "Hand pose samples: recorded = " + std::to_string(humanHandPoseStream.getNumberOfRecorded())
+			+ ", dropped = " + std::to_string(humanHandPoseStream.getNumberOfDropped()));
+	}
+	if (logWriter.isOpen())
+	{
+		log(LogLevel::CONTROL, "Log events: logged = " + std::to_string(logWriter.getNumberOfLogged())
+			+ ", dropped = " + std::to_string(logWriter.getNumberOfDropped()));
+		logWriter.close();
+	}
+}
 
-	humanHandPoseFile << logMsg;
-	humanHandPoseFile.flush(); // Ensure that each message is immediately written to the file
+void EventLogger::installCrashHandlers()
+{
+	// Events are committed in batches, so Ctrl+C or a terminate() would otherwise lose the last batch.
+	// The signal handler only hands the signal to the writer thread, which commits and raises it again.
+	for (const int signal : stopSignals)
+		std::signal(signal, [](int raised)
+			{
+				if (logWriter.requestFlushOnSignal(raised))
+					return;
+				std::signal(raised, SIG_DFL);
+				std::raise(raised);
+			});
+
+	previousTerminateHandler = std::set_terminate([]
+		{
+			flushOnCrash();
+			if (previousTerminateHandler)
+				previousTerminateHandler();
+			std::abort();
+		});
 }
 
-void EventLogger::finalize()
+void EventLogger::flushOnCrash()
 {
-	if (logFile.is_open())
-		logFile.close();
-	if (humanHandPoseFile.is_open())
-		humanHandPoseFile.close();
-}
\ No newline at end of file
+	// Only the first terminate() flushes.
+	if (crashed.exchange(true))
+		return;
+	logWriter.flushOnCrash();
+}
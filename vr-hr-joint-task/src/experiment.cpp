@@ -1,11 +1,22 @@
 #include "experiment.h"
 
+#include <stdexcept>
+
 Experiment::Experiment(const ExperimentParameters& parameters)
-	: dnfComposerHandler(parameters.dnf, parameters.deltaT)
-	, coppeliasimHandler()
+	: dnfComposerHandler(parameters.dnf, parameters.deltaT, parameters.dnfParameters)
+	, coppeliasimHandler(makeCoppeliasimHandler(parameters.transport))
+	, maxControlPeriod(parameters.maxControlPeriod)
+	, controlActivity("Control")
 	, handPose({},{})
+	, lastHandPoseSequence(0)
 {
-
+	// The scene only reports the first objects; the others would never appear to the fields.
+	if (parameters.dnfParameters.architectureOptions.workspace.getNumberOfObjects() > IncomingSignals::NUMBER_OF_OBJECTS)
+		throw std::runtime_error("The CoppeliaSim scene publishes signals for "
+			+ std::to_string(IncomingSignals::NUMBER_OF_OBJECTS) + " objects, the workspace has more.");
+	dnfComposerHandler.setChangeNotifier(&controlNotifier);
+	coppeliasimHandler.setChangeNotifier(&controlNotifier);
+	coppeliasimHandler.setCausalLatencyTracer(&causalLatencyTracer);
 }
 
 Experiment::~Experiment()
@@ -15,9 +26,13 @@ Experiment::~Experiment()
 
 void Experiment::init()
 {
+	// The pose stream is written from the moment the hand pose thread starts.
+	EventLogger::initialize();
+	coppeliasimHandler.setHandPoseTelemetry(EventLogger::getHumanHandPoseStream());
 	dnfComposerHandler.init();
 	coppeliasimHandler.init();
-	EventLogger::initialize();
+	sessionRecorder.open(EventLogger::getSessionDirectory() + "/session.trace", dnfComposerHandler.getArchitectureType(),
+		dnfComposerHandler.getDeltaT(), dnfComposerHandler.getNoiseSeed());
 }
 
 void Experiment::run()
@@ -29,34 +44,58 @@ void Experiment::run()
 
 void Experiment::end()
 {
+	// Without a window to close, the session lasts as long as the connection with CoppeliaSim.
+	if (dnfComposerHandler.isHeadless())
+		while (coppeliasimHandler.isConnected())
+			std::this_thread::sleep_for(std::chrono::milliseconds(500));
 	dnfComposerHandler.end();
 	coppeliasimHandler.end();
-	experimentThread.join();
+	if (experimentThread.joinable())
+		experimentThread.join();
+	sessionRecorder.close();
+	causalLatencyTracer.writeCsv(EventLogger::getSessionDirectory() + "/causal_latency.csv");
+	logRuntimeStatistics();
 	EventLogger::finalize();
 }
 
 void Experiment::handleSignalsBetweenDnfAndCoppeliasim()
 {
+	controlActivity.start();
 	while (coppeliasimHandler.isConnected())
 	{
+		controlNotifier.waitFor(maxControlPeriod);
+		controlActivity.wakeup();
+		METRICS_SCOPED_TIMER("control iteration");
+		const std::uint64_t dnfStep = dnfComposerHandler.getNumberOfSteps();
 		inSignals = coppeliasimHandler.getSignals();
-		sendHandPositionToDnf();
-		sendAvailableObjectsToDnf();
+		objectSignals = decodeObjectSignals(inSignals);
+		{
+			METRICS_SCOPED_TIMER("stimulus update");
+			sendHandPositionToDnf();
+			sendAvailableObjectsToDnf();
+		}
 		sendTargetObjectToRobot();
+		sessionRecorder.record(dnfStep, stimulusTime, handPoseSnapshot, inSignals, outSignals.targetObject);
 		interpretAndLogSystemState();
-		coppeliasimHandler.setSignals(outSignals);
+		coppeliasimHandler.setSignals(outSignals, decisionCause);
+		if (handPoseSnapshot.sequence != 0)
+			METRICS_SET("hand pose age (ms)", (std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - handPoseSnapshot.captureTime).count()));
 	}
+	controlActivity.finish();
 }
 
 void Experiment::waitForConnectionWithCoppeliasim()
 {
 	while (!coppeliasimHandler.isConnected())
 	{
+		if (coppeliasimHandler.hasFailed())
+			throw std::runtime_error("Could not connect with CoppeliaSim.");
 		log(dnf_composer::tools::logger::LogLevel::INFO, "Waiting for connection with CoppeliaSim...\n");
-		Sleep(500);
+		std::this_thread::sleep_for(std::chrono::milliseconds(500));
 	}
 	log(dnf_composer::tools::logger::LogLevel::INFO, "Connected with CoppeliaSim.\n");
-	EventLogger::log(LogLevel::CONTROL, "Connected with CoppeliaSim.");
+	EventLogger::log(LogLevel::CONTROL, LogEventId::CONNECTED_WITH_COPPELIASIM);
 }
 
 void Experiment::waitForSimulationToStart()
@@ -67,139 +106,110 @@ void Experiment::waitForSimulationToStart()
 		outSignals.startSim = true;
 		log(dnf_composer::tools::logger::LogLevel::INFO, "Waiting for Simulation to start...\n");
 		hasSimStarted = inSignals.simStarted;
-		Sleep(500);
+		std::this_thread::sleep_for(std::chrono::milliseconds(500));
 	}
 	log(dnf_composer::tools::logger::LogLevel::INFO, "Simulation has started.\n");
 }
 
 void Experiment::sendHandPositionToDnf()
 {
-	handPose = coppeliasimHandler.getHandPose();
-	dnfComposerHandler.setHandStimulus({ handPose.position.x,
-		handPose.position.y,
-		handPose.position.z},
-		inSignals.object1,
-		inSignals.object2,
-		inSignals.object3);
+	handPoseSnapshot = coppeliasimHandler.getHandPoseSnapshot();
+	handPose = handPoseSnapshot.value;
+	handKinematics.update(handPoseSnapshot);
+	// The stimulus is first read by the next step, estimate the hand for then rather than for the last sample.
+	stimulusTime = dnfComposerHandler.getNextStepTime();
+	dnfComposerHandler.setHandStimulus(handKinematics.estimateAt(stimulusTime), objectSignals.present);
+	causalLatencyTracer.onStimulusApplied(handPoseSnapshot.sequence, handPoseSnapshot.captureTime,
+		dnfComposerHandler.getNumberOfSteps());
 }
 
 void Experiment::sendAvailableObjectsToDnf() const
 {
-	dnfComposerHandler.setAvailableObjectsInTheWorkspace(inSignals.object1, inSignals.object2, inSignals.object3);
+	dnfComposerHandler.setAvailableObjectsInTheWorkspace(objectSignals.present);
 }
 
 void Experiment::sendTargetObjectToRobot()
 {
-	outSignals.targetObject = dnfComposerHandler.getTargetObject();
+	// Taken by the DNF thread after its last step, which the step index says.
+	const TargetDecision decision = dnfComposerHandler.getTargetDecision().value;
+	outSignals.targetObject = decision.targetObject;
+	decisionCause = causalLatencyTracer.onDecision(outSignals.targetObject, decision.step);
 }
 
 void Experiment::interpretAndLogSystemState()
 {
-	const std::string log = "Hand pose: x = "
-		+ std::to_string(handPose.position.x) +
-		", y = " + std::to_string(handPose.position.y) +
-		", z = " + std::to_string(handPose.position.z) +
-		", alpha = " + std::to_string(handPose.orientation.alpha) +
-		", beta = " + std::to_string(handPose.orientation.beta) +
-		", gamma = " + std::to_string(handPose.orientation.gamma);
-	EventLogger::logHumanHandPose(log);
+	// Every sample is logged by the hand pose thread; these are the ones no control pass saw.
+	if (handPoseSnapshot.sequence != lastHandPoseSequence)
+	{
+		if (lastHandPoseSequence != 0)
+			METRICS_ADD("hand pose samples skipped", handPoseSnapshot.sequence - lastHandPoseSequence - 1);
+		lastHandPoseSequence = handPoseSnapshot.sequence;
+	}
 
 	if(inSignals.simStarted && logMsgs.prevSimStarted == false)
 	{
-		EventLogger::log(LogLevel::CONTROL, "Simulation has started.");
+		EventLogger::log(LogLevel::CONTROL, LogEventId::SIMULATION_STARTED);
 		logMsgs.prevSimStarted = true;
 	}
 	logMsgs.prevSimStarted = inSignals.simStarted;
 
-	// Grasping events for robot, logged every time it passes from 0 to 1.
-	if (inSignals.robotGraspObj1 && logMsgs.prevRobotGraspObj1 == 0) {
-		EventLogger::log(LogLevel::ROBOT, "Robot is grasping object 1.");
-	}
-	logMsgs.prevRobotGraspObj1 = inSignals.robotGraspObj1;
-
-	if (inSignals.robotGraspObj2 && logMsgs.prevRobotGraspObj2 == 0) {
-		EventLogger::log(LogLevel::ROBOT, "Robot is grasping object 2.");
-	}
-	logMsgs.prevRobotGraspObj2 = inSignals.robotGraspObj2;
-
-	if (inSignals.robotGraspObj3 && logMsgs.prevRobotGraspObj3 == 0) {
-		EventLogger::log(LogLevel::ROBOT, "Robot is grasping object 3.");
-	}
-	logMsgs.prevRobotGraspObj3 = inSignals.robotGraspObj3;
-
-	// Grasping events for human, logged every time it passes from 0 to 1.
-	if (inSignals.humanGraspObj1 && logMsgs.prevHumanGraspObj1 == 0) {
-		EventLogger::log(LogLevel::HUMAN, "Human is grasping object 1.");
-	}
-	logMsgs.prevHumanGraspObj1 = inSignals.humanGraspObj1;
-
-	if (inSignals.humanGraspObj2 && logMsgs.prevHumanGraspObj2 == 0) {
-		EventLogger::log(LogLevel::HUMAN, "Human is grasping object 2.");
-	}
-	logMsgs.prevHumanGraspObj2 = inSignals.humanGraspObj2;
-
-	if (inSignals.humanGraspObj3 && logMsgs.prevHumanGraspObj3 == 0) {
-		EventLogger::log(LogLevel::HUMAN, "Human is grasping object 3.");
-	}
-	logMsgs.prevHumanGraspObj3 = inSignals.humanGraspObj3;
-
-	// Placement events for robot, logged every time it passes from 0 to 1.
-	if (inSignals.robotPlaceObj1 && logMsgs.prevRobotPlaceObj1 == 0) {
-		EventLogger::log(LogLevel::ROBOT, "Robot is placing object 1.");
-	}
-	logMsgs.prevRobotPlaceObj1 = inSignals.robotPlaceObj1;
-
-	if (inSignals.robotPlaceObj2 && logMsgs.prevRobotPlaceObj2 == 0) {
-		EventLogger::log(LogLevel::ROBOT, "Robot is placing object 2.");
-	}
-	logMsgs.prevRobotPlaceObj2 = inSignals.robotPlaceObj2;
-
-	if (inSignals.robotPlaceObj3 && logMsgs.prevRobotPlaceObj3 == 0) {
-		EventLogger::log(LogLevel::ROBOT, "Robot is placing object 3.");
-	}
-	logMsgs.prevRobotPlaceObj3 = inSignals.robotPlaceObj3;
-
-	// Placement events for human, logged every time it passes from 0 to 1.
-	if (inSignals.humanPlaceObj1 && logMsgs.prevHumanPlaceObj1 == 0) {
-		EventLogger::log(LogLevel::HUMAN, "Human is placing object 1.");
-	}
-	logMsgs.prevHumanPlaceObj1 = inSignals.humanPlaceObj1;
-
-	if (inSignals.humanPlaceObj2 && logMsgs.prevHumanPlaceObj2 == 0) {
-		EventLogger::log(LogLevel::HUMAN, "Human is placing object 2.");
-	}
-	logMsgs.prevHumanPlaceObj2 = inSignals.humanPlaceObj2;
-
-	if (inSignals.humanPlaceObj3 && logMsgs.prevHumanPlaceObj3 == 0) {
-		EventLogger::log(LogLevel::HUMAN, "Human is placing object 3.");
-	}
-	logMsgs.prevHumanPlaceObj3 = inSignals.humanPlaceObj3;
+	// Grasping and placement events, logged every time an object's flag passes from 0 to 1.
+	const ObjectSignals& previous = logMsgs.prevObjectSignals;
+	forEachObject(objectSignals.robotGrasp & ~previous.robotGrasp, [](int object) {
+		EventLogger::log(LogLevel::ROBOT, LogEventId::ROBOT_GRASPING, object);
+	});
+	forEachObject(objectSignals.humanGrasp & ~previous.humanGrasp, [](int object) {
+		EventLogger::log(LogLevel::HUMAN, LogEventId::HUMAN_GRASPING, object);
+	});
+	forEachObject(objectSignals.robotPlace & ~previous.robotPlace, [](int object) {
+		EventLogger::log(LogLevel::ROBOT, LogEventId::ROBOT_PLACING, object);
+	});
+	forEachObject(objectSignals.humanPlace & ~previous.humanPlace, [](int object) {
+		EventLogger::log(LogLevel::HUMAN, LogEventId::HUMAN_PLACING, object);
+	});
+	logMsgs.prevObjectSignals = objectSignals;
 
 	// Check if the robot is approaching a new object.
 	if (inSignals.robotApproaching && /*!inSignals.robotGrasping && */outSignals.targetObject != logMsgs.lastTargetObject) {
 		if (outSignals.targetObject != 0)
-			EventLogger::log(LogLevel::ROBOT, "Robot will target object " + std::to_string(outSignals.targetObject) + ".");
+			EventLogger::log(LogLevel::ROBOT, LogEventId::ROBOT_TARGETING, outSignals.targetObject);
 		logMsgs.lastTargetObject = outSignals.targetObject;
 	}
 }
 
+void Experiment::logRuntimeStatistics() const
+{
+	std::vector<std::string> reports;
+	for (const auto* activity : coppeliasimHandler.getThreadActivities())
+		reports.push_back(activity->getReport());
+	reports.push_back(controlActivity.getReport());
+	reports.push_back(dnfComposerHandler.getSteppingReport());
+
+	const OutgoingSignalsStatistics outgoing = coppeliasimHandler.getOutgoingSignalsStatistics();
+	reports.push_back("Outgoing signal writes: sent = " + std::to_string(outgoing.writesSent)
+		+ ", suppressed = " + std::to_string(outgoing.writesSuppressed));
+	reports.push_back(causalLatencyTracer.getReport());
+	reports.push_back("Session trace records: recorded = " + std::to_string(sessionRecorder.getNumberOfRecorded())
+		+ ", dropped = " + std::to_string(sessionRecorder.getNumberOfDropped()));
+
+	for (const auto& report : reports)
+	{
+		log(dnf_composer::tools::logger::LogLevel::INFO, report + "\n");
+		EventLogger::log(LogLevel::CONTROL, report);
+	}
+}
+
 void Experiment::keepAliveWhileTaskIsRunning() const
 {
 	while (true)
 	{
-		Sleep(1000);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
 	}
 	// For now let's keep alive for a few seconds after the task is done.
-	Sleep(10000);
+	std::this_thread::sleep_for(std::chrono::milliseconds(10000));
 }
 
 bool Experiment::areObjectsPresent() const
 {
-	const bool isPresent = inSignals.object1 != 0 || inSignals.object2 != 0 || inSignals.object3 != 0;
-	return isPresent;
-}
-
-bool Experiment::areAllObjectsPresent() const
-{
-	return inSignals.object1 != 0 && inSignals.object2 != 0 && inSignals.object3 != 0;
+	return objectSignals.present.any();
 }
@@ -0,0 +1,108 @@
+#include "fixed_step_runner.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <time.h>
+#endif
+
+FixedStepRunner::FixedStepRunner(std::chrono::nanoseconds period, SteppingMode mode, int maxCatchUpSteps)
+	: period(period), mode(mode), maxCatchUpSteps(std::max(maxCatchUpSteps, 0)), steps(0),
+	missedDeadlines(0), skippedSteps(0), nextStepTimeNs(0)
+{}
+
+void FixedStepRunner::run(const std::stop_token& stopToken, const std::function<bool()>& step)
+{
+	using Clock = std::chrono::steady_clock;
+
+	Clock::time_point deadline = Clock::now();
+	while (!stopToken.stop_requested())
+	{
+		if (!step())
+			break;
+		steps.fetch_add(1, std::memory_order_relaxed);
+
+		if (mode != SteppingMode::REAL_TIME)
+			continue;
+
+		deadline += period;
+		const Clock::time_point now = Clock::now();
+		if (now < deadline)
+		{
+			nextStepTimeNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count(),
+				std::memory_order_relaxed);
+			sleepUntil(deadline);
+			const auto late = std::max(Clock::now() - deadline, Clock::duration::zero());
+			lateness.record(late);
+			METRICS_RECORD("dnf step lateness", late);
+			continue;
+		}
+
+		// Late: this step runs right away, along with at most maxCatchUpSteps more to make up for whole periods
+		// lost; the deadlines past those are skipped.
+		lateness.record(now - deadline);
+		METRICS_RECORD("dnf step lateness", now - deadline);
+		missedDeadlines.fetch_add(1, std::memory_order_relaxed);
+		METRICS_ADD("dnf missed deadlines", 1);
+		const auto behind = (now - deadline) / period;
+		if (behind > maxCatchUpSteps)
+		{
+			const auto skipped = behind - maxCatchUpSteps;
+			deadline += skipped * period;
+			skippedSteps.fetch_add(static_cast<std::uint64_t>(skipped), std::memory_order_relaxed);
+			METRICS_ADD("dnf skipped steps", static_cast<std::uint64_t>(skipped));
+		}
+		nextStepTimeNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count(),
+			std::memory_order_relaxed);
+	}
+	nextStepTimeNs.store(0, std::memory_order_relaxed);
+}
+
+std::chrono::steady_clock::time_point FixedStepRunner::getNextStepTime() const
+{
+	const auto now = std::chrono::steady_clock::now();
+	const std::int64_t next = nextStepTimeNs.load(std::memory_order_relaxed);
+	if (next == 0)
+		return now;
+	const std::chrono::steady_clock::time_point nextStep(
+		std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(next)));
+	return std::max(now, nextStep);
+}
+
+std::string FixedStepRunner::getReport(const std::string& name) const
+{
+	const auto toMilliseconds = [](std::chrono::nanoseconds time) {
+		return std::chrono::duration<double, std::milli>(time).count();
+	};
+
+	std::stringstream ss;
+	ss << name << " stepping: steps = " << getNumberOfSteps();
+	if (mode == SteppingMode::REAL_TIME)
+		ss << ", period = " << toMilliseconds(period) << " ms"
+			<< ", missed deadlines = " << getNumberOfMissedDeadlines()
+			<< ", skipped steps = " << getNumberOfSkippedSteps()
+			<< ", lateness p50 = " << toMilliseconds(lateness.getPercentile(50)) << " ms"
+			<< ", p99 = " << toMilliseconds(lateness.getPercentile(99)) << " ms"
+			<< ", max = " << toMilliseconds(lateness.getMax()) << " ms";
+	else
+		ss << " (simulated time)";
+	return ss.str();
+}
+
+void FixedStepRunner::sleepUntil(std::chrono::steady_clock::time_point time)
+{
+#ifdef __linux__
+	// steady_clock is CLOCK_MONOTONIC on Linux; an absolute deadline is immune to the time spent getting here.
+	const auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch());
+	timespec deadline{};
+	deadline.tv_sec = static_cast<time_t>(sinceEpoch.count() / 1000000000);
+	deadline.tv_nsec = static_cast<long>(sinceEpoch.count() % 1000000000);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+	{}
+#else
+	std::this_thread::sleep_until(time);
+#endif
+}
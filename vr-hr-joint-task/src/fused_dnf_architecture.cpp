@@ -0,0 +1,5 @@
+#include "fused_dnf_architecture.h"
+
+// Both architectures use 100-sample fields (x_max 50, d_x 0.5); compiled once here.
+template class FusedKernel<100>;
+template class FusedDnfArchitecture<100>;
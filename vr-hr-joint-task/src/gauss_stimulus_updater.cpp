@@ -0,0 +1,63 @@
+#include "gauss_stimulus_updater.h"
+
+GaussStimulusUpdater::GaussStimulusUpdater(dnf_composer::element::GaussStimulus* stimulus)
+	: stimulus(stimulus), profileEvaluations(0), rescales(0), skips(0)
+{
+	if (stimulus)
+	{
+		parameters = stimulus->getParameters();
+		evaluateProfile(parameters.position, parameters.amplitude);
+	}
+}
+
+void GaussStimulusUpdater::setAmplitude(double amplitude)
+{
+	if (amplitude == parameters.amplitude)
+	{
+		++skips;
+		return;
+	}
+	if (unitProfile.empty())
+	{
+		evaluateProfile(parameters.position, amplitude);
+		return;
+	}
+	rescale(amplitude);
+}
+
+void GaussStimulusUpdater::setAmplitudeAndPosition(double amplitude, double position)
+{
+	if (position == parameters.position)
+	{
+		setAmplitude(amplitude);
+		return;
+	}
+	evaluateProfile(position, amplitude);
+}
+
+void GaussStimulusUpdater::evaluateProfile(double position, double amplitude)
+{
+	// Let the element evaluate the Gaussian with the parameters it shows, so the output matches its own formula
+	// exactly and it renders the same again whenever it is initialised; the output is linear in the amplitude.
+	parameters.position = position;
+	parameters.amplitude = amplitude;
+	stimulus->setParameters(parameters);
+	++profileEvaluations;
+
+	unitProfile.clear();
+	if (amplitude == 0)
+		return;
+	const std::vector<double>& output = *stimulus->getComponentPtr("output");
+	unitProfile.resize(output.size());
+	for (std::size_t i = 0; i < output.size(); ++i)
+		unitProfile[i] = output[i] / amplitude;
+}
+
+void GaussStimulusUpdater::rescale(double amplitude)
+{
+	std::vector<double>& output = *stimulus->getComponentPtr("output");
+	for (std::size_t i = 0; i < output.size(); ++i)
+		output[i] = amplitude * unitProfile[i];
+	parameters.amplitude = amplitude;
+	++rescales;
+}
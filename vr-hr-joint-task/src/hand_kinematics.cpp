@@ -0,0 +1,126 @@
+#include "hand_kinematics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+	Position add(const Position& a, const Position& b, double scale)
+	{
+		return { a.x + scale * b.x, a.y + scale * b.y, a.z + scale * b.z };
+	}
+
+	Position difference(const Position& a, const Position& b, double scale)
+	{
+		return { scale * (a.x - b.x), scale * (a.y - b.y), scale * (a.z - b.z) };
+	}
+
+	Position interpolate(const Position& a, const Position& b, double weight)
+	{
+		return { a.x + weight * (b.x - a.x), a.y + weight * (b.y - a.y), a.z + weight * (b.z - a.z) };
+	}
+
+	// Weight of a new value in a first-order filter with the given time constant, for a step of dt.
+	double getFilterGain(double dt, double timeConstant)
+	{
+		return timeConstant > 0 ? 1 - std::exp(-dt / timeConstant) : 1.0;
+	}
+}
+
+HandKinematicsEstimator::HandKinematicsEstimator(const HandKinematicsParameters& parameters)
+	: parameters(parameters), samples(parameters.capacity), newest(0), numberOfSamples(0)
+{
+	if (parameters.capacity < 2)
+		throw std::runtime_error("The hand kinematics estimator needs room for at least two samples.");
+}
+
+bool HandKinematicsEstimator::update(std::uint64_t sequence, std::chrono::steady_clock::time_point time, const Position& position)
+{
+	if (sequence == 0)
+		return false;
+
+	HandKinematics sample;
+	sample.sequence = sequence;
+	sample.time = time;
+	sample.position = position;
+
+	if (numberOfSamples > 0)
+	{
+		const HandKinematics& previous = samples[newest];
+		if (sequence <= previous.sequence || time <= previous.time)
+			return false;
+
+		const double dt = std::chrono::duration<double>(time - previous.time).count();
+		const Position rawVelocity = difference(position, previous.position, 1 / dt);
+		// The first difference has no history to smooth against.
+		const double velocityGain = numberOfSamples == 1 ? 1.0 : getFilterGain(dt, parameters.velocityTimeConstant.count());
+		sample.velocity = interpolate(previous.velocity, rawVelocity, velocityGain);
+
+		if (numberOfSamples > 1)
+		{
+			const Position rawAcceleration = difference(sample.velocity, previous.velocity, 1 / dt);
+			sample.acceleration = interpolate(previous.acceleration, rawAcceleration,
+				getFilterGain(dt, parameters.accelerationTimeConstant.count()));
+		}
+	}
+
+	newest = (newest + 1) % samples.size();
+	samples[newest] = sample;
+	numberOfSamples = std::min(numberOfSamples + 1, samples.size());
+	return true;
+}
+
+void HandKinematicsEstimator::clear()
+{
+	numberOfSamples = 0;
+}
+
+const HandKinematics& HandKinematicsEstimator::getLatest() const
+{
+	static const HandKinematics none;
+	return numberOfSamples == 0 ? none : samples[newest];
+}
+
+HandKinematics HandKinematicsEstimator::estimateAt(std::chrono::steady_clock::time_point time) const
+{
+	if (numberOfSamples == 0)
+		return {};
+
+	const HandKinematics& latest = samples[newest];
+	if (time >= latest.time)
+	{
+		const double dt = std::min(std::chrono::duration<double>(time - latest.time).count(), parameters.maxExtrapolation.count());
+		HandKinematics estimate = latest;
+		estimate.time = time;
+		estimate.position = add(add(latest.position, latest.velocity, dt), latest.acceleration, 0.5 * dt * dt);
+		estimate.velocity = add(latest.velocity, latest.acceleration, dt);
+		return estimate;
+	}
+
+	// Newest to oldest, the first sample at or before time brackets it with the one after.
+	for (std::size_t age = 1; age < numberOfSamples; ++age)
+	{
+		const HandKinematics& before = getSample(age);
+		if (before.time > time)
+			continue;
+		const HandKinematics& after = getSample(age - 1);
+		const double weight = std::chrono::duration<double>(time - before.time).count()
+			/ std::chrono::duration<double>(after.time - before.time).count();
+		HandKinematics estimate = after;
+		estimate.time = time;
+		estimate.position = interpolate(before.position, after.position, weight);
+		estimate.velocity = interpolate(before.velocity, after.velocity, weight);
+		estimate.acceleration = interpolate(before.acceleration, after.acceleration, weight);
+		return estimate;
+	}
+
+	HandKinematics estimate = getSample(numberOfSamples - 1);
+	estimate.time = time;
+	return estimate;
+}
+
+const HandKinematics& HandKinematicsEstimator::getSample(std::size_t age) const
+{
+	return samples[(newest + samples.size() - age) % samples.size()];
+}
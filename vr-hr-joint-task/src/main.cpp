@@ -3,6 +3,10 @@
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: https://pvs-studio.com
 
 
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
 #include "experiment.h"
 
 int main(int argc, char* argv[])
@@ -13,7 +17,45 @@ int main(int argc, char* argv[])
 		constexpr double deltaT = 65;
 		constexpr DnfArchitectureType architecture = DnfArchitectureType::HAND_MOTION;
 
-		const ExperimentParameters params{architecture, deltaT};
+		// The fields are stepped in real time, one step per deltaT of wall-clock time.
+		// --headless: no plot windows, the fields are stepped on a plain thread.
+		// --seed N: fixed NormalNoise seed, so the recorded session replays bit for bit.
+		// --workspace path.json: objects on the table (see resources/workspace.json), the three-object scene otherwise.
+		// --transport threads|pipelined: how CoppeliaSim is reached, three remote API threads by default.
+		// --backend graph|fused: what steps the fields, the dnf_composer element graph by default; fused needs --headless.
+		DnfComposerHandlerParameters dnfParams;
+		CoppeliasimTransport transport = CoppeliasimTransport::REMOTE_API_THREADS;
+		for (int i = 1; i < argc; ++i)
+		{
+			if (std::strcmp(argv[i], "--headless") == 0)
+				dnfParams.userInterface = false;
+			else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+				dnfParams.architectureOptions.noiseSeed = std::stoull(argv[++i]);
+			else if (std::strcmp(argv[i], "--workspace") == 0 && i + 1 < argc)
+				dnfParams.architectureOptions.workspace = Workspace::load(argv[++i]);
+			else if (std::strcmp(argv[i], "--transport") == 0 && i + 1 < argc)
+			{
+				const std::string name = argv[++i];
+				if (name == "threads")
+					transport = CoppeliasimTransport::REMOTE_API_THREADS;
+				else if (name == "pipelined")
+					transport = CoppeliasimTransport::PIPELINED;
+				else
+					throw std::runtime_error("Unknown transport " + name + ", expected threads or pipelined.");
+			}
+			else if (std::strcmp(argv[i], "--backend") == 0 && i + 1 < argc)
+			{
+				const std::string name = argv[++i];
+				if (name == "graph")
+					dnfParams.backend = DnfBackend::ELEMENT_GRAPH;
+				else if (name == "fused")
+					dnfParams.backend = DnfBackend::FUSED;
+				else
+					throw std::runtime_error("Unknown backend " + name + ", expected graph or fused.");
+			}
+		}
+
+		const ExperimentParameters params{architecture, deltaT, std::chrono::milliseconds(20), dnfParams, transport};
 		Experiment experiment(params);
 
 		experiment.init();
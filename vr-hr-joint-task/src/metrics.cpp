@@ -0,0 +1,186 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+	std::string toMicroseconds(std::chrono::nanoseconds value)
+	{
+		std::ostringstream stream;
+		stream << std::fixed << std::setprecision(1) << value.count() / 1000.0 << " us";
+		return stream.str();
+	}
+}
+
+LatencyHistogram::LatencyHistogram()
+	: count(0), sum(0), max(0)
+{
+	for (auto& bucket : buckets)
+		bucket.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency)
+{
+	const std::uint64_t value = latency.count() > 0 ? static_cast<std::uint64_t>(latency.count()) : 0;
+	buckets[getBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+	count.fetch_add(1, std::memory_order_relaxed);
+	sum.fetch_add(value, std::memory_order_relaxed);
+	std::uint64_t currentMax = max.load(std::memory_order_relaxed);
+	while (value > currentMax && !max.compare_exchange_weak(currentMax, value, std::memory_order_relaxed));
+}
+
+std::chrono::nanoseconds LatencyHistogram::getMean() const
+{
+	const std::uint64_t n = getCount();
+	return std::chrono::nanoseconds(n > 0 ? sum.load(std::memory_order_relaxed) / n : 0);
+}
+
+std::chrono::nanoseconds LatencyHistogram::getPercentile(double percentile) const
+{
+	const std::uint64_t n = getCount();
+	if (n == 0)
+		return std::chrono::nanoseconds(0);
+
+	const auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * n)));
+	std::uint64_t cumulative = 0;
+	for (std::size_t i = 0; i < NUMBER_OF_BUCKETS; ++i)
+	{
+		cumulative += buckets[i].load(std::memory_order_relaxed);
+		if (cumulative >= target)
+			return std::min(std::chrono::nanoseconds(getBucketUpperBound(i)), getMax());
+	}
+	return getMax();
+}
+
+std::size_t LatencyHistogram::getBucketIndex(std::uint64_t value)
+{
+	if (value < SUB_BUCKET_COUNT)
+		return static_cast<std::size_t>(value);
+	// Keep the top SUB_BUCKET_BITS bits, the leading one selects the power of two.
+	const int shift = std::bit_width(value) - SUB_BUCKET_BITS;
+	const std::uint64_t subBucket = value >> shift;
+	return SUB_BUCKET_COUNT + (shift - 1) * HALF_SUB_BUCKET_COUNT + (subBucket - HALF_SUB_BUCKET_COUNT);
+}
+
+std::uint64_t LatencyHistogram::getBucketUpperBound(std::size_t index)
+{
+	if (index < SUB_BUCKET_COUNT)
+		return index;
+	const std::uint64_t shift = (index - SUB_BUCKET_COUNT) / HALF_SUB_BUCKET_COUNT + 1;
+	const std::uint64_t subBucket = (index - SUB_BUCKET_COUNT) % HALF_SUB_BUCKET_COUNT + HALF_SUB_BUCKET_COUNT;
+	return ((subBucket + 1) << shift) - 1;
+}
+
+MetricsRegistry::MetricsRegistry()
+	: creationTime(std::chrono::steady_clock::now())
+{}
+
+MetricsRegistry& MetricsRegistry::global()
+{
+	static MetricsRegistry registry;
+	return registry;
+}
+
+LatencyHistogram& MetricsRegistry::getHistogram(const std::string& name)
+{
+	std::lock_guard lock(mutex);
+	auto& histogram = histograms[name];
+	if (!histogram)
+		histogram = std::make_unique<LatencyHistogram>();
+	return *histogram;
+}
+
+Counter& MetricsRegistry::getCounter(const std::string& name)
+{
+	std::lock_guard lock(mutex);
+	auto& counter = counters[name];
+	if (!counter)
+		counter = std::make_unique<Counter>();
+	return *counter;
+}
+
+Gauge& MetricsRegistry::getGauge(const std::string& name)
+{
+	std::lock_guard lock(mutex);
+	auto& gauge = gauges[name];
+	if (!gauge)
+		gauge = std::make_unique<Gauge>();
+	return *gauge;
+}
+
+std::string MetricsRegistry::getSnapshot() const
+{
+	std::lock_guard lock(mutex);
+	const std::chrono::duration<double> uptime = std::chrono::steady_clock::now() - creationTime;
+
+	std::ostringstream snapshot;
+	snapshot << "Metrics after " << std::fixed << std::setprecision(1) << uptime.count() << " s\n";
+	for (const auto& [name, histogram] : histograms)
+		snapshot << "latency " << name
+			<< ": count = " << histogram->getCount()
+			<< ", mean = " << toMicroseconds(histogram->getMean())
+			<< ", p50 = " << toMicroseconds(histogram->getPercentile(50))
+			<< ", p90 = " << toMicroseconds(histogram->getPercentile(90))
+			<< ", p99 = " << toMicroseconds(histogram->getPercentile(99))
+			<< ", p99.9 = " << toMicroseconds(histogram->getPercentile(99.9))
+			<< ", max = " << toMicroseconds(histogram->getMax()) << "\n";
+	for (const auto& [name, counter] : counters)
+		snapshot << "counter " << name << ": " << counter->get() << "\n";
+	for (const auto& [name, gauge] : gauges)
+		snapshot << "gauge " << name << ": " << gauge->get() << "\n";
+	return snapshot.str();
+}
+
+MetricsReporter::MetricsReporter(MetricsRegistry& registry)
+	: registry(registry)
+{}
+
+MetricsReporter::~MetricsReporter()
+{
+	stop();
+}
+
+void MetricsReporter::start(const std::string& reportPath, std::chrono::milliseconds period)
+{
+	stop();
+	path = reportPath;
+	reporterThread = std::jthread([this, period](const std::stop_token& stopToken)
+		{
+			std::mutex mutex;
+			std::condition_variable_any wakeup;
+			std::unique_lock lock(mutex);
+			while (!wakeup.wait_for(lock, stopToken, period, [] { return false; }) && !stopToken.stop_requested())
+				dump();
+		});
+}
+
+void MetricsReporter::stop()
+{
+	if (!reporterThread.joinable())
+		return;
+	reporterThread.request_stop();
+	reporterThread.join();
+	dump();
+}
+
+bool MetricsReporter::dump() const
+{
+	// Written aside and renamed, so a reader never sees a half-written snapshot.
+	const std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ofstream::out | std::ofstream::trunc);
+		if (!file.is_open())
+			return false;
+		file << registry.getSnapshot();
+	}
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, path, error);
+	return !error;
+}
@@ -1,5 +1,21 @@
 #include "misc.h"
 
+PositionArrays::PositionArrays(const std::vector<Position>& positions)
+{
+	x.reserve(positions.size());
+	y.reserve(positions.size());
+	z.reserve(positions.size());
+	for (const Position& position : positions)
+		push_back(position);
+}
+
+void PositionArrays::push_back(const Position& position)
+{
+	x.push_back(position.x);
+	y.push_back(position.y);
+	z.push_back(position.z);
+}
+
 
 double calculateEuclideanDistance(const Position& a, const Position& b)
 {
@@ -18,14 +34,41 @@ double calculateVelocity(const Position& a, const Position& b, double time)
 
 // https://github.com/Jgocunha/action-likelihood
 double calculateLikelihoodOfHumanAction(const Position& handPos, const Position& handPosPrev, const Position& componentPos, double deltaTime, double tau, double sigma)
+{
+	return calculateLikelihoodOfHumanAction(handPos, calculateVelocity(handPos, handPosPrev, deltaTime), componentPos, tau, sigma);
+}
+
+double calculateLikelihoodOfHumanAction(const Position& handPos, double handSpeed, const Position& componentPos, double tau, double sigma)
 {
 	const double distance = calculateEuclideanDistance(handPos, componentPos);
-	const double velocity = calculateVelocity(handPos, handPosPrev, deltaTime);
 
-	const double exponent = -pow((distance + tau * velocity), 2) / (2 * pow(sigma, 2));
+	const double exponent = -pow((distance + tau * handSpeed), 2) / (2 * pow(sigma, 2));
 	const double likelihood = (1 / sqrt(2 * std::numbers::pi * pow(sigma, 2))) * exp(exponent);
 
 	return likelihood;
 }
 
+void calculateLikelihoodsOfHumanAction(const Position& handPos, double handSpeed, const PositionArrays& components,
+	double tau, double sigma, double* likelihoods)
+{
+	// Same operations, in the same order, as the scalar function.
+	const double offset = tau * handSpeed;
+	const double twoSigmaSquared = 2 * (sigma * sigma);
+	const double normalisation = 1 / sqrt(2 * std::numbers::pi * (sigma * sigma));
+	const std::size_t n = components.size();
+	const double* x = components.x.data();
+	const double* y = components.y.data();
+	const double* z = components.z.data();
 
+	// Exponents first, a loop of plain arithmetic and sqrt; exp in a loop of its own.
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		const double deltaX = handPos.x - x[i];
+		const double deltaY = handPos.y - y[i];
+		const double deltaZ = handPos.z - z[i];
+		const double distance = sqrt(deltaX * deltaX + deltaY * deltaY + deltaZ * deltaZ) + offset;
+		likelihoods[i] = -(distance * distance) / twoSigmaSquared;
+	}
+	for (std::size_t i = 0; i < n; ++i)
+		likelihoods[i] = normalisation * exp(likelihoods[i]);
+}
@@ -0,0 +1,206 @@
+#include "parameter_sweep.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include "work_stealing_thread_pool.h"
+
+namespace
+{
+	const Position restingHandPosition = { 0.35, 0.0, 0.95 };
+	// The hand stops above the object.
+	constexpr double graspHeight = 0.04;
+
+	bool isObjectPresent(const IncomingSignals& signals, int object)
+	{
+		return decodeObjectSignals(signals).present.test(object - 1);
+	}
+
+	IncomingSignals getSignals(const SessionTraceRecord& record)
+	{
+		IncomingSignals signals;
+		IncomingSignalsSnapshot::unpack(record.incomingSignals, signals);
+		return signals;
+	}
+
+	int getGraspedObject(const SessionTraceRecord& record)
+	{
+		const ObjectSet grasped = decodeObjectSignals(getSignals(record)).humanGrasp;
+		return grasped.none() ? 0 : std::countr_zero(grasped.to_ullong()) + 1;
+	}
+}
+
+std::vector<dnf_composer::element::LateralInteractionsParameters> LateralInteractionsGrid::getCandidates() const
+{
+	std::vector<dnf_composer::element::LateralInteractionsParameters> candidates;
+	for (const double se : sigmaExc)
+		for (const double ae : amplitudeExc)
+			for (const double si : sigmaInh)
+				for (const double ai : amplitudeInh)
+					for (const double ag : amplitudeGlobal)
+						candidates.emplace_back(se, ae, si, ai, ag, false, false);
+	return candidates;
+}
+
+SessionTrace makeSyntheticReach(DnfArchitectureType architecture, int humanObject, const SyntheticReachParameters& parameters)
+{
+	SessionTrace trace{};
+	std::memcpy(trace.header.magic, SessionTraceHeader::MAGIC, sizeof(trace.header.magic));
+	trace.header.version = SessionTraceHeader::VERSION;
+	trace.header.recordSize = sizeof(SessionTraceRecord);
+	trace.header.architecture = static_cast<std::uint32_t>(architecture);
+	trace.header.deltaT = parameters.deltaT;
+
+	IncomingSignals signals;
+	signals.simStarted = signals.object1 = signals.object2 = signals.object3 = true;
+
+	// Same layout the action likelihood stimulus uses.
+	const Position object = Workspace::getDefault().getObject(humanObject).position;
+	const Position target = { object.x, object.y, object.z + graspHeight };
+	const auto duration = parameters.reachDuration + parameters.holdDuration;
+	const auto numberOfPasses = duration / parameters.controlPeriod;
+	for (std::int64_t i = 0; i <= numberOfPasses; ++i)
+	{
+		const auto time = i * parameters.controlPeriod;
+		// Minimum-jerk profile: 10 s^3 - 15 s^4 + 6 s^5.
+		const double s = std::min(1.0, std::chrono::duration<double>(time) / parameters.reachDuration);
+		const double progress = s * s * s * (10 - 15 * s + 6 * s * s);
+		const Position hand = { restingHandPosition.x + (target.x - restingHandPosition.x) * progress,
+			restingHandPosition.y + (target.y - restingHandPosition.y) * progress,
+			restingHandPosition.z + (target.z - restingHandPosition.z) * progress };
+
+		if (i == numberOfPasses)
+		{
+			signals.humanGraspObj1 = humanObject == 1;
+			signals.humanGraspObj2 = humanObject == 2;
+			signals.humanGraspObj3 = humanObject == 3;
+		}
+
+		const std::int64_t timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+		trace.records.push_back({ static_cast<std::uint64_t>(std::chrono::duration<double, std::milli>(time).count() / parameters.deltaT),
+			timestampNs, static_cast<std::uint64_t>(i + 1), timestampNs,
+			hand.x, hand.y, hand.z, 0, 0, 0,
+			IncomingSignalsSnapshot::pack(signals), 0 });
+	}
+	return trace;
+}
+
+std::vector<SessionTrace> splitIntoReaches(const SessionTrace& session)
+{
+	std::vector<SessionTrace> reaches;
+	SessionTrace reach{ session.header, {} };
+	std::uint64_t firstStep = 0;
+	bool grasping = false;
+	for (const SessionTraceRecord& record : session.records)
+	{
+		const bool graspsNow = getGraspedObject(record) != 0;
+		// Passes while an object is held belong to no reach.
+		if (grasping && graspsNow)
+			continue;
+		grasping = false;
+		if (reach.records.empty())
+			firstStep = record.dnfStep;
+		SessionTraceRecord rebased = record;
+		rebased.dnfStep -= firstStep;
+		reach.records.push_back(rebased);
+		// A rising grasp edge closes the reach; passes after the last grasp have no outcome and are dropped.
+		if (graspsNow)
+		{
+			reaches.push_back(reach);
+			reach.records.clear();
+			grasping = true;
+		}
+	}
+	return reaches;
+}
+
+int getGraspedObject(const SessionTrace& reach)
+{
+	for (const SessionTraceRecord& record : reach.records)
+		if (const int object = getGraspedObject(record))
+			return object;
+	return 0;
+}
+
+TrialScore scoreTrial(const SessionTrace& reach, const SessionReplayResult& replay)
+{
+	TrialScore score;
+	if (replay.targetObjects.empty() || replay.targetObjects.size() != reach.records.size())
+		return score;
+
+	const int finalTarget = replay.targetObjects.back();
+	const int graspedObject = getGraspedObject(reach);
+	score.correct = finalTarget != 0 && finalTarget != graspedObject
+		&& isObjectPresent(getSignals(reach.records.back()), finalTarget);
+
+	std::size_t settled = replay.targetObjects.size() - 1;
+	while (settled > 0 && replay.targetObjects[settled - 1] == finalTarget)
+		--settled;
+	score.decisionLatency = std::chrono::nanoseconds(reach.records[settled].timestampNs - reach.records.front().timestampNs);
+	return score;
+}
+
+std::vector<SweepResult> runParameterSweep(const std::vector<dnf_composer::element::LateralInteractionsParameters>& candidates,
+	const std::vector<SessionTrace>& reaches, std::size_t numberOfThreads, std::uint64_t noiseSeed)
+{
+	// One task per (candidate, reach), each writing its own slot.
+	std::vector<TrialScore> scores(candidates.size() * reaches.size());
+	{
+		WorkStealingThreadPool pool(numberOfThreads);
+		for (std::size_t c = 0; c < candidates.size(); ++c)
+			for (std::size_t r = 0; r < reaches.size(); ++r)
+				pool.submit([&, c, r] {
+					const SessionReplayResult replay = replaySession(reaches[r], { noiseSeed, candidates[c] });
+					scores[c * reaches.size() + r] = scoreTrial(reaches[r], replay);
+				});
+		pool.wait();
+	}
+
+	std::vector<SweepResult> results;
+	for (std::size_t c = 0; c < candidates.size(); ++c)
+	{
+		SweepResult result;
+		result.parameters = candidates[c];
+		result.trials = reaches.size();
+		for (std::size_t r = 0; r < reaches.size(); ++r)
+		{
+			const TrialScore& score = scores[c * reaches.size() + r];
+			result.correct += score.correct;
+			result.meanDecisionLatency += score.decisionLatency;
+			result.maxDecisionLatency = std::max(result.maxDecisionLatency, score.decisionLatency);
+		}
+		if (result.trials > 0)
+			result.meanDecisionLatency /= static_cast<double>(result.trials);
+		results.push_back(result);
+	}
+	return results;
+}
+
+std::string formatSweepTable(std::vector<SweepResult> results)
+{
+	std::stable_sort(results.begin(), results.end(), [](const SweepResult& a, const SweepResult& b) {
+		if (a.getAccuracy() != b.getAccuracy())
+			return a.getAccuracy() > b.getAccuracy();
+		return a.meanDecisionLatency < b.meanDecisionLatency;
+	});
+
+	std::ostringstream table;
+	table << std::left << std::setw(10) << "sigmaExc" << std::setw(10) << "ampExc" << std::setw(10) << "sigmaInh"
+		<< std::setw(10) << "ampInh" << std::setw(10) << "ampGlob" << std::setw(10) << "accuracy"
+		<< std::setw(14) << "mean latency" << "max latency\n";
+	table << std::fixed;
+	for (const SweepResult& result : results)
+	{
+		const auto& p = result.parameters;
+		table << std::setprecision(3)
+			<< std::setw(10) << p.sigmaExc << std::setw(10) << p.amplitudeExc << std::setw(10) << p.sigmaInh
+			<< std::setw(10) << p.amplitudeInh << std::setw(10) << p.amplitudeGlobal
+			<< std::setw(10) << std::setprecision(2) << result.getAccuracy()
+			<< std::setw(14) << (std::to_string(static_cast<int>(result.meanDecisionLatency.count() * 1000)) + " ms")
+			<< std::to_string(static_cast<int>(result.maxDecisionLatency.count() * 1000)) << " ms\n";
+	}
+	return table.str();
+}
@@ -0,0 +1,112 @@
+#include "polling_schedule.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+	PollingSchedule::Clock::duration toPeriod(double frequency)
+	{
+		if (frequency <= 0)
+			return PollingSchedule::Clock::duration::zero();
+		return std::chrono::duration_cast<PollingSchedule::Clock::duration>(std::chrono::duration<double>(1.0 / frequency));
+	}
+}
+
+std::size_t PollingSchedule::add(const PollingTarget& target)
+{
+	if (indices.contains(target.name))
+		throw std::runtime_error("Polling target " + target.name + " is already scheduled.");
+	indices.emplace(target.name, entries.size());
+	entries.push_back({ target, std::nullopt, 0, 0, Clock::time_point() });
+	return entries.size() - 1;
+}
+
+void PollingSchedule::addBoost(const PollingBoost& boost)
+{
+	const auto indexOf = [this](const std::string& name) {
+		const std::optional<std::size_t> index = find(name);
+		if (!index)
+			throw std::runtime_error("Polling boost refers to " + name + ", which is not scheduled.");
+		return *index;
+	};
+	Boost added{ indexOf(boost.trigger), {}, boost.frequency, boost.duration };
+	for (const std::string& target : boost.targets)
+		added.targets.push_back(indexOf(target));
+	boosts.push_back(std::move(added));
+}
+
+std::optional<std::size_t> PollingSchedule::find(const std::string& name) const
+{
+	const auto it = indices.find(name);
+	if (it == indices.end())
+		return std::nullopt;
+	return it->second;
+}
+
+PollingSchedule::Clock::duration PollingSchedule::getPeriod(std::size_t index, Clock::time_point time) const
+{
+	const Entry& entry = entries[index];
+	if (entry.target.frequency <= 0)
+		return Clock::duration::zero();
+	// A boost only ever raises the rate.
+	if (time < entry.boostedUntil && (entry.boostedFrequency <= 0 || entry.boostedFrequency > entry.target.frequency))
+		return toPeriod(entry.boostedFrequency);
+	return toPeriod(entry.target.frequency);
+}
+
+bool PollingSchedule::isDue(std::size_t index, Clock::time_point time) const
+{
+	const Entry& entry = entries[index];
+	return !entry.lastRead || time >= *entry.lastRead + getPeriod(index, time);
+}
+
+std::vector<std::size_t> PollingSchedule::getDue(const std::vector<std::size_t>& candidates, Clock::time_point time) const
+{
+	std::vector<std::size_t> due;
+	for (const std::size_t index : candidates)
+		if (isDue(index, time))
+			due.push_back(index);
+	std::stable_sort(due.begin(), due.end(), [this](std::size_t a, std::size_t b) {
+		return entries[a].target.priority < entries[b].target.priority;
+	});
+	return due;
+}
+
+PollingSchedule::Clock::time_point PollingSchedule::getNextDueTime(const std::vector<std::size_t>& candidates,
+	Clock::time_point time) const
+{
+	std::optional<Clock::time_point> next;
+	for (const std::size_t index : candidates)
+	{
+		const Entry& entry = entries[index];
+		if (!entry.lastRead)
+			return time;
+		const Clock::time_point due = *entry.lastRead + getPeriod(index, time);
+		if (!next || due < *next)
+			next = due;
+	}
+	return next ? std::max(*next, time) : time;
+}
+
+void PollingSchedule::onRead(std::size_t index, int value, Clock::time_point time)
+{
+	Entry& entry = entries[index];
+	entry.lastRead = time;
+	const bool rose = entry.lastValue == 0 && value != 0;
+	entry.lastValue = value;
+	if (!rose)
+		return;
+
+	for (const Boost& boost : boosts)
+	{
+		if (boost.trigger != index)
+			continue;
+		// The period is looked up when a target is next considered, so a pending read comes forward too.
+		for (const std::size_t target : boost.targets)
+		{
+			entries[target].boostedFrequency = boost.frequency;
+			entries[target].boostedUntil = time + boost.duration;
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#include "pose_telemetry.h"
+
+#include <cstring>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+
+PoseTelemetryWriter::PoseTelemetryWriter(std::size_t ringCapacity)
+	: stream(ringCapacity)
+{}
+
+bool PoseTelemetryWriter::open(const std::string& path)
+{
+	PoseTelemetryHeader header{};
+	std::memcpy(header.magic, PoseTelemetryHeader::MAGIC, sizeof(header.magic));
+	header.version = PoseTelemetryHeader::VERSION;
+	header.recordSize = sizeof(PoseTelemetryRecord);
+	header.steadyClockAnchorNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	header.systemClockAnchorNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	return stream.open(path, header);
+}
+
+void PoseTelemetryWriter::record(std::uint64_t sequence, std::chrono::steady_clock::time_point timestamp, const Pose& pose)
+{
+	stream.record({ sequence,
+		std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count(),
+		pose.position.x, pose.position.y, pose.position.z,
+		pose.orientation.alpha, pose.orientation.beta, pose.orientation.gamma });
+}
+
+bool convertPoseTelemetryToCsv(std::istream& input, std::ostream& output)
+{
+	PoseTelemetryHeader header{};
+	if (!input.read(reinterpret_cast<char*>(&header), sizeof(header))
+		|| std::memcmp(header.magic, PoseTelemetryHeader::MAGIC, sizeof(header.magic)) != 0
+		|| header.version != PoseTelemetryHeader::VERSION
+		|| header.recordSize != sizeof(PoseTelemetryRecord))
+		return false;
+
+	output << "sequence,timestamp_ns,system_time_ns,x,y,z,alpha,beta,gamma\n";
+	output << std::setprecision(17);
+	PoseTelemetryRecord record{};
+	while (input.read(reinterpret_cast<char*>(&record), sizeof(record)))
+	{
+		const std::int64_t systemTimeNs = header.systemClockAnchorNs + (record.timestampNs - header.steadyClockAnchorNs);
+		output << record.sequence << ',' << record.timestampNs << ',' << systemTimeNs << ','
+			<< record.x << ',' << record.y << ',' << record.z << ','
+			<< record.alpha << ',' << record.beta << ',' << record.gamma << '\n';
+	}
+	return true;
+}
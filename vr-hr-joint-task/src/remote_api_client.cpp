@@ -0,0 +1,54 @@
+#include "remote_api_client.h"
+
+CoppeliaSimRemoteApiClient::CoppeliaSimRemoteApiClient(const std::string& ip, int port)
+	: client(ip, port)
+{
+	client.setLogMode(coppeliasim_cpp::LogMode::NO_LOGS);
+}
+
+bool CoppeliaSimRemoteApiClient::initialize()
+{
+	return client.initialize();
+}
+
+bool CoppeliaSimRemoteApiClient::isConnected() const
+{
+	return client.isConnected();
+}
+
+void CoppeliaSimRemoteApiClient::startSimulation() const
+{
+	client.startSimulation();
+}
+
+void CoppeliaSimRemoteApiClient::stopSimulation() const
+{
+	client.stopSimulation();
+}
+
+int CoppeliaSimRemoteApiClient::getIntegerSignal(const std::string& signalName) const
+{
+	return client.getIntegerSignal(signalName);
+}
+
+void CoppeliaSimRemoteApiClient::setIntegerSignal(const std::string& signalName, int signalValue) const
+{
+	client.setIntegerSignal(signalName, signalValue);
+}
+
+int CoppeliaSimRemoteApiClient::getObjectHandle(const std::string& objectName) const
+{
+	return client.getObjectHandle(objectName);
+}
+
+Pose CoppeliaSimRemoteApiClient::getObjectPose(int objectHandle) const
+{
+	const coppeliasim_cpp::Pose pose = client.getObjectPose(objectHandle);
+	return { {pose.position.x,
+		pose.position.y,
+		pose.position.z},
+		{pose.orientation.alpha,
+		pose.orientation.beta,
+		pose.orientation.gamma}
+	};
+}
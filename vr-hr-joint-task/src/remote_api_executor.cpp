@@ -0,0 +1,352 @@
+#include "remote_api_executor.h"
+
+#include <algorithm>
+
+RemoteApiResponse execute(const RemoteApiClient& client, const RemoteApiRequest& request)
+{
+	RemoteApiResponse response;
+	switch (request.call)
+	{
+	case RemoteApiCall::START_SIMULATION:
+		client.startSimulation();
+		break;
+	case RemoteApiCall::STOP_SIMULATION:
+		client.stopSimulation();
+		break;
+	case RemoteApiCall::GET_INTEGER_SIGNAL:
+		response.value = client.getIntegerSignal(request.name);
+		break;
+	case RemoteApiCall::SET_INTEGER_SIGNAL:
+		client.setIntegerSignal(request.name, request.value);
+		break;
+	case RemoteApiCall::GET_OBJECT_HANDLE:
+		response.value = client.getObjectHandle(request.name);
+		break;
+	case RemoteApiCall::GET_OBJECT_POSE:
+		response.pose = client.getObjectPose(request.value);
+		break;
+	}
+	return response;
+}
+
+SerialRemoteApiConnection::SerialRemoteApiConnection(std::unique_ptr<RemoteApiClient> client)
+	: client(std::move(client)), stopping(false), worker(&SerialRemoteApiConnection::serve, this)
+{}
+
+SerialRemoteApiConnection::~SerialRemoteApiConnection()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	requestQueued.notify_one();
+	worker.join();
+}
+
+bool SerialRemoteApiConnection::connect()
+{
+	return client->initialize();
+}
+
+bool SerialRemoteApiConnection::isConnected() const
+{
+	return client->isConnected();
+}
+
+void SerialRemoteApiConnection::send(std::uint64_t id, const RemoteApiRequest& request)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		requests.emplace_back(id, request);
+	}
+	requestQueued.notify_one();
+}
+
+void SerialRemoteApiConnection::receive(std::vector<Completion>& responses)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	responses.insert(responses.end(), completed.begin(), completed.end());
+	completed.clear();
+}
+
+void SerialRemoteApiConnection::setWakeup(std::function<void()> function)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	wakeup = std::move(function);
+}
+
+void SerialRemoteApiConnection::serve()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		requestQueued.wait(lock, [this] { return stopping || !requests.empty(); });
+		if (stopping)
+			return;
+		auto [id, request] = std::move(requests.front());
+		requests.pop_front();
+
+		lock.unlock();
+		const RemoteApiResponse response = execute(*client, request);
+		lock.lock();
+
+		completed.emplace_back(id, response);
+		// Under the lock, so the executor can clear it before it goes away.
+		if (wakeup)
+			wakeup();
+	}
+}
+
+RemoteApiExecutor::Request& RemoteApiExecutor::Request::operator=(Request&& other) noexcept
+{
+	if (this != &other)
+	{
+		if (executor)
+			executor->pending.erase(id);
+		executor = std::exchange(other.executor, nullptr);
+		id = other.id;
+		sendTime = other.sendTime;
+	}
+	return *this;
+}
+
+RemoteApiExecutor::Request::~Request()
+{
+	if (executor)
+		executor->pending.erase(id);
+}
+
+bool RemoteApiExecutor::Request::await_ready() const
+{
+	return executor->pending.at(id).response.has_value();
+}
+
+void RemoteApiExecutor::Request::await_suspend(std::coroutine_handle<> awaiting) const
+{
+	executor->pending.at(id).awaiting = awaiting;
+}
+
+RemoteApiResponse RemoteApiExecutor::Request::await_resume()
+{
+	const auto request = executor->pending.find(id);
+	RemoteApiResponse response = std::move(*request->second.response);
+	executor->pending.erase(request);
+	executor = nullptr;
+	return response;
+}
+
+void RemoteApiExecutor::Event::notify()
+{
+	set.store(true, std::memory_order_release);
+	executor.wake();
+}
+
+bool RemoteApiExecutor::Event::Wait::await_ready()
+{
+	notified = event.reset();
+	return notified;
+}
+
+void RemoteApiExecutor::Event::Wait::await_suspend(std::coroutine_handle<> awaiting)
+{
+	event.executor.eventWaiters.push_back({ this, awaiting });
+}
+
+void RemoteApiExecutor::Sleep::await_suspend(std::coroutine_handle<> awaiting) const
+{
+	executor.timers.emplace(until, awaiting);
+}
+
+RemoteApiExecutor::RemoteApiExecutor(std::unique_ptr<PipelinedConnection> connection, std::string name,
+	std::chrono::microseconds spinThreshold)
+	: connection(std::move(connection)),
+	nextRequestId(0),
+	woken(false),
+	spinThreshold(spinThreshold),
+	requestsSent(0),
+	activity(std::move(name))
+{
+	this->connection->setWakeup([this] { wake(); });
+}
+
+RemoteApiExecutor::~RemoteApiExecutor()
+{
+	connection->setWakeup({});
+	// Unfinished tasks hold requests that refer to the executor.
+	tasks.clear();
+}
+
+void RemoteApiExecutor::spawn(Task<void> task)
+{
+	ready.push_back(task.getHandle());
+	tasks.push_back(std::move(task));
+}
+
+void RemoteApiExecutor::run()
+{
+	activity.start();
+	std::exception_ptr failure;
+	while (!tasks.empty())
+	{
+		while (!ready.empty())
+		{
+			const std::coroutine_handle<> coroutine = ready.front();
+			ready.pop_front();
+			coroutine.resume();
+		}
+
+		for (auto task = tasks.begin(); task != tasks.end();)
+		{
+			if (!task->isDone())
+			{
+				++task;
+				continue;
+			}
+			try
+			{
+				task->getResult();
+			}
+			catch (...)
+			{
+				failure = std::current_exception();
+			}
+			task = tasks.erase(task);
+		}
+		if (failure || tasks.empty())
+			break;
+
+		if (!collectReady(Clock::now()))
+		{
+			waitForWork(Clock::now());
+			activity.wakeup();
+		}
+	}
+	activity.finish();
+	if (failure)
+		std::rethrow_exception(failure);
+}
+
+void RemoteApiExecutor::wake()
+{
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		woken.store(true, std::memory_order_release);
+	}
+	wakeCondition.notify_one();
+}
+
+RemoteApiExecutor::Request RemoteApiExecutor::submit(const RemoteApiRequest& request)
+{
+	const std::uint64_t id = nextRequestId++;
+	pending.emplace(id, PendingRequest());
+	const Clock::time_point sendTime = Clock::now();
+	connection->send(id, request);
+	requestsSent.fetch_add(1, std::memory_order_relaxed);
+	return { *this, id, sendTime };
+}
+
+bool RemoteApiExecutor::collectReady(Clock::time_point now)
+{
+	responses.clear();
+	connection->receive(responses);
+	for (auto& [id, response] : responses)
+	{
+		const auto request = pending.find(id);
+		// Abandoned.
+		if (request == pending.end())
+			continue;
+		request->second.response = std::move(response);
+		if (request->second.awaiting)
+			ready.push_back(std::exchange(request->second.awaiting, {}));
+	}
+
+	for (auto timer = timers.begin(); timer != timers.end() && timer->first <= now; timer = timers.erase(timer))
+		ready.push_back(timer->second);
+
+	std::erase_if(eventWaiters, [&](const EventWaiter& waiter) {
+		waiter.wait->notified = waiter.wait->event.reset();
+		if (!waiter.wait->notified && waiter.wait->deadline > now)
+			return false;
+		ready.push_back(waiter.awaiting);
+		return true;
+	});
+
+	return !ready.empty();
+}
+
+void RemoteApiExecutor::waitForWork(Clock::time_point now)
+{
+	std::optional<Clock::time_point> deadline = connection->getNextResponseTime();
+	const auto until = [&](Clock::time_point time) {
+		if (!deadline || time < *deadline)
+			deadline = time;
+	};
+	if (!timers.empty())
+		until(timers.begin()->first);
+	for (const EventWaiter& waiter : eventWaiters)
+		until(waiter.wait->deadline);
+
+	{
+		std::unique_lock<std::mutex> lock(wakeMutex);
+		const auto isWoken = [this] { return woken.load(std::memory_order_acquire); };
+		if (!deadline)
+			wakeCondition.wait(lock, isWoken);
+		else if (*deadline - now > spinThreshold)
+			wakeCondition.wait_until(lock, *deadline - spinThreshold, isWoken);
+	}
+	// Only with an opt-in spinThreshold.
+	if (deadline && spinThreshold.count() > 0)
+		while (!woken.load(std::memory_order_acquire) && Clock::now() < *deadline)
+		{}
+	// What woke us is picked up by the next collectReady(), even if another wake lands in between.
+	woken.store(false, std::memory_order_relaxed);
+}
+
+Task<bool> AsyncRemoteApiClient::connect(const std::atomic<bool>& stopRequested)
+{
+	std::chrono::milliseconds delay = backoff.initialDelay;
+	while (!executor.getConnection().connect())
+	{
+		if (stopRequested.load(std::memory_order_relaxed))
+			co_return false;
+		co_await executor.sleepFor(delay);
+		delay = std::min(delay * 2, backoff.maxDelay);
+	}
+	co_return true;
+}
+
+Task<void> AsyncRemoteApiClient::startSimulation()
+{
+	co_await executor.submit({ RemoteApiCall::START_SIMULATION });
+}
+
+Task<void> AsyncRemoteApiClient::stopSimulation()
+{
+	co_await executor.submit({ RemoteApiCall::STOP_SIMULATION });
+}
+
+Task<int> AsyncRemoteApiClient::getObjectHandle(std::string objectName)
+{
+	const RemoteApiResponse response = co_await executor.submit({ RemoteApiCall::GET_OBJECT_HANDLE, std::move(objectName) });
+	co_return response.value;
+}
+
+RemoteApiExecutor::Request AsyncRemoteApiClient::getIntegerSignal(std::string signalName)
+{
+	return executor.submit({ RemoteApiCall::GET_INTEGER_SIGNAL, std::move(signalName) });
+}
+
+RemoteApiExecutor::Request AsyncRemoteApiClient::readPose(int objectHandle)
+{
+	return executor.submit({ RemoteApiCall::GET_OBJECT_POSE, {}, objectHandle });
+}
+
+Task<void> AsyncRemoteApiClient::writeSignals(std::vector<std::pair<std::string, int>> signals)
+{
+	std::vector<RemoteApiExecutor::Request> writes;
+	writes.reserve(signals.size());
+	for (auto& [name, value] : signals)
+		writes.push_back(executor.submit({ RemoteApiCall::SET_INTEGER_SIGNAL, std::move(name), value }));
+	for (RemoteApiExecutor::Request& write : writes)
+		co_await write;
+}
@@ -0,0 +1,40 @@
+#include "seeded_normal_noise.h"
+
+#include <cmath>
+
+SeededNormalNoise::SeededNormalNoise(const dnf_composer::element::ElementCommonParameters& elementCommonParameters,
+	const dnf_composer::element::NormalNoiseParameters& parameters, std::uint64_t seed)
+	: NormalNoise(elementCommonParameters, parameters), seed(seed), engine(seed)
+{}
+
+void SeededNormalNoise::init()
+{
+	NormalNoise::init();
+	engine.seed(seed);
+	distribution.reset();
+}
+
+void SeededNormalNoise::step(double t, double deltaT)
+{
+	// Same scaling as NormalNoise: amplitude / sqrt(deltaT) times a standard normal sample per position.
+	const double scale = getParameters().amplitude / std::sqrt(deltaT);
+	std::vector<double>& output = *getComponentPtr("output");
+	for (double& value : output)
+		value = scale * distribution(engine);
+}
+
+std::shared_ptr<dnf_composer::element::Element> SeededNormalNoise::clone() const
+{
+	return std::make_shared<SeededNormalNoise>(*this);
+}
+
+std::uint64_t SeededNormalNoise::deriveSeed(std::uint64_t seed, const std::string& elementName)
+{
+	std::uint64_t hash = 14695981039346656037ull;
+	for (const char c : elementName)
+	{
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ull;
+	}
+	return seed ^ hash;
+}
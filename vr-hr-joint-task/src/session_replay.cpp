@@ -0,0 +1,55 @@
+#include "session_replay.h"
+
+#include "dnf_composer_handler.h"
+#include "hand_kinematics.h"
+
+SessionReplayResult replaySession(const SessionTrace& trace, DnfArchitectureOptions options)
+{
+	if (!options.noiseSeed)
+		options.noiseSeed = trace.getNoiseSeed();
+	DnfComposerHandler dnfComposerHandler(trace.getArchitectureType(), trace.header.deltaT,
+		{ false, SteppingMode::AS_FAST_AS_POSSIBLE, options });
+
+	HandKinematicsEstimator handKinematics;
+	SessionReplayResult result;
+	result.targetObjects.reserve(trace.records.size());
+
+	const auto start = std::chrono::steady_clock::now();
+	dnfComposerHandler.initSimulation();
+	std::size_t next = 0;
+	while (next < trace.records.size())
+	{
+		// Same order as the control loop: hand stimulus, available objects, target decision.
+		for (; next < trace.records.size() && trace.records[next].dnfStep <= result.steps; ++next)
+		{
+			const SessionTraceRecord& record = trace.records[next];
+			IncomingSignals signals;
+			IncomingSignalsSnapshot::unpack(record.incomingSignals, signals);
+
+			const ObjectSignals objects = decodeObjectSignals(signals);
+			const auto toTimePoint = [](std::int64_t ns) {
+				return std::chrono::steady_clock::time_point(
+					std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(ns)));
+			};
+
+			// The estimator sees the samples the live one saw, so it estimates the same hand state.
+			handKinematics.update(record.handPoseSequence, toTimePoint(record.handPoseTimestampNs), { record.x, record.y, record.z });
+			dnfComposerHandler.setHandStimulus(handKinematics.estimateAt(toTimePoint(record.timestampNs)), objects.present);
+			dnfComposerHandler.setAvailableObjectsInTheWorkspace(objects.present);
+			const int targetObject = dnfComposerHandler.getTargetObject();
+
+			result.targetObjects.push_back(targetObject);
+			if (targetObject != record.targetObject)
+				++result.targetMismatches;
+		}
+		if (next == trace.records.size())
+			break;
+		dnfComposerHandler.stepSimulation();
+		++result.steps;
+	}
+	result.finalActivation = dnfComposerHandler.getActionExecutionActivation();
+	dnfComposerHandler.closeSimulation();
+	result.wallTime = std::chrono::steady_clock::now() - start;
+	result.simulatedTime = std::chrono::duration<double, std::milli>(result.steps * trace.header.deltaT);
+	return result;
+}
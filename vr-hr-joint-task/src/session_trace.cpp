@@ -0,0 +1,72 @@
+#include "session_trace.h"
+
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+
+namespace
+{
+	std::int64_t toNanoseconds(std::chrono::steady_clock::time_point time)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+	}
+}
+
+std::optional<std::uint64_t> SessionTrace::getNoiseSeed() const
+{
+	if (!header.hasNoiseSeed)
+		return std::nullopt;
+	return header.noiseSeed;
+}
+
+SessionRecorder::SessionRecorder(std::size_t ringCapacity)
+	: stream(ringCapacity)
+{}
+
+bool SessionRecorder::open(const std::string& path, DnfArchitectureType architecture, double deltaT, std::optional<std::uint64_t> noiseSeed)
+{
+	SessionTraceHeader header{};
+	std::memcpy(header.magic, SessionTraceHeader::MAGIC, sizeof(header.magic));
+	header.version = SessionTraceHeader::VERSION;
+	header.recordSize = sizeof(SessionTraceRecord);
+	header.architecture = static_cast<std::uint32_t>(architecture);
+	header.hasNoiseSeed = noiseSeed.has_value();
+	header.noiseSeed = noiseSeed.value_or(0);
+	header.deltaT = deltaT;
+	header.steadyClockAnchorNs = toNanoseconds(std::chrono::steady_clock::now());
+	return stream.open(path, header);
+}
+
+void SessionRecorder::record(std::uint64_t dnfStep, std::chrono::steady_clock::time_point timestamp,
+	const Snapshot<Pose>& handPose, const IncomingSignals& incomingSignals, int targetObject)
+{
+	const Pose& pose = handPose.value;
+	stream.record({ dnfStep, toNanoseconds(timestamp), handPose.sequence, toNanoseconds(handPose.captureTime),
+		pose.position.x, pose.position.y, pose.position.z,
+		pose.orientation.alpha, pose.orientation.beta, pose.orientation.gamma,
+		IncomingSignalsSnapshot::pack(incomingSignals), targetObject });
+}
+
+SessionTrace readSessionTrace(std::istream& input)
+{
+	SessionTrace trace{};
+	if (!input.read(reinterpret_cast<char*>(&trace.header), sizeof(trace.header))
+		|| std::memcmp(trace.header.magic, SessionTraceHeader::MAGIC, sizeof(trace.header.magic)) != 0)
+		throw std::runtime_error("Not a session trace.");
+	if (trace.header.version != SessionTraceHeader::VERSION || trace.header.recordSize != sizeof(SessionTraceRecord))
+		throw std::runtime_error("Unsupported session trace version " + std::to_string(trace.header.version) + ".");
+
+	SessionTraceRecord record{};
+	while (input.read(reinterpret_cast<char*>(&record), sizeof(record)))
+		trace.records.push_back(record);
+	return trace;
+}
+
+SessionTrace readSessionTrace(const std::string& path)
+{
+	std::ifstream input(path, std::ifstream::binary);
+	if (!input.is_open())
+		throw std::runtime_error("Could not open " + path + ".");
+	return readSessionTrace(input);
+}
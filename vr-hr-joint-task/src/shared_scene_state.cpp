@@ -0,0 +1,215 @@
+#include "shared_scene_state.h"
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	std::string getSystemName(const std::string& name)
+	{
+#ifdef _WIN32
+		return "Local\\" + name;
+#else
+		return "/" + name;
+#endif
+	}
+
+	std::runtime_error makeError(const std::string& what, const std::string& name)
+	{
+#ifdef _WIN32
+		return std::runtime_error(what + " shared memory region " + name + " (error " + std::to_string(GetLastError()) + ").");
+#else
+		return std::runtime_error(what + " shared memory region " + name + ": " + std::strerror(errno) + ".");
+#endif
+	}
+}
+
+SharedMemoryRegion::SharedMemoryRegion(std::string name, bool owner)
+	: name(std::move(name)), address(nullptr), size(0), owner(owner)
+#ifdef _WIN32
+	, mapping(nullptr)
+#endif
+{}
+
+std::unique_ptr<SharedMemoryRegion> SharedMemoryRegion::create(const std::string& name, std::size_t size)
+{
+	std::unique_ptr<SharedMemoryRegion> region(new SharedMemoryRegion(name, true));
+	const std::string systemName = getSystemName(name);
+#ifdef _WIN32
+	// A region still mapped by another process is reused rather than replaced.
+	region->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		static_cast<DWORD>(static_cast<std::uint64_t>(size) >> 32), static_cast<DWORD>(size), systemName.c_str());
+	if (!region->mapping)
+		throw makeError("Could not create", name);
+	region->address = MapViewOfFile(region->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (!region->address)
+		throw makeError("Could not map", name);
+#else
+	shm_unlink(systemName.c_str());
+	const int descriptor = shm_open(systemName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (descriptor < 0)
+		throw makeError("Could not create", name);
+	if (ftruncate(descriptor, static_cast<off_t>(size)) != 0)
+	{
+		const std::runtime_error error = makeError("Could not size", name);
+		close(descriptor);
+		shm_unlink(systemName.c_str());
+		throw error;
+	}
+	void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	close(descriptor);
+	if (address == MAP_FAILED)
+	{
+		const std::runtime_error error = makeError("Could not map", name);
+		shm_unlink(systemName.c_str());
+		throw error;
+	}
+	region->address = address;
+#endif
+	region->size = size;
+	return region;
+}
+
+std::unique_ptr<SharedMemoryRegion> SharedMemoryRegion::open(const std::string& name)
+{
+	std::unique_ptr<SharedMemoryRegion> region(new SharedMemoryRegion(name, false));
+	const std::string systemName = getSystemName(name);
+#ifdef _WIN32
+	region->mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, systemName.c_str());
+	if (!region->mapping)
+	{
+		if (GetLastError() == ERROR_FILE_NOT_FOUND)
+			return nullptr;
+		throw makeError("Could not open", name);
+	}
+	region->address = MapViewOfFile(region->mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	if (!region->address)
+		throw makeError("Could not map", name);
+	MEMORY_BASIC_INFORMATION information;
+	VirtualQuery(region->address, &information, sizeof(information));
+	region->size = information.RegionSize;
+#else
+	const int descriptor = shm_open(systemName.c_str(), O_RDWR, 0);
+	if (descriptor < 0)
+	{
+		if (errno == ENOENT)
+			return nullptr;
+		throw makeError("Could not open", name);
+	}
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+	{
+		// Created but not sized yet.
+		close(descriptor);
+		return nullptr;
+	}
+	const std::size_t size = static_cast<std::size_t>(status.st_size);
+	void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	close(descriptor);
+	if (address == MAP_FAILED)
+		throw makeError("Could not map", name);
+	region->address = address;
+	region->size = size;
+#endif
+	return region;
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+#ifdef _WIN32
+	if (address)
+		UnmapViewOfFile(address);
+	if (mapping)
+		CloseHandle(mapping);
+#else
+	if (address)
+		munmap(address, size);
+	if (owner)
+		shm_unlink(getSystemName(name).c_str());
+#endif
+}
+
+SharedSceneServer::SharedSceneServer(const std::string& name)
+	: region(SharedMemoryRegion::create(name, sizeof(SharedSceneState))),
+	state(new (region->getAddress()) SharedSceneState())
+{
+	state->open.store(1, std::memory_order_relaxed);
+	beat();
+	state->magic.store(SharedSceneState::MAGIC, std::memory_order_release);
+}
+
+void SharedSceneServer::beat()
+{
+	const auto now = std::chrono::steady_clock::now().time_since_epoch();
+	state->heartbeat.store(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(), std::memory_order_release);
+}
+
+SharedSceneServer::~SharedSceneServer()
+{
+	close();
+}
+
+SharedSceneClient::SharedSceneClient(std::string name, std::chrono::steady_clock::duration livenessTimeout)
+	: name(std::move(name)), livenessTimeout(livenessTimeout), state(nullptr)
+{}
+
+bool SharedSceneClient::connect()
+{
+	const SharedSceneState* current = state.load(std::memory_order_acquire);
+	if (current && isAlive(*current))
+		return true;
+	std::unique_ptr<SharedMemoryRegion> mapped = SharedMemoryRegion::open(name);
+	if (!mapped)
+		return false;
+	constexpr std::size_t headerSize = 4 * sizeof(std::uint32_t);
+	if (mapped->getSize() < headerSize)
+		throw std::runtime_error("Shared memory region " + name + " is too small for a shared scene.");
+
+	SharedSceneState* candidate = static_cast<SharedSceneState*>(mapped->getAddress());
+	// Still being laid out.
+	if (candidate->magic.load(std::memory_order_acquire) != SharedSceneState::MAGIC)
+		return false;
+	if (candidate->version != SharedSceneState::VERSION || candidate->size != sizeof(SharedSceneState)
+		|| mapped->getSize() < sizeof(SharedSceneState))
+		throw std::runtime_error("Shared scene " + name + " has layout version " + std::to_string(candidate->version)
+			+ " (" + std::to_string(candidate->size) + " bytes), expected version " + std::to_string(SharedSceneState::VERSION)
+			+ " (" + std::to_string(sizeof(SharedSceneState)) + " bytes).");
+	// Left behind by a simulator that went away; the next one replaces it.
+	if (!isAlive(*candidate))
+		return false;
+
+	// The previous mapping stays for the lifetime of the client, other threads may be reading it.
+	if (region)
+		retiredRegions.push_back(std::move(region));
+	region = std::move(mapped);
+	state.store(candidate, std::memory_order_release);
+	return true;
+}
+
+bool SharedSceneClient::isConnected() const
+{
+	const SharedSceneState* current = state.load(std::memory_order_acquire);
+	return current && isAlive(*current);
+}
+
+bool SharedSceneClient::isAlive(const SharedSceneState& candidate) const
+{
+	if (candidate.open.load(std::memory_order_acquire) == 0)
+		return false;
+	const std::chrono::steady_clock::time_point heartbeat(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::nanoseconds(candidate.heartbeat.load(std::memory_order_acquire))));
+	return std::chrono::steady_clock::now() - heartbeat <= livenessTimeout;
+}
@@ -0,0 +1,500 @@
+#include "simulated_coppeliasim.h"
+
+#include "coppeliasim_handler.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace
+{
+	constexpr const char* callNames[SimulatedCoppeliaSim::NUMBER_OF_CALLS] = {
+		"startSimulation", "stopSimulation", "getIntegerSignal", "setIntegerSignal", "getObjectHandle", "getObjectPose",
+	};
+
+	std::int64_t toNanoseconds(std::chrono::steady_clock::time_point time)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+	}
+
+	double toMilliseconds(std::chrono::nanoseconds duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	Pose interpolate(const Pose& a, const Pose& b, double weight)
+	{
+		const auto lerp = [weight](double from, double to) { return from + weight * (to - from); };
+		return { { lerp(a.position.x, b.position.x), lerp(a.position.y, b.position.y), lerp(a.position.z, b.position.z) },
+			{ lerp(a.orientation.alpha, b.orientation.alpha), lerp(a.orientation.beta, b.orientation.beta),
+				lerp(a.orientation.gamma, b.orientation.gamma) } };
+	}
+}
+
+std::chrono::nanoseconds SceneScript::getDuration() const
+{
+	std::chrono::nanoseconds duration(0);
+	for (const auto& [name, trajectory] : trajectories)
+		if (!trajectory.empty())
+			duration = std::max(duration, trajectory.back().time);
+	for (const SignalKeyframe& keyframe : signals)
+		duration = std::max(duration, keyframe.time);
+	return duration;
+}
+
+SceneScript makeSceneScript(const SessionTrace& trace, const std::string& handObjectName)
+{
+	SceneScript script;
+	if (trace.records.empty())
+		return script;
+
+	const std::int64_t origin = trace.records.front().timestampNs;
+	std::vector<PoseKeyframe>& hand = script.trajectories[handObjectName];
+	std::uint64_t lastSequence = 0;
+	std::int32_t lastSignals = 0;
+	for (const SessionTraceRecord& record : trace.records)
+	{
+		// A sample spans as many control passes as it took to replace it.
+		if (record.handPoseSequence != 0 && record.handPoseSequence != lastSequence)
+		{
+			const std::chrono::nanoseconds time(std::max<std::int64_t>(record.handPoseTimestampNs - origin, 0));
+			if (hand.empty() || time > hand.back().time)
+				hand.push_back({ time, { { record.x, record.y, record.z }, { record.alpha, record.beta, record.gamma } } });
+			lastSequence = record.handPoseSequence;
+		}
+		if (script.signals.empty() || record.incomingSignals != lastSignals)
+		{
+			script.signals.push_back({ std::chrono::nanoseconds(std::max<std::int64_t>(record.timestampNs - origin, 0)),
+				IncomingSignalsSnapshot::SIGNAL, record.incomingSignals });
+			lastSignals = record.incomingSignals;
+		}
+	}
+	return script;
+}
+
+SimulatedCoppeliaSim::SimulatedCoppeliaSim(SceneScript script)
+	: script(std::move(script)), scriptDuration(0), nextSignalKeyframe(0), lastScriptTime(0), running(false),
+	serviceTime(0), open(true), firstRequestNs(0), lastRequestNs(0)
+{
+	std::stable_sort(this->script.signals.begin(), this->script.signals.end(),
+		[](const SignalKeyframe& a, const SignalKeyframe& b) { return a.time < b.time; });
+	scriptDuration = this->script.getDuration();
+}
+
+int SimulatedCoppeliaSim::addObject(const std::string& name, const Pose& pose)
+{
+	std::lock_guard lock(mutex);
+	const auto [it, added] = handles.try_emplace(name, static_cast<int>(handles.size()) + 1);
+	const int handle = it->second;
+	poses[handle] = pose;
+	const auto trajectory = script.trajectories.find(name);
+	if (trajectory != script.trajectories.end() && !trajectory->second.empty())
+		trajectories[handle] = &trajectory->second;
+	return handle;
+}
+
+void SimulatedCoppeliaSim::setSignal(const std::string& name, int value)
+{
+	std::lock_guard lock(mutex);
+	signals[name] = value;
+}
+
+int SimulatedCoppeliaSim::getSignal(const std::string& name) const
+{
+	std::lock_guard lock(mutex);
+	const auto it = signals.find(name);
+	return it == signals.end() ? 0 : it->second;
+}
+
+void SimulatedCoppeliaSim::start(Clock::time_point time)
+{
+	std::lock_guard lock(mutex);
+	if (running)
+		return;
+	running = true;
+	startTime = time;
+	nextSignalKeyframe = 0;
+	scriptedSignals.clear();
+	lastScriptTime = std::chrono::nanoseconds(0);
+}
+
+void SimulatedCoppeliaSim::stop()
+{
+	std::lock_guard lock(mutex);
+	running = false;
+}
+
+bool SimulatedCoppeliaSim::isRunning() const
+{
+	std::lock_guard lock(mutex);
+	return running;
+}
+
+void SimulatedCoppeliaSim::setServiceTime(std::chrono::nanoseconds serviceTime)
+{
+	std::lock_guard lock(mutex);
+	this->serviceTime = serviceTime;
+}
+
+void SimulatedCoppeliaSim::recordServedValues(const std::string& name)
+{
+	std::lock_guard lock(mutex);
+	servedValues.try_emplace(name);
+}
+
+std::vector<int> SimulatedCoppeliaSim::getServedValues(const std::string& name) const
+{
+	std::lock_guard lock(mutex);
+	const auto it = servedValues.find(name);
+	return it == servedValues.end() ? std::vector<int>() : it->second;
+}
+
+SimulatedCoppeliaSim::Clock::time_point SimulatedCoppeliaSim::reserveService(Clock::time_point arrival)
+{
+	std::lock_guard lock(mutex);
+	if (serviceTime.count() == 0)
+		return arrival;
+	busyUntil = std::max(arrival, busyUntil) + serviceTime;
+	return busyUntil;
+}
+
+int SimulatedCoppeliaSim::serveGetIntegerSignal(const std::string& name, Clock::time_point time)
+{
+	std::lock_guard lock(mutex);
+	advanceScript(time);
+	const auto it = signals.find(name);
+	const int value = it == signals.end() ? 0 : it->second;
+	if (const auto served = servedValues.find(name); served != servedValues.end())
+		served->second.push_back(value);
+	return value;
+}
+
+void SimulatedCoppeliaSim::serveSetIntegerSignal(const std::string& name, int value, Clock::time_point time)
+{
+	std::lock_guard lock(mutex);
+	advanceScript(time);
+	signals[name] = value;
+}
+
+int SimulatedCoppeliaSim::serveGetObjectHandle(const std::string& name) const
+{
+	std::lock_guard lock(mutex);
+	const auto it = handles.find(name);
+	return it == handles.end() ? -1 : it->second;
+}
+
+Pose SimulatedCoppeliaSim::serveGetObjectPose(int handle, Clock::time_point time)
+{
+	std::lock_guard lock(mutex);
+	const std::chrono::nanoseconds scriptTime = advanceScript(time);
+	const auto trajectory = trajectories.find(handle);
+	if (trajectory != trajectories.end())
+		return samplePose(*trajectory->second, scriptTime);
+	const auto it = poses.find(handle);
+	return it == poses.end() ? Pose() : it->second;
+}
+
+void SimulatedCoppeliaSim::recordCall(RemoteApiCall call, Clock::duration latency, Clock::time_point end)
+{
+	latencies[static_cast<std::size_t>(call)].record(latency);
+	const std::int64_t endNs = toNanoseconds(end);
+	std::int64_t first = 0;
+	firstRequestNs.compare_exchange_strong(first, endNs, std::memory_order_relaxed);
+	std::int64_t last = lastRequestNs.load(std::memory_order_relaxed);
+	while (endNs > last && !lastRequestNs.compare_exchange_weak(last, endNs, std::memory_order_relaxed))
+	{}
+}
+
+std::uint64_t SimulatedCoppeliaSim::getNumberOfRequests() const
+{
+	std::uint64_t requests = 0;
+	for (const LatencyHistogram& latency : latencies)
+		requests += latency.getCount();
+	return requests;
+}
+
+double SimulatedCoppeliaSim::getRequestRate() const
+{
+	const double window = static_cast<double>(lastRequestNs.load(std::memory_order_relaxed)
+		- firstRequestNs.load(std::memory_order_relaxed)) * 1e-9;
+	return window > 0 ? static_cast<double>(getNumberOfRequests()) / window : 0.0;
+}
+
+std::string SimulatedCoppeliaSim::getReport() const
+{
+	std::stringstream ss;
+	ss << "Simulated CoppeliaSim: requests = " << getNumberOfRequests() << ", " << getRequestRate() << " requests/s";
+	for (std::size_t call = 0; call < NUMBER_OF_CALLS; ++call)
+	{
+		const LatencyHistogram& latency = latencies[call];
+		if (latency.getCount() == 0)
+			continue;
+		ss << "\n  " << callNames[call] << ": calls = " << latency.getCount()
+			<< ", p50 = " << toMilliseconds(latency.getPercentile(50)) << " ms"
+			<< ", p99 = " << toMilliseconds(latency.getPercentile(99)) << " ms"
+			<< ", max = " << toMilliseconds(latency.getMax()) << " ms";
+	}
+	return ss.str();
+}
+
+std::chrono::nanoseconds SimulatedCoppeliaSim::advanceScript(Clock::time_point time)
+{
+	// A stopped scene holds where it was.
+	if (!running)
+		return lastScriptTime;
+	if (time < startTime)
+		return std::chrono::nanoseconds(0);
+
+	std::chrono::nanoseconds scriptTime = time - startTime;
+	if (script.loop && scriptDuration.count() > 0)
+		scriptTime %= scriptDuration;
+	// Wrapped around, play the timeline again.
+	if (scriptTime < lastScriptTime)
+	{
+		nextSignalKeyframe = 0;
+		scriptedSignals.clear();
+	}
+	lastScriptTime = scriptTime;
+
+	for (; nextSignalKeyframe < script.signals.size() && script.signals[nextSignalKeyframe].time <= scriptTime; ++nextSignalKeyframe)
+		scriptedSignals[script.signals[nextSignalKeyframe].signal] = script.signals[nextSignalKeyframe].value;
+	for (const auto& [name, value] : scriptedSignals)
+		signals[name] = value;
+	return scriptTime;
+}
+
+Pose SimulatedCoppeliaSim::samplePose(const std::vector<PoseKeyframe>& trajectory, std::chrono::nanoseconds time)
+{
+	const auto after = std::upper_bound(trajectory.begin(), trajectory.end(), time,
+		[](std::chrono::nanoseconds t, const PoseKeyframe& keyframe) { return t < keyframe.time; });
+	if (after == trajectory.begin())
+		return trajectory.front().pose;
+	if (after == trajectory.end())
+		return trajectory.back().pose;
+	const auto before = after - 1;
+	const double weight = std::chrono::duration<double>(time - before->time).count()
+		/ std::chrono::duration<double>(after->time - before->time).count();
+	return interpolate(before->pose, after->pose, weight);
+}
+
+SimulatedRemoteApiClient::SimulatedRemoteApiClient(SimulatedCoppeliaSim& scene, const SimulatedConnectionParameters& parameters)
+	: scene(scene), parameters(parameters), random(parameters.seed), connected(false)
+{}
+
+template<typename Request>
+auto SimulatedRemoteApiClient::roundTrip(RemoteApiCall call, Request&& request) const
+{
+	using Clock = SimulatedCoppeliaSim::Clock;
+
+	std::chrono::nanoseconds latency = parameters.roundTripTime;
+	if (parameters.jitter.count() > 0)
+		latency += std::chrono::nanoseconds(std::uniform_int_distribution<std::int64_t>(0, parameters.jitter.count())(random));
+
+	const Clock::time_point start = Clock::now();
+	waitFor(latency / 2);
+	waitFor(scene.reserveService(Clock::now()) - Clock::now());
+	auto result = request(Clock::now());
+	waitFor(latency - latency / 2);
+	const Clock::time_point end = Clock::now();
+	scene.recordCall(call, end - start, end);
+	return result;
+}
+
+bool SimulatedRemoteApiClient::initialize()
+{
+	connected.store(scene.isOpen(), std::memory_order_relaxed);
+	return isConnected();
+}
+
+bool SimulatedRemoteApiClient::isConnected() const
+{
+	return connected.load(std::memory_order_relaxed) && scene.isOpen();
+}
+
+void SimulatedRemoteApiClient::startSimulation() const
+{
+	roundTrip(RemoteApiCall::START_SIMULATION, [this](SimulatedCoppeliaSim::Clock::time_point time) {
+		scene.start(time);
+		return 0;
+	});
+}
+
+void SimulatedRemoteApiClient::stopSimulation() const
+{
+	roundTrip(RemoteApiCall::STOP_SIMULATION, [this](SimulatedCoppeliaSim::Clock::time_point) {
+		scene.stop();
+		return 0;
+	});
+}
+
+int SimulatedRemoteApiClient::getIntegerSignal(const std::string& signalName) const
+{
+	return roundTrip(RemoteApiCall::GET_INTEGER_SIGNAL, [&](SimulatedCoppeliaSim::Clock::time_point time) {
+		return scene.serveGetIntegerSignal(signalName, time);
+	});
+}
+
+void SimulatedRemoteApiClient::setIntegerSignal(const std::string& signalName, int signalValue) const
+{
+	roundTrip(RemoteApiCall::SET_INTEGER_SIGNAL, [&](SimulatedCoppeliaSim::Clock::time_point time) {
+		scene.serveSetIntegerSignal(signalName, signalValue, time);
+		return 0;
+	});
+}
+
+int SimulatedRemoteApiClient::getObjectHandle(const std::string& objectName) const
+{
+	return roundTrip(RemoteApiCall::GET_OBJECT_HANDLE, [&](SimulatedCoppeliaSim::Clock::time_point) {
+		return scene.serveGetObjectHandle(objectName);
+	});
+}
+
+Pose SimulatedRemoteApiClient::getObjectPose(int objectHandle) const
+{
+	return roundTrip(RemoteApiCall::GET_OBJECT_POSE, [&](SimulatedCoppeliaSim::Clock::time_point time) {
+		return scene.serveGetObjectPose(objectHandle, time);
+	});
+}
+
+void SimulatedRemoteApiClient::waitFor(std::chrono::nanoseconds duration)
+{
+	// Sleep granularity is far coarser than a loopback round trip: sleep the bulk, spin the rest.
+	constexpr std::chrono::microseconds spinThreshold(200);
+	const auto until = SimulatedCoppeliaSim::Clock::now() + duration;
+	if (duration > spinThreshold)
+		std::this_thread::sleep_until(until - spinThreshold);
+	while (SimulatedCoppeliaSim::Clock::now() < until)
+	{}
+}
+
+SimulatedPipelinedConnection::SimulatedPipelinedConnection(SimulatedCoppeliaSim& scene, const SimulatedConnectionParameters& parameters)
+	: scene(scene), parameters(parameters), random(parameters.seed), connected(false), served(0)
+{}
+
+bool SimulatedPipelinedConnection::connect()
+{
+	connected.store(scene.isOpen(), std::memory_order_relaxed);
+	return isConnected();
+}
+
+bool SimulatedPipelinedConnection::isConnected() const
+{
+	return connected.load(std::memory_order_relaxed) && scene.isOpen();
+}
+
+void SimulatedPipelinedConnection::send(std::uint64_t id, const RemoteApiRequest& request)
+{
+	const Clock::time_point now = Clock::now();
+	std::chrono::nanoseconds latency = parameters.roundTripTime;
+	if (parameters.jitter.count() > 0)
+		latency += std::chrono::nanoseconds(std::uniform_int_distribution<std::int64_t>(0, parameters.jitter.count())(random));
+	const Clock::time_point serveTime = scene.reserveService(now + latency / 2);
+	Clock::time_point responseTime = serveTime + (latency - latency / 2);
+	if (!inFlight.empty())
+		responseTime = std::max(responseTime, inFlight.back().responseTime);
+	inFlight.push_back({ id, request, now, serveTime, responseTime, {} });
+}
+
+void SimulatedPipelinedConnection::receive(std::vector<Completion>& responses)
+{
+	const Clock::time_point now = Clock::now();
+	// Served when due rather than at the due time, so the scene only ever moves forward.
+	for (; served < inFlight.size() && inFlight[served].serveTime <= now; ++served)
+		inFlight[served].response = serve(inFlight[served].request, now);
+
+	while (served > 0 && inFlight.front().responseTime <= now)
+	{
+		const InFlight& request = inFlight.front();
+		scene.recordCall(request.request.call, now - request.sendTime, now);
+		responses.emplace_back(request.id, request.response);
+		inFlight.pop_front();
+		--served;
+	}
+}
+
+std::optional<PipelinedConnection::Clock::time_point> SimulatedPipelinedConnection::getNextResponseTime() const
+{
+	if (inFlight.empty())
+		return std::nullopt;
+	if (served < inFlight.size())
+		return std::min(inFlight[served].serveTime, inFlight.front().responseTime);
+	return inFlight.front().responseTime;
+}
+
+RemoteApiResponse SimulatedPipelinedConnection::serve(const RemoteApiRequest& request, Clock::time_point time)
+{
+	RemoteApiResponse response;
+	switch (request.call)
+	{
+	case RemoteApiCall::START_SIMULATION:
+		scene.start(time);
+		break;
+	case RemoteApiCall::STOP_SIMULATION:
+		scene.stop();
+		break;
+	case RemoteApiCall::GET_INTEGER_SIGNAL:
+		response.value = scene.serveGetIntegerSignal(request.name, time);
+		break;
+	case RemoteApiCall::SET_INTEGER_SIGNAL:
+		scene.serveSetIntegerSignal(request.name, request.value, time);
+		break;
+	case RemoteApiCall::GET_OBJECT_HANDLE:
+		response.value = scene.serveGetObjectHandle(request.name);
+		break;
+	case RemoteApiCall::GET_OBJECT_POSE:
+		response.pose = scene.serveGetObjectPose(request.value, time);
+		break;
+	}
+	return response;
+}
+
+SimulatedSharedSceneServer::SimulatedSharedSceneServer(SimulatedCoppeliaSim& scene, const std::string& name,
+	const SimulatedSharedSceneParameters& parameters)
+	: scene(scene), parameters(parameters), server(name), stopping(false), steps(0),
+	thread(&SimulatedSharedSceneServer::run, this)
+{}
+
+SimulatedSharedSceneServer::~SimulatedSharedSceneServer()
+{
+	close();
+}
+
+void SimulatedSharedSceneServer::close()
+{
+	hang();
+	server.close();
+}
+
+void SimulatedSharedSceneServer::hang()
+{
+	stopping.store(true, std::memory_order_relaxed);
+	if (thread.joinable())
+		thread.join();
+}
+
+void SimulatedSharedSceneServer::run()
+{
+	SharedSceneState& state = server.getState();
+	const int hand = scene.serveGetObjectHandle(parameters.handObjectName);
+	std::uint64_t outgoingSequence = 0;
+
+	auto stepTime = SimulatedCoppeliaSim::Clock::now();
+	while (!stopping.load(std::memory_order_relaxed))
+	{
+		const auto now = SimulatedCoppeliaSim::Clock::now();
+		if (state.outgoingSignals.getSequence() != outgoingSequence)
+		{
+			const Snapshot<SharedOutgoingSignals> outgoing = state.outgoingSignals.read();
+			scene.serveSetIntegerSignal(OutgoingSignals::START_SIM, outgoing.value.startSim, now);
+			scene.serveSetIntegerSignal(OutgoingSignals::TARGET_OBJECT, outgoing.value.targetObject, now);
+			outgoingSequence = outgoing.sequence;
+		}
+		state.incomingSignals.publish(scene.serveGetIntegerSignal(IncomingSignalsSnapshot::SIGNAL, now), now);
+		if (hand >= 0)
+			state.handPose.publish(scene.serveGetObjectPose(hand, now), now);
+		server.beat();
+		steps.fetch_add(1, std::memory_order_relaxed);
+
+		stepTime += parameters.stepPeriod;
+		std::this_thread::sleep_until(stepTime);
+	}
+}
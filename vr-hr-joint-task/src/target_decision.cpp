@@ -0,0 +1,43 @@
+#include "target_decision.h"
+
+TargetDecisionTracker::TargetDecisionTracker(const Workspace& workspace)
+	: workspace(workspace)
+{}
+
+void TargetDecisionTracker::reset(double centroid)
+{
+	decision = TargetDecision();
+	decision.centroid = centroid;
+	decision.peak = centroid >= 0;
+	decision.targetObject = workspace.getTargetObject(centroid);
+	decision.stableSteps = 1;
+	published.publish(decision);
+}
+
+void TargetDecisionTracker::update(double centroid)
+{
+	++decision.step;
+	decide(centroid);
+	published.publish(decision);
+}
+
+void TargetDecisionTracker::decide(double centroid)
+{
+	// A settled peak stays put from step to step, and so does its target.
+	if (centroid == decision.centroid)
+	{
+		++decision.stableSteps;
+		return;
+	}
+	decision.centroid = centroid;
+	decision.peak = centroid >= 0;
+	const int targetObject = workspace.getTargetObject(centroid);
+	if (targetObject == decision.targetObject)
+	{
+		++decision.stableSteps;
+		return;
+	}
+	decision.targetObject = targetObject;
+	decision.stableSteps = 1;
+	decision.changeStep = decision.step;
+}
@@ -0,0 +1,66 @@
+#include "thread_activity.h"
+
+#include <sstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+ThreadActivity::ThreadActivity(std::string name)
+	: name(std::move(name)), wakeups(0),
+	startCpuTime(0), finishCpuTime(0)
+{}
+
+void ThreadActivity::start()
+{
+	startTime = std::chrono::steady_clock::now();
+	startCpuTime = getCurrentThreadCpuTime();
+	wakeups = 0;
+}
+
+void ThreadActivity::finish()
+{
+	finishTime = std::chrono::steady_clock::now();
+	finishCpuTime = getCurrentThreadCpuTime();
+}
+
+double ThreadActivity::getWakeupsPerSecond() const
+{
+	const std::chrono::duration<double> wallTime = getWallTime();
+	return wallTime.count() > 0 ? wakeups / wallTime.count() : 0.0;
+}
+
+std::string ThreadActivity::getReport() const
+{
+	const std::chrono::duration<double> wallTime = getWallTime();
+	const std::chrono::duration<double> cpuTime = getCpuTime();
+
+	std::stringstream ss;
+	ss << name << " thread: cpu time = " << cpuTime.count() << " s";
+	if (wallTime.count() > 0)
+		ss << " (" << 100.0 * cpuTime.count() / wallTime.count() << "% of " << wallTime.count() << " s)"
+			<< ", wakeups = " << getWakeupsPerSecond() << "/s";
+	return ss.str();
+}
+
+std::chrono::nanoseconds ThreadActivity::getCurrentThreadCpuTime()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+		return std::chrono::nanoseconds(0);
+	const auto toTicks = [](const FILETIME& time) {
+		return (static_cast<std::uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+	};
+	// FILETIME ticks are 100 ns.
+	return std::chrono::nanoseconds((toTicks(kernel) + toTicks(user)) * 100);
+#else
+	timespec time{};
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+	return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+#endif
+}
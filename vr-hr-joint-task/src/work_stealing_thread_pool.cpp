@@ -0,0 +1,133 @@
+#include "work_stealing_thread_pool.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Pool and index of the worker running on this thread, if any.
+	thread_local const WorkStealingThreadPool* currentPool = nullptr;
+	thread_local std::size_t currentWorker = 0;
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(std::size_t numberOfThreads)
+	: pending(0), nextWorker(0), steals(0), firstError(nullptr), stopping(false)
+{
+	if (numberOfThreads == 0)
+		numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (std::size_t i = 0; i < numberOfThreads; ++i)
+		workers.push_back(std::make_unique<Worker>());
+	for (std::size_t i = 0; i < numberOfThreads; ++i)
+		threads.emplace_back([this, i] { workerLoop(i); });
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+	waitForTasks();
+	{
+		std::lock_guard lock(idleMutex);
+		stopping = true;
+	}
+	idle.notify_all();
+	threads.clear();
+}
+
+void WorkStealingThreadPool::submit(std::function<void()> task)
+{
+	const std::size_t index = currentPool == this
+		? currentWorker
+		: nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+	pending.fetch_add(1, std::memory_order_relaxed);
+	{
+		std::lock_guard lock(workers[index]->mutex);
+		workers[index]->tasks.push_back(std::move(task));
+	}
+	{
+		// Taken so a worker about to sleep cannot miss the wakeup.
+		std::lock_guard lock(idleMutex);
+	}
+	idle.notify_one();
+}
+
+void WorkStealingThreadPool::wait()
+{
+	waitForTasks();
+	std::exception_ptr error;
+	{
+		std::lock_guard lock(idleMutex);
+		std::swap(error, firstError);
+	}
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void WorkStealingThreadPool::waitForTasks()
+{
+	std::unique_lock lock(idleMutex);
+	finished.wait(lock, [this] { return pending.load() == 0; });
+}
+
+void WorkStealingThreadPool::workerLoop(std::size_t index)
+{
+	currentPool = this;
+	currentWorker = index;
+	while (true)
+	{
+		if (tryRunTask(index))
+			continue;
+
+		std::unique_lock lock(idleMutex);
+		if (stopping)
+			return;
+		// Re-check under the lock, a task may have been pushed after the failed attempt.
+		const bool anyTask = std::any_of(workers.begin(), workers.end(), [](const auto& worker) {
+			std::lock_guard workerLock(worker->mutex);
+			return !worker->tasks.empty();
+		});
+		if (!anyTask)
+			idle.wait(lock);
+	}
+}
+
+bool WorkStealingThreadPool::tryRunTask(std::size_t index)
+{
+	std::function<void()> task;
+	{
+		Worker& own = *workers[index];
+		std::lock_guard lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+		}
+	}
+	for (std::size_t offset = 1; !task && offset < workers.size(); ++offset)
+	{
+		Worker& victim = *workers[(index + offset) % workers.size()];
+		std::lock_guard lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			steals.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	if (!task)
+		return false;
+
+	try
+	{
+		task();
+	}
+	catch (...)
+	{
+		std::lock_guard lock(idleMutex);
+		if (!firstError)
+			firstError = std::current_exception();
+	}
+	if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		std::lock_guard lock(idleMutex);
+		finished.notify_all();
+	}
+	return true;
+}
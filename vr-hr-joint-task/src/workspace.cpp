@@ -0,0 +1,116 @@
+#include "workspace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+Workspace::Workspace(std::vector<WorkspaceObject> objects, int xMax, double dX, double tableYMin, double tableYMax)
+	: objects(std::move(objects)), xMax(xMax), dX(dX), tableYMin(tableYMin), tableYMax(tableYMax)
+{
+	if (this->objects.empty() || this->objects.size() > MAX_OBJECTS)
+		throw std::runtime_error("A workspace holds between 1 and " + std::to_string(MAX_OBJECTS) + " objects.");
+	if (xMax <= 0 || dX <= 0 || tableYMax <= tableYMin)
+		throw std::runtime_error("Invalid workspace field or table dimensions.");
+	for (const WorkspaceObject& object : this->objects)
+		if (object.fieldPosition < 0 || object.fieldPosition > xMax)
+			throw std::runtime_error("Object '" + object.name + "' lies outside the field.");
+
+	byFieldPosition.resize(this->objects.size());
+	for (std::size_t i = 0; i < byFieldPosition.size(); ++i)
+		byFieldPosition[i] = static_cast<int>(i);
+	std::stable_sort(byFieldPosition.begin(), byFieldPosition.end(), [this](int a, int b) {
+		return this->objects[a].fieldPosition < this->objects[b].fieldPosition;
+	});
+}
+
+Workspace Workspace::getDefault()
+{
+	return Workspace({
+		{ "object1", { 0.000,  0.125, 0.716 }, 37.5 },
+		{ "object2", { 0.000,  0.000, 0.716 }, 25 },
+		{ "object3", { 0.000, -0.125, 0.716 }, 12.5 },
+	});
+}
+
+Workspace Workspace::parse(std::istream& stream)
+{
+	try
+	{
+		const nlohmann::json json = nlohmann::json::parse(stream);
+		const nlohmann::json field = json.value("field", nlohmann::json::object());
+		const nlohmann::json table = json.value("table", nlohmann::json::object());
+		const int xMax = field.value("x_max", 50);
+		const double dX = field.value("d_x", 0.5);
+		const double yMin = table.value("y_min", -0.25);
+		const double yMax = table.value("y_max", 0.25);
+
+		std::vector<WorkspaceObject> objects;
+		for (const nlohmann::json& object : json.at("objects"))
+		{
+			const auto position = object.at("position").get<std::vector<double>>();
+			if (position.size() != 3)
+				throw std::runtime_error("Object positions are [x, y, z].");
+			WorkspaceObject workspaceObject(object.value("name", "object" + std::to_string(objects.size() + 1)),
+				{ position[0], position[1], position[2] });
+			workspaceObject.fieldPosition = object.contains("field_position")
+				? object.at("field_position").get<double>()
+				: xMax * (position[1] - yMin) / (yMax - yMin);
+			objects.push_back(workspaceObject);
+		}
+		return Workspace(std::move(objects), xMax, dX, yMin, yMax);
+	}
+	catch (const nlohmann::json::exception& e)
+	{
+		throw std::runtime_error(std::string("Invalid workspace description: ") + e.what());
+	}
+}
+
+Workspace Workspace::load(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file)
+		throw std::runtime_error("Could not open workspace description '" + path + "'.");
+	return parse(file);
+}
+
+ObjectSet Workspace::getAllObjects() const
+{
+	ObjectSet all;
+	for (std::size_t i = 0; i < objects.size(); ++i)
+		all.set(i);
+	return all;
+}
+
+double Workspace::getFieldPosition(double y) const
+{
+	return xMax * (y - tableYMin) / (tableYMax - tableYMin);
+}
+
+int Workspace::getTargetObject(double centroid) const
+{
+	if (centroid < 0)
+		return 0;
+
+	const auto circularDistance = [this](double a, double b) {
+		const double direct = std::abs(a - b);
+		return std::min(direct, xMax - direct);
+	};
+
+	// The closest object, going round the field, is one of the two that bracket the centroid.
+	// Objects sharing a field position are ordered by index, the first of each run is the one a tie goes to.
+	const auto byPosition = [this](double value, int object) { return value < objects[object].fieldPosition; };
+	const auto atPosition = [this](int object, double value) { return objects[object].fieldPosition < value; };
+	const auto upper = std::upper_bound(byFieldPosition.begin(), byFieldPosition.end(), centroid, byPosition);
+	const int after = upper == byFieldPosition.end() ? byFieldPosition.front() : *upper;
+	const int last = upper == byFieldPosition.begin() ? byFieldPosition.back() : *(upper - 1);
+	const int before = *std::lower_bound(byFieldPosition.begin(), byFieldPosition.end(), objects[last].fieldPosition, atPosition);
+
+	const double distanceBefore = circularDistance(centroid, objects[before].fieldPosition);
+	const double distanceAfter = circularDistance(centroid, objects[after].fieldPosition);
+	if (distanceBefore < distanceAfter || (distanceBefore == distanceAfter && before < after))
+		return before + 1;
+	return after + 1;
+}
@@ -0,0 +1,110 @@
+#include "workspace_stimulus.h"
+
+WorkspaceStimulus::WorkspaceStimulus(const dnf_composer::element::ElementCommonParameters& elementCommonParameters,
+	const dnf_composer::element::GaussStimulusParameters& parameters, const Workspace& workspace, double amplitude)
+	: GaussStimulus(elementCommonParameters, parameters), amplitudes(workspace.getNumberOfObjects(), amplitude),
+	evaluatingProfiles(false)
+{
+	for (const WorkspaceObject& object : workspace.getObjects())
+		fieldPositions.push_back(object.fieldPosition);
+}
+
+void WorkspaceStimulus::init()
+{
+	GaussStimulus::init();
+	if (evaluatingProfiles)
+		return;
+	evaluateProfiles();
+	resetOutput();
+}
+
+void WorkspaceStimulus::step(double, double)
+{
+	// The output only changes with the amplitudes.
+}
+
+std::shared_ptr<dnf_composer::element::Element> WorkspaceStimulus::clone() const
+{
+	return std::make_shared<WorkspaceStimulus>(*this);
+}
+
+void WorkspaceStimulus::setAmplitude(std::size_t index, double amplitude)
+{
+	if (amplitudes.at(index) == amplitude)
+		return;
+	amplitudes[index] = amplitude;
+	updateOutput();
+}
+
+void WorkspaceStimulus::setAmplitudes(const std::vector<double>& newAmplitudes)
+{
+	if (newAmplitudes == amplitudes)
+		return;
+	amplitudes = newAmplitudes;
+	amplitudes.resize(fieldPositions.size());
+	updateOutput();
+}
+
+void WorkspaceStimulus::setAmplitudes(const ObjectSet& objects, double amplitude)
+{
+	bool changed = false;
+	for (std::size_t i = 0; i < amplitudes.size(); ++i)
+	{
+		const double value = objects.test(i) ? amplitude : 0;
+		changed |= amplitudes[i] != value;
+		amplitudes[i] = value;
+	}
+	if (changed)
+		updateOutput();
+}
+
+void WorkspaceStimulus::evaluateProfiles()
+{
+	// Let the base element evaluate each Gaussian so the profiles match its own formula exactly.
+	const dnf_composer::element::GaussStimulusParameters parameters = getParameters();
+	const std::vector<double>& output = *getComponentPtr("output");
+	unitProfiles.clear();
+	evaluatingProfiles = true;
+	for (const double position : fieldPositions)
+	{
+		dnf_composer::element::GaussStimulusParameters unit = parameters;
+		unit.amplitude = 1.0;
+		unit.position = position;
+		setParameters(unit);
+		unitProfiles.insert(unitProfiles.end(), output.begin(), output.end());
+	}
+	setParameters(parameters);
+	evaluatingProfiles = false;
+}
+
+void WorkspaceStimulus::resetOutput()
+{
+	std::vector<double>& output = *getComponentPtr("output");
+	std::fill(output.begin(), output.end(), 0.0);
+	appliedAmplitudes.assign(amplitudes.size(), 0.0);
+	updateOutput();
+}
+
+void WorkspaceStimulus::updateOutput()
+{
+	std::vector<double>& output = *getComponentPtr("output");
+	const std::size_t size = output.size();
+	// Before init() there are no profiles yet, init() applies the amplitudes.
+	if (unitProfiles.size() != amplitudes.size() * size || appliedAmplitudes.size() != amplitudes.size())
+		return;
+	bool anyApplied = false;
+	for (std::size_t i = 0; i < amplitudes.size(); ++i)
+	{
+		anyApplied |= amplitudes[i] != 0;
+		const double change = amplitudes[i] - appliedAmplitudes[i];
+		if (change == 0)
+			continue;
+		appliedAmplitudes[i] = amplitudes[i];
+		const double* profile = unitProfiles.data() + i * size;
+		for (std::size_t k = 0; k < size; ++k)
+			output[k] += change * profile[k];
+	}
+	// Back to exactly nothing rather than the rounding left by the additions.
+	if (!anyApplied)
+		std::fill(output.begin(), output.end(), 0.0);
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "remote_api_client.h"
+
+// In-process stand-in for a CoppeliaSim remote API server.
+// Every call costs one simulated round trip and is sampled at the midpoint of that round trip.
+class MockRemoteApiClient : public RemoteApiClient
+{
+public:
+	using Clock = std::chrono::steady_clock;
+private:
+	mutable std::mutex mutex;
+	mutable std::unordered_map<std::string, int> signals;
+	mutable std::unordered_map<std::string, std::vector<int>> writes;
+	std::unordered_map<std::string, int> handles;
+	std::unordered_map<int, Pose> poses;
+	std::chrono::nanoseconds roundTripTime;
+	std::atomic<bool> connected;
+	// initialize() fails this many more times.
+	std::atomic<int> refusals;
+	std::atomic<int> connectionAttempts;
+	mutable std::atomic<long long> calls;
+	mutable Clock::time_point firstSample;
+	mutable Clock::time_point lastSample;
+public:
+	explicit MockRemoteApiClient(std::chrono::nanoseconds roundTripTime = std::chrono::microseconds(100))
+		: roundTripTime(roundTripTime), connected(false), refusals(0), connectionAttempts(0), calls(0)
+	{}
+
+	bool initialize() override
+	{
+		++connectionAttempts;
+		if (refusals > 0)
+		{
+			--refusals;
+			return false;
+		}
+		connected = true;
+		return true;
+	}
+	bool isConnected() const override { return connected; }
+	void disconnect() { connected = false; }
+	// As a server that is not up yet.
+	void refuseConnections(int count) { refusals = count; }
+	int getNumberOfConnectionAttempts() const { return connectionAttempts; }
+	void startSimulation() const override { roundTrip(); }
+	void stopSimulation() const override { roundTrip(); }
+
+	int getIntegerSignal(const std::string& signalName) const override
+	{
+		return roundTrip([&] {
+			const auto it = signals.find(signalName);
+			return it == signals.end() ? 0 : it->second;
+		});
+	}
+
+	void setIntegerSignal(const std::string& signalName, int signalValue) const override
+	{
+		roundTrip([&] {
+			signals[signalName] = signalValue;
+			writes[signalName].push_back(signalValue);
+			return 0;
+		});
+	}
+
+	int getObjectHandle(const std::string& objectName) const override
+	{
+		return roundTrip([&] {
+			const auto it = handles.find(objectName);
+			return it == handles.end() ? -1 : it->second;
+		});
+	}
+
+	Pose getObjectPose(int objectHandle) const override
+	{
+		Pose pose;
+		roundTrip([&] {
+			const auto it = poses.find(objectHandle);
+			if (it != poses.end())
+				pose = it->second;
+			return 0;
+		});
+		return pose;
+	}
+
+	// Scene side, no simulated latency.
+	void publishSignal(const std::string& signalName, int signalValue)
+	{
+		std::lock_guard lock(mutex);
+		signals[signalName] = signalValue;
+	}
+
+	int signal(const std::string& signalName) const
+	{
+		std::lock_guard lock(mutex);
+		const auto it = signals.find(signalName);
+		return it == signals.end() ? 0 : it->second;
+	}
+
+	// Every value written by the client, in arrival order.
+	std::vector<int> getWrites(const std::string& signalName) const
+	{
+		std::lock_guard lock(mutex);
+		const auto it = writes.find(signalName);
+		return it == writes.end() ? std::vector<int>{} : it->second;
+	}
+
+	void addObject(const std::string& objectName, int objectHandle, const Pose& pose)
+	{
+		std::lock_guard lock(mutex);
+		handles[objectName] = objectHandle;
+		poses[objectHandle] = pose;
+	}
+
+	void setObjectPose(int objectHandle, const Pose& pose)
+	{
+		std::lock_guard lock(mutex);
+		poses[objectHandle] = pose;
+	}
+
+	long long getNumberOfCalls() const { return calls; }
+
+	// Sampling instants of the first and last call since the last reset.
+	void resetSampleWindow() const { firstSample = {}; lastSample = {}; }
+	std::chrono::nanoseconds getSampleWindow() const { return lastSample - firstSample; }
+private:
+	void roundTrip() const { roundTrip([] { return 0; }); }
+
+	template<typename Request>
+	int roundTrip(Request&& request) const
+	{
+		++calls;
+		spinFor(roundTripTime / 2);
+		int result;
+		{
+			std::lock_guard lock(mutex);
+			const auto now = Clock::now();
+			if (firstSample == Clock::time_point{})
+				firstSample = now;
+			lastSample = now;
+			result = request();
+		}
+		spinFor(roundTripTime / 2);
+		return result;
+	}
+
+	static void spinFor(std::chrono::nanoseconds duration)
+	{
+		// Busy wait, sleep granularity is far coarser than a loopback round trip.
+		const auto until = Clock::now() + duration;
+		while (Clock::now() < until);
+	}
+};
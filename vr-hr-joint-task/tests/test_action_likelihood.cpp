@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "misc.h"
+
+namespace
+{
+	// n objects spread over the table.
+	std::vector<Position> makeObjects(std::size_t n)
+	{
+		std::vector<Position> objects;
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			const double t = static_cast<double>(i) / static_cast<double>(n);
+			objects.emplace_back(0.2 * std::sin(7 * t), -0.25 + 0.5 * t, 0.716);
+		}
+		return objects;
+	}
+}
+
+TEST_CASE("Batch action likelihood matches the scalar one", "[likelihood]")
+{
+	const std::vector<Position> objects = makeObjects(37);
+	const PositionArrays arrays(objects);
+	REQUIRE(arrays.size() == objects.size());
+
+	const Position hands[] = { { 0.35, 0.0, 0.95 }, { 0.0, 0.1, 0.76 }, { 0.02, -0.13, 0.72 } };
+	for (const Position& hand : hands)
+	{
+		for (const double speed : { 0.0, 0.3, 1.5 })
+		{
+			std::vector<double> likelihoods(objects.size());
+			calculateLikelihoodsOfHumanAction(hand, speed, arrays, 0.1, 0.05, likelihoods.data());
+			for (std::size_t i = 0; i < objects.size(); ++i)
+			{
+				const double expected = calculateLikelihoodOfHumanAction(hand, speed, objects[i], 0.1, 0.05);
+				REQUIRE(std::abs(likelihoods[i] - expected) <= 1e-12 * std::max(1.0, std::abs(expected)));
+			}
+		}
+	}
+}
+
+TEST_CASE("Scalar action likelihood from two positions uses their speed", "[likelihood]")
+{
+	const Position previous{ 0.1, 0.0, 0.8 };
+	const Position current{ 0.1, 0.01, 0.8 };
+	const Position object{ 0.0, 0.125, 0.716 };
+	// 0.01 m in 20 ms.
+	REQUIRE(calculateLikelihoodOfHumanAction(current, previous, object, 0.02, 0.1, 0.05)
+		== calculateLikelihoodOfHumanAction(current, calculateVelocity(current, previous, 0.02), object, 0.1, 0.05));
+}
+
+TEST_CASE("Benchmark action likelihood", "[.][benchmark][likelihood]")
+{
+	const Position hand{ 0.1, 0.02, 0.8 };
+	const Position previousHand{ 0.1, 0.01, 0.8 };
+	for (const std::size_t n : { 3, 16, 64, 256, 1024 })
+	{
+		const std::vector<Position> objects = makeObjects(n);
+		const PositionArrays arrays(objects);
+		std::vector<double> likelihoods(n);
+
+		BENCHMARK("scalar, " + std::to_string(n) + " objects")
+		{
+			for (std::size_t i = 0; i < n; ++i)
+				likelihoods[i] = calculateLikelihoodOfHumanAction(hand, previousHand, objects[i], 0.02, 0.1, 0.05);
+			return likelihoods[0];
+		};
+
+		BENCHMARK("batch, " + std::to_string(n) + " objects")
+		{
+			calculateLikelihoodsOfHumanAction(hand, calculateVelocity(hand, previousHand, 0.02), arrays, 0.1, 0.05, likelihoods.data());
+			return likelihoods[0];
+		};
+	}
+}
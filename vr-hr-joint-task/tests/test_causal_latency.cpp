@@ -0,0 +1,99 @@
+#include <fstream>
+#include <sstream>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "causal_latency.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	const std::chrono::steady_clock::time_point start{ 10s };
+}
+
+TEST_CASE("Decision changes are attributed to the newest sample the step read", "[causal latency]")
+{
+	CausalLatencyTracer tracer;
+	// Samples 1 and 2 applied before step 1 ran, sample 3 after it.
+	tracer.onStimulusApplied(1, start, 0, start + 1ms);
+	tracer.onStimulusApplied(2, start + 10ms, 0, start + 11ms);
+	tracer.onStimulusApplied(2, start + 10ms, 0, start + 15ms);
+	tracer.onStimulusApplied(3, start + 20ms, 1, start + 21ms);
+
+	const DecisionCause cause = tracer.onDecision(2, 1, start + 30ms);
+	REQUIRE(cause.isValid());
+	REQUIRE(cause.sampleSequence == 2);
+	REQUIRE(cause.sampleTime == start + 10ms);
+	// The first application of the sample, not a repeat.
+	REQUIRE(cause.stimulusTime == start + 11ms);
+	REQUIRE(cause.stimulusStep == 0);
+	REQUIRE(cause.decisionStep == 1);
+	REQUIRE(cause.previousTargetObject == 0);
+	REQUIRE(cause.targetObject == 2);
+
+	// The same decision again is no change.
+	REQUIRE_FALSE(tracer.onDecision(2, 2, start + 40ms).isValid());
+	const DecisionCause next = tracer.onDecision(0, 2, start + 50ms);
+	REQUIRE(next.sampleSequence == 3);
+	REQUIRE(next.previousTargetObject == 2);
+}
+
+TEST_CASE("A decision before any step read a sample has no cause", "[causal latency]")
+{
+	CausalLatencyTracer tracer;
+	tracer.onStimulusApplied(1, start, 3, start + 1ms);
+	const DecisionCause cause = tracer.onDecision(1, 3, start + 2ms);
+	REQUIRE_FALSE(cause.isValid());
+	REQUIRE(cause.targetObject == 1);
+
+	tracer.onTargetWritten(cause, start + 3ms);
+	REQUIRE(tracer.getNumberOfChanges() == 0);
+}
+
+TEST_CASE("Written decision changes make up the latency report", "[causal latency]")
+{
+	CausalLatencyTracer tracer(1);
+	for (int i = 0; i < 3; ++i)
+	{
+		const auto sampleTime = start + i * 100ms;
+		tracer.onStimulusApplied(i + 1, sampleTime, i, sampleTime + 2ms);
+		const DecisionCause cause = tracer.onDecision(i + 1, i + 1, sampleTime + 70ms);
+		tracer.onTargetWritten(cause, sampleTime + 75ms);
+	}
+
+	REQUIRE(tracer.getNumberOfChanges() == 3);
+	REQUIRE(tracer.getTotal().getMax() >= 74ms);
+	REQUIRE(tracer.getTotal().getMax() <= 76ms);
+	const std::string report = tracer.getReport();
+	REQUIRE(report.find("3 decision changes") != std::string::npos);
+	REQUIRE(report.find("stimulus to decision") != std::string::npos);
+	REQUIRE(report.find("2 changes not kept") != std::string::npos);
+
+	const std::string path = "causal_latency_test.csv";
+	REQUIRE(tracer.writeCsv(path));
+	std::ifstream file(path);
+	std::string header, row, extra;
+	std::getline(file, header);
+	std::getline(file, row);
+	REQUIRE(header.rfind("sample_sequence,", 0) == 0);
+	REQUIRE(row.rfind("1,0,1,0,1,2,68,5,75", 0) == 0);
+	REQUIRE_FALSE(std::getline(file, extra));
+}
+
+TEST_CASE("Benchmark causal latency tracing", "[.][benchmark][causal latency]")
+{
+	CausalLatencyTracer tracer;
+	std::uint64_t pass = 0;
+
+	// What one control pass adds: a new sample, a decision that changes every tenth pass and its write.
+	BENCHMARK("control pass")
+	{
+		++pass;
+		const auto now = start + pass * 1ms;
+		tracer.onStimulusApplied(pass, now, pass, now);
+		const DecisionCause cause = tracer.onDecision(static_cast<int>(pass / 10 % 3), pass + 1, now);
+		tracer.onTargetWritten(cause, now);
+		return cause.sampleSequence;
+	};
+}
@@ -0,0 +1,55 @@
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+
+#include "change_notifier.h"
+#include "thread_activity.h"
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Waiting without a notification times out", "[notifier]")
+{
+	ChangeNotifier notifier;
+	const auto start = std::chrono::steady_clock::now();
+	REQUIRE_FALSE(notifier.waitFor(20ms));
+	REQUIRE(std::chrono::steady_clock::now() - start >= 20ms);
+}
+
+TEST_CASE("Notifications before a wait collapse into one wakeup", "[notifier]")
+{
+	ChangeNotifier notifier;
+	notifier.notify();
+	notifier.notify();
+	notifier.notify();
+	REQUIRE(notifier.waitFor(0ms));
+	REQUIRE_FALSE(notifier.waitFor(1ms));
+}
+
+TEST_CASE("A notification from another thread wakes the waiter", "[notifier]")
+{
+	ChangeNotifier notifier;
+	std::thread producer([&] {
+		std::this_thread::sleep_for(5ms);
+		notifier.notify();
+	});
+	REQUIRE(notifier.waitFor(5s));
+	producer.join();
+}
+
+TEST_CASE("An idle waiting thread uses little CPU", "[notifier]")
+{
+	ChangeNotifier notifier;
+	ThreadActivity activity("Waiter");
+	std::thread waiter([&] {
+		activity.start();
+		const auto until = std::chrono::steady_clock::now() + 200ms;
+		while (std::chrono::steady_clock::now() < until)
+		{
+			notifier.waitFor(10ms);
+			activity.wakeup();
+		}
+		activity.finish();
+	});
+	waiter.join();
+	REQUIRE(activity.getCpuTime() < activity.getWallTime() / 2);
+	REQUIRE(activity.getWakeupsPerSecond() < 150);
+}
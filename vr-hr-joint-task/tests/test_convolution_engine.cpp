@@ -0,0 +1,210 @@
+#include <cmath>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "convolution_engine.h"
+#include "dnf_architecture.h"
+#include "engine_convolution_kernels.h"
+
+namespace
+{
+	std::vector<double> makeKernel(std::size_t radius, double sigma)
+	{
+		std::vector<double> kernel(2 * radius + 1);
+		for (std::size_t k = 0; k < kernel.size(); ++k)
+		{
+			const double x = static_cast<double>(k) - static_cast<double>(radius);
+			kernel[k] = 2 * std::exp(-0.5 * x * x / (sigma * sigma)) - std::exp(-0.5 * x * x / (4 * sigma * sigma));
+		}
+		return kernel;
+	}
+
+	std::vector<double> makeInput(std::size_t size)
+	{
+		std::vector<double> input(size);
+		for (std::size_t i = 0; i < size; ++i)
+			input[i] = std::sin(0.07 * static_cast<double>(i)) + (i % 17 == 0 ? 1 : 0);
+		return input;
+	}
+
+	std::vector<double> convolve(const std::vector<double>& input, const std::vector<double>& kernel)
+	{
+		const int size = static_cast<int>(input.size());
+		const int radius = static_cast<int>(kernel.size() / 2);
+		std::vector<double> output(input.size());
+		for (int i = 0; i < size; ++i)
+			for (int k = 0; k < static_cast<int>(kernel.size()); ++k)
+				if (i + radius - k >= 0 && i + radius - k < size)
+					output[i] += kernel[k] * input[i + radius - k];
+		return output;
+	}
+
+	// One field with lateral interactions of the same spatial extent as "ael -> ael", sampled at the given size.
+	std::shared_ptr<dnf_composer::Simulation> makeWideField(std::size_t size, std::optional<ConvolutionMethod> convolution)
+	{
+		using namespace dnf_composer;
+		auto simulation = std::make_shared<Simulation>("wide", 65, 0, 0);
+		const element::ElementSpatialDimensionParameters dimensions{ static_cast<int>(size / 2), 0.5 };
+		const double scale = static_cast<double>(size) / 100;
+		const element::LateralInteractionsParameters lateral{ 4.75 * scale, 8.37, 3.375 * scale, 5.677, -2.5, false, false };
+
+		element::ElementFactory factory;
+		const element::SigmoidFunction activationFunction = { 0, 4 };
+		element::NeuralFieldParameters fieldParameters = { 100, -5, activationFunction };
+		simulation->addElement(factory.createElement(element::NEURAL_FIELD, { "u", dimensions }, { fieldParameters }));
+		if (convolution)
+			simulation->addElement(std::make_shared<EngineLateralInteractions>(element::ElementCommonParameters{ "u -> u", dimensions },
+				lateral, *convolution));
+		else
+			simulation->addElement(factory.createElement(element::LATERAL_INTERACTIONS, { "u -> u", dimensions }, lateral));
+		simulation->addElement(factory.createElement(element::GAUSS_STIMULUS, { "s", dimensions },
+			element::GaussStimulusParameters{ 3 * scale, 8, static_cast<double>(size) / 4, false, false }));
+		simulation->createInteraction("u", "output", "u -> u");
+		simulation->createInteraction("u -> u", "output", "u");
+		simulation->createInteraction("s", "output", "u");
+		simulation->init();
+		return simulation;
+	}
+}
+
+TEST_CASE("FFT plans invert their own transform", "[convolution]")
+{
+	const auto plan = FftPlan::get(64);
+	std::vector<std::complex<double>> data(64);
+	for (std::size_t i = 0; i < data.size(); ++i)
+		data[i] = { std::cos(0.3 * static_cast<double>(i)), static_cast<double>(i % 5) };
+	const auto original = data;
+
+	plan->forward(data.data());
+	// A pure cosine input would peak; here just check the DC bin is the sum.
+	std::complex<double> sum;
+	for (const auto& value : original)
+		sum += value;
+	REQUIRE(std::abs(data[0] - sum) < 1e-9);
+
+	plan->inverse(data.data());
+	for (std::size_t i = 0; i < data.size(); ++i)
+		REQUIRE(std::abs(data[i] / 64.0 - original[i]) < 1e-12);
+
+	REQUIRE_THROWS_AS(FftPlan(48), std::invalid_argument);
+}
+
+TEST_CASE("Direct and FFT convolution match the definition", "[convolution]")
+{
+	// (field size, kernel radius): narrow, wide, wider than the field.
+	const std::pair<std::size_t, std::size_t> cases[] = { { 100, 3 }, { 100, 49 }, { 257, 120 }, { 1000, 999 }, { 64, 90 } };
+	for (const auto& [size, radius] : cases)
+	{
+		INFO("size " << size << ", radius " << radius);
+		const std::vector<double> input = makeInput(size);
+		const std::vector<double> kernel = makeKernel(radius, static_cast<double>(radius) / 5 + 0.5);
+		const std::vector<double> expected = convolve(input, kernel);
+
+		for (const ConvolutionMethod method : { ConvolutionMethod::DIRECT, ConvolutionMethod::FFT, ConvolutionMethod::AUTOMATIC })
+		{
+			ConvolutionEngine engine(size, kernel, method);
+			REQUIRE(engine.getMethod() != ConvolutionMethod::AUTOMATIC);
+			std::vector<double> output(size);
+			// Twice, the scratch buffers must not carry anything over.
+			engine.convolve(input, output);
+			engine.convolve(input, output);
+			for (std::size_t i = 0; i < size; ++i)
+				REQUIRE(std::abs(output[i] - expected[i]) < 1e-9);
+		}
+	}
+}
+
+TEST_CASE("Automatic convolution picks the cheaper method", "[convolution]")
+{
+	// The architectures' own kernels on 100 samples stay direct.
+	REQUIRE(ConvolutionEngine::chooseMethod(100, 11) == ConvolutionMethod::DIRECT);
+	REQUIRE(ConvolutionEngine::chooseMethod(100, 49) == ConvolutionMethod::DIRECT);
+	// Kernels of the same spatial extent on finer fields go through the FFT.
+	REQUIRE(ConvolutionEngine::chooseMethod(1000, 477) == ConvolutionMethod::FFT);
+	REQUIRE(ConvolutionEngine::chooseMethod(10000, 4751) == ConvolutionMethod::FFT);
+	// A narrow kernel stays direct however wide the field.
+	REQUIRE(ConvolutionEngine::chooseMethod(10000, 7) == ConvolutionMethod::DIRECT);
+}
+
+TEST_CASE("Engines of the same transform size share one plan", "[convolution]")
+{
+	const ConvolutionEngine first(300, makeKernel(50, 10), ConvolutionMethod::FFT);
+	const std::size_t cached = FftPlan::getNumberOfCachedPlans();
+	const ConvolutionEngine second(350, makeKernel(20, 4), ConvolutionMethod::FFT);
+	REQUIRE(ConvolutionEngine::getFftSize(300, 101) == ConvolutionEngine::getFftSize(350, 41));
+	REQUIRE(FftPlan::getNumberOfCachedPlans() == cached);
+	REQUIRE(FftPlan::get(512) == FftPlan::get(512));
+
+	REQUIRE_THROWS_AS(ConvolutionEngine(100, std::vector<double>(4, 1.0)), std::invalid_argument);
+	REQUIRE_THROWS_AS(ConvolutionEngine(0, makeKernel(2, 1)), std::invalid_argument);
+}
+
+TEST_CASE("Engine kernels follow the library kernels", "[convolution]")
+{
+	for (const ConvolutionMethod method : { ConvolutionMethod::DIRECT, ConvolutionMethod::FFT })
+	{
+		const DnfArchitecture library = getDynamicNeuralFieldArchitectureHandMotion("library", 65, DnfArchitectureOptions(3, std::nullopt, std::nullopt));
+		const DnfArchitecture engine = getDynamicNeuralFieldArchitectureHandMotion("engine", 65, DnfArchitectureOptions(3, std::nullopt, method));
+		library.simulation->init();
+		engine.simulation->init();
+		for (int step = 0; step < 300; ++step)
+		{
+			const double position = 50.0 * step / 300;
+			library.handles.handPositionStimulus->setParameters({ 4, 4, position, false, false });
+			engine.handles.handPositionStimulus->setParameters({ 4, 4, position, false, false });
+			library.simulation->step();
+			engine.simulation->step();
+		}
+		for (const char* name : { "aol", "asl", "orl", "ael" })
+		{
+			const std::vector<double>& expected = *library.simulation->getElement(name)->getComponentPtr("activation");
+			const std::vector<double>& actual = *engine.simulation->getElement(name)->getComponentPtr("activation");
+			REQUIRE(expected.size() == actual.size());
+			for (std::size_t i = 0; i < expected.size(); ++i)
+				REQUIRE(std::abs(expected[i] - actual[i]) < 1e-9);
+		}
+	}
+}
+
+TEST_CASE("Benchmark convolution against field size", "[.][benchmark][convolution]")
+{
+	// Kernel of the spatial extent of "ael -> ael" at every resolution, so its width grows with the field.
+	for (const std::size_t size : { 100, 200, 500, 1000, 2000, 5000, 10000 })
+	{
+		const double sigma = 4.75 * static_cast<double>(size) / 100;
+		const std::size_t radius = std::min(static_cast<std::size_t>(std::ceil(5 * sigma)), size - 1);
+		const std::vector<double> kernel = makeKernel(radius, sigma);
+		const std::vector<double> input = makeInput(size);
+		std::vector<double> output(size);
+
+		for (const auto& [name, method] : { std::pair{ "direct", ConvolutionMethod::DIRECT }, std::pair{ "fft", ConvolutionMethod::FFT } })
+		{
+			ConvolutionEngine engine(size, kernel, method);
+			BENCHMARK(std::to_string(size) + " samples, " + name)
+			{
+				engine.convolve(input, output);
+				return output[size / 2];
+			};
+		}
+	}
+}
+
+TEST_CASE("Benchmark field step against field size", "[.][benchmark][convolution]")
+{
+	for (const std::size_t size : { 100, 200, 500, 1000, 2000, 5000, 10000 })
+	{
+		const auto library = makeWideField(size, std::nullopt);
+		const auto engine = makeWideField(size, ConvolutionMethod::AUTOMATIC);
+
+		BENCHMARK(std::to_string(size) + " samples, library")
+		{
+			library->step();
+		};
+
+		BENCHMARK(std::to_string(size) + " samples, engine")
+		{
+			engine->step();
+		};
+	}
+}
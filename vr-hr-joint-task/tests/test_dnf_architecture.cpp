@@ -0,0 +1,58 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "dnf_architecture.h"
+#include "workspace_stimulus.h"
+
+TEST_CASE("Hand motion architecture handles point at the named elements", "[dnf]")
+{
+	const DnfArchitecture architecture = getDynamicNeuralFieldArchitectureHandMotion("test", 65);
+	const auto& simulation = architecture.simulation;
+	const auto& handles = architecture.handles;
+
+	REQUIRE(handles.ael == simulation->getElement("ael").get());
+	REQUIRE(handles.handPositionStimulus == simulation->getElement("hand position stimulus").get());
+	REQUIRE(handles.objectStimuli == simulation->getElement("object stimuli").get());
+	REQUIRE(handles.handLikelihoodStimuli == nullptr);
+	REQUIRE(handles.objectStimuli->getNumberOfObjects() == 3);
+}
+
+TEST_CASE("Action likelihood architecture handles point at the named elements", "[dnf]")
+{
+	const DnfArchitecture architecture = getDynamicNeuralFieldArchitectureActionLikelihood("test", 65);
+	const auto& simulation = architecture.simulation;
+	const auto& handles = architecture.handles;
+
+	REQUIRE(handles.ael == simulation->getElement("ael").get());
+	REQUIRE(handles.handPositionStimulus == nullptr);
+	REQUIRE(handles.objectStimuli == simulation->getElement("object stimuli").get());
+	REQUIRE(handles.handLikelihoodStimuli == simulation->getElement("hand position stimuli").get());
+	REQUIRE(handles.handLikelihoodStimuli->getNumberOfObjects() == 3);
+}
+
+TEST_CASE("Benchmark per-tick element access", "[.][benchmark][dnf]")
+{
+	using namespace dnf_composer::element;
+	const DnfArchitecture architecture = getDynamicNeuralFieldArchitectureActionLikelihood("bench", 65);
+	const auto& simulation = architecture.simulation;
+	const auto& handles = architecture.handles;
+
+	// The three elements the control loop touches on every pass.
+	BENCHMARK("string lookup and dynamic_pointer_cast")
+	{
+		double sum = 0;
+		for (const char* name : { "object stimuli", "hand position stimuli" })
+			sum += std::dynamic_pointer_cast<WorkspaceStimulus>(simulation->getElement(name))->getAmplitude(0);
+		sum += std::dynamic_pointer_cast<NeuralField>(simulation->getElement("ael"))->getMaxSpatialDimension();
+		return sum;
+	};
+
+	BENCHMARK("handle table")
+	{
+		double sum = 0;
+		sum += handles.objectStimuli->getAmplitude(0);
+		sum += handles.handLikelihoodStimuli->getAmplitude(0);
+		sum += handles.ael->getMaxSpatialDimension();
+		return sum;
+	};
+}
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <csignal>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "event_log_writer.h"
+#include "mpsc_queue.h"
+
+namespace
+{
+	std::string temporaryPath(const std::string& name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	std::vector<std::string> readLines(const std::string& path)
+	{
+		std::ifstream file(path);
+		std::vector<std::string> lines;
+		for (std::string line; std::getline(file, line);)
+			lines.push_back(line);
+		return lines;
+	}
+
+	LogEvent makeEvent(LogLevel level, LogEventId id, int objectId = 0, std::string message = {})
+	{
+		return { level, id, objectId, std::chrono::system_clock::now(), std::move(message) };
+	}
+
+	// The logger as it was before events were queued: format, localtime and flush on the calling thread.
+	class LegacyEventLogger
+	{
+		std::ofstream logFile;
+	public:
+		explicit LegacyEventLogger(const std::string& path)
+			: logFile(path, std::ofstream::out | std::ofstream::app)
+		{}
+
+		void log(LogLevel level, const std::string& msg)
+		{
+			const auto now = std::chrono::system_clock::now();
+			const std::time_t now_time = std::chrono::system_clock::to_time_t(now);
+
+			std::stringstream timeSS, logSS;
+			timeSS << std::put_time(std::localtime(&now_time), "%Y-%m-%d %H:%M:%S");
+			std::string levelStr;
+			switch (level) {
+			case LogLevel::CONTROL: levelStr = "CONTROL"; break;
+			case LogLevel::ROBOT: levelStr = "ROBOT"; break;
+			case LogLevel::HUMAN: levelStr = "HUMAN"; break;
+			}
+
+			logSS << timeSS.str() << " " << levelStr << " " << msg << std::endl;
+
+			logFile << logSS.str();
+			logFile.flush();
+		}
+	};
+}
+
+TEST_CASE("Queue keeps every producer's events in order", "[event log]")
+{
+	constexpr int numberOfProducers = 4;
+	constexpr int eventsPerProducer = 50000;
+	MpscQueue<std::pair<int, int>> queue(1024);
+
+	std::vector<std::thread> producers;
+	for (int p = 0; p < numberOfProducers; ++p)
+		producers.emplace_back([&, p] {
+			for (int i = 0; i < eventsPerProducer; ++i)
+				while (!queue.tryPush({ p, i }))
+					std::this_thread::yield();
+		});
+
+	std::vector<int> next(numberOfProducers, 0);
+	int popped = 0, outOfOrder = 0;
+	std::pair<int, int> item;
+	while (popped < numberOfProducers * eventsPerProducer)
+	{
+		if (!queue.tryPop(item))
+			continue;
+		if (item.second != next[item.first])
+			++outOfOrder;
+		next[item.first] = item.second + 1;
+		++popped;
+	}
+	for (auto& producer : producers)
+		producer.join();
+
+	REQUIRE(outOfOrder == 0);
+	REQUIRE_FALSE(queue.tryPop(item));
+}
+
+TEST_CASE("Typed events are written with the legacy line format", "[event log]")
+{
+	const std::string path = temporaryPath("test_event_log_writer.txt");
+	std::filesystem::remove(path);
+	{
+		EventLogWriter writer;
+		REQUIRE(writer.open(path));
+		writer.push(makeEvent(LogLevel::CONTROL, LogEventId::SIMULATION_STARTED));
+		writer.push(makeEvent(LogLevel::ROBOT, LogEventId::ROBOT_GRASPING, 2));
+		writer.push(makeEvent(LogLevel::HUMAN, LogEventId::HUMAN_PLACING, 3));
+		writer.push(makeEvent(LogLevel::ROBOT, LogEventId::ROBOT_TARGETING, 1));
+		writer.push(makeEvent(LogLevel::CONTROL, LogEventId::MESSAGE, 0, "Free text."));
+		writer.close();
+		REQUIRE(writer.getNumberOfLogged() == 5);
+	}
+
+	const std::vector<std::string> lines = readLines(path);
+	REQUIRE(lines.size() == 5);
+	// "YYYY-MM-DD HH:MM:SS " prefix
+	for (const auto& line : lines)
+	{
+		REQUIRE(line.size() > 20);
+		REQUIRE(line[4] == '-');
+		REQUIRE(line[10] == ' ');
+		REQUIRE(line[13] == ':');
+		REQUIRE(line[19] == ' ');
+	}
+	REQUIRE(lines[0].substr(20) == "CONTROL Simulation has started.");
+	REQUIRE(lines[1].substr(20) == "ROBOT Robot is grasping object 2.");
+	REQUIRE(lines[2].substr(20) == "HUMAN Human is placing object 3.");
+	REQUIRE(lines[3].substr(20) == "ROBOT Robot will target object 1.");
+	REQUIRE(lines[4].substr(20) == "CONTROL Free text.");
+	std::filesystem::remove(path);
+}
+
+TEST_CASE("Bursts are committed in groups", "[event log]")
+{
+	constexpr int numberOfEvents = 10000;
+	const std::string path = temporaryPath("test_event_log_group_commit.txt");
+	std::filesystem::remove(path);
+	{
+		EventLogWriter writer({ numberOfEvents, 16 * 1024, std::chrono::milliseconds(50) });
+		REQUIRE(writer.open(path));
+		for (int i = 0; i < numberOfEvents; ++i)
+			writer.push(makeEvent(LogLevel::HUMAN, LogEventId::HUMAN_GRASPING, i));
+		writer.close();
+		REQUIRE(writer.getNumberOfDropped() == 0);
+		REQUIRE(writer.getNumberOfCommits() < numberOfEvents / 10);
+	}
+	REQUIRE(readLines(path).size() == numberOfEvents);
+	std::filesystem::remove(path);
+}
+
+TEST_CASE("Full event queue drops instead of blocking", "[event log]")
+{
+	// Not opened, so nothing drains the queue.
+	EventLogWriter writer(EventLogWriterParameters(16));
+	for (int i = 0; i < 20; ++i)
+		writer.push(makeEvent(LogLevel::ROBOT, LogEventId::ROBOT_PLACING, i));
+	REQUIRE(writer.getNumberOfLogged() == 16);
+	REQUIRE(writer.getNumberOfDropped() == 4);
+}
+
+TEST_CASE("Crash flush commits pending events", "[event log]")
+{
+	const std::string path = temporaryPath("test_event_log_crash.txt");
+	std::filesystem::remove(path);
+	EventLogWriter writer({ 8192, 1024 * 1024, std::chrono::hours(1) });
+	REQUIRE(writer.open(path));
+	for (int i = 0; i < 100; ++i)
+		writer.push(makeEvent(LogLevel::ROBOT, LogEventId::ROBOT_GRASPING, i));
+
+	writer.flushOnCrash();
+	REQUIRE(readLines(path).size() == 100);
+	writer.close();
+	std::filesystem::remove(path);
+}
+
+#ifdef SIGCHLD
+TEST_CASE("Stop signals are committed by the writer thread", "[event log]")
+{
+	const std::string path = temporaryPath("test_event_log_signal.txt");
+	std::filesystem::remove(path);
+	EventLogWriter writer({ 8192, 1024 * 1024, std::chrono::hours(1) });
+	REQUIRE_FALSE(writer.requestFlushOnSignal(SIGCHLD));
+	REQUIRE(writer.open(path));
+	for (int i = 0; i < 100; ++i)
+		writer.push(makeEvent(LogLevel::ROBOT, LogEventId::ROBOT_GRASPING, i));
+
+	// Ignored by default, so raising it again leaves the test running.
+	REQUIRE(writer.requestFlushOnSignal(SIGCHLD));
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (readLines(path).size() < 100 && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	REQUIRE(readLines(path).size() == 100);
+	writer.close();
+	std::filesystem::remove(path);
+}
+#endif
+
+TEST_CASE("Benchmark event producer latency", "[.][benchmark][event log]")
+{
+	constexpr int numberOfProducers = 4;
+	constexpr int eventsPerProducer = 20000;
+
+	const auto measure = [&](const char* label, const auto& logEvent)
+	{
+		std::vector<std::chrono::nanoseconds> latencies(numberOfProducers * eventsPerProducer);
+		std::vector<std::thread> producers;
+		for (int p = 0; p < numberOfProducers; ++p)
+			producers.emplace_back([&, p] {
+				for (int i = 0; i < eventsPerProducer; ++i)
+				{
+					const auto start = std::chrono::steady_clock::now();
+					logEvent(i);
+					latencies[p * eventsPerProducer + i] = std::chrono::steady_clock::now() - start;
+				}
+			});
+		for (auto& producer : producers)
+			producer.join();
+
+		std::sort(latencies.begin(), latencies.end());
+		const auto percentile = [&](double p) {
+			return std::chrono::duration<double, std::micro>(latencies[static_cast<std::size_t>(p * (latencies.size() - 1))]).count();
+		};
+		std::cout << label << " (" << numberOfProducers << " producers)"
+			<< ": p50 " << percentile(0.5) << " us"
+			<< ", p99 " << percentile(0.99) << " us"
+			<< ", max " << percentile(1.0) << " us" << std::endl;
+	};
+
+	const std::string legacyPath = temporaryPath("benchmark_event_log_legacy.txt");
+	{
+		// The old logger had no synchronisation at all; the mutex keeps the comparison well defined.
+		LegacyEventLogger legacy(legacyPath);
+		std::mutex mutex;
+		measure("legacy log()", [&](int i) {
+			std::lock_guard lock(mutex);
+			legacy.log(LogLevel::HUMAN, "Human is grasping object " + std::to_string(i) + ".");
+		});
+	}
+
+	const std::string queuedPath = temporaryPath("benchmark_event_log_queued.txt");
+	{
+		EventLogWriter writer(EventLogWriterParameters(numberOfProducers * eventsPerProducer));
+		REQUIRE(writer.open(queuedPath));
+		measure("queued typed event", [&](int i) {
+			writer.push({ LogLevel::HUMAN, LogEventId::HUMAN_GRASPING, i, std::chrono::system_clock::now(), {} });
+		});
+		writer.close();
+		REQUIRE(writer.getNumberOfDropped() == 0);
+	}
+
+	std::filesystem::remove(legacyPath);
+	std::filesystem::remove(queuedPath);
+}
@@ -0,0 +1,116 @@
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+
+#include "fixed_step_runner.h"
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Real-time runner paces steps to the period", "[runner]")
+{
+	FixedStepRunner runner(10ms, SteppingMode::REAL_TIME);
+	std::stop_source stopSource;
+	const auto start = std::chrono::steady_clock::now();
+	runner.run(stopSource.get_token(), [&] { return runner.getNumberOfSteps() < 10; });
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+
+	REQUIRE(runner.getNumberOfSteps() == 10);
+	REQUIRE(elapsed >= 100ms);
+}
+
+TEST_CASE("As-fast-as-possible runner does not sleep", "[runner]")
+{
+	FixedStepRunner runner(1s, SteppingMode::AS_FAST_AS_POSSIBLE);
+	std::stop_source stopSource;
+	const auto start = std::chrono::steady_clock::now();
+	runner.run(stopSource.get_token(), [&] { return runner.getNumberOfSteps() < 1000; });
+
+	REQUIRE(runner.getNumberOfSteps() == 1000);
+	REQUIRE(std::chrono::steady_clock::now() - start < 1s);
+}
+
+TEST_CASE("Runner stops when requested", "[runner]")
+{
+	FixedStepRunner runner(1ms, SteppingMode::REAL_TIME);
+	std::jthread thread([&](const std::stop_token& stopToken) {
+		runner.run(stopToken, [] { return true; });
+	});
+	std::this_thread::sleep_for(20ms);
+	thread.request_stop();
+	thread.join();
+	REQUIRE(runner.getNumberOfSteps() > 0);
+}
+
+TEST_CASE("Real-time runner reports when the next step is due", "[runner]")
+{
+	FixedStepRunner runner(50ms, SteppingMode::REAL_TIME);
+	const auto beforeRun = runner.getNextStepTime();
+	REQUIRE(beforeRun <= std::chrono::steady_clock::now());
+
+	std::jthread thread([&](const std::stop_token& stopToken) {
+		runner.run(stopToken, [] { return true; });
+	});
+	std::this_thread::sleep_for(10ms);
+	const auto now = std::chrono::steady_clock::now();
+	const auto nextStep = runner.getNextStepTime();
+	REQUIRE(nextStep > now);
+	REQUIRE(nextStep - now <= 50ms);
+
+	thread.request_stop();
+	thread.join();
+	const auto afterRun = runner.getNextStepTime();
+	REQUIRE(afterRun <= std::chrono::steady_clock::now());
+}
+
+TEST_CASE("Real-time runner catches up on a late step", "[runner]")
+{
+	FixedStepRunner runner(10ms, SteppingMode::REAL_TIME, 2);
+	std::stop_source stopSource;
+	const auto start = std::chrono::steady_clock::now();
+	runner.run(stopSource.get_token(), [&] {
+		// The third step overruns by two and a half periods.
+		if (runner.getNumberOfSteps() == 2)
+			std::this_thread::sleep_for(25ms);
+		return runner.getNumberOfSteps() < 10;
+	});
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+
+	// The steps that fell behind ran back to back rather than being skipped, the session still takes ten periods.
+	REQUIRE(runner.getNumberOfSteps() == 10);
+	REQUIRE(runner.getNumberOfMissedDeadlines() >= 1);
+	REQUIRE(runner.getNumberOfSkippedSteps() == 0);
+	REQUIRE(elapsed >= 100ms);
+	REQUIRE(runner.getLateness().getCount() == runner.getNumberOfSteps());
+	REQUIRE(runner.getLateness().getMax() >= 15ms);
+}
+
+TEST_CASE("Real-time runner skips the deadlines it cannot catch up on", "[runner]")
+{
+	FixedStepRunner runner(10ms, SteppingMode::REAL_TIME, 1);
+	std::stop_source stopSource;
+	runner.run(stopSource.get_token(), [&] {
+		if (runner.getNumberOfSteps() == 2)
+			std::this_thread::sleep_for(55ms);
+		return runner.getNumberOfSteps() < 10;
+	});
+
+	REQUIRE(runner.getNumberOfMissedDeadlines() >= 1);
+	// Five whole periods behind, one is caught up on.
+	REQUIRE(runner.getNumberOfSkippedSteps() >= 3);
+	REQUIRE(runner.getNumberOfSkippedSteps() <= 5);
+	REQUIRE(runner.getReport("Test").find("missed deadlines") != std::string::npos);
+}
+
+TEST_CASE("As-fast-as-possible runner keeps no deadlines", "[runner]")
+{
+	FixedStepRunner runner(1ms, SteppingMode::AS_FAST_AS_POSSIBLE);
+	std::stop_source stopSource;
+	runner.run(stopSource.get_token(), [&] {
+		std::this_thread::sleep_for(std::chrono::microseconds(1500));
+		return runner.getNumberOfSteps() < 5;
+	});
+
+	REQUIRE(runner.getNumberOfMissedDeadlines() == 0);
+	REQUIRE(runner.getNumberOfSkippedSteps() == 0);
+	REQUIRE(runner.getLateness().getCount() == 0);
+	REQUIRE(runner.getReport("Test").find("simulated time") != std::string::npos);
+}
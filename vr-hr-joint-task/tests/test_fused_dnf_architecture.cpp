@@ -0,0 +1,264 @@
+#include <cmath>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "dnf_composer_handler.h"
+#include "fused_dnf_architecture.h"
+#include "gauss_stimulus_updater.h"
+#include "workspace_stimulus.h"
+
+namespace
+{
+	constexpr std::size_t SIZE = FusedDnfArchitecture<>::SIZE;
+
+	// Straightforward zero-padded convolution, the definition the fused kernel must reproduce.
+	std::array<double, SIZE> convolve(const FusedKernel<SIZE>& kernel, const std::array<double, SIZE>& input)
+	{
+		std::array<double, SIZE> output{};
+		const int radius = static_cast<int>(kernel.getRadius());
+		double sum = 0;
+		for (const double value : input)
+			sum += value;
+		for (int i = 0; i < static_cast<int>(SIZE); ++i)
+		{
+			output[i] = kernel.getAmplitudeGlobal() * sum;
+			for (int k = -radius; k <= radius; ++k)
+				if (i - k >= 0 && i - k < static_cast<int>(SIZE))
+					output[i] += kernel.getTap(k) * input[i - k];
+		}
+		return output;
+	}
+
+	double getMaxDifference(const std::array<double, SIZE>& a, const std::vector<double>& b)
+	{
+		REQUIRE(b.size() == SIZE);
+		double difference = 0;
+		for (std::size_t i = 0; i < SIZE; ++i)
+			difference = std::max(difference, std::abs(a[i] - b[i]));
+		return difference;
+	}
+
+	// Hand moving across the table while object 2 disappears half-way, applied to both backends.
+	void checkAgainstSimulation(DnfArchitectureType type)
+	{
+		constexpr double deltaT = 65;
+		constexpr int steps = 400;
+		const DnfArchitectureOptions options(7);
+		DnfArchitecture generic = type == DnfArchitectureType::HAND_MOTION
+			? getDynamicNeuralFieldArchitectureHandMotion("generic", deltaT, options)
+			: getDynamicNeuralFieldArchitectureActionLikelihood("generic", deltaT, options);
+		FusedDnfArchitecture<> fused(type, deltaT, options);
+
+		generic.simulation->init();
+		fused.init();
+		for (int step = 0; step < steps; ++step)
+		{
+			const double progress = static_cast<double>(step) / steps;
+			if (type == DnfArchitectureType::HAND_MOTION)
+			{
+				GaussStimulusUpdater(generic.handles.handPositionStimulus).setAmplitudeAndPosition(3 + progress, 50 * progress);
+				fused.setHandPositionStimulus(3 + progress, 50 * progress);
+			}
+			else
+			{
+				generic.handles.handLikelihoodStimuli->setAmplitude(0, 4 * progress);
+				fused.setHandLikelihoodStimulusAmplitude(0, 4 * progress);
+			}
+			if (step == steps / 2)
+			{
+				generic.handles.objectStimuli->setAmplitude(1, 0);
+				fused.setObjectStimulusAmplitude(1, 0);
+			}
+			generic.simulation->step();
+			fused.step();
+		}
+
+		const std::pair<const char*, FusedDnfLayer> layers[] = {
+			{ "aol", FusedDnfLayer::AOL }, { "asl", FusedDnfLayer::ASL }, { "orl", FusedDnfLayer::ORL }, { "ael", FusedDnfLayer::AEL } };
+		for (const auto& [name, layer] : layers)
+		{
+			INFO(name);
+			const std::vector<double>& activation = *generic.simulation->getElement(name)->getComponentPtr("activation");
+			REQUIRE(getMaxDifference(fused.getLayer(layer).activation, activation) < 1e-6);
+		}
+	}
+
+	// The hand reaches for object 1 and stays there, through the handler of each backend.
+	void checkHandlerBackends(DnfArchitectureType type)
+	{
+		constexpr double deltaT = 65;
+		constexpr int steps = 600;
+		const auto makeHandler = [&](DnfBackend backend) {
+			return std::make_unique<DnfComposerHandler>(type, deltaT,
+				DnfComposerHandlerParameters(false, SteppingMode::AS_FAST_AS_POSSIBLE, DnfArchitectureOptions(7), 2, backend));
+		};
+		const auto graph = makeHandler(DnfBackend::ELEMENT_GRAPH);
+		const auto fused = makeHandler(DnfBackend::FUSED);
+		REQUIRE(fused->getBackend() == DnfBackend::FUSED);
+
+		const Workspace& workspace = fused->getWorkspace();
+		const Position start{ 0, -0.2, 0.9 };
+		const Position target = workspace.getObject(1).position;
+		graph->initSimulation();
+		fused->initSimulation();
+		for (int step = 0; step < steps; ++step)
+		{
+			const double progress = std::min(1.0, 2.0 * step / steps);
+			HandKinematics hand;
+			hand.sequence = step + 1;
+			hand.position = { start.x + progress * (target.x - start.x), start.y + progress * (target.y - start.y),
+				start.z + progress * (target.z - start.z) };
+			if (progress < 1)
+				hand.velocity = { (target.x - start.x) / 2, (target.y - start.y) / 2, (target.z - start.z) / 2 };
+			const ObjectSet available = step < steps / 3 ? workspace.getAllObjects() : ObjectSet(0b110);
+			for (DnfComposerHandler* handler : { graph.get(), fused.get() })
+			{
+				handler->setHandStimulus(hand, available);
+				handler->setAvailableObjectsInTheWorkspace(available);
+				handler->stepSimulation();
+			}
+		}
+
+		const std::vector<double> expected = graph->getActionExecutionActivation();
+		const std::vector<double> actual = fused->getActionExecutionActivation();
+		REQUIRE(actual.size() == expected.size());
+		for (std::size_t i = 0; i < expected.size(); ++i)
+			REQUIRE(std::abs(actual[i] - expected[i]) < 1e-6);
+		REQUIRE(fused->getTargetObject() != 0);
+		REQUIRE(fused->getTargetObject() == graph->getTargetObject());
+	}
+}
+
+TEST_CASE("Fused kernels match a direct convolution", "[fused dnf]")
+{
+	std::array<double, SIZE> input{};
+	for (std::size_t i = 0; i < SIZE; ++i)
+		input[i] = std::sin(0.3 * static_cast<double>(i)) + (i > 40 && i < 60 ? 1 : 0);
+
+	using namespace dnf_composer::element;
+	FusedKernel<SIZE> kernels[] = {
+		FusedKernel<SIZE>::gauss(1, 1.5),
+		FusedKernel<SIZE>::gauss(2.4, 0.755),
+		FusedKernel<SIZE>::lateralInteractions({ 4.75, 8.37, 3.375, 5.677, -2.5, false, false }),
+		// Wider than the field, the radius is clipped.
+		FusedKernel<SIZE>::lateralInteractions({ 30, 1, 25, 0.5, -0.1, false, false }),
+	};
+	for (auto& kernel : kernels)
+	{
+		std::array<double, SIZE> output{};
+		kernel.apply(input, output);
+		const std::array<double, SIZE> expected = convolve(kernel, input);
+		for (std::size_t i = 0; i < SIZE; ++i)
+			REQUIRE(std::abs(output[i] - expected[i]) < 1e-12);
+	}
+	REQUIRE(kernels[0].getRadius() == 5);
+	REQUIRE(kernels[3].getRadius() == SIZE - 1);
+}
+
+TEST_CASE("Fused fields stay at rest without input", "[fused dnf]")
+{
+	FusedDnfArchitecture<> fused(DnfArchitectureType::HAND_MOTION, 65, DnfArchitectureOptions(1));
+	fused.setObjectStimulusAmplitudes(ObjectSet(), 0);
+	fused.init();
+	for (int step = 0; step < 200; ++step)
+		fused.step();
+
+	for (const FusedDnfLayer layer : { FusedDnfLayer::AOL, FusedDnfLayer::ASL, FusedDnfLayer::ORL, FusedDnfLayer::AEL })
+		for (const double activation : fused.getLayer(layer).activation)
+			REQUIRE(std::abs(activation + 5) < 0.01);
+}
+
+TEST_CASE("Fused object layer peaks at the present objects", "[fused dnf]")
+{
+	FusedDnfArchitecture<> fused(DnfArchitectureType::HAND_MOTION, 65, DnfArchitectureOptions(1));
+	fused.setObjectStimulusAmplitude(2, 0);
+	fused.init();
+	for (int step = 0; step < 200; ++step)
+		fused.step();
+
+	const auto& orl = fused.getLayer(FusedDnfLayer::ORL).activation;
+	const auto sampleAt = [&](double position) { return static_cast<std::size_t>(position / fused.getSpatialStep()); };
+	REQUIRE(orl[sampleAt(37.5)] > 0);
+	REQUIRE(orl[sampleAt(25)] > 0);
+	REQUIRE(orl[sampleAt(12.5)] < 0);
+	REQUIRE(orl[sampleAt(12.5)] < orl[sampleAt(31.25)]);
+}
+
+TEST_CASE("Seeded fused runs are bit identical", "[fused dnf]")
+{
+	FusedDnfArchitecture<> fused(DnfArchitectureType::ACTION_LIKELIHOOD, 65, DnfArchitectureOptions(5));
+	FusedDnfArchitecture<> other(DnfArchitectureType::ACTION_LIKELIHOOD, 65, DnfArchitectureOptions(5));
+	const auto run = [](FusedDnfArchitecture<>& architecture) {
+		architecture.init();
+		architecture.setHandLikelihoodStimulusAmplitude(1, 3);
+		for (int step = 0; step < 100; ++step)
+			architecture.step();
+		return architecture.getLayer(FusedDnfLayer::AEL).activation;
+	};
+
+	const auto first = run(fused);
+	REQUIRE(run(other) == first);
+	// init() rewinds the noise.
+	REQUIRE(run(fused) == first);
+	REQUIRE_THROWS_AS(fused.setHandPositionStimulus(1, 25), std::logic_error);
+}
+
+TEST_CASE("Fused hand motion backend follows the generic simulation", "[fused dnf]")
+{
+	checkAgainstSimulation(DnfArchitectureType::HAND_MOTION);
+}
+
+TEST_CASE("Fused action likelihood backend follows the generic simulation", "[fused dnf]")
+{
+	checkAgainstSimulation(DnfArchitectureType::ACTION_LIKELIHOOD);
+}
+
+TEST_CASE("Fused hand motion handler decides as the element graph", "[fused dnf]")
+{
+	checkHandlerBackends(DnfArchitectureType::HAND_MOTION);
+}
+
+TEST_CASE("Fused action likelihood handler decides as the element graph", "[fused dnf]")
+{
+	checkHandlerBackends(DnfArchitectureType::ACTION_LIKELIHOOD);
+}
+
+TEST_CASE("Fused backend is headless and needs fields of its size", "[fused dnf]")
+{
+	REQUIRE_THROWS_AS(DnfComposerHandler(DnfArchitectureType::HAND_MOTION, 65,
+		DnfComposerHandlerParameters(true, SteppingMode::REAL_TIME, {}, 2, DnfBackend::FUSED)), std::runtime_error);
+
+	const Workspace coarse({ { "object1", { 0, 0, 0 }, 25 } }, 50, 1);
+	REQUIRE_THROWS_AS(FusedDnfArchitecture<>(DnfArchitectureType::HAND_MOTION, 65,
+		DnfArchitectureOptions(1, std::nullopt, ConvolutionMethod::AUTOMATIC, coarse)), std::runtime_error);
+
+	const Workspace single({ { "object1", { 0, 0, 0 }, 25 } });
+	FusedDnfArchitecture<> fused(DnfArchitectureType::ACTION_LIKELIHOOD, 65,
+		DnfArchitectureOptions(1, std::nullopt, ConvolutionMethod::AUTOMATIC, single));
+	REQUIRE(fused.getNumberOfObjects() == 1);
+}
+
+TEST_CASE("Benchmark DNF step", "[.][benchmark][fused dnf]")
+{
+	for (const DnfArchitectureType type : { DnfArchitectureType::HAND_MOTION, DnfArchitectureType::ACTION_LIKELIHOOD })
+	{
+		const std::string name = type == DnfArchitectureType::HAND_MOTION ? "hand motion" : "action likelihood";
+		DnfArchitecture generic = type == DnfArchitectureType::HAND_MOTION
+			? getDynamicNeuralFieldArchitectureHandMotion("bench", 65, DnfArchitectureOptions(1))
+			: getDynamicNeuralFieldArchitectureActionLikelihood("bench", 65, DnfArchitectureOptions(1));
+		FusedDnfArchitecture<> fused(type, 65, DnfArchitectureOptions(1));
+		generic.simulation->init();
+		fused.init();
+
+		BENCHMARK("generic simulation, " + name)
+		{
+			generic.simulation->step();
+		};
+
+		BENCHMARK("fused, " + name)
+		{
+			fused.step();
+		};
+	}
+}
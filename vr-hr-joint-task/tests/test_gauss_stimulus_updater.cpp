@@ -0,0 +1,135 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "gauss_stimulus_updater.h"
+
+using namespace dnf_composer::element;
+
+namespace
+{
+	std::shared_ptr<GaussStimulus> makeStimulus(const GaussStimulusParameters& parameters,
+		const ElementSpatialDimensionParameters& dimensions = { 50, 0.5 })
+	{
+		ElementFactory factory;
+		auto stimulus = std::dynamic_pointer_cast<GaussStimulus>(
+			factory.createElement(GAUSS_STIMULUS, { "stimulus", dimensions }, { parameters }));
+		stimulus->init();
+		return stimulus;
+	}
+
+	void requireSameOutput(GaussStimulus& a, GaussStimulus& b)
+	{
+		const std::vector<double>& outputA = *a.getComponentPtr("output");
+		const std::vector<double>& outputB = *b.getComponentPtr("output");
+		REQUIRE(outputA.size() == outputB.size());
+		for (std::size_t i = 0; i < outputA.size(); ++i)
+			REQUIRE(std::abs(outputA[i] - outputB[i]) < 1e-12);
+	}
+}
+
+TEST_CASE("Amplitude updates match a full parameter update", "[stimulus]")
+{
+	const auto updated = makeStimulus({ 3, 5, 25, false, false });
+	const auto reference = makeStimulus({ 3, 5, 25, false, false });
+	GaussStimulusUpdater updater(updated.get());
+	requireSameOutput(*updated, *reference);
+
+	for (const double amplitude : { 0.0, 2.5, 5.0, 0.123 })
+	{
+		updater.setAmplitude(amplitude);
+		reference->setParameters({ 3, amplitude, 25, false, false });
+		requireSameOutput(*updated, *reference);
+	}
+	REQUIRE(updater.getNumberOfProfileEvaluations() == 1);
+}
+
+TEST_CASE("Identical updates leave the element untouched", "[stimulus]")
+{
+	const auto stimulus = makeStimulus({ 3, 5, 25, false, false });
+	GaussStimulusUpdater updater(stimulus.get());
+	const std::uint64_t rescales = updater.getNumberOfRescales();
+
+	updater.setAmplitude(5);
+	updater.setAmplitudeAndPosition(5, 25);
+	REQUIRE(updater.getNumberOfSkips() == 2);
+	REQUIRE(updater.getNumberOfRescales() == rescales);
+}
+
+TEST_CASE("Position updates re-evaluate the profile", "[stimulus]")
+{
+	const auto updated = makeStimulus({ 4, 0, 0, false, false });
+	const auto reference = makeStimulus({ 4, 0, 0, false, false });
+	GaussStimulusUpdater updater(updated.get());
+
+	updater.setAmplitudeAndPosition(3.2, 17.5);
+	reference->setParameters({ 4, 3.2, 17.5, false, false });
+	requireSameOutput(*updated, *reference);
+	REQUIRE(updater.getNumberOfProfileEvaluations() == 2);
+}
+
+TEST_CASE("Hand motion updates evaluate the Gaussian once per position", "[stimulus]")
+{
+	const auto updated = makeStimulus({ 3, 0, 25, false, false });
+	const auto reference = makeStimulus({ 3, 0, 25, false, false });
+	GaussStimulusUpdater updater(updated.get());
+	REQUIRE(updater.getNumberOfProfileEvaluations() == 1);
+
+	// Nothing to rescale from at amplitude 0.
+	updater.setAmplitude(2.5);
+	reference->setParameters({ 3, 2.5, 25, false, false });
+	requireSameOutput(*updated, *reference);
+	REQUIRE(updater.getNumberOfProfileEvaluations() == 2);
+
+	for (int i = 1; i <= 10; ++i)
+	{
+		const double amplitude = 1.0 / i;
+		const double position = 20 + i * 0.25;
+		updater.setAmplitudeAndPosition(amplitude, position);
+		updater.setAmplitude(2 * amplitude);
+		reference->setParameters({ 3, 2 * amplitude, position, false, false });
+		requireSameOutput(*updated, *reference);
+	}
+	REQUIRE(updater.getNumberOfProfileEvaluations() == 12);
+	REQUIRE(updater.getNumberOfRescales() == 10);
+}
+
+TEST_CASE("Stimuli initialised again show the updated parameters", "[stimulus]")
+{
+	const auto updated = makeStimulus({ 3, 5, 25, false, false });
+	const auto reference = makeStimulus({ 3, 5, 25, false, false });
+	GaussStimulusUpdater updater(updated.get());
+	updated->init();
+	requireSameOutput(*updated, *reference);
+
+	updater.setAmplitudeAndPosition(3.2, 17.5);
+	updated->init();
+	reference->setParameters({ 3, 3.2, 17.5, false, false });
+	requireSameOutput(*updated, *reference);
+	REQUIRE(updated->getParameters().amplitude == 3.2);
+}
+
+TEST_CASE("Benchmark stimulus amplitude updates", "[.][benchmark][stimulus]")
+{
+	const ElementSpatialDimensionParameters dimensions{ 500, 0.05 };
+	const auto stimulus = makeStimulus({ 3, 5, 250, false, false }, dimensions);
+	const auto cachedStimulus = makeStimulus({ 3, 5, 250, false, false }, dimensions);
+	GaussStimulusUpdater updater(cachedStimulus.get());
+	double amplitude = 0;
+
+	BENCHMARK("setParameters")
+	{
+		amplitude = amplitude == 5 ? 0 : 5;
+		stimulus->setParameters({ 3, amplitude, 250, false, false });
+	};
+
+	BENCHMARK("rescale cached profile")
+	{
+		amplitude = amplitude == 5 ? 0 : 5;
+		updater.setAmplitude(amplitude);
+	};
+
+	BENCHMARK("identical update")
+	{
+		updater.setAmplitude(amplitude);
+	};
+}
@@ -0,0 +1,109 @@
+#include <cmath>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "hand_kinematics.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	const std::chrono::steady_clock::time_point start{ 1s };
+
+	bool isNear(double a, double b, double tolerance = 1e-9)
+	{
+		return std::abs(a - b) <= tolerance;
+	}
+}
+
+TEST_CASE("Hand kinematics of a constant velocity reach", "[kinematics]")
+{
+	HandKinematicsEstimator estimator;
+	// 0.5 m/s along y, sampled every 10 ms.
+	for (int i = 0; i < 20; ++i)
+		REQUIRE(estimator.update(i + 1, start + i * 10ms, { 0.1, 0.005 * i, 0.8 }));
+
+	const HandKinematics& latest = estimator.getLatest();
+	REQUIRE(latest.sequence == 20);
+	REQUIRE(isNear(latest.velocity.y, 0.5));
+	REQUIRE(isNear(latest.velocity.x, 0));
+	REQUIRE(isNear(latest.acceleration.y, 0));
+	REQUIRE(isNear(latest.getSpeed(), 0.5));
+
+	// Between samples the pose is interpolated.
+	const HandKinematics between = estimator.estimateAt(start + 55ms);
+	REQUIRE(isNear(between.position.y, 0.0275));
+	REQUIRE(between.sequence == 7);
+
+	// After the newest sample it is extrapolated, up to the extrapolation limit.
+	const HandKinematics ahead = estimator.estimateAt(start + 190ms + 30ms);
+	REQUIRE(isNear(ahead.position.y, 0.095 + 0.015));
+	const HandKinematics farAhead = estimator.estimateAt(start + 190ms + 1s);
+	REQUIRE(isNear(farAhead.position.y, 0.095 + 0.05));
+}
+
+TEST_CASE("Hand kinematics filter a constant acceleration", "[kinematics]")
+{
+	HandKinematicsEstimator estimator;
+	// 2 m/s^2 from rest, sampled every 5 ms for half a second.
+	const auto y = [](double t) { return t * t; };
+	for (int i = 0; i <= 100; ++i)
+		estimator.update(i + 1, start + i * 5ms, { 0, y(0.005 * i), 0 });
+
+	const HandKinematics& latest = estimator.getLatest();
+	// The filters lag a ramp by about their time constants.
+	REQUIRE(isNear(latest.acceleration.y, 2, 0.05));
+	REQUIRE(isNear(latest.velocity.y, 2 * 0.5, 0.15));
+	REQUIRE(latest.velocity.y < 2 * 0.5);
+}
+
+TEST_CASE("Hand kinematics ignore stale and repeated samples", "[kinematics]")
+{
+	HandKinematicsEstimator estimator;
+	REQUIRE_FALSE(estimator.update(0, start, { 1, 1, 1 }));
+	REQUIRE_FALSE(estimator.getLatest().isValid());
+	REQUIRE_FALSE(estimator.estimateAt(start).isValid());
+
+	Snapshot<Pose> pose;
+	pose.sequence = 1;
+	pose.captureTime = start;
+	pose.value = { { 0, 0, 0 }, {} };
+	REQUIRE(estimator.update(pose));
+	// The control loop sees the same snapshot on several passes.
+	REQUIRE_FALSE(estimator.update(pose));
+	REQUIRE_FALSE(estimator.update(2, start, { 1, 0, 0 }));
+	REQUIRE(estimator.getNumberOfSamples() == 1);
+	// A single sample has no velocity yet.
+	REQUIRE(estimator.estimateAt(start + 10ms).position == Position(0, 0, 0));
+}
+
+TEST_CASE("Hand kinematics keep a fixed number of samples", "[kinematics]")
+{
+	HandKinematicsEstimator estimator(HandKinematicsParameters(4));
+	for (int i = 0; i < 10; ++i)
+		estimator.update(i + 1, start + i * 10ms, { 0.01 * i, 0, 0 });
+
+	REQUIRE(estimator.getNumberOfSamples() == 4);
+	// Before the oldest sample kept, the oldest one.
+	REQUIRE(isNear(estimator.estimateAt(start).position.x, 0.06));
+	REQUIRE(isNear(estimator.estimateAt(start + 75ms).position.x, 0.075));
+
+	estimator.clear();
+	REQUIRE_FALSE(estimator.getLatest().isValid());
+	REQUIRE_THROWS(HandKinematicsEstimator(HandKinematicsParameters(1)));
+}
+
+TEST_CASE("Benchmark hand kinematics", "[.][benchmark][kinematics]")
+{
+	HandKinematicsEstimator estimator;
+	std::uint64_t sequence = 0;
+	auto time = start;
+
+	BENCHMARK("update and estimate at the next step")
+	{
+		++sequence;
+		time += 11ms;
+		estimator.update(sequence, time, { 0.1, std::sin(0.01 * static_cast<double>(sequence)), 0.8 });
+		return estimator.estimateAt(time + 30ms).position.y;
+	};
+}
@@ -0,0 +1,123 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "metrics.h"
+
+namespace
+{
+	bool isWithinResolution(std::chrono::nanoseconds reported, std::chrono::nanoseconds expected)
+	{
+		// One bucket is 1/16 of its power of two wide.
+		return reported >= expected && reported.count() <= expected.count() + expected.count() / 16 + 1;
+	}
+}
+
+TEST_CASE("Histogram buckets cover every value in order", "[metrics]")
+{
+	std::size_t previous = 0;
+	for (std::uint64_t value : { 0ull, 1ull, 31ull, 32ull, 33ull, 1000ull, 123456789ull, ~0ull })
+	{
+		const std::size_t index = LatencyHistogram::getBucketIndex(value);
+		REQUIRE(index < LatencyHistogram::NUMBER_OF_BUCKETS);
+		REQUIRE(index >= previous);
+		REQUIRE(LatencyHistogram::getBucketUpperBound(index) >= value);
+		previous = index;
+	}
+	REQUIRE(LatencyHistogram::getBucketIndex(~0ull) == LatencyHistogram::NUMBER_OF_BUCKETS - 1);
+}
+
+TEST_CASE("Histogram percentiles are within bucket resolution", "[metrics]")
+{
+	LatencyHistogram histogram;
+	for (int i = 1; i <= 1000; ++i)
+		histogram.record(std::chrono::microseconds(i));
+
+	REQUIRE(histogram.getCount() == 1000);
+	REQUIRE(histogram.getMax() == std::chrono::microseconds(1000));
+	REQUIRE(histogram.getMean() == std::chrono::nanoseconds(500500));
+	REQUIRE(isWithinResolution(histogram.getPercentile(50), std::chrono::microseconds(500)));
+	REQUIRE(isWithinResolution(histogram.getPercentile(99), std::chrono::microseconds(990)));
+	REQUIRE(histogram.getPercentile(100) == std::chrono::microseconds(1000));
+}
+
+TEST_CASE("Concurrent records are all counted", "[metrics]")
+{
+	LatencyHistogram histogram;
+	Counter counter;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+		threads.emplace_back([&] {
+			for (int i = 0; i < 100000; ++i)
+			{
+				histogram.record(std::chrono::nanoseconds(i));
+				counter.add();
+			}
+		});
+	for (auto& thread : threads)
+		thread.join();
+
+	REQUIRE(histogram.getCount() == 400000);
+	REQUIRE(counter.get() == 400000);
+}
+
+TEST_CASE("Registry snapshot lists every metric", "[metrics]")
+{
+	MetricsRegistry registry;
+	{
+		const ScopedTimer timer(registry.getHistogram("dnf step"));
+	}
+	registry.getCounter("control iterations").add(3);
+	registry.getGauge("hand pose age (ms)").set(2.5);
+	REQUIRE(&registry.getHistogram("dnf step") == &registry.getHistogram("dnf step"));
+
+	const std::string snapshot = registry.getSnapshot();
+	REQUIRE(snapshot.find("latency dnf step: count = 1") != std::string::npos);
+	REQUIRE(snapshot.find("counter control iterations: 3") != std::string::npos);
+	REQUIRE(snapshot.find("gauge hand pose age (ms): 2.5") != std::string::npos);
+}
+
+TEST_CASE("Reporter writes a final snapshot on stop", "[metrics]")
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "test_metrics.txt").string();
+	std::filesystem::remove(path);
+
+	MetricsRegistry registry;
+	registry.getCounter("signal writes").add(7);
+	MetricsReporter reporter(registry);
+	reporter.start(path, std::chrono::hours(1));
+	reporter.stop();
+
+	std::ifstream file(path);
+	std::stringstream contents;
+	contents << file.rdbuf();
+	REQUIRE(contents.str().find("counter signal writes: 7") != std::string::npos);
+	file.close();
+	std::filesystem::remove(path);
+}
+
+TEST_CASE("Benchmark probe overhead", "[.][benchmark][metrics]")
+{
+	LatencyHistogram histogram;
+	Counter counter;
+
+	BENCHMARK("scoped timer")
+	{
+		const ScopedTimer timer(histogram);
+	};
+
+	BENCHMARK("histogram record")
+	{
+		histogram.record(std::chrono::nanoseconds(1234));
+	};
+
+	BENCHMARK("counter add")
+	{
+		counter.add();
+	};
+}
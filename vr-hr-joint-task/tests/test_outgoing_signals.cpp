@@ -0,0 +1,212 @@
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+
+#include "coppeliasim_handler.h"
+#include "mock_remote_api_client.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	struct MockedCoppeliasimHandler
+	{
+		MockRemoteApiClient* incoming;
+		MockRemoteApiClient* outgoing;
+		MockRemoteApiClient* hand;
+		CoppeliasimHandler handler;
+
+		explicit MockedCoppeliasimHandler(const CoppeliasimHandlerParameters& parameters)
+			: MockedCoppeliasimHandler(std::make_unique<MockRemoteApiClient>(50us),
+				std::make_unique<MockRemoteApiClient>(50us),
+				std::make_unique<MockRemoteApiClient>(50us),
+				parameters)
+		{}
+
+		~MockedCoppeliasimHandler()
+		{
+			incoming->disconnect();
+			outgoing->disconnect();
+			hand->disconnect();
+			handler.end();
+		}
+	private:
+		MockedCoppeliasimHandler(std::unique_ptr<MockRemoteApiClient> incoming,
+			std::unique_ptr<MockRemoteApiClient> outgoing,
+			std::unique_ptr<MockRemoteApiClient> hand,
+			const CoppeliasimHandlerParameters& parameters)
+			: incoming(incoming.get()), outgoing(outgoing.get()), hand(hand.get()),
+			handler(std::move(incoming), std::move(outgoing), std::move(hand), parameters)
+		{}
+	};
+
+	template<typename Predicate>
+	bool waitUntil(Predicate predicate, std::chrono::milliseconds timeout = 2000ms)
+	{
+		const auto until = std::chrono::steady_clock::now() + timeout;
+		while (!predicate())
+		{
+			if (std::chrono::steady_clock::now() > until)
+				return false;
+			std::this_thread::sleep_for(1ms);
+		}
+		return true;
+	}
+
+	OutgoingSignals makeSignals(bool startSim, int targetObject)
+	{
+		OutgoingSignals signals;
+		signals.startSim = startSim;
+		signals.targetObject = targetObject;
+		return signals;
+	}
+}
+
+TEST_CASE("Every outgoing value change reaches the simulator", "[outgoing]")
+{
+	MockedCoppeliasimHandler mocked({ 0ms, 0us });
+	mocked.handler.init();
+	REQUIRE(waitUntil([&] { return mocked.outgoing->isConnected(); }));
+
+	const std::vector<int> targets = { 1, 2, 3, 0, 2, 1 };
+	for (const int target : targets)
+	{
+		mocked.handler.setSignals(makeSignals(true, target));
+		REQUIRE(waitUntil([&] { return mocked.outgoing->signal(OutgoingSignals::TARGET_OBJECT) == target; }));
+	}
+
+	const std::vector<int> written = mocked.outgoing->getWrites(OutgoingSignals::TARGET_OBJECT);
+	REQUIRE(std::vector<int>(written.end() - static_cast<long>(targets.size()), written.end()) == targets);
+	// startSim only changed once, at most from its initial value to true.
+	const std::vector<int> startSimWrites = mocked.outgoing->getWrites(OutgoingSignals::START_SIM);
+	REQUIRE(startSimWrites.size() <= 2);
+	REQUIRE(startSimWrites.back() == 1);
+}
+
+TEST_CASE("Unchanged outgoing signals are not re-sent", "[outgoing]")
+{
+	MockedCoppeliasimHandler mocked({ 0ms, 0us });
+	mocked.handler.setSignals(makeSignals(true, 2));
+	mocked.handler.init();
+	REQUIRE(waitUntil([&] { return mocked.outgoing->signal(OutgoingSignals::TARGET_OBJECT) == 2; }));
+
+	for (int i = 0; i < 100; ++i)
+		mocked.handler.setSignals(makeSignals(true, 2));
+	std::this_thread::sleep_for(50ms);
+
+	REQUIRE(mocked.outgoing->getWrites(OutgoingSignals::TARGET_OBJECT).size() == 1);
+	REQUIRE(mocked.outgoing->getWrites(OutgoingSignals::START_SIM).size() == 1);
+	const OutgoingSignalsStatistics statistics = mocked.handler.getOutgoingSignalsStatistics();
+	REQUIRE(statistics.writesSent == 2);
+}
+
+TEST_CASE("Bursts of changes are coalesced", "[outgoing]")
+{
+	MockedCoppeliasimHandler mocked({ 0ms, 5000us });
+	mocked.handler.init();
+	REQUIRE(waitUntil([&] { return mocked.outgoing->isConnected(); }));
+
+	for (int target = 1; target <= 100; ++target)
+		mocked.handler.setSignals(makeSignals(false, target));
+	REQUIRE(waitUntil([&] { return mocked.outgoing->signal(OutgoingSignals::TARGET_OBJECT) == 100; }));
+
+	REQUIRE(mocked.outgoing->getWrites(OutgoingSignals::TARGET_OBJECT).size() < 100);
+	const OutgoingSignalsStatistics statistics = mocked.handler.getOutgoingSignalsStatistics();
+	REQUIRE(statistics.writesSuppressed > 0);
+}
+
+TEST_CASE("Keep-alive refreshes unchanged signals", "[outgoing]")
+{
+	MockedCoppeliasimHandler mocked({ 10ms, 0us });
+	mocked.handler.setSignals(makeSignals(true, 3));
+	mocked.handler.init();
+	REQUIRE(waitUntil([&] { return mocked.outgoing->getWrites(OutgoingSignals::TARGET_OBJECT).size() >= 3; }));
+	for (const int value : mocked.outgoing->getWrites(OutgoingSignals::TARGET_OBJECT))
+		REQUIRE(value == 3);
+}
+
+TEST_CASE("Traced target changes are reported once written", "[outgoing][causal latency]")
+{
+	MockedCoppeliasimHandler mocked({ 10ms, 0us });
+	CausalLatencyTracer tracer;
+	mocked.handler.setCausalLatencyTracer(&tracer);
+	mocked.handler.init();
+	REQUIRE(waitUntil([&] { return mocked.outgoing->isConnected(); }));
+
+	const auto sampleTime = std::chrono::steady_clock::now();
+	tracer.onStimulusApplied(1, sampleTime, 0, sampleTime + 1ms);
+	for (const int target : { 2, 3 })
+	{
+		const DecisionCause cause = tracer.onDecision(target, 1);
+		REQUIRE(cause.isValid());
+		mocked.handler.setSignals(makeSignals(true, target), cause);
+		REQUIRE(waitUntil([&] { return mocked.outgoing->signal(OutgoingSignals::TARGET_OBJECT) == target; }));
+	}
+	// Keep-alive refreshes of the same target are not decision changes.
+	std::this_thread::sleep_for(50ms);
+
+	REQUIRE(tracer.getNumberOfChanges() == 2);
+	REQUIRE(tracer.getTotal().getMax() >= 1ms);
+}
+
+TEST_CASE("Republishing without a cause keeps the pending one", "[outgoing][causal latency]")
+{
+	MockedCoppeliasimHandler mocked({ 0ms, 0us });
+	CausalLatencyTracer tracer;
+	mocked.handler.setCausalLatencyTracer(&tracer);
+	const auto sampleTime = std::chrono::steady_clock::now();
+	tracer.onStimulusApplied(1, sampleTime, 0, sampleTime + 1ms);
+
+	// Before the writer starts, so none of them has been written yet.
+	mocked.handler.setSignals(makeSignals(false, 2), tracer.onDecision(2, 1));
+	mocked.handler.setSignals(makeSignals(false, 2));
+	mocked.handler.setSignals(makeSignals(true, 2));
+	mocked.handler.init();
+	REQUIRE(waitUntil([&] { return mocked.outgoing->signal(OutgoingSignals::START_SIM) == 1; }));
+
+	REQUIRE(waitUntil([&] { return tracer.getNumberOfChanges() == 1; }));
+}
+
+TEST_CASE("Signals are reset before the writer starts", "[outgoing]")
+{
+	MockedCoppeliasimHandler mocked({ 0ms, 0us, 2, ConnectionBackoff(1ms, 5ms) });
+	mocked.incoming->refuseConnections(1000000);
+	mocked.handler.setSignals(makeSignals(true, 2));
+	mocked.handler.init();
+	std::this_thread::sleep_for(20ms);
+	REQUIRE(mocked.outgoing->getNumberOfConnectionAttempts() == 0);
+
+	mocked.incoming->refuseConnections(0);
+	REQUIRE(waitUntil([&] { return mocked.outgoing->signal(OutgoingSignals::TARGET_OBJECT) == 2; }));
+	// Zeroed once, before anything the writer records as sent; without a keep-alive nothing would restore it.
+	REQUIRE(mocked.incoming->getWrites(OutgoingSignals::START_SIM) == std::vector<int>{ 0 });
+	REQUIRE(mocked.incoming->getWrites(OutgoingSignals::TARGET_OBJECT) == std::vector<int>{ 0 });
+	REQUIRE(mocked.outgoing->getWrites(OutgoingSignals::START_SIM) == std::vector<int>{ 1 });
+}
+
+TEST_CASE("Blocking connections back off until the simulator accepts them", "[outgoing]")
+{
+	MockedCoppeliasimHandler mocked({ 0ms, 0us, 2, ConnectionBackoff(5ms, 20ms) });
+	mocked.outgoing->refuseConnections(3);
+	const auto start = std::chrono::steady_clock::now();
+	mocked.handler.init();
+	REQUIRE(waitUntil([&] { return mocked.outgoing->isConnected(); }));
+
+	// 5, 10 and 20 ms between the four attempts.
+	REQUIRE(mocked.outgoing->getNumberOfConnectionAttempts() == 4);
+	REQUIRE(std::chrono::steady_clock::now() - start >= 35ms);
+}
+
+TEST_CASE("A handler that never connects still ends", "[outgoing]")
+{
+	MockedCoppeliasimHandler mocked({ 0ms, 0us, 2, ConnectionBackoff(1ms, 10ms) });
+	mocked.incoming->refuseConnections(1000000);
+	mocked.outgoing->refuseConnections(1000000);
+	mocked.hand->refuseConnections(1000000);
+	mocked.handler.init();
+	std::this_thread::sleep_for(50ms);
+	mocked.handler.end();
+
+	// Attempts are spaced out rather than back to back.
+	REQUIRE(mocked.incoming->getNumberOfConnectionAttempts() < 20);
+	REQUIRE_FALSE(mocked.handler.isConnected());
+}
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+
+#include "parameter_sweep.h"
+
+namespace
+{
+	SessionTraceRecord makeRecord(std::uint64_t dnfStep, std::int64_t timestampMs, IncomingSignals signals)
+	{
+		SessionTraceRecord record{};
+		record.dnfStep = dnfStep;
+		record.timestampNs = timestampMs * 1000000;
+		record.incomingSignals = IncomingSignalsSnapshot::pack(signals);
+		return record;
+	}
+}
+
+TEST_CASE("Grid enumerates every combination", "[sweep]")
+{
+	const LateralInteractionsGrid grid{ { 1, 2 }, { 3 }, { 4, 5, 6 }, { 7 }, { -1, -2 } };
+	const auto candidates = grid.getCandidates();
+	REQUIRE(candidates.size() == 12);
+	REQUIRE(candidates.front().sigmaExc == 1);
+	REQUIRE(candidates.back().amplitudeGlobal == -2);
+}
+
+TEST_CASE("Synthetic reaches end with the grasp of their object", "[sweep]")
+{
+	const SyntheticReachParameters parameters(65, std::chrono::milliseconds(20), std::chrono::milliseconds(1000), std::chrono::milliseconds(500));
+	const SessionTrace reach = makeSyntheticReach(DnfArchitectureType::HAND_MOTION, 2, parameters);
+
+	REQUIRE(reach.records.size() == 76);
+	REQUIRE(getGraspedObject(reach) == 2);
+	REQUIRE(reach.records.front().x == 0.35);
+	REQUIRE(reach.records.back().x == 0.0);
+	REQUIRE(reach.records.back().dnfStep == 1500 / 65);
+	// Only the last pass carries the grasp.
+	IncomingSignals signals;
+	IncomingSignalsSnapshot::unpack(reach.records[74].incomingSignals, signals);
+	REQUIRE_FALSE(signals.humanGraspObj2);
+
+	const SessionTrace other = makeSyntheticReach(DnfArchitectureType::HAND_MOTION, 1, parameters);
+	REQUIRE(other.records.back().y > reach.records.back().y);
+}
+
+TEST_CASE("Recorded sessions split into one reach per grasp", "[sweep]")
+{
+	IncomingSignals idle, graspObject3, graspObject1;
+	idle.object1 = idle.object2 = idle.object3 = true;
+	graspObject3 = idle;
+	graspObject3.humanGraspObj3 = true;
+	graspObject1 = idle;
+	graspObject1.humanGraspObj1 = true;
+
+	SessionTrace session{};
+	session.records = {
+		makeRecord(0, 0, idle), makeRecord(1, 65, idle), makeRecord(2, 130, graspObject3),
+		makeRecord(3, 195, graspObject3), makeRecord(4, 260, idle), makeRecord(5, 325, idle),
+		makeRecord(6, 390, graspObject1), makeRecord(7, 455, idle) };
+
+	const auto reaches = splitIntoReaches(session);
+	REQUIRE(reaches.size() == 2);
+	REQUIRE(reaches[0].records.size() == 3);
+	REQUIRE(getGraspedObject(reaches[0]) == 3);
+	REQUIRE(reaches[1].records.size() == 3);
+	REQUIRE(reaches[1].records.front().dnfStep == 0);
+	REQUIRE(reaches[1].records.back().dnfStep == 2);
+	REQUIRE(getGraspedObject(reaches[1]) == 1);
+}
+
+TEST_CASE("Trials score accuracy and settling time", "[sweep]")
+{
+	IncomingSignals idle, grasp;
+	idle.object1 = idle.object2 = idle.object3 = true;
+	grasp = idle;
+	grasp.humanGraspObj1 = true;
+
+	SessionTrace reach{};
+	reach.records = { makeRecord(0, 0, idle), makeRecord(1, 100, idle), makeRecord(2, 200, idle), makeRecord(3, 300, grasp) };
+
+	SessionReplayResult replay;
+	replay.targetObjects = { 0, 1, 2, 2 };
+	TrialScore score = scoreTrial(reach, replay);
+	REQUIRE(score.correct);
+	REQUIRE(score.decisionLatency == std::chrono::milliseconds(200));
+
+	// Settling on the object the human takes is wrong.
+	replay.targetObjects = { 0, 2, 1, 1 };
+	score = scoreTrial(reach, replay);
+	REQUIRE_FALSE(score.correct);
+
+	// So is never deciding.
+	replay.targetObjects = { 0, 0, 0, 0 };
+	REQUIRE_FALSE(scoreTrial(reach, replay).correct);
+}
+
+TEST_CASE("Sweep results do not depend on the number of threads", "[sweep]")
+{
+	// The action likelihood architecture also estimates the hand's speed, which each trial must keep to itself.
+	for (const DnfArchitectureType architecture : { DnfArchitectureType::HAND_MOTION, DnfArchitectureType::ACTION_LIKELIHOOD })
+	{
+		const LateralInteractionsGrid grid{ { 4.75 }, { 7.5, 8.143 }, { 3.375 }, { 5.677 }, { -2.5 } };
+		std::vector<SessionTrace> reaches;
+		for (int object = 1; object <= 3; ++object)
+			reaches.push_back(makeSyntheticReach(architecture, object));
+
+		const auto sequential = runParameterSweep(grid.getCandidates(), reaches, 1);
+		const auto parallel = runParameterSweep(grid.getCandidates(), reaches, 4);
+		REQUIRE(sequential.size() == 2);
+		for (std::size_t i = 0; i < sequential.size(); ++i)
+		{
+			REQUIRE(sequential[i].trials == 3);
+			REQUIRE(sequential[i].correct == parallel[i].correct);
+			REQUIRE(sequential[i].meanDecisionLatency == parallel[i].meanDecisionLatency);
+		}
+	}
+}
+
+TEST_CASE("Benchmark sweep scaling", "[.][benchmark][sweep]")
+{
+	const LateralInteractionsGrid grid{ { 4.0, 4.75, 5.5 }, { 7.5, 8.143, 9.0 }, { 3.375 }, { 5.0, 5.677 }, { -2.5 } };
+	std::vector<SessionTrace> reaches;
+	for (int object = 1; object <= 3; ++object)
+		reaches.push_back(makeSyntheticReach(DnfArchitectureType::HAND_MOTION, object));
+
+	const std::size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	double singleThreaded = 0;
+	for (std::size_t threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		runParameterSweep(grid.getCandidates(), reaches, threads);
+		const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+		if (threads == 1)
+			singleThreaded = wall.count();
+		std::cout << threads << " threads: " << wall.count() << " s, speedup " << singleThreaded / wall.count() << std::endl;
+	}
+}
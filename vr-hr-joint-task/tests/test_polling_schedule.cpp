@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+
+#include "coppeliasim_handler.h"
+#include "polling_schedule.h"
+#include "simulated_coppeliasim.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	using Clock = PollingSchedule::Clock;
+
+	Clock::time_point at(std::chrono::milliseconds time)
+	{
+		return Clock::time_point(time);
+	}
+
+	// An older scene: no packed snapshot, every flag is its own signal and its own read.
+	SceneScript makeFlagPerSignalScript()
+	{
+		SceneScript script;
+		script.trajectories["RightController"] = { { 0ms, {} }, { 1000ms, { { 1, 1, 1 }, {} } } };
+		for (const char* name : { IncomingSignals::SIM_STARTED, IncomingSignals::OBJECT1_EXISTS,
+			IncomingSignals::OBJECT2_EXISTS, IncomingSignals::OBJECT3_EXISTS })
+			script.signals.push_back({ 0ms, name, 1 });
+		// Human grasps held for 30 ms, well over the 10 ms period of the flag.
+		for (int i = 0; i < 5; ++i)
+		{
+			script.signals.push_back({ 50ms + i * 100ms, IncomingSignals::HUMAN_GRASP_OBJ1, 1 });
+			script.signals.push_back({ 80ms + i * 100ms, IncomingSignals::HUMAN_GRASP_OBJ1, 0 });
+		}
+		// Robot grasps held for 6 ms, under the period of the flag but over its boosted period once the robot approaches.
+		script.signals.push_back({ 100ms, IncomingSignals::ROBOT_APPROACH, 1 });
+		for (int i = 0; i < 3; ++i)
+		{
+			script.signals.push_back({ 200ms + i * 60ms, IncomingSignals::ROBOT_GRASP_OBJ2, 1 });
+			script.signals.push_back({ 206ms + i * 60ms, IncomingSignals::ROBOT_GRASP_OBJ2, 0 });
+		}
+		return script;
+	}
+
+	int countRisingEdges(const std::vector<int>& values)
+	{
+		int edges = 0;
+		int last = 0;
+		for (const int value : values)
+		{
+			edges += value && !last;
+			last = value;
+		}
+		return edges;
+	}
+
+	struct PlayedScript
+	{
+		double poseRate;
+		// Rising edges in the values the scene served to the reads of the flag, which the handler publishes in order.
+		int humanGraspEdges;
+		int robotGraspEdges;
+	};
+
+	// Plays the script for 600 ms.
+	PlayedScript playScript(const SceneScript& script, const PollingScheduleParameters& schedule)
+	{
+		SimulatedCoppeliaSim scene(script);
+		scene.addObject("RightController");
+		// Every request, hand pose or signal, takes the scene 40 us.
+		scene.setServiceTime(40us);
+		scene.recordServedValues(IncomingSignals::HUMAN_GRASP_OBJ1);
+		scene.recordServedValues(IncomingSignals::ROBOT_GRASP_OBJ2);
+		CoppeliasimHandler handler(std::make_unique<SimulatedPipelinedConnection>(scene, SimulatedConnectionParameters(200us)),
+			CoppeliasimHandlerParameters(0ms, 0us, 2, ConnectionBackoff(), 50us, schedule));
+		ChangeNotifier changes;
+		handler.setChangeNotifier(&changes);
+		handler.init();
+
+		REQUIRE(changes.waitFor(1s));
+		const std::uint64_t firstPose = handler.getHandPoseSnapshot().sequence;
+		const auto start = Clock::now();
+		std::this_thread::sleep_for(600ms);
+		const double poseRate = static_cast<double>(handler.getHandPoseSnapshot().sequence - firstPose)
+			/ std::chrono::duration<double>(Clock::now() - start).count();
+
+		scene.close();
+		handler.end();
+		return { poseRate, countRisingEdges(scene.getServedValues(IncomingSignals::HUMAN_GRASP_OBJ1)),
+			countRisingEdges(scene.getServedValues(IncomingSignals::ROBOT_GRASP_OBJ2)) };
+	}
+
+	// Hand reads per second from a scene that serves one request every 40 us, taking turns between the hand, which
+	// always has a read waiting, and the flags the schedule has due. Simulated time, so the rate does not depend
+	// on the machine.
+	double simulateHandRate(const PollingScheduleParameters& parameters)
+	{
+		PollingSchedule schedule;
+		std::vector<std::size_t> flags;
+		for (const PollingTarget& target : makeDefaultPollingSchedule().targets)
+		{
+			if (target.name == HumanHand::POLLING_TARGET)
+				continue;
+			const auto configured = std::find_if(parameters.targets.begin(), parameters.targets.end(),
+				[&](const PollingTarget& candidate) { return candidate.name == target.name; });
+			flags.push_back(schedule.add(configured == parameters.targets.end() ? PollingTarget(target.name) : *configured));
+		}
+
+		constexpr auto serviceTime = 40us;
+		std::deque<std::size_t> pending;
+		bool flagsTurn = true;
+		int handReads = 0;
+		for (Clock::time_point time{}; time < at(1000ms); time += serviceTime)
+		{
+			if (pending.empty())
+				for (const std::size_t flag : schedule.getDue(flags, time))
+					pending.push_back(flag);
+			if (flagsTurn && !pending.empty())
+			{
+				schedule.onRead(pending.front(), 0, time);
+				pending.pop_front();
+			}
+			else
+				++handReads;
+			flagsTurn = !flagsTurn;
+		}
+		return handReads;
+	}
+}
+
+TEST_CASE("Polling targets are due at their own rates, by priority", "[polling schedule]")
+{
+	PollingSchedule schedule;
+	const std::size_t hand = schedule.add({ "hand", 0, 0 });
+	const std::size_t grasp = schedule.add({ "grasp", 100, 1 });
+	const std::size_t restart = schedule.add({ "restart", 2, 2 });
+	const std::vector<std::size_t> all = { restart, grasp, hand };
+
+	// Never read: all due, by priority.
+	REQUIRE(schedule.getDue(all, at(0ms)) == std::vector<std::size_t>{ hand, grasp, restart });
+	for (const std::size_t target : all)
+		schedule.onRead(target, 0, at(0ms));
+
+	REQUIRE(schedule.getDue(all, at(5ms)) == std::vector<std::size_t>{ hand });
+	REQUIRE(schedule.getNextDueTime({ grasp, restart }, at(5ms)) == at(10ms));
+	REQUIRE(schedule.getDue(all, at(10ms)) == std::vector<std::size_t>{ hand, grasp });
+	REQUIRE(schedule.getDue({ restart }, at(499ms)).empty());
+	REQUIRE(schedule.getDue({ restart }, at(500ms)) == std::vector<std::size_t>{ restart });
+	REQUIRE(schedule.getPeriod(hand, at(0ms)) == Clock::duration::zero());
+	REQUIRE(schedule.find("grasp") == grasp);
+	REQUIRE_FALSE(schedule.find("place"));
+	REQUIRE_THROWS_AS(schedule.add({ "grasp", 10, 1 }), std::runtime_error);
+}
+
+TEST_CASE("A rising trigger boosts the rate of its targets for a while", "[polling schedule]")
+{
+	PollingSchedule schedule;
+	const std::size_t approaching = schedule.add({ "approaching", 100, 1 });
+	const std::size_t grasp = schedule.add({ "grasp", 100, 1 });
+	const std::size_t restart = schedule.add({ "restart", 2, 2 });
+	schedule.addBoost({ "approaching", { "grasp" }, 500, 100ms });
+	REQUIRE_THROWS_AS(schedule.addBoost({ "approaching", { "place" }, 500, 100ms }), std::runtime_error);
+
+	schedule.onRead(grasp, 0, at(0ms));
+	schedule.onRead(restart, 0, at(0ms));
+	schedule.onRead(approaching, 0, at(0ms));
+	REQUIRE_FALSE(schedule.isDue(grasp, at(2ms)));
+
+	schedule.onRead(approaching, 1, at(10ms));
+	REQUIRE(schedule.getPeriod(grasp, at(10ms)) == 2ms);
+	// The pending read comes forward.
+	REQUIRE(schedule.isDue(grasp, at(10ms)));
+	schedule.onRead(grasp, 0, at(10ms));
+	REQUIRE(schedule.isDue(grasp, at(12ms)));
+	REQUIRE(schedule.getPeriod(restart, at(10ms)) == 500ms);
+
+	// Holding high is not another rise.
+	schedule.onRead(approaching, 1, at(50ms));
+	REQUIRE(schedule.getPeriod(grasp, at(109ms)) == 2ms);
+	REQUIRE(schedule.getPeriod(grasp, at(110ms)) == 10ms);
+
+	schedule.onRead(approaching, 0, at(200ms));
+	schedule.onRead(approaching, 1, at(210ms));
+	REQUIRE(schedule.getPeriod(grasp, at(300ms)) == 2ms);
+}
+
+TEST_CASE("The handler refuses polling targets it does not read", "[polling schedule]")
+{
+	SimulatedCoppeliaSim scene;
+	CoppeliasimHandlerParameters parameters;
+	parameters.pollingSchedule.targets.emplace_back("robotWaving", 10, 1);
+	REQUIRE_THROWS_AS(CoppeliasimHandler(std::make_unique<SimulatedPipelinedConnection>(scene), parameters), std::runtime_error);
+}
+
+TEST_CASE("Scheduled polling does not lose edges", "[polling schedule]")
+{
+	const PlayedScript scheduled = playScript(makeFlagPerSignalScript(), makeDefaultPollingSchedule());
+
+	REQUIRE(scheduled.humanGraspEdges == 5);
+	REQUIRE(scheduled.robotGraspEdges == 3);
+}
+
+TEST_CASE("Scheduled polling leaves a busy scene to the hand", "[polling schedule]")
+{
+	// Read at every opportunity, the flags take every other request.
+	const double unscheduledRate = simulateHandRate(PollingScheduleParameters());
+	const double scheduledRate = simulateHandRate(makeDefaultPollingSchedule());
+
+	REQUIRE(unscheduledRate < 13000);
+	REQUIRE(scheduledRate > 1.5 * unscheduledRate);
+}
+
+TEST_CASE("Benchmark scheduled polling", "[.][benchmark][polling schedule]")
+{
+	const SceneScript script = makeFlagPerSignalScript();
+	const double unscheduledRate = playScript(script, PollingScheduleParameters()).poseRate;
+	const double scheduledRate = playScript(script, makeDefaultPollingSchedule()).poseRate;
+	std::cout << "Hand pose: " << unscheduledRate << " samples/s with every flag read at every opportunity, "
+		<< scheduledRate << " samples/s scheduled" << std::endl;
+
+	REQUIRE(scheduledRate > 1.5 * unscheduledRate);
+}
@@ -0,0 +1,124 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "pose_telemetry.h"
+#include "spsc_ring_buffer.h"
+
+namespace
+{
+	Pose makePose(int i)
+	{
+		const double v = static_cast<double>(i);
+		return { { v, v + 0.5, v + 0.25 }, { -v, 0.0, 1.0 } };
+	}
+
+	std::string temporaryPath(const std::string& name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+}
+
+TEST_CASE("Ring buffer rejects pushes when full", "[telemetry]")
+{
+	SpscRingBuffer<int> ring(3);
+	REQUIRE(ring.getCapacity() == 4);
+	for (int i = 0; i < 4; ++i)
+		REQUIRE(ring.tryPush(i));
+	REQUIRE_FALSE(ring.tryPush(4));
+
+	int item = -1;
+	REQUIRE(ring.tryPop(item));
+	REQUIRE(item == 0);
+	REQUIRE(ring.tryPush(4));
+	for (int expected = 1; expected <= 4; ++expected)
+	{
+		REQUIRE(ring.tryPop(item));
+		REQUIRE(item == expected);
+	}
+	REQUIRE(ring.isEmpty());
+}
+
+TEST_CASE("Pose stream round trips through CSV", "[telemetry]")
+{
+	constexpr int numberOfPoses = 1000;
+	const std::string path = temporaryPath("test_pose_telemetry.bin");
+	const auto start = std::chrono::steady_clock::now();
+
+	{
+		PoseTelemetryWriter writer(numberOfPoses);
+		REQUIRE(writer.open(path));
+		for (int i = 0; i < numberOfPoses; ++i)
+			writer.record(i + 1, start + std::chrono::milliseconds(i), makePose(i));
+		writer.close();
+		REQUIRE(writer.getNumberOfRecorded() == numberOfPoses);
+		REQUIRE(writer.getNumberOfDropped() == 0);
+	}
+
+	REQUIRE(std::filesystem::file_size(path) == sizeof(PoseTelemetryHeader) + numberOfPoses * sizeof(PoseTelemetryRecord));
+
+	std::ifstream input(path, std::ifstream::binary);
+	std::stringstream csv;
+	REQUIRE(convertPoseTelemetryToCsv(input, csv));
+
+	std::string line;
+	std::getline(csv, line);
+	REQUIRE(line.rfind("sequence,", 0) == 0);
+	int rows = 0;
+	while (std::getline(csv, line))
+	{
+		++rows;
+		REQUIRE(line.substr(0, line.find(',')) == std::to_string(rows));
+	}
+	REQUIRE(rows == numberOfPoses);
+
+	input.close();
+	std::filesystem::remove(path);
+}
+
+TEST_CASE("Full pose ring drops new samples instead of blocking", "[telemetry]")
+{
+	// Not opened, so nothing drains the ring.
+	PoseTelemetryWriter writer(8);
+	for (int i = 0; i < 20; ++i)
+		writer.record(i + 1, std::chrono::steady_clock::now(), makePose(i));
+	REQUIRE(writer.getNumberOfRecorded() == 8);
+	REQUIRE(writer.getNumberOfDropped() == 12);
+}
+
+TEST_CASE("Non pose streams are rejected", "[telemetry]")
+{
+	std::stringstream input("Hand pose: x = 0.0, y = 0.0");
+	std::stringstream output;
+	REQUIRE_FALSE(convertPoseTelemetryToCsv(input, output));
+}
+
+TEST_CASE("Benchmark hand pose logging cost", "[.][benchmark][telemetry]")
+{
+	const std::string path = temporaryPath("benchmark_pose_telemetry.bin");
+	PoseTelemetryWriter writer;
+	REQUIRE(writer.open(path));
+	const Pose pose = makePose(1);
+	std::uint64_t sequence = 0;
+
+	BENCHMARK("binary record")
+	{
+		writer.record(++sequence, std::chrono::steady_clock::now(), pose);
+	};
+
+	std::ofstream textFile(temporaryPath("benchmark_pose_text.txt"));
+	BENCHMARK("text line with flush")
+	{
+		textFile << "Hand pose: x = " << std::to_string(pose.position.x)
+			<< ", y = " << std::to_string(pose.position.y)
+			<< ", z = " << std::to_string(pose.position.z) << "\n";
+		textFile.flush();
+	};
+
+	writer.close();
+	std::filesystem::remove(path);
+	std::filesystem::remove(temporaryPath("benchmark_pose_text.txt"));
+}
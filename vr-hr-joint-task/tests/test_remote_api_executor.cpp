@@ -0,0 +1,323 @@
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+
+#include "coppeliasim_handler.h"
+#include "remote_api_executor.h"
+#include "simulated_coppeliasim.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	using Clock = RemoteApiExecutor::Clock;
+
+	template<typename Predicate>
+	bool waitUntil(Predicate predicate, std::chrono::milliseconds timeout = 2000ms)
+	{
+		const auto until = std::chrono::steady_clock::now() + timeout;
+		while (!predicate())
+		{
+			if (std::chrono::steady_clock::now() > until)
+				return false;
+			std::this_thread::sleep_for(1ms);
+		}
+		return true;
+	}
+
+	Pose at(double x, double y, double z)
+	{
+		return { { x, y, z }, {} };
+	}
+
+	// Refuses the first attempts, then answers every request at once.
+	class FlakyConnection : public PipelinedConnection
+	{
+	private:
+		int failures;
+		std::vector<Completion> completed;
+	public:
+		std::vector<Clock::time_point> attempts;
+
+		explicit FlakyConnection(int failures) : failures(failures) {}
+
+		bool connect() override
+		{
+			attempts.push_back(Clock::now());
+			return static_cast<int>(attempts.size()) > failures;
+		}
+		bool isConnected() const override { return static_cast<int>(attempts.size()) > failures; }
+		void send(std::uint64_t id, const RemoteApiRequest&) override { completed.emplace_back(id, RemoteApiResponse()); }
+		void receive(std::vector<Completion>& responses) override
+		{
+			responses.insert(responses.end(), completed.begin(), completed.end());
+			completed.clear();
+		}
+		std::optional<Clock::time_point> getNextResponseTime() const override
+		{
+			return completed.empty() ? std::nullopt : std::optional<Clock::time_point>(Clock::now());
+		}
+	};
+
+	Task<int> add(int a, int b)
+	{
+		co_return a + b;
+	}
+
+	Task<int> addTwice(int a, int b)
+	{
+		const int once = co_await add(a, b);
+		co_return once + co_await add(a, b);
+	}
+
+	Task<void> fail()
+	{
+		throw std::runtime_error("failed");
+		co_return;
+	}
+}
+
+TEST_CASE("Tasks return their result to the awaiting coroutine", "[remote api executor]")
+{
+	SimulatedCoppeliaSim scene;
+	RemoteApiExecutor executor(std::make_unique<SimulatedPipelinedConnection>(scene));
+
+	int result = 0;
+	bool caught = false;
+	// Named, as the frame of a coroutine lambda refers to the lambda.
+	const auto body = [&]() -> Task<void> {
+		result = co_await addTwice(2, 3);
+		try
+		{
+			co_await fail();
+		}
+		catch (const std::runtime_error&)
+		{
+			caught = true;
+		}
+	};
+	executor.spawn(body());
+	executor.run();
+	REQUIRE(result == 10);
+	REQUIRE(caught);
+
+	// A task that throws ends the loop.
+	executor.spawn(fail());
+	REQUIRE_THROWS_AS(executor.run(), std::runtime_error);
+}
+
+TEST_CASE("Requests are pipelined over one connection", "[remote api executor]")
+{
+	SimulatedCoppeliaSim scene;
+	scene.setSignal("robotApproaching", 1);
+	RemoteApiExecutor executor(std::make_unique<SimulatedPipelinedConnection>(scene, SimulatedConnectionParameters(2ms)));
+	AsyncRemoteApiClient client(executor);
+	constexpr int numberOfRequests = 20;
+
+	std::vector<int> values;
+	Clock::duration elapsed{};
+	const auto body = [&]() -> Task<void> {
+		const std::atomic<bool> stopRequested(false);
+		const bool connected = co_await client.connect(stopRequested);
+		REQUIRE(connected);
+
+		const Clock::time_point start = Clock::now();
+		std::vector<RemoteApiExecutor::Request> reads;
+		for (int i = 0; i < numberOfRequests; ++i)
+			reads.push_back(client.getIntegerSignal("robotApproaching"));
+		REQUIRE(executor.getNumberOfOutstandingRequests() == numberOfRequests);
+		for (RemoteApiExecutor::Request& read : reads)
+			values.push_back((co_await read).value);
+		std::vector<std::pair<std::string, int>> writes = { { "targetObject", 2 }, { "startSim", 1 } };
+		co_await client.writeSignals(std::move(writes));
+		elapsed = Clock::now() - start;
+	};
+	executor.spawn(body());
+	executor.run();
+
+	REQUIRE(values == std::vector<int>(numberOfRequests, 1));
+	REQUIRE(scene.getSignal("targetObject") == 2);
+	REQUIRE(scene.getSignal("startSim") == 1);
+	REQUIRE(executor.getNumberOfRequests() == numberOfRequests + 2);
+	REQUIRE(executor.getNumberOfOutstandingRequests() == 0);
+	// All the reads were outstanding at once (above); the reads and the writes each take at least a round trip.
+	REQUIRE(elapsed >= 4ms);
+	REQUIRE(scene.getLatency(RemoteApiCall::GET_INTEGER_SIGNAL).getCount() == numberOfRequests);
+}
+
+TEST_CASE("Connecting backs off between attempts", "[remote api executor]")
+{
+	SECTION("Until connected")
+	{
+		auto connection = std::make_unique<FlakyConnection>(3);
+		FlakyConnection& flaky = *connection;
+		RemoteApiExecutor executor(std::move(connection));
+		AsyncRemoteApiClient client(executor, ConnectionBackoff(5ms, 15ms));
+
+		bool connected = false;
+		const auto body = [&]() -> Task<void> {
+			const std::atomic<bool> stopRequested(false);
+			connected = co_await client.connect(stopRequested);
+		};
+		executor.spawn(body());
+		executor.run();
+
+		REQUIRE(connected);
+		REQUIRE(flaky.attempts.size() == 4);
+		// 5, 10, then capped at 15 ms.
+		REQUIRE(flaky.attempts[1] - flaky.attempts[0] >= 5ms);
+		REQUIRE(flaky.attempts[2] - flaky.attempts[1] >= 10ms);
+		REQUIRE(flaky.attempts[3] - flaky.attempts[2] >= 15ms);
+	}
+
+	SECTION("Until stopped")
+	{
+		RemoteApiExecutor executor(std::make_unique<FlakyConnection>(1000));
+		AsyncRemoteApiClient client(executor, ConnectionBackoff(1ms, 2ms));
+		std::atomic<bool> stopRequested(false);
+
+		bool connected = true;
+		const auto body = [&]() -> Task<void> {
+			connected = co_await client.connect(stopRequested);
+		};
+		executor.spawn(body());
+		std::thread stopper([&] {
+			std::this_thread::sleep_for(20ms);
+			stopRequested = true;
+		});
+		executor.run();
+		stopper.join();
+		REQUIRE_FALSE(connected);
+	}
+}
+
+TEST_CASE("Events wake a waiting coroutine or time out", "[remote api executor]")
+{
+	SimulatedCoppeliaSim scene;
+	RemoteApiExecutor executor(std::make_unique<SimulatedPipelinedConnection>(scene));
+	RemoteApiExecutor::Event event(executor);
+
+	bool timedOut = false, notified = false;
+	Clock::duration waited{};
+	const auto body = [&]() -> Task<void> {
+		const bool notifiedEarly = co_await event.waitFor(5ms);
+		timedOut = !notifiedEarly;
+		const Clock::time_point start = Clock::now();
+		notified = co_await event.waitFor(5s);
+		waited = Clock::now() - start;
+	};
+	executor.spawn(body());
+	std::thread notifier([&] {
+		std::this_thread::sleep_for(30ms);
+		event.notify();
+	});
+	executor.run();
+	notifier.join();
+
+	REQUIRE(timedOut);
+	REQUIRE(notified);
+	REQUIRE(waited < 1s);
+	REQUIRE(executor.getActivity().getWakeupsPerSecond() > 0);
+}
+
+TEST_CASE("The handler runs over one pipelined connection", "[remote api executor]")
+{
+	IncomingSignals present;
+	present.simStarted = present.object1 = present.object2 = present.object3 = true;
+	IncomingSignals grasped = present;
+	grasped.humanGraspObj1 = true;
+
+	SceneScript script;
+	script.trajectories["RightController"] = { { 0ms, at(0.35, 0, 0.95) }, { 200ms, at(0.1, 0.2, 0.75) } };
+	script.signals = { { 0ms, IncomingSignalsSnapshot::SIGNAL, IncomingSignalsSnapshot::pack(present) },
+		{ 100ms, IncomingSignalsSnapshot::SIGNAL, IncomingSignalsSnapshot::pack(grasped) } };
+	SimulatedCoppeliaSim scene(script);
+	scene.addObject("RightController");
+
+	CoppeliasimHandler handler(std::make_unique<SimulatedPipelinedConnection>(scene, SimulatedConnectionParameters(300us, 100us)),
+		{ 0ms, 0us, 3 });
+	handler.init();
+
+	REQUIRE(waitUntil([&] { return handler.getSignals().humanGraspObj1; }));
+	REQUIRE(handler.getSignals() == grasped);
+	REQUIRE(waitUntil([&] { return handler.getHandPose() == at(0.1, 0.2, 0.75); }));
+
+	OutgoingSignals signals;
+	signals.targetObject = 3;
+	handler.setSignals(signals);
+	REQUIRE(waitUntil([&] { return scene.getSignal(OutgoingSignals::TARGET_OBJECT) == 3; }));
+	REQUIRE(handler.isConnected());
+	REQUIRE(handler.getThreadActivities().size() == 1);
+
+	handler.end();
+	REQUIRE_FALSE(scene.isRunning());
+	REQUIRE(scene.getLatency(RemoteApiCall::STOP_SIMULATION).getCount() == 1);
+}
+
+TEST_CASE("Handlers are made for each transport", "[remote api executor]")
+{
+	REQUIRE(makeCoppeliasimHandler(CoppeliasimTransport::REMOTE_API_THREADS).getThreadActivities().size() == 3);
+	REQUIRE(makeCoppeliasimHandler(CoppeliasimTransport::PIPELINED).getThreadActivities().size() == 1);
+}
+
+TEST_CASE("Benchmark pipelined against three-thread I/O", "[.][benchmark][remote api executor]")
+{
+	constexpr auto duration = 1s;
+	SceneScript script;
+	script.trajectories["RightController"] = { { 0ms, at(0, 0, 0) }, { 1000ms, at(1, 1, 1) } };
+	script.signals = { { 0ms, IncomingSignalsSnapshot::SIGNAL, IncomingSignalsSnapshot::pack({}) } };
+	script.loop = true;
+
+	const auto measure = [&](const char* label, SimulatedConnectionParameters connection,
+		const std::function<std::unique_ptr<CoppeliasimHandler>(SimulatedCoppeliaSim&)>& makeHandler)
+	{
+		SimulatedCoppeliaSim scene(script);
+		scene.addObject("RightController");
+		std::unique_ptr<CoppeliasimHandler> handler = makeHandler(scene);
+		handler->init();
+
+		// The age of the freshest pose, sampled at 1 kHz as a control loop would.
+		LatencyHistogram poseAge;
+		std::uint64_t firstSequence = 0, lastSequence = 0;
+		const auto start = Clock::now();
+		while (Clock::now() - start < duration)
+		{
+			std::this_thread::sleep_for(1ms);
+			const Snapshot<Pose> pose = handler->getHandPoseSnapshot();
+			if (pose.sequence == 0)
+				continue;
+			if (firstSequence == 0)
+				firstSequence = pose.sequence;
+			lastSequence = pose.sequence;
+			poseAge.record(Clock::now() - pose.captureTime);
+		}
+		scene.close();
+		handler->end();
+
+		const LatencyHistogram& poseRead = scene.getLatency(RemoteApiCall::GET_OBJECT_POSE);
+		std::cout << label << " (round trip " << std::chrono::duration<double, std::micro>(connection.roundTripTime).count()
+			<< " us, jitter " << std::chrono::duration<double, std::micro>(connection.jitter).count() << " us): "
+			<< scene.getRequestRate() << " requests/s, "
+			<< static_cast<double>(lastSequence - firstSequence) / std::chrono::duration<double>(duration).count() << " poses/s"
+			<< ", pose read p50 " << std::chrono::duration<double, std::micro>(poseRead.getPercentile(50)).count() << " us"
+			<< ", p99 " << std::chrono::duration<double, std::micro>(poseRead.getPercentile(99)).count() << " us"
+			<< ", pose age p50 " << std::chrono::duration<double, std::micro>(poseAge.getPercentile(50)).count() << " us"
+			<< ", p99 " << std::chrono::duration<double, std::micro>(poseAge.getPercentile(99)).count() << " us" << std::endl;
+	};
+
+	for (const SimulatedConnectionParameters connection : { SimulatedConnectionParameters(200us), SimulatedConnectionParameters(1ms, 200us) })
+	{
+		measure("three threads", connection, [&](SimulatedCoppeliaSim& scene) {
+			return std::make_unique<CoppeliasimHandler>(std::make_unique<SimulatedRemoteApiClient>(scene, connection),
+				std::make_unique<SimulatedRemoteApiClient>(scene, connection),
+				std::make_unique<SimulatedRemoteApiClient>(scene, connection));
+		});
+		for (const std::size_t readsInFlight : { 1, 4 })
+			measure(readsInFlight == 1 ? "pipelined, 1 read in flight" : "pipelined, 4 reads in flight", connection,
+				[&](SimulatedCoppeliaSim& scene) {
+					return std::make_unique<CoppeliasimHandler>(std::make_unique<SimulatedPipelinedConnection>(scene, connection),
+						CoppeliasimHandlerParameters(std::chrono::milliseconds(500), std::chrono::microseconds(1000), readsInFlight));
+				});
+	}
+}
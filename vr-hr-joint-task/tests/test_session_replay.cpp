@@ -0,0 +1,130 @@
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <catch2/catch_test_macros.hpp>
+
+#include "seeded_normal_noise.h"
+#include "session_replay.h"
+#include "session_trace.h"
+
+namespace
+{
+	// Hand sweeping across the table towards object 1 with every object present, one pass every 20 ms
+	// against a 65 ms step, as the live control loop would record it.
+	SessionTrace makeTrace(std::uint64_t noiseSeed, int numberOfPasses)
+	{
+		const std::string path = (std::filesystem::temp_directory_path() / "test_session.trace").string();
+		{
+			SessionRecorder recorder(static_cast<std::size_t>(numberOfPasses));
+			REQUIRE(recorder.open(path, DnfArchitectureType::HAND_MOTION, 65, noiseSeed));
+
+			IncomingSignals signals;
+			signals.simStarted = signals.object1 = signals.object2 = signals.object3 = true;
+			const auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < numberOfPasses; ++i)
+			{
+				Snapshot<Pose> handPose;
+				handPose.sequence = i + 1;
+				handPose.captureTime = start + std::chrono::milliseconds(20 * i);
+				handPose.value = { { 0.3 * std::cos(i * 0.01), 0.25 - 0.5 * i / numberOfPasses, 0.8 }, {} };
+				recorder.record(static_cast<std::uint64_t>(20 * i / 65), handPose.captureTime, handPose, signals, 0);
+			}
+			recorder.close();
+			REQUIRE(recorder.getNumberOfDropped() == 0);
+		}
+		SessionTrace trace = readSessionTrace(path);
+		std::filesystem::remove(path);
+		return trace;
+	}
+}
+
+TEST_CASE("Seeded noise rewinds on init", "[replay]")
+{
+	using namespace dnf_composer::element;
+	const ElementSpatialDimensionParameters dimensions{ 50, 0.5 };
+	SeededNormalNoise noise({ "normal noise", dimensions }, NormalNoiseParameters{ 0.001 }, 3);
+	SeededNormalNoise other({ "normal noise", dimensions }, NormalNoiseParameters{ 0.001 }, 3);
+
+	noise.init();
+	noise.step(0, 65);
+	const std::vector<double> first = *noise.getComponentPtr("output");
+	noise.step(65, 65);
+	REQUIRE(*noise.getComponentPtr("output") != first);
+
+	noise.init();
+	noise.step(0, 65);
+	other.init();
+	other.step(0, 65);
+	REQUIRE(*noise.getComponentPtr("output") == first);
+	REQUIRE(*other.getComponentPtr("output") == first);
+	REQUIRE(SeededNormalNoise::deriveSeed(3, "normal noise aol") != SeededNormalNoise::deriveSeed(3, "normal noise asl"));
+}
+
+TEST_CASE("Session traces round trip", "[replay]")
+{
+	const SessionTrace trace = makeTrace(42, 100);
+	REQUIRE(trace.getArchitectureType() == DnfArchitectureType::HAND_MOTION);
+	REQUIRE(trace.getNoiseSeed() == 42u);
+	REQUIRE(trace.header.deltaT == 65);
+	REQUIRE(trace.records.size() == 100);
+	REQUIRE(trace.records[99].handPoseSequence == 100);
+	REQUIRE(trace.records[99].dnfStep == 20 * 99 / 65);
+
+	IncomingSignals signals;
+	REQUIRE(IncomingSignalsSnapshot::unpack(trace.records[0].incomingSignals, signals));
+	REQUIRE(signals.object2);
+	REQUIRE_FALSE(signals.robotGrasping);
+}
+
+TEST_CASE("Non trace files are rejected", "[replay]")
+{
+	std::stringstream input("2024-01-01 00:00:00 CONTROL Session started");
+	REQUIRE_THROWS(readSessionTrace(input));
+}
+
+TEST_CASE("Traces of an older version are rejected", "[replay]")
+{
+	SessionTraceHeader header{};
+	std::memcpy(header.magic, SessionTraceHeader::MAGIC, sizeof(header.magic));
+	header.version = 1;
+	header.recordSize = sizeof(SessionTraceRecord);
+	const SessionTraceRecord record{};
+	std::stringstream input;
+	input.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	input.write(reinterpret_cast<const char*>(&record), sizeof(record));
+	REQUIRE_THROWS_AS(readSessionTrace(input), std::runtime_error);
+
+	input.clear();
+	input.seekp(0);
+	header.version = SessionTraceHeader::VERSION;
+	input.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	input.seekg(0);
+	REQUIRE(readSessionTrace(input).records.size() == 1);
+}
+
+TEST_CASE("Seeded replays are bit-identical", "[replay]")
+{
+	const SessionTrace trace = makeTrace(7, 500);
+
+	const SessionReplayResult first = replaySession(trace);
+	const SessionReplayResult second = replaySession(trace);
+	REQUIRE(first.steps == trace.records.back().dnfStep);
+	REQUIRE(first.targetObjects.size() == trace.records.size());
+	REQUIRE(first.targetObjects == second.targetObjects);
+	REQUIRE(first.finalActivation == second.finalActivation);
+
+	const SessionReplayResult otherSeed = replaySession(trace, DnfArchitectureOptions(8));
+	REQUIRE(otherSeed.finalActivation != first.finalActivation);
+}
+
+TEST_CASE("Benchmark replay throughput", "[.][benchmark][replay]")
+{
+	const SessionTrace trace = makeTrace(1, 20000);
+	const SessionReplayResult result = replaySession(trace);
+	std::cout << "Replayed " << result.steps << " steps (" << result.simulatedTime.count() << " simulated s) in "
+		<< result.wallTime.count() << " s: " << result.getSimulatedSecondsPerWallSecond()
+		<< " simulated s per wall s" << std::endl;
+}
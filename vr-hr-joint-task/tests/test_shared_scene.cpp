@@ -0,0 +1,271 @@
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+
+#include "coppeliasim_handler.h"
+#include "shared_scene_state.h"
+#include "simulated_coppeliasim.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	template<typename Predicate>
+	bool waitUntil(Predicate predicate, std::chrono::milliseconds timeout = 2000ms)
+	{
+		const auto until = Clock::now() + timeout;
+		while (!predicate())
+		{
+			if (Clock::now() > until)
+				return false;
+			std::this_thread::sleep_for(1ms);
+		}
+		return true;
+	}
+
+	Pose at(double x, double y, double z)
+	{
+		return { { x, y, z }, {} };
+	}
+
+	// Tests may run concurrently with other test binaries on the host.
+	std::string makeRegionName()
+	{
+		return "vr-hr-joint-task-test-" + std::to_string(Clock::now().time_since_epoch().count());
+	}
+}
+
+TEST_CASE("Shared scene clients wait for the region and refuse other layouts", "[shared scene]")
+{
+	const std::string name = makeRegionName();
+	SharedSceneClient client(name);
+	REQUIRE_FALSE(client.connect());
+	REQUIRE_FALSE(client.isConnected());
+
+	{
+		SharedSceneServer server(name);
+		REQUIRE(client.connect());
+		REQUIRE(client.isConnected());
+
+		// Both sides see the same snapshots.
+		server.getState().handPose.publish(at(0.1, 0.2, 0.3), Clock::time_point(5ms));
+		const Snapshot<Pose> pose = client.getState().handPose.read();
+		REQUIRE(pose.value == at(0.1, 0.2, 0.3));
+		REQUIRE(pose.sequence == 1);
+		REQUIRE(pose.captureTime == Clock::time_point(5ms));
+		client.getState().outgoingSignals.publish({ 1, 2 });
+		REQUIRE(server.getState().outgoingSignals.read().value.targetObject == 2);
+
+		server.close();
+		REQUIRE_FALSE(client.isConnected());
+	}
+
+	const std::string otherName = makeRegionName();
+	SharedSceneServer server(otherName);
+	server.getState().version = SharedSceneState::VERSION + 1;
+	SharedSceneClient otherClient(otherName);
+	REQUIRE_THROWS_AS(otherClient.connect(), std::runtime_error);
+}
+
+TEST_CASE("Shared scene clients map the region of a restarted simulator", "[shared scene]")
+{
+	const std::string name = makeRegionName();
+	SharedSceneClient client(name, 50ms);
+	auto server = std::make_unique<SharedSceneServer>(name);
+	REQUIRE(client.connect());
+	const SharedSceneState& first = client.getState();
+
+	// Crashed: the region stays open but its heartbeat stops.
+	std::this_thread::sleep_for(100ms);
+	REQUIRE_FALSE(client.isConnected());
+	REQUIRE_FALSE(client.connect());
+
+	server.reset();
+	server = std::make_unique<SharedSceneServer>(name);
+	REQUIRE(client.connect());
+	REQUIRE(client.isConnected());
+	REQUIRE(&client.getState() != &first);
+	server->getState().handPose.publish(at(0.1, 0.2, 0.3));
+	REQUIRE(client.getState().handPose.read().value == at(0.1, 0.2, 0.3));
+	// Still mapped for whoever was reading it.
+	REQUIRE(first.handPose.getSequence() == 0);
+}
+
+TEST_CASE("The handler runs over a shared scene region", "[shared scene]")
+{
+	IncomingSignals present;
+	present.simStarted = present.object1 = present.object2 = present.object3 = true;
+	IncomingSignals grasped = present;
+	grasped.humanGraspObj1 = true;
+
+	SceneScript script;
+	script.trajectories["RightController"] = { { 0ms, at(0.35, 0, 0.95) }, { 200ms, at(0.1, 0.2, 0.75) } };
+	script.signals = { { 0ms, IncomingSignalsSnapshot::SIGNAL, IncomingSignalsSnapshot::pack(present) },
+		{ 100ms, IncomingSignalsSnapshot::SIGNAL, IncomingSignalsSnapshot::pack(grasped) } };
+	SimulatedCoppeliaSim scene(script);
+	scene.addObject("RightController");
+	// The simulator runs before it creates the region.
+	scene.start();
+
+	const std::string name = makeRegionName();
+	// The handler comes up first and waits for the region.
+	CoppeliasimHandler handler(std::make_unique<SharedSceneClient>(name), { 0ms, 0us, 2, ConnectionBackoff(1ms, 10ms) });
+	handler.init();
+	SimulatedSharedSceneServer server(scene, name);
+
+	REQUIRE(waitUntil([&] { return handler.getSignals().humanGraspObj1; }));
+	REQUIRE(handler.getSignals() == grasped);
+	REQUIRE(waitUntil([&] { return handler.getHandPose() == at(0.1, 0.2, 0.75); }));
+	// Samples carry the simulator's step time.
+	const Snapshot<Pose> pose = handler.getHandPoseSnapshot();
+	REQUIRE(pose.captureTime <= Clock::now());
+	REQUIRE(Clock::now() - pose.captureTime < 1s);
+
+	OutgoingSignals signals;
+	signals.targetObject = 3;
+	handler.setSignals(signals);
+	REQUIRE(waitUntil([&] { return scene.getSignal(OutgoingSignals::TARGET_OBJECT) == 3; }));
+	REQUIRE(handler.isConnected());
+	REQUIRE(handler.getThreadActivities().size() == 1);
+	REQUIRE(server.getNumberOfSteps() > 0);
+
+	server.close();
+	REQUIRE_FALSE(handler.isConnected());
+	handler.end();
+	// The simulator owns the simulation in this mode.
+	REQUIRE(scene.isRunning());
+	REQUIRE(scene.getNumberOfRequests() == 0);
+}
+
+TEST_CASE("Hand poses the simulator overwrote count as dropped", "[shared scene][telemetry]")
+{
+	const std::string name = makeRegionName();
+	SharedSceneServer server(name);
+	// Not opened, the ring holds every sample of the test.
+	PoseTelemetryWriter telemetry(64);
+	CoppeliasimHandler handler(std::make_unique<SharedSceneClient>(name),
+		{ 0ms, 0us, 2, ConnectionBackoff(1ms, 10ms), 20000us });
+	handler.setHandPoseTelemetry(&telemetry);
+	handler.init();
+
+	server.getState().handPose.publish(at(0, 0, 0));
+	REQUIRE(waitUntil([&] { return handler.getHandPoseSnapshot().sequence == 1; }));
+	// A burst between two polls of the region.
+	for (int i = 1; i <= 5; ++i)
+		server.getState().handPose.publish(at(i, 0, 0));
+	REQUIRE(waitUntil([&] { return handler.getHandPose() == at(5, 0, 0); }));
+	handler.end();
+
+	// Every sample the simulator published is either recorded or counted as dropped.
+	REQUIRE(telemetry.getNumberOfRecorded() + telemetry.getNumberOfDropped() == 6);
+	REQUIRE(telemetry.getNumberOfRecorded() == handler.getHandPoseSnapshot().sequence);
+}
+
+TEST_CASE("A simulator that stops stepping reads as disconnected", "[shared scene]")
+{
+	SimulatedCoppeliaSim scene;
+	scene.addObject("RightController");
+	scene.start();
+	const std::string name = makeRegionName();
+	SimulatedSharedSceneServer server(scene, name);
+
+	CoppeliasimHandler handler(std::make_unique<SharedSceneClient>(name, 50ms), { 0ms, 0us, 2, ConnectionBackoff(1ms, 10ms) });
+	handler.init();
+	REQUIRE(waitUntil([&] { return handler.isConnected(); }));
+
+	// Crashed: the region stays open but its heartbeat stops.
+	server.hang();
+	REQUIRE(waitUntil([&] { return !handler.isConnected(); }));
+	handler.end();
+
+	// Nor does a new client take up the region left behind.
+	SharedSceneClient client(name, 50ms);
+	REQUIRE_FALSE(client.connect());
+}
+
+TEST_CASE("The handler gives up on a shared scene of another layout", "[shared scene]")
+{
+	const std::string name = makeRegionName();
+	SharedSceneServer server(name);
+	server.getState().version = SharedSceneState::VERSION + 1;
+
+	CoppeliasimHandler handler(std::make_unique<SharedSceneClient>(name), { 0ms, 0us, 2, ConnectionBackoff(1ms, 10ms) });
+	handler.init();
+	REQUIRE(waitUntil([&] { return handler.hasFailed(); }));
+	REQUIRE_FALSE(handler.isConnected());
+	handler.end();
+}
+
+TEST_CASE("A handler is made for the shared memory transport", "[shared scene]")
+{
+	const CoppeliasimHandler shared = makeCoppeliasimHandler(CoppeliasimTransport::SHARED_MEMORY);
+	REQUIRE(shared.getThreadActivities().front()->getReport().starts_with("Shared scene"));
+	REQUIRE_FALSE(shared.isConnected());
+}
+
+TEST_CASE("Benchmark shared memory against remote API pose freshness", "[.][benchmark][shared scene]")
+{
+	constexpr auto duration = 1s;
+	SceneScript script;
+	script.trajectories["RightController"] = { { 0ms, at(0, 0, 0) }, { 1000ms, at(1, 1, 1) } };
+	script.signals = { { 0ms, IncomingSignalsSnapshot::SIGNAL, IncomingSignalsSnapshot::pack({}) } };
+	script.loop = true;
+
+	const auto measure = [&](const std::string& label,
+		const std::function<std::unique_ptr<CoppeliasimHandler>(SimulatedCoppeliaSim&, std::unique_ptr<SimulatedSharedSceneServer>&)>& makeHandler)
+	{
+		SimulatedCoppeliaSim scene(script);
+		scene.addObject("RightController");
+		std::unique_ptr<SimulatedSharedSceneServer> server;
+		std::unique_ptr<CoppeliasimHandler> handler = makeHandler(scene, server);
+		handler->init();
+
+		// The age of the freshest pose, sampled at 1 kHz as a control loop would.
+		LatencyHistogram poseAge;
+		std::uint64_t firstSequence = 0, lastSequence = 0;
+		const auto start = Clock::now();
+		while (Clock::now() - start < duration)
+		{
+			std::this_thread::sleep_for(1ms);
+			const Snapshot<Pose> pose = handler->getHandPoseSnapshot();
+			if (pose.sequence == 0)
+				continue;
+			if (firstSequence == 0)
+				firstSequence = pose.sequence;
+			lastSequence = pose.sequence;
+			poseAge.record(Clock::now() - pose.captureTime);
+		}
+		scene.close();
+		if (server)
+			server->close();
+		handler->end();
+
+		std::cout << label << ": "
+			<< static_cast<double>(lastSequence - firstSequence) / std::chrono::duration<double>(duration).count() << " poses/s"
+			<< ", pose age p50 " << std::chrono::duration<double, std::micro>(poseAge.getPercentile(50)).count() << " us"
+			<< ", p99 " << std::chrono::duration<double, std::micro>(poseAge.getPercentile(99)).count() << " us" << std::endl;
+	};
+
+	const SimulatedConnectionParameters connection(200us);
+	measure("three threads, round trip 200 us", [&](SimulatedCoppeliaSim& scene, std::unique_ptr<SimulatedSharedSceneServer>&) {
+		return std::make_unique<CoppeliasimHandler>(std::make_unique<SimulatedRemoteApiClient>(scene, connection),
+			std::make_unique<SimulatedRemoteApiClient>(scene, connection),
+			std::make_unique<SimulatedRemoteApiClient>(scene, connection));
+	});
+	measure("pipelined, 4 reads in flight, round trip 200 us", [&](SimulatedCoppeliaSim& scene, std::unique_ptr<SimulatedSharedSceneServer>&) {
+		return std::make_unique<CoppeliasimHandler>(std::make_unique<SimulatedPipelinedConnection>(scene, connection),
+			CoppeliasimHandlerParameters(500ms, 1000us, 4));
+	});
+	// Freshness over shared memory is bounded by how often the simulator publishes, not by a round trip.
+	for (const std::chrono::microseconds stepPeriod : { 1000us, 100us })
+		measure("shared memory, step " + std::to_string(stepPeriod.count()) + " us",
+			[&](SimulatedCoppeliaSim& scene, std::unique_ptr<SimulatedSharedSceneServer>& server) {
+				scene.start();
+				const std::string name = makeRegionName();
+				server = std::make_unique<SimulatedSharedSceneServer>(scene, name, SimulatedSharedSceneParameters(stepPeriod));
+				return std::make_unique<CoppeliasimHandler>(std::make_unique<SharedSceneClient>(name));
+			});
+}
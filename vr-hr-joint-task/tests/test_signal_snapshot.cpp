@@ -0,0 +1,161 @@
+#include <iostream>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+
+#include "coppeliasim_handler.h"
+#include "mock_remote_api_client.h"
+#include "simulated_coppeliasim.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	template<typename Predicate>
+	bool waitUntil(Predicate predicate, std::chrono::milliseconds timeout = 2000ms)
+	{
+		const auto until = std::chrono::steady_clock::now() + timeout;
+		while (!predicate())
+		{
+			if (std::chrono::steady_clock::now() > until)
+				return false;
+			std::this_thread::sleep_for(1ms);
+		}
+		return true;
+	}
+
+	// Runs the handler against a scene without a snapshot until it has read the flags a while after seeing
+	// them set; returns the snapshot reads before and after.
+	std::pair<std::size_t, std::size_t> countSnapshotReads(bool pipelined)
+	{
+		SceneScript script;
+		// After the handler's reset.
+		script.signals = { { 20ms, IncomingSignals::SIM_STARTED, 1 }, { 20ms, IncomingSignals::OBJECT1_EXISTS, 1 } };
+		SimulatedCoppeliaSim scene(script);
+		scene.addObject("RightController");
+		scene.recordServedValues(IncomingSignalsSnapshot::SIGNAL);
+		scene.recordServedValues(IncomingSignals::SIM_STARTED);
+		const SimulatedConnectionParameters connection(100us);
+		// Every flag at every opportunity.
+		const CoppeliasimHandlerParameters parameters(0ms, 0us, 2, ConnectionBackoff(), 50us, PollingScheduleParameters());
+		const std::unique_ptr<CoppeliasimHandler> handler = pipelined
+			? std::make_unique<CoppeliasimHandler>(std::make_unique<SimulatedPipelinedConnection>(scene, connection), parameters)
+			: std::make_unique<CoppeliasimHandler>(std::make_unique<SimulatedRemoteApiClient>(scene, connection),
+				std::make_unique<SimulatedRemoteApiClient>(scene, connection),
+				std::make_unique<SimulatedRemoteApiClient>(scene, connection), parameters);
+		handler->init();
+
+		REQUIRE(waitUntil([&] { return handler->getSignals().simStarted; }));
+		const std::size_t before = scene.getServedValues(IncomingSignalsSnapshot::SIGNAL).size();
+		const std::size_t simStartedReads = scene.getServedValues(IncomingSignals::SIM_STARTED).size();
+		REQUIRE(waitUntil([&] { return scene.getServedValues(IncomingSignals::SIM_STARTED).size() >= simStartedReads + 20; }));
+		const std::size_t after = scene.getServedValues(IncomingSignalsSnapshot::SIGNAL).size();
+
+		scene.close();
+		handler->end();
+		return { before, after };
+	}
+}
+
+TEST_CASE("Packed incoming signals round trip", "[signals]")
+{
+	IncomingSignals signals;
+	signals.simStarted = true;
+	signals.object2 = true;
+	signals.robotGraspObj3 = true;
+	signals.humanPlaceObj1 = true;
+	signals.restart = true;
+
+	const int packed = IncomingSignalsSnapshot::pack(signals);
+	REQUIRE(((packed >> IncomingSignalsSnapshot::VERSION_SHIFT) & IncomingSignalsSnapshot::VERSION_MASK) == IncomingSignalsSnapshot::VERSION);
+	REQUIRE((packed & 1) == 1);
+	REQUIRE(((packed >> 19) & 1) == 1);
+
+	IncomingSignals decoded;
+	REQUIRE(IncomingSignalsSnapshot::unpack(packed, decoded));
+	REQUIRE(IncomingSignalsSnapshot::pack(decoded) == packed);
+	REQUIRE(decoded.simStarted);
+	REQUIRE_FALSE(decoded.object1);
+	REQUIRE(decoded.object2);
+	REQUIRE(decoded.robotGraspObj3);
+	REQUIRE(decoded.humanPlaceObj1);
+	REQUIRE(decoded.restart);
+	REQUIRE_FALSE(decoded.canRestart);
+}
+
+TEST_CASE("Unknown snapshot versions are rejected", "[signals]")
+{
+	IncomingSignals decoded;
+	REQUIRE_FALSE(IncomingSignalsSnapshot::unpack(0, decoded));
+	REQUIRE_FALSE(IncomingSignalsSnapshot::unpack((IncomingSignalsSnapshot::VERSION + 1) << IncomingSignalsSnapshot::VERSION_SHIFT, decoded));
+}
+
+TEST_CASE("Snapshot read costs a single round trip", "[signals]")
+{
+	MockRemoteApiClient client(std::chrono::nanoseconds(0));
+	IncomingSignals published;
+	published.object1 = true;
+	published.robotApproaching = true;
+	client.publishSignal(IncomingSignalsSnapshot::SIGNAL, IncomingSignalsSnapshot::pack(published));
+
+	const IncomingSignals signals = readIncomingSignals(client);
+	REQUIRE(client.getNumberOfCalls() == 1);
+	REQUIRE(signals.object1);
+	REQUIRE(signals.robotApproaching);
+	REQUIRE_FALSE(signals.object2);
+}
+
+TEST_CASE("Scenes without a snapshot fall back to per-signal reads", "[signals]")
+{
+	MockRemoteApiClient client(std::chrono::nanoseconds(0));
+	client.publishSignal(IncomingSignals::SIM_STARTED, 1);
+	client.publishSignal(IncomingSignals::HUMAN_GRASP_OBJ2, 1);
+
+	const IncomingSignals signals = readIncomingSignals(client);
+	REQUIRE(client.getNumberOfCalls() == 1 + IncomingSignalsSnapshot::NUMBER_OF_FLAGS);
+	REQUIRE(signals.simStarted);
+	REQUIRE(signals.humanGraspObj2);
+	REQUIRE_FALSE(signals.humanGraspObj1);
+}
+
+TEST_CASE("Scenes without a snapshot are detected once per connection", "[signals]")
+{
+	for (const bool pipelined : { false, true })
+	{
+		const auto [before, after] = countSnapshotReads(pipelined);
+		REQUIRE(before > 0);
+		REQUIRE(after == before);
+	}
+}
+
+TEST_CASE("Benchmark snapshot rate and staleness", "[.][benchmark][signals]")
+{
+	constexpr auto roundTripTime = std::chrono::microseconds(200);
+	constexpr int numberOfSnapshots = 500;
+
+	const auto measure = [&](const char* label, bool publishSnapshot)
+	{
+		MockRemoteApiClient client(roundTripTime);
+		if (publishSnapshot)
+			client.publishSignal(IncomingSignalsSnapshot::SIGNAL, IncomingSignalsSnapshot::pack({}));
+
+		std::chrono::nanoseconds totalSkew{ 0 }, maxSkew{ 0 };
+		const auto start = MockRemoteApiClient::Clock::now();
+		for (int i = 0; i < numberOfSnapshots; ++i)
+		{
+			client.resetSampleWindow();
+			readIncomingSignals(client);
+			totalSkew += client.getSampleWindow();
+			maxSkew = std::max(maxSkew, client.getSampleWindow());
+		}
+		const std::chrono::duration<double> elapsed = MockRemoteApiClient::Clock::now() - start;
+
+		std::cout << label
+			<< ": " << numberOfSnapshots / elapsed.count() << " snapshots/s"
+			<< ", mean skew " << std::chrono::duration<double, std::micro>(totalSkew).count() / numberOfSnapshots << " us"
+			<< ", max skew " << std::chrono::duration<double, std::micro>(maxSkew).count() << " us"
+			<< " (round trip " << roundTripTime.count() << " us)" << std::endl;
+	};
+
+	measure("per-signal", false);
+	measure("packed snapshot", true);
+}
@@ -0,0 +1,195 @@
+#include <filesystem>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include "coppeliasim_handler.h"
+#include "parameter_sweep.h"
+#include "simulated_coppeliasim.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	template<typename Predicate>
+	bool waitUntil(Predicate predicate, std::chrono::milliseconds timeout = 2000ms)
+	{
+		const auto until = std::chrono::steady_clock::now() + timeout;
+		while (!predicate())
+		{
+			if (std::chrono::steady_clock::now() > until)
+				return false;
+			std::this_thread::sleep_for(1ms);
+		}
+		return true;
+	}
+
+	Pose at(double x, double y, double z)
+	{
+		return { { x, y, z }, {} };
+	}
+}
+
+TEST_CASE("Signal timelines play from the simulation start", "[simulated coppeliasim]")
+{
+	SceneScript script;
+	script.signals = { { 20ms, "robotApproaching", 1 }, { 10ms, "object1", 1 }, { 30ms, "robotApproaching", 0 } };
+	SimulatedCoppeliaSim scene(script);
+
+	const auto start = std::chrono::steady_clock::now();
+	REQUIRE(scene.serveGetIntegerSignal("object1", start + 50ms) == 0);
+
+	scene.start(start);
+	REQUIRE(scene.serveGetIntegerSignal("object1", start + 5ms) == 0);
+	REQUIRE(scene.serveGetIntegerSignal("object1", start + 10ms) == 1);
+	REQUIRE(scene.serveGetIntegerSignal("robotApproaching", start + 25ms) == 1);
+	REQUIRE(scene.serveGetIntegerSignal("robotApproaching", start + 35ms) == 0);
+
+	// Scripted signals are re-asserted, as the scene script does every step.
+	scene.serveSetIntegerSignal("object1", 0, start + 40ms);
+	REQUIRE(scene.getSignal("object1") == 0);
+	REQUIRE(scene.serveGetIntegerSignal("object1", start + 41ms) == 1);
+}
+
+TEST_CASE("Trajectories are interpolated, held and looped", "[simulated coppeliasim]")
+{
+	SceneScript script;
+	script.trajectories["RightController"] = { { 0ms, at(0, 0, 0) }, { 100ms, at(1, -1, 2) } };
+	script.signals = { { 50ms, "restart", 1 } };
+
+	SECTION("Held after the last keyframe")
+	{
+		SimulatedCoppeliaSim scene(script);
+		const int hand = scene.addObject("RightController");
+		const int table = scene.addObject("Table", at(5, 5, 5));
+		const auto start = std::chrono::steady_clock::now();
+		scene.start(start);
+
+		const Pose halfway = scene.serveGetObjectPose(hand, start + 25ms);
+		REQUIRE(halfway.position.x == Catch::Approx(0.25));
+		REQUIRE(halfway.position.y == Catch::Approx(-0.25));
+		REQUIRE(halfway.position.z == Catch::Approx(0.5));
+		REQUIRE(scene.serveGetObjectPose(hand, start + 500ms) == at(1, -1, 2));
+		REQUIRE(scene.serveGetObjectPose(table, start + 500ms) == at(5, 5, 5));
+		REQUIRE(scene.serveGetObjectHandle("RightController") == hand);
+		REQUIRE(scene.serveGetObjectHandle("Missing") == -1);
+	}
+
+	SECTION("Looped")
+	{
+		script.loop = true;
+		SimulatedCoppeliaSim scene(script);
+		const int hand = scene.addObject("RightController");
+		const auto start = std::chrono::steady_clock::now();
+		scene.start(start);
+
+		REQUIRE(scene.serveGetIntegerSignal("restart", start + 60ms) == 1);
+		scene.setSignal("restart", 0);
+		REQUIRE(scene.serveGetObjectPose(hand, start + 125ms).position.x == Catch::Approx(0.25));
+		REQUIRE(scene.getSignal("restart") == 0);
+		REQUIRE(scene.serveGetIntegerSignal("restart", start + 160ms) == 1);
+	}
+}
+
+TEST_CASE("Calls take the configured round trip and are accounted for", "[simulated coppeliasim]")
+{
+	SimulatedCoppeliaSim scene;
+	SimulatedRemoteApiClient client(scene, { 300us, 200us, 7 });
+	REQUIRE(client.initialize());
+
+	for (int i = 0; i < 20; ++i)
+		client.setIntegerSignal("targetObject", i);
+	for (int i = 0; i < 10; ++i)
+		REQUIRE(client.getIntegerSignal("targetObject") == 19);
+
+	REQUIRE(scene.getNumberOfRequests() == 30);
+	const LatencyHistogram& writes = scene.getLatency(RemoteApiCall::SET_INTEGER_SIGNAL);
+	REQUIRE(writes.getCount() == 20);
+	// A call never returns before its round trip is over.
+	REQUIRE(writes.getPercentile(0) >= 280us);
+	REQUIRE(scene.getLatency(RemoteApiCall::GET_INTEGER_SIGNAL).getCount() == 10);
+	REQUIRE(scene.getRequestRate() > 0);
+	REQUIRE(scene.getRequestRate() < 1.0 / 280e-6);
+
+	scene.close();
+	REQUIRE_FALSE(client.isConnected());
+	REQUIRE_FALSE(client.initialize());
+}
+
+TEST_CASE("Recorded sessions become scene scripts", "[simulated coppeliasim]")
+{
+	const SessionTrace reach = makeSyntheticReach(DnfArchitectureType::HAND_MOTION, 2, { 65, 20ms, 1000ms, 200ms });
+	const SceneScript script = makeSceneScript(reach);
+
+	const auto& hand = script.trajectories.at("RightController");
+	REQUIRE(hand.size() == reach.records.size());
+	REQUIRE(hand.front().time == 0ns);
+	REQUIRE(hand.back().pose.position.x == reach.records.back().x);
+	// All objects present from the start, then the human grasp.
+	REQUIRE(script.signals.size() == 2);
+	REQUIRE(script.signals.back().signal == std::string(IncomingSignalsSnapshot::SIGNAL));
+	REQUIRE(script.signals.back().value == reach.records.back().incomingSignals);
+	REQUIRE(script.getDuration() == 1200ms);
+}
+
+TEST_CASE("Every hand pose sample is recorded by the thread that reads it", "[simulated coppeliasim][telemetry]")
+{
+	SimulatedCoppeliaSim scene;
+	scene.addObject("RightController");
+	CoppeliasimHandler handler(std::make_unique<SimulatedRemoteApiClient>(scene, SimulatedConnectionParameters(100us, 50us, 1)),
+		std::make_unique<SimulatedRemoteApiClient>(scene, SimulatedConnectionParameters(100us, 50us, 2)),
+		std::make_unique<SimulatedRemoteApiClient>(scene, SimulatedConnectionParameters(100us, 50us, 3)),
+		{ 0ms, 0us });
+	const std::string path = (std::filesystem::temp_directory_path() / "handler_poses.bin").string();
+	PoseTelemetryWriter telemetry;
+	REQUIRE(telemetry.open(path));
+	handler.setHandPoseTelemetry(&telemetry);
+	handler.init();
+
+	// Nothing reads the hand pose snapshot in between.
+	REQUIRE(waitUntil([&] { return handler.getHandPoseSnapshot().sequence >= 50; }));
+	scene.close();
+	handler.end();
+	telemetry.close();
+
+	REQUIRE(telemetry.getNumberOfRecorded() == handler.getHandPoseSnapshot().sequence);
+	REQUIRE(telemetry.getNumberOfDropped() == 0);
+	REQUIRE(std::filesystem::file_size(path) == sizeof(PoseTelemetryHeader)
+		+ telemetry.getNumberOfRecorded() * sizeof(PoseTelemetryRecord));
+	std::filesystem::remove(path);
+}
+
+TEST_CASE("The handler runs against the simulated scene", "[simulated coppeliasim]")
+{
+	IncomingSignals present;
+	present.simStarted = present.object1 = present.object2 = present.object3 = true;
+	IncomingSignals grasped = present;
+	grasped.humanGraspObj3 = true;
+
+	SceneScript script;
+	script.trajectories["RightController"] = { { 0ms, at(0.35, 0, 0.95) }, { 200ms, at(0.1, 0.2, 0.75) } };
+	script.signals = { { 0ms, IncomingSignalsSnapshot::SIGNAL, IncomingSignalsSnapshot::pack(present) },
+		{ 100ms, IncomingSignalsSnapshot::SIGNAL, IncomingSignalsSnapshot::pack(grasped) } };
+	SimulatedCoppeliaSim scene(script);
+	scene.addObject("RightController");
+
+	CoppeliasimHandler handler(std::make_unique<SimulatedRemoteApiClient>(scene, SimulatedConnectionParameters(100us, 50us, 1)),
+		std::make_unique<SimulatedRemoteApiClient>(scene, SimulatedConnectionParameters(100us, 50us, 2)),
+		std::make_unique<SimulatedRemoteApiClient>(scene, SimulatedConnectionParameters(100us, 50us, 3)),
+		{ 0ms, 0us });
+	handler.init();
+
+	REQUIRE(waitUntil([&] { return handler.getSignals().humanGraspObj3; }));
+	REQUIRE(handler.getSignals() == grasped);
+	REQUIRE(waitUntil([&] { return handler.getHandPose() == at(0.1, 0.2, 0.75); }));
+
+	OutgoingSignals signals;
+	signals.targetObject = 2;
+	handler.setSignals(signals);
+	REQUIRE(waitUntil([&] { return scene.getSignal(OutgoingSignals::TARGET_OBJECT) == 2; }));
+	REQUIRE(scene.isRunning());
+	REQUIRE(scene.getLatency(RemoteApiCall::GET_OBJECT_POSE).getCount() > 0);
+
+	scene.close();
+	handler.end();
+}
@@ -0,0 +1,113 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "coppeliasim_handler.h"
+#include "snapshot_publisher.h"
+
+namespace
+{
+	constexpr std::uint64_t numberOfPublications = 200000;
+	constexpr int numberOfReaders = 3;
+	constexpr int allFlags = (1 << IncomingSignalsSnapshot::NUMBER_OF_FLAGS) - 1;
+
+	// Every flag set on odd publications, none on even ones.
+	IncomingSignals makeSignals(std::uint64_t i)
+	{
+		IncomingSignals signals;
+		const int flags = (i & 1) ? allFlags : 0;
+		IncomingSignalsSnapshot::unpack(IncomingSignalsSnapshot::VERSION << IncomingSignalsSnapshot::VERSION_SHIFT | flags, signals);
+		return signals;
+	}
+
+	Pose makePose(std::uint64_t i)
+	{
+		const double v = static_cast<double>(i);
+		return { { v, v, v }, { v, v, v } };
+	}
+
+	bool isConsistent(const Snapshot<IncomingSignals>& snapshot)
+	{
+		const int flags = IncomingSignalsSnapshot::pack(snapshot.value) & allFlags;
+		const bool expectSet = snapshot.sequence != 0 && ((snapshot.sequence - 1) & 1);
+		return flags == (expectSet ? allFlags : 0);
+	}
+
+	bool isConsistent(const Snapshot<Pose>& snapshot)
+	{
+		const double v = snapshot.sequence == 0 ? 0.0 : static_cast<double>(snapshot.sequence - 1);
+		const Pose& p = snapshot.value;
+		return p.position.x == v && p.position.y == v && p.position.z == v
+			&& p.orientation.alpha == v && p.orientation.beta == v && p.orientation.gamma == v
+			&& (snapshot.sequence == 0 || snapshot.captureTime.time_since_epoch().count() == static_cast<long long>(v));
+	}
+
+	template<typename T, typename Make>
+	void hammer(Make make)
+	{
+		SnapshotPublisher<T> publisher;
+		std::atomic<bool> done{ false };
+		std::atomic<int> readersStarted{ 0 };
+		std::atomic<long long> tornReads{ 0 }, backwardsReads{ 0 }, reads{ 0 };
+
+		std::vector<std::thread> readers;
+		for (int r = 0; r < numberOfReaders; ++r)
+			readers.emplace_back([&] {
+				std::uint64_t lastSequence = 0;
+				++readersStarted;
+				do
+				{
+					const Snapshot<T> snapshot = publisher.read();
+					if (!isConsistent(snapshot))
+						++tornReads;
+					if (snapshot.sequence < lastSequence)
+						++backwardsReads;
+					lastSequence = snapshot.sequence;
+					++reads;
+				} while (!done);
+			});
+
+		while (readersStarted < numberOfReaders)
+			std::this_thread::yield();
+		for (std::uint64_t i = 0; i < numberOfPublications; ++i)
+			publisher.publish(make(i), std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(i)));
+		done = true;
+		for (auto& reader : readers)
+			reader.join();
+
+		REQUIRE(reads > 0);
+		REQUIRE(tornReads == 0);
+		REQUIRE(backwardsReads == 0);
+		REQUIRE(publisher.getSequence() == numberOfPublications);
+	}
+}
+
+TEST_CASE("Snapshot starts empty", "[snapshot]")
+{
+	const SnapshotPublisher<Pose> publisher;
+	const Snapshot<Pose> snapshot = publisher.read();
+	REQUIRE(snapshot.sequence == 0);
+	REQUIRE(snapshot.value.position.x == 0.0);
+}
+
+TEST_CASE("Snapshot carries sequence and capture time", "[snapshot]")
+{
+	SnapshotPublisher<Pose> publisher;
+	const auto captureTime = std::chrono::steady_clock::now();
+	publisher.publish(makePose(7), captureTime);
+	const Snapshot<Pose> snapshot = publisher.read();
+	REQUIRE(snapshot.sequence == 1);
+	REQUIRE(snapshot.captureTime == captureTime);
+	REQUIRE(snapshot.value.orientation.gamma == 7.0);
+}
+
+TEST_CASE("No torn incoming signal snapshots under contention", "[snapshot][stress]")
+{
+	hammer<IncomingSignals>(makeSignals);
+}
+
+TEST_CASE("No torn hand pose snapshots under contention", "[snapshot][stress]")
+{
+	hammer<Pose>(makePose);
+}
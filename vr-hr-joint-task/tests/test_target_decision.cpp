@@ -0,0 +1,85 @@
+#include <atomic>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+
+#include "target_decision.h"
+#include "workspace.h"
+
+TEST_CASE("The target decision follows the field step by step", "[target decision]")
+{
+	// Objects 1, 2 and 3 at 37.5, 25 and 12.5 along the field.
+	const Workspace workspace = Workspace::getDefault();
+	TargetDecisionTracker tracker(workspace);
+
+	tracker.reset(-1);
+	Snapshot<TargetDecision> decision = tracker.read();
+	REQUIRE(decision.sequence == 1);
+	REQUIRE_FALSE(decision.value.peak);
+	REQUIRE(decision.value.targetObject == 0);
+	REQUIRE(decision.value.step == 0);
+
+	// No peak yet.
+	tracker.update(-1);
+	REQUIRE(tracker.read().value.stableSteps == 2);
+
+	// A peak forms near object 2 and drifts without crossing over to another object.
+	tracker.update(24);
+	decision = tracker.read();
+	REQUIRE(decision.value.peak);
+	REQUIRE(decision.value.centroid == 24);
+	REQUIRE(decision.value.targetObject == 2);
+	REQUIRE(decision.value.step == 2);
+	REQUIRE(decision.value.changeStep == 2);
+	REQUIRE(decision.value.stableSteps == 1);
+	tracker.update(26);
+	tracker.update(26);
+	decision = tracker.read();
+	REQUIRE(decision.value.targetObject == 2);
+	REQUIRE(decision.value.stableSteps == 3);
+	REQUIRE(decision.value.changeStep == 2);
+
+	// It moves over to object 1, then dies out.
+	tracker.update(36);
+	REQUIRE(tracker.read().value.targetObject == 1);
+	REQUIRE(tracker.read().value.changeStep == 5);
+	tracker.update(-1);
+	decision = tracker.read();
+	REQUIRE_FALSE(decision.value.peak);
+	REQUIRE(decision.value.targetObject == 0);
+	REQUIRE(decision.value.changeStep == 6);
+	REQUIRE(decision.sequence == 7);
+
+	// Fields initialised again start over.
+	tracker.reset(12);
+	decision = tracker.read();
+	REQUIRE(decision.value.targetObject == 3);
+	REQUIRE(decision.value.step == 0);
+	REQUIRE(decision.value.changeStep == 0);
+}
+
+TEST_CASE("Target decisions are read whole while the fields step", "[target decision]")
+{
+	const Workspace workspace = Workspace::getDefault();
+	TargetDecisionTracker tracker(workspace);
+	tracker.reset(-1);
+
+	// The peak alternates between objects 1 and 3 every step; a reader must never see the centroid of one
+	// with the target of the other.
+	std::atomic<bool> done(false);
+	std::thread stepping([&] {
+		for (int step = 1; !done; ++step)
+			tracker.update(step % 2 ? 37.5 : 12.5);
+	});
+	while (tracker.read().value.step == 0)
+		std::this_thread::yield();
+	bool consistent = true;
+	for (int read = 0; read < 200000; ++read)
+	{
+		const TargetDecision decision = tracker.read().value;
+		consistent = consistent && decision.targetObject == (decision.centroid == 37.5 ? 1 : 3)
+			&& decision.changeStep == decision.step;
+	}
+	done = true;
+	stepping.join();
+	REQUIRE(consistent);
+}
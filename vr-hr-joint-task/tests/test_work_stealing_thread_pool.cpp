@@ -0,0 +1,71 @@
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+
+#include "work_stealing_thread_pool.h"
+
+TEST_CASE("Every submitted task runs before wait returns", "[thread pool]")
+{
+	WorkStealingThreadPool pool(4);
+	std::atomic<int> executed{ 0 };
+	for (int i = 0; i < 10000; ++i)
+		pool.submit([&] { ++executed; });
+	pool.wait();
+	REQUIRE(executed == 10000);
+
+	// The pool is reusable after a wait.
+	pool.submit([&] { ++executed; });
+	pool.wait();
+	REQUIRE(executed == 10001);
+}
+
+TEST_CASE("Tasks submitted from tasks are waited for", "[thread pool]")
+{
+	WorkStealingThreadPool pool(3);
+	std::atomic<int> leaves{ 0 };
+	for (int i = 0; i < 10; ++i)
+		pool.submit([&] {
+			for (int j = 0; j < 100; ++j)
+				pool.submit([&] { ++leaves; });
+		});
+	pool.wait();
+	REQUIRE(leaves == 1000);
+}
+
+TEST_CASE("Idle workers steal queued tasks", "[thread pool]")
+{
+	WorkStealingThreadPool pool(4);
+	std::atomic<int> executed{ 0 };
+	// All tasks land on the first worker's deque, the others can only get work by stealing.
+	pool.submit([&] {
+		for (int i = 0; i < 64; ++i)
+			pool.submit([&] {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				++executed;
+			});
+	});
+	pool.wait();
+	REQUIRE(executed == 64);
+	REQUIRE(pool.getNumberOfSteals() > 0);
+}
+
+TEST_CASE("Pool rethrows the first task exception from wait", "[thread pool]")
+{
+	WorkStealingThreadPool pool(2);
+	std::atomic<int> counter = 0;
+	for (int i = 0; i < 10; ++i)
+		pool.submit([&counter, i] {
+			counter.fetch_add(1);
+			if (i == 3)
+				throw std::runtime_error("task failed");
+		});
+	REQUIRE_THROWS_AS(pool.wait(), std::runtime_error);
+	REQUIRE(counter.load() == 10);
+
+	// The error is reported once, the pool keeps working.
+	pool.submit([&counter] { counter.fetch_add(1); });
+	REQUIRE_NOTHROW(pool.wait());
+	REQUIRE(counter.load() == 11);
+}
@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <simulation/simulation.h>
+
+#include "coppeliasim_handler.h"
+#include "workspace.h"
+#include "workspace_stimulus.h"
+
+namespace
+{
+	// numberOfObjects objects evenly spaced along the field.
+	Workspace makeWorkspace(int numberOfObjects)
+	{
+		std::vector<WorkspaceObject> objects;
+		for (int i = 0; i < numberOfObjects; ++i)
+		{
+			const double y = -0.25 + 0.5 * (i + 0.5) / numberOfObjects;
+			objects.emplace_back("object" + std::to_string(i + 1), Position{ 0, y, 0.716 }, 50 * (i + 0.5) / numberOfObjects);
+		}
+		return Workspace(std::move(objects));
+	}
+
+	// The decision as it was with three hard-coded objects.
+	int getThreeObjectTarget(double centroid)
+	{
+		if (centroid < 0)
+			return 0;
+		const auto circularDistance = [](double a, double b) { return std::min(std::abs(a - b), 50 - std::abs(a - b)); };
+		const double d1 = circularDistance(centroid, 37.5);
+		const double d2 = circularDistance(centroid, 25);
+		const double d3 = circularDistance(centroid, 12.5);
+		const double minDistance = std::min({ d1, d2, d3 });
+		if (minDistance == d1)
+			return 1;
+		if (minDistance == d2)
+			return 2;
+		return 3;
+	}
+
+	// Nearest object by checking every one, ties to the lowest.
+	int getNearestObject(const Workspace& workspace, double centroid)
+	{
+		if (centroid < 0)
+			return 0;
+		int nearest = 0;
+		double nearestDistance = 0;
+		for (int object = 1; object <= static_cast<int>(workspace.getNumberOfObjects()); ++object)
+		{
+			const double direct = std::abs(centroid - workspace.getObject(object).fieldPosition);
+			const double distance = std::min(direct, workspace.getMaxSpatialDimension() - direct);
+			if (nearest == 0 || distance < nearestDistance)
+			{
+				nearest = object;
+				nearestDistance = distance;
+			}
+		}
+		return nearest;
+	}
+
+	WorkspaceStimulus makeStimulus(const Workspace& workspace, double amplitude)
+	{
+		const dnf_composer::element::ElementCommonParameters common{ "stimuli",
+			{ workspace.getMaxSpatialDimension(), workspace.getSpatialStep() } };
+		return WorkspaceStimulus(common, { 3, 0, 0, true, false }, workspace, amplitude);
+	}
+}
+
+TEST_CASE("The default workspace is the three-object scene", "[workspace]")
+{
+	const Workspace workspace = Workspace::getDefault();
+	REQUIRE(workspace.getNumberOfObjects() == 3);
+	REQUIRE(workspace.getMaxSpatialDimension() == 50);
+	REQUIRE(workspace.getSpatialStep() == 0.5);
+	REQUIRE(workspace.getObject(1).fieldPosition == 37.5);
+	REQUIRE(workspace.getObject(2).fieldPosition == 25);
+	REQUIRE(workspace.getObject(3).fieldPosition == 12.5);
+	REQUIRE(workspace.getAllObjects() == ObjectSet(0b111));
+	// The hand position maps onto the field as the object positions do.
+	for (int object = 1; object <= 3; ++object)
+		REQUIRE(workspace.getFieldPosition(workspace.getObject(object).position.y) == workspace.getObject(object).fieldPosition);
+}
+
+TEST_CASE("Workspaces parse from JSON", "[workspace]")
+{
+	std::istringstream description(R"({
+		"field": { "x_max": 100, "d_x": 1 },
+		"objects": [
+			{ "name": "cup", "position": [0.1, 0.0, 0.7] },
+			{ "position": [0.0, 0.2, 0.7], "field_position": 12 }
+		]
+	})");
+	const Workspace workspace = Workspace::parse(description);
+
+	REQUIRE(workspace.getNumberOfObjects() == 2);
+	REQUIRE(workspace.getMaxSpatialDimension() == 100);
+	REQUIRE(workspace.getSpatialStep() == 1);
+	REQUIRE(workspace.getObject(1).name == "cup");
+	REQUIRE(workspace.getObject(1).position.x == 0.1);
+	REQUIRE(workspace.getObject(1).fieldPosition == 50);
+	REQUIRE(workspace.getObject(2).name == "object2");
+	REQUIRE(workspace.getObject(2).fieldPosition == 12);
+}
+
+TEST_CASE("Invalid workspaces are rejected", "[workspace]")
+{
+	const auto parse = [](const std::string& text) {
+		std::istringstream description(text);
+		return Workspace::parse(description);
+	};
+
+	REQUIRE_THROWS_AS(parse("not json"), std::runtime_error);
+	REQUIRE_THROWS_AS(parse(R"({ "objects": [] })"), std::runtime_error);
+	REQUIRE_THROWS_AS(parse(R"({ "objects": [ { "position": [0, 0] } ] })"), std::runtime_error);
+	REQUIRE_THROWS_AS(parse(R"({ "objects": [ { "position": [0, 0, 0], "field_position": 60 } ] })"), std::runtime_error);
+	REQUIRE_THROWS_AS(makeWorkspace(65), std::runtime_error);
+	REQUIRE_THROWS_AS(Workspace::load("does/not/exist.json"), std::runtime_error);
+}
+
+TEST_CASE("Target decoding matches the three-object decision", "[workspace]")
+{
+	const Workspace workspace = Workspace::getDefault();
+	for (double centroid = -1; centroid <= 50; centroid += 0.125)
+		REQUIRE(workspace.getTargetObject(centroid) == getThreeObjectTarget(centroid));
+	// Object 3 is as far from 0 as object 1 is going round the field, the tie goes to object 1.
+	REQUIRE(workspace.getTargetObject(0) == 1);
+}
+
+TEST_CASE("Target decoding finds the nearest of many objects", "[workspace]")
+{
+	for (const int numberOfObjects : { 1, 2, 7, 64 })
+	{
+		const Workspace workspace = makeWorkspace(numberOfObjects);
+		for (double centroid = 0; centroid <= 50; centroid += 0.1)
+			REQUIRE(workspace.getTargetObject(centroid) == getNearestObject(workspace, centroid));
+	}
+
+	// Objects sharing a field position: the lowest one wins.
+	const Workspace shared({ { "a", {}, 30 }, { "b", {}, 10 }, { "c", {}, 10 }, { "d", {}, 30 } });
+	REQUIRE(shared.getTargetObject(9) == 2);
+	REQUIRE(shared.getTargetObject(31) == 1);
+	REQUIRE(shared.getTargetObject(20) == 1);
+}
+
+TEST_CASE("forEachObject visits the set objects in order", "[workspace]")
+{
+	ObjectSet objects;
+	objects.set(0).set(5).set(63);
+	std::vector<int> visited;
+	forEachObject(objects, [&visited](int object) { visited.push_back(object); });
+	REQUIRE(visited == std::vector<int>{ 1, 6, 64 });
+
+	visited.clear();
+	forEachObject(ObjectSet(), [&visited](int object) { visited.push_back(object); });
+	REQUIRE(visited.empty());
+}
+
+TEST_CASE("Scene signals decode into object sets", "[workspace]")
+{
+	IncomingSignals signals;
+	signals.object1 = signals.object3 = true;
+	signals.robotGraspObj2 = true;
+	signals.robotPlaceObj3 = true;
+	signals.humanGraspObj1 = true;
+	signals.humanPlaceObj2 = signals.humanPlaceObj3 = true;
+
+	const ObjectSignals objects = decodeObjectSignals(signals);
+	REQUIRE(objects.present == ObjectSet(0b101));
+	REQUIRE(objects.robotGrasp == ObjectSet(0b010));
+	REQUIRE(objects.robotPlace == ObjectSet(0b100));
+	REQUIRE(objects.humanGrasp == ObjectSet(0b001));
+	REQUIRE(objects.humanPlace == ObjectSet(0b110));
+}
+
+TEST_CASE("Workspace stimuli sum one Gaussian per object", "[workspace]")
+{
+	using namespace dnf_composer::element;
+	const Workspace workspace = Workspace::getDefault();
+	WorkspaceStimulus stimuli = makeStimulus(workspace, 5);
+	stimuli.init();
+
+	const auto expected = [&workspace](const std::vector<double>& amplitudes) {
+		std::vector<double> sum;
+		for (std::size_t i = 0; i < amplitudes.size(); ++i)
+		{
+			GaussStimulus single({ "single", { workspace.getMaxSpatialDimension(), workspace.getSpatialStep() } },
+				{ 3, amplitudes[i], workspace.getObjects()[i].fieldPosition, true, false });
+			single.init();
+			const std::vector<double>& output = *single.getComponentPtr("output");
+			sum.resize(output.size());
+			for (std::size_t k = 0; k < output.size(); ++k)
+				sum[k] += output[k];
+		}
+		return sum;
+	};
+	const auto requireOutput = [&stimuli](const std::vector<double>& reference) {
+		const std::vector<double>& output = *stimuli.getComponentPtr("output");
+		REQUIRE(output.size() == reference.size());
+		for (std::size_t k = 0; k < output.size(); ++k)
+			REQUIRE(std::abs(output[k] - reference[k]) < 1e-12);
+	};
+
+	requireOutput(expected({ 5, 5, 5 }));
+
+	stimuli.setAmplitudes(ObjectSet(0b101), 5);
+	REQUIRE(stimuli.getAmplitude(1) == 0);
+	requireOutput(expected({ 5, 0, 5 }));
+
+	stimuli.setAmplitude(0, 2.5);
+	requireOutput(expected({ 2.5, 0, 5 }));
+
+	stimuli.setAmplitudes({ 0, 1, 0 });
+	requireOutput(expected({ 0, 1, 0 }));
+}
+
+TEST_CASE("Workspace stimuli initialise through the simulation", "[workspace]")
+{
+	// The simulation initialises every element, and GaussStimulus re-initialises itself on setParameters().
+	using namespace dnf_composer::element;
+	const Workspace workspace = Workspace::getDefault();
+	dnf_composer::Simulation simulation("workspace", 1, 0, 0);
+	const auto stimuli = std::make_shared<WorkspaceStimulus>(makeStimulus(workspace, 0));
+	stimuli->setAmplitudes({ 2, 0, 4 });
+	simulation.addElement(stimuli);
+	simulation.init();
+
+	WorkspaceStimulus reference = makeStimulus(workspace, 0);
+	reference.init();
+	reference.setAmplitudes({ 2, 0, 4 });
+	const auto requireReference = [&stimuli, &reference] {
+		const std::vector<double>& output = *stimuli->getComponentPtr("output");
+		const std::vector<double>& expected = *reference.getComponentPtr("output");
+		REQUIRE(output.size() == expected.size());
+		for (std::size_t k = 0; k < output.size(); ++k)
+			REQUIRE(std::abs(output[k] - expected[k]) < 1e-12);
+	};
+	requireReference();
+
+	// Initialised again, the output is rebuilt from the same amplitudes.
+	simulation.init();
+	requireReference();
+	REQUIRE(stimuli->getParameters().amplitude == 0);
+}
+
+TEST_CASE("Benchmark per-tick workspace cost", "[.][benchmark][workspace]")
+{
+	// What the control loop does for the objects every pass: decode the scene flags, update the object
+	// presence and the per-object likelihoods, and decode the target from the centroid.
+	for (const int numberOfObjects : { 3, 8, 16, 32, 64 })
+	{
+		const Workspace workspace = makeWorkspace(numberOfObjects);
+		WorkspaceStimulus objectStimuli = makeStimulus(workspace, 5);
+		WorkspaceStimulus likelihoodStimuli = makeStimulus(workspace, 0);
+		objectStimuli.init();
+		likelihoodStimuli.init();
+		std::vector<double> likelihoods(workspace.getNumberOfObjects());
+		IncomingSignals signals;
+		signals.object1 = signals.object2 = signals.object3 = true;
+
+		int pass = 0;
+		BENCHMARK(std::to_string(numberOfObjects) + " objects")
+		{
+			++pass;
+			const ObjectSignals objects = decodeObjectSignals(signals);
+			// Presence rarely changes, the amplitudes are compared and nothing is recomputed.
+			objectStimuli.setAmplitudes(workspace.getAllObjects(), 5);
+			for (std::size_t i = 0; i < likelihoods.size(); ++i)
+				likelihoods[i] = objects.present.test(i % 3) ? std::sin(0.01 * (pass + static_cast<int>(i))) : 0;
+			likelihoodStimuli.setAmplitudes(likelihoods);
+			return workspace.getTargetObject(std::fmod(0.37 * pass, 50.0));
+		};
+	}
+}
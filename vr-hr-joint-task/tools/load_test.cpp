@@ -0,0 +1,152 @@
+// Runs the CoppeliaSim I/O path against the simulated scene and reports throughput and latency.
+// Usage: vr-hr-joint-task-loadtest [--round-trip-us N] [--jitter-us N] [--duration-s N] [--pipelined READS] [--spin-us N]
+//   [session.trace]
+// The scene plays the hand and signals of the session, or a synthetic reach to each object, in a loop.
+// A control thread reads every change and writes the object nearest to the hand as the target. The handler
+// uses three blocking connections, or with --pipelined one pipelined connection with READS reads in flight,
+// whose executor busy-waits the last --spin-us before each deadline (none by default).
+
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+
+#include "change_notifier.h"
+#include "coppeliasim_handler.h"
+#include "parameter_sweep.h"
+#include "simulated_coppeliasim.h"
+
+namespace
+{
+	// The reaches one after another, each starting where the previous one ended.
+	SceneScript concatenate(const std::vector<SceneScript>& scripts)
+	{
+		SceneScript script;
+		std::chrono::nanoseconds offset(0);
+		for (const SceneScript& part : scripts)
+		{
+			for (const auto& [name, trajectory] : part.trajectories)
+				for (const PoseKeyframe& keyframe : trajectory)
+					script.trajectories[name].push_back({ offset + keyframe.time, keyframe.pose });
+			for (const SignalKeyframe& keyframe : part.signals)
+				script.signals.push_back({ offset + keyframe.time, keyframe.signal, keyframe.value });
+			offset += part.getDuration() + std::chrono::milliseconds(1);
+		}
+		return script;
+	}
+
+	int getNearestObject(const Workspace& workspace, const Position& hand)
+	{
+		int nearest = 0;
+		double nearestDistance = std::numeric_limits<double>::max();
+		for (int object = 1; object <= static_cast<int>(workspace.getNumberOfObjects()); ++object)
+		{
+			const double distance = calculateEuclideanDistance(hand, workspace.getObject(object).position);
+			if (distance < nearestDistance)
+			{
+				nearest = object;
+				nearestDistance = distance;
+			}
+		}
+		return nearest;
+	}
+
+	double toMilliseconds(std::chrono::nanoseconds duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		SimulatedConnectionParameters connection;
+		std::chrono::seconds duration(10);
+		std::size_t readsInFlight = 0;
+		std::chrono::microseconds spinThreshold(0);
+		std::string tracePath;
+		for (int i = 1; i < argc; ++i)
+		{
+			if (std::strcmp(argv[i], "--round-trip-us") == 0 && i + 1 < argc)
+				connection.roundTripTime = std::chrono::microseconds(std::stoll(argv[++i]));
+			else if (std::strcmp(argv[i], "--jitter-us") == 0 && i + 1 < argc)
+				connection.jitter = std::chrono::microseconds(std::stoll(argv[++i]));
+			else if (std::strcmp(argv[i], "--duration-s") == 0 && i + 1 < argc)
+				duration = std::chrono::seconds(std::stoll(argv[++i]));
+			else if (std::strcmp(argv[i], "--pipelined") == 0 && i + 1 < argc)
+				readsInFlight = std::stoul(argv[++i]);
+			else if (std::strcmp(argv[i], "--spin-us") == 0 && i + 1 < argc)
+				spinThreshold = std::chrono::microseconds(std::stoll(argv[++i]));
+			else
+				tracePath = argv[i];
+		}
+
+		const Workspace workspace = Workspace::getDefault();
+		SceneScript script;
+		if (!tracePath.empty())
+			script = makeSceneScript(readSessionTrace(tracePath));
+		else
+		{
+			std::vector<SceneScript> reaches;
+			for (int object = 1; object <= static_cast<int>(workspace.getNumberOfObjects()); ++object)
+				reaches.push_back(makeSceneScript(makeSyntheticReach(DnfArchitectureType::HAND_MOTION, object)));
+			script = concatenate(reaches);
+		}
+		script.loop = true;
+
+		SimulatedCoppeliaSim scene(script);
+		scene.addObject("RightController");
+		const auto connect = [&](std::uint64_t seed) {
+			SimulatedConnectionParameters parameters = connection;
+			parameters.seed = seed;
+			return std::make_unique<SimulatedRemoteApiClient>(scene, parameters);
+		};
+		CoppeliasimHandlerParameters parameters;
+		parameters.readsInFlight = readsInFlight;
+		parameters.executorSpinThreshold = spinThreshold;
+		CoppeliasimHandler handler = readsInFlight > 0
+			? CoppeliasimHandler(std::make_unique<SimulatedPipelinedConnection>(scene, connection), parameters)
+			: CoppeliasimHandler(connect(1), connect(2), connect(3));
+		ChangeNotifier changes;
+		handler.setChangeNotifier(&changes);
+		handler.init();
+
+		LatencyHistogram handPoseAge;
+		std::uint64_t controlPasses = 0;
+		const auto end = std::chrono::steady_clock::now() + duration;
+		while (std::chrono::steady_clock::now() < end)
+		{
+			changes.waitFor(std::chrono::milliseconds(20));
+			const Snapshot<Pose> hand = handler.getHandPoseSnapshot();
+			if (hand.sequence != 0)
+				handPoseAge.record(std::chrono::steady_clock::now() - hand.captureTime);
+			OutgoingSignals signals;
+			signals.startSim = handler.getSignals().simStarted;
+			signals.targetObject = getNearestObject(workspace, hand.value.position);
+			handler.setSignals(signals);
+			++controlPasses;
+		}
+
+		scene.close();
+		handler.end();
+
+		std::cout << "Connection: round trip = " << toMilliseconds(connection.roundTripTime) << " ms, jitter = "
+			<< toMilliseconds(connection.jitter) << " ms\n";
+		std::cout << scene.getReport() << "\n";
+		for (const auto* activity : handler.getThreadActivities())
+			std::cout << activity->getReport() << "\n";
+		const OutgoingSignalsStatistics outgoing = handler.getOutgoingSignalsStatistics();
+		std::cout << "Outgoing signal writes: sent = " << outgoing.writesSent << ", suppressed = " << outgoing.writesSuppressed << "\n";
+		std::cout << "Control passes = " << controlPasses << ", hand pose age p50 = " << toMilliseconds(handPoseAge.getPercentile(50))
+			<< " ms, p99 = " << toMilliseconds(handPoseAge.getPercentile(99)) << " ms, max = "
+			<< toMilliseconds(handPoseAge.getMax()) << " ms" << std::endl;
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
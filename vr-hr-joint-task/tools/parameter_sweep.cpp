@@ -0,0 +1,87 @@
+// Sweeps the "ael -> ael" lateral interaction constants over recorded or synthetic reaches.
+// Usage: vr-hr-joint-task-sweep [--threads N] [--scaling] [--action-likelihood] [session.trace ...]
+// Without traces, synthetic minimum-jerk reaches to each object are used.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "parameter_sweep.h"
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		std::size_t numberOfThreads = 0;
+		bool scaling = false;
+		DnfArchitectureType architecture = DnfArchitectureType::HAND_MOTION;
+		std::vector<SessionTrace> reaches;
+		for (int i = 1; i < argc; ++i)
+		{
+			if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+				numberOfThreads = std::stoul(argv[++i]);
+			else if (std::strcmp(argv[i], "--scaling") == 0)
+				scaling = true;
+			else if (std::strcmp(argv[i], "--action-likelihood") == 0)
+				architecture = DnfArchitectureType::ACTION_LIKELIHOOD;
+			else
+				for (auto& reach : splitIntoReaches(readSessionTrace(argv[i])))
+					reaches.push_back(std::move(reach));
+		}
+
+		if (reaches.empty())
+			for (const int reachDuration : { 1000, 1500, 2000 })
+				for (int object = 1; object <= static_cast<int>(Workspace::getDefault().getNumberOfObjects()); ++object)
+					reaches.push_back(makeSyntheticReach(architecture, object,
+						{ 65, std::chrono::milliseconds(20), std::chrono::milliseconds(reachDuration) }));
+
+		// Around the hand-tuned values for deltaT = 65.
+		const LateralInteractionsGrid grid{
+			{ 4.0, 4.75, 5.5 },
+			{ 7.5, 8.143, 9.0 },
+			{ 3.375 },
+			{ 5.0, 5.677, 6.5 },
+			{ -2.5 },
+		};
+		const auto candidates = grid.getCandidates();
+		std::cout << candidates.size() << " candidates x " << reaches.size() << " reaches" << std::endl;
+
+		const auto start = std::chrono::steady_clock::now();
+		const auto results = runParameterSweep(candidates, reaches, numberOfThreads);
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		std::cout << formatSweepTable(results) << "Sweep took " << elapsed.count() << " s" << std::endl;
+
+		if (scaling)
+		{
+			// Powers of two up to every hardware thread, plus the hardware thread count itself.
+			const std::size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+			std::vector<std::size_t> threadCounts;
+			for (std::size_t threads = 1; threads < maxThreads; threads *= 2)
+				threadCounts.push_back(threads);
+			threadCounts.push_back(maxThreads);
+
+			double singleThreaded = 0;
+			std::cout << "\nthreads\twall (s)\tspeedup\tefficiency" << std::endl;
+			for (const std::size_t threads : threadCounts)
+			{
+				const auto scalingStart = std::chrono::steady_clock::now();
+				runParameterSweep(candidates, reaches, threads);
+				const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - scalingStart;
+				if (threads == 1)
+					singleThreaded = wall.count();
+				const double speedup = singleThreaded / wall.count();
+				std::cout << threads << "\t" << wall.count() << "\t" << speedup << "\t" << speedup / threads << std::endl;
+			}
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
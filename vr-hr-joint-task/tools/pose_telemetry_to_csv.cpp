@@ -0,0 +1,41 @@
+// Converts a binary hand pose stream (logs_human.bin) to CSV.
+// Usage: vr-hr-joint-task-pose2csv <logs_human.bin> [output.csv]
+
+#include <fstream>
+#include <iostream>
+
+#include "pose_telemetry.h"
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <logs_human.bin> [output.csv]" << std::endl;
+		return 1;
+	}
+
+	std::ifstream input(argv[1], std::ifstream::binary);
+	if (!input.is_open())
+	{
+		std::cerr << "Could not open " << argv[1] << std::endl;
+		return 1;
+	}
+
+	std::ofstream outputFile;
+	if (argc > 2)
+	{
+		outputFile.open(argv[2]);
+		if (!outputFile.is_open())
+		{
+			std::cerr << "Could not open " << argv[2] << std::endl;
+			return 1;
+		}
+	}
+
+	if (!convertPoseTelemetryToCsv(input, argc > 2 ? outputFile : std::cout))
+	{
+		std::cerr << argv[1] << " is not a hand pose stream" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,43 @@
+// Replays a recorded session (session.trace) through the fields without CoppeliaSim.
+// Usage: vr-hr-joint-task-replay <session.trace> [--seed N]
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "session_replay.h"
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <session.trace> [--seed N]" << std::endl;
+		return 1;
+	}
+
+	try
+	{
+		std::optional<std::uint64_t> noiseSeed;
+		for (int i = 2; i + 1 < argc; ++i)
+			if (std::strcmp(argv[i], "--seed") == 0)
+				noiseSeed = std::stoull(argv[i + 1]);
+
+		const SessionTrace trace = readSessionTrace(argv[1]);
+		if (!noiseSeed && !trace.getNoiseSeed())
+			std::cerr << "The session was recorded without a noise seed, the replay is not reproducible." << std::endl;
+
+		const SessionReplayResult result = replaySession(trace, DnfArchitectureOptions(noiseSeed));
+		std::cout << "Control passes: " << trace.records.size() << "\n"
+			<< "DNF steps: " << result.steps << "\n"
+			<< "Target decisions differing from the recording: " << result.targetMismatches << "\n"
+			<< "Simulated time: " << result.simulatedTime.count() << " s\n"
+			<< "Wall time: " << result.wallTime.count() << " s\n"
+			<< "Throughput: " << result.getSimulatedSecondsPerWallSecond() << " simulated s per wall s" << std::endl;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}